@@ -0,0 +1,275 @@
+#include "bench/bench_runner.hpp"
+
+#include <QDir>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "bench/bench_stats.hpp"
+#include "common/clock.hpp"
+#include "common/json_utils.hpp"
+#include "daemon/journal_parser.hpp"
+#include "daemon/khronicle_api_server.hpp"
+#include "daemon/khronicle_daemon.hpp"
+#include "daemon/khronicle_store.hpp"
+#include "daemon/pacman_parser.hpp"
+#include "report/ReportCli.hpp"
+
+namespace khronicle::bench {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+double elapsedMs(SteadyClock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(SteadyClock::now() - start).count();
+}
+
+// Times fn once and adds the sample to phase.
+template <typename Fn>
+void timeOperation(PhaseResult &phase, Fn &&fn)
+{
+    const auto start = SteadyClock::now();
+    fn();
+    const double ms = elapsedMs(start);
+    phase.samplesMs.push_back(ms);
+    phase.totalMs += ms;
+}
+
+// Random [from, from + span) windows inside the workload's history.
+class WindowPicker
+{
+public:
+    WindowPicker(std::uint64_t seed,
+                 std::chrono::system_clock::time_point start,
+                 std::chrono::system_clock::time_point end)
+        : m_engine(seed), m_start(start), m_end(end)
+    {
+    }
+
+    std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point>
+    pick(std::chrono::hours span)
+    {
+        const auto range = std::chrono::duration_cast<std::chrono::seconds>(
+            (m_end - m_start) - span).count();
+        const auto offset = std::chrono::seconds(
+            range > 0 ? static_cast<long long>(m_engine() % static_cast<std::uint64_t>(range)) : 0);
+        const auto from = m_start + offset;
+        return {from, from + span};
+    }
+
+    std::size_t index(std::size_t bound) { return m_engine() % bound; }
+
+private:
+    std::mt19937_64 m_engine;
+    std::chrono::system_clock::time_point m_start;
+    std::chrono::system_clock::time_point m_end;
+};
+
+} // namespace
+
+BenchRunner::BenchRunner(const BenchOptions &options)
+    : m_options(options)
+    , m_generator(options.workload)
+{
+}
+
+bool BenchRunner::run()
+{
+    const QString dir = m_options.workDir;
+    const QString pacmanPath = dir + QStringLiteral("/pacman.log");
+    const QString journalPath = dir + QStringLiteral("/journal.txt");
+    const QString home = dir + QStringLiteral("/home");
+    QDir().mkpath(home);
+
+    // Everything the daemon and report CLI touch stays in the work dir.
+    qputenv("HOME", home.toUtf8());
+    qputenv("KHRONICLE_PACMAN_LOG_PATH", pacmanPath.toUtf8());
+    qputenv("KHRONICLE_JOURNAL_PATH", journalPath.toUtf8());
+    qputenv("KHRONICLE_REPLAY_NO_SNAPSHOT", "1");
+
+    PhaseResult generate{"generate_logs", "lines"};
+    bool written = false;
+    timeOperation(generate, [&] {
+        written = m_generator.writePacmanLog(pacmanPath)
+            && m_generator.writeJournal(journalPath);
+    });
+    if (!written) {
+        std::fprintf(stderr, "failed to write workload to %s\n", qPrintable(dir));
+        return false;
+    }
+    generate.items = m_generator.stats().pacmanLines + m_generator.stats().journalLines;
+    m_results.push_back(std::move(generate));
+
+    // Parsers alone, without SQLite.
+    PhaseResult parsePacman{"parse_pacman", "events"};
+    timeOperation(parsePacman, [&] {
+        parsePacman.items = parsePacmanLog(pacmanPath.toStdString(), std::nullopt).events.size();
+    });
+    m_results.push_back(std::move(parsePacman));
+
+    PhaseResult parseJournal{"parse_journal", "events"};
+    timeOperation(parseJournal, [&] {
+        parseJournal.items =
+            parseJournalSince(m_generator.start() - std::chrono::hours(1)).events.size();
+    });
+    m_results.push_back(std::move(parseJournal));
+
+    // One daemon ingestion cycle over the whole history: parsing, watch rule
+    // evaluation and SQLite inserts, as on a first start with old logs.
+    VirtualClock clock(m_generator.start());
+    KhronicleDaemon daemon(clock);
+    daemon.resetIngestionStateForReplay();
+    clock.setNow(m_generator.end());
+    KhronicleStore &store = daemon.store();
+
+    PhaseResult ingest{"ingest_cycle", "rows"};
+    const std::uint64_t rowsBefore = store.rowsWritten();
+    timeOperation(ingest, [&] { daemon.runIngestionCycleForReplay(); });
+    ingest.items = store.rowsWritten() - rowsBefore;
+    m_results.push_back(std::move(ingest));
+
+    PhaseResult storeSnapshots{"store_snapshots", "snapshots"};
+    std::vector<SystemSnapshot> snapshots = m_generator.snapshots();
+    const HostIdentity host = store.getHostIdentity();
+    for (auto &snapshot : snapshots) {
+        snapshot.hostIdentity = host;
+        timeOperation(storeSnapshots, [&] { store.addSnapshot(snapshot); });
+    }
+    storeSnapshots.items = snapshots.size();
+    m_results.push_back(std::move(storeSnapshots));
+
+    WindowPicker windows(m_options.workload.seed, m_generator.start(), m_generator.end());
+
+    PhaseResult queryWindow{"query_30d_window", "events"};
+    for (int i = 0; i < m_options.queryIterations; ++i) {
+        const auto window = windows.pick(std::chrono::hours(24 * 30));
+        timeOperation(queryWindow, [&] {
+            queryWindow.items += store.getEventsBetween(window.first, window.second).size();
+        });
+    }
+    m_results.push_back(std::move(queryWindow));
+
+    // Same kind of query through JSON-RPC dispatch, including serialization.
+    KhronicleApiServer server(store);
+    PhaseResult apiWindow{"api_changes_7d", "bytes"};
+    for (int i = 0; i < m_options.queryIterations; ++i) {
+        const auto window = windows.pick(std::chrono::hours(24 * 7));
+        const nlohmann::json request = {
+            {"id", i},
+            {"method", "get_changes_between"},
+            {"params", {{"from", toIso8601Utc(window.first)},
+                        {"to", toIso8601Utc(window.second)}}}
+        };
+        const QByteArray payload = QByteArray::fromStdString(request.dump());
+        timeOperation(apiWindow, [&] {
+            apiWindow.items += static_cast<std::size_t>(server.handleRequestPayload(payload).size());
+        });
+    }
+    m_results.push_back(std::move(apiWindow));
+
+    PhaseResult diff{"diff_snapshots", "changed fields"};
+    if (snapshots.size() >= 2) {
+        for (int i = 0; i < m_options.diffIterations; ++i) {
+            const auto &a = snapshots[windows.index(snapshots.size())];
+            const auto &b = snapshots[windows.index(snapshots.size())];
+            timeOperation(diff, [&] {
+                diff.items += store.diffSnapshots(a.id, b.id).changedFields.size();
+            });
+        }
+    }
+    m_results.push_back(std::move(diff));
+
+    // The report CLI opens its own connection, as khronicle-report does.
+    PhaseResult report{"report_timeline_90d", "bytes"};
+    std::ostringstream captured;
+    std::streambuf *previous = std::cout.rdbuf(captured.rdbuf());
+    for (int i = 0; i < m_options.reportIterations; ++i) {
+        const auto window = windows.pick(std::chrono::hours(24 * 90));
+        std::vector<std::string> args = {
+            "khronicle-report", "timeline",
+            "--from", toIso8601Utc(window.first), "--to", toIso8601Utc(window.second),
+            "--format", "json"
+        };
+        std::vector<char *> argv;
+        for (auto &arg : args) {
+            argv.push_back(arg.data());
+        }
+        captured.str(std::string());
+        timeOperation(report, [&] {
+            ReportCli cli;
+            cli.run(static_cast<int>(argv.size()), argv.data());
+        });
+        report.items += captured.str().size();
+    }
+    std::cout.rdbuf(previous);
+    m_results.push_back(std::move(report));
+    return true;
+}
+
+void BenchRunner::printTable(std::FILE *out) const
+{
+    const WorkloadStats &stats = m_generator.stats();
+    std::fprintf(out,
+                 "workload: %d years, %d packages, %zu sessions, %zu upgrades, "
+                 "%zu journal lines (%zu GPU/firmware), seed %llu\n\n",
+                 m_options.workload.years, m_options.workload.packages,
+                 stats.sessions, stats.upgrades, stats.journalLines, stats.gpuJournalLines,
+                 static_cast<unsigned long long>(m_options.workload.seed));
+    std::fprintf(out, "%-20s %6s %10s %-15s %10s %12s %9s %9s %9s %9s\n",
+                 "phase", "ops", "items", "unit", "total ms", "items/s",
+                 "p50 ms", "p95 ms", "p99 ms", "max ms");
+    for (const PhaseResult &phase : m_results) {
+        std::vector<double> samples = phase.samplesMs;
+        const LatencySummary summary = summarizeLatencies(samples);
+        const double perSecond = phase.totalMs > 0.0
+            ? static_cast<double>(phase.items) * 1000.0 / phase.totalMs
+            : 0.0;
+        std::fprintf(out, "%-20s %6zu %10zu %-15s %10.1f %12.0f %9.3f %9.3f %9.3f %9.3f\n",
+                     phase.name.c_str(), summary.count, phase.items, phase.unit.c_str(),
+                     phase.totalMs, perSecond,
+                     summary.p50, summary.p95, summary.p99, summary.max);
+    }
+}
+
+nlohmann::json BenchRunner::toJson() const
+{
+    const WorkloadStats &stats = m_generator.stats();
+    nlohmann::json phases = nlohmann::json::array();
+    for (const PhaseResult &phase : m_results) {
+        std::vector<double> samples = phase.samplesMs;
+        const LatencySummary summary = summarizeLatencies(samples);
+        phases.push_back({
+            {"name", phase.name},
+            {"unit", phase.unit},
+            {"ops", summary.count},
+            {"items", phase.items},
+            {"totalMs", phase.totalMs},
+            {"meanMs", summary.mean},
+            {"p50Ms", summary.p50},
+            {"p95Ms", summary.p95},
+            {"p99Ms", summary.p99},
+            {"maxMs", summary.max}
+        });
+    }
+    return {
+        {"workload", {
+            {"years", m_options.workload.years},
+            {"packages", m_options.workload.packages},
+            {"upgradesPerWeek", m_options.workload.upgradesPerWeek},
+            {"upgradeShare", m_options.workload.upgradeShare},
+            {"journalLinesPerDay", m_options.workload.journalLinesPerDay},
+            {"seed", m_options.workload.seed},
+            {"sessions", stats.sessions},
+            {"upgrades", stats.upgrades},
+            {"pacmanLines", stats.pacmanLines},
+            {"journalLines", stats.journalLines}
+        }},
+        {"phases", phases}
+    };
+}
+
+} // namespace khronicle::bench
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QString>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "bench/workload_generator.hpp"
+
+namespace khronicle::bench {
+
+struct BenchOptions {
+    WorkloadConfig workload;
+    // Operations timed per query, diff and report phase.
+    int queryIterations = 200;
+    int diffIterations = 200;
+    int reportIterations = 20;
+    // Existing directory for generated logs, the database (under home/) and
+    // daemon logs.
+    QString workDir;
+};
+
+struct PhaseResult {
+    std::string name;
+    // What items counts: lines, events, rows, bytes, ...
+    std::string unit;
+    std::size_t items = 0;
+    double totalMs = 0.0;
+    // One sample per timed operation.
+    std::vector<double> samplesMs;
+};
+
+// Runs a synthetic workload end to end through the real code paths: log
+// generation, the pacman and journal parsers, a daemon ingestion cycle into
+// SQLite, snapshot storage, event window queries (store and JSON-RPC),
+// snapshot diffs and the timeline report.
+class BenchRunner
+{
+public:
+    explicit BenchRunner(const BenchOptions &options);
+
+    // Returns false with a message on stderr when the workload cannot be set
+    // up; phases that ran keep their results.
+    bool run();
+
+    const std::vector<PhaseResult> &results() const { return m_results; }
+    void printTable(std::FILE *out) const;
+    nlohmann::json toJson() const;
+
+private:
+    BenchOptions m_options;
+    WorkloadGenerator m_generator;
+    std::vector<PhaseResult> m_results;
+};
+
+} // namespace khronicle::bench
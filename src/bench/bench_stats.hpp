@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace khronicle::bench {
+
+// Latency distribution of one benchmark phase, in milliseconds.
+struct LatencySummary {
+    std::size_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Nearest-rank percentiles; sorts samples in place.
+inline LatencySummary summarizeLatencies(std::vector<double> &samples)
+{
+    LatencySummary summary;
+    summary.count = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto rank = [&samples](double p) {
+        const auto index = static_cast<std::size_t>(
+            std::ceil(p * static_cast<double>(samples.size())));
+        return samples[std::clamp<std::size_t>(index, 1, samples.size()) - 1];
+    };
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0)
+        / static_cast<double>(samples.size());
+    summary.p50 = rank(0.50);
+    summary.p95 = rank(0.95);
+    summary.p99 = rank(0.99);
+    summary.max = samples.back();
+    return summary;
+}
+
+} // namespace khronicle::bench
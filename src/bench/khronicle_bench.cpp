@@ -0,0 +1,114 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <memory>
+
+#include <nlohmann/json.hpp>
+
+#include "bench/bench_runner.hpp"
+#include "common/logging.hpp"
+
+// End-to-end benchmark on a synthetic host history. The workload is a pure
+// function of the options, so two runs with the same flags on two builds
+// measure the same work; pass --json to keep results for comparison.
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("khronicle-bench"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption yearsOption(QStringList() << "years",
+                                   "Years of history to generate.", "n",
+                                   QStringLiteral("3"));
+    QCommandLineOption packagesOption(QStringList() << "packages",
+                                      "Installed packages.", "n",
+                                      QStringLiteral("1200"));
+    QCommandLineOption cadenceOption(QStringList() << "upgrades-per-week",
+                                     "Upgrade sessions per week.", "n",
+                                     QStringLiteral("3"));
+    QCommandLineOption shareOption(QStringList() << "upgrade-share",
+                                   "Share of packages touched per session.", "fraction",
+                                   QStringLiteral("0.05"));
+    QCommandLineOption journalOption(QStringList() << "journal-lines-per-day",
+                                     "Journal lines per day (GPU/firmware noise included).", "n",
+                                     QStringLiteral("40"));
+    QCommandLineOption seedOption(QStringList() << "seed",
+                                  "Workload random seed.", "n",
+                                  QStringLiteral("1"));
+    QCommandLineOption queriesOption(QStringList() << "queries",
+                                     "Timed operations per query phase.", "n",
+                                     QStringLiteral("200"));
+    QCommandLineOption diffsOption(QStringList() << "diffs",
+                                   "Timed snapshot diffs.", "n",
+                                   QStringLiteral("200"));
+    QCommandLineOption reportsOption(QStringList() << "reports",
+                                     "Timed timeline reports.", "n",
+                                     QStringLiteral("20"));
+    QCommandLineOption workDirOption(QStringList() << "work-dir",
+                                     "Keep generated logs and the database in <dir> "
+                                     "instead of a temporary directory.", "dir");
+    QCommandLineOption jsonOption(QStringList() << "json",
+                                  "Also write results as JSON to <path>.", "path");
+    parser.addOptions({yearsOption, packagesOption, cadenceOption, shareOption,
+                       journalOption, seedOption, queriesOption, diffsOption,
+                       reportsOption, workDirOption, jsonOption});
+    parser.process(app);
+
+    khronicle::bench::BenchOptions options;
+    options.workload.years = parser.value(yearsOption).toInt();
+    options.workload.packages = parser.value(packagesOption).toInt();
+    options.workload.upgradesPerWeek = parser.value(cadenceOption).toDouble();
+    options.workload.upgradeShare = parser.value(shareOption).toDouble();
+    options.workload.journalLinesPerDay = parser.value(journalOption).toInt();
+    options.workload.seed = parser.value(seedOption).toULongLong();
+    options.queryIterations = parser.value(queriesOption).toInt();
+    options.diffIterations = parser.value(diffsOption).toInt();
+    options.reportIterations = parser.value(reportsOption).toInt();
+
+    if (options.workload.years <= 0 || options.workload.packages <= 0
+        || options.workload.upgradesPerWeek <= 0.0 || options.workload.upgradeShare <= 0.0
+        || options.workload.journalLinesPerDay < 0 || options.queryIterations < 0
+        || options.diffIterations < 0 || options.reportIterations < 0) {
+        std::fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    std::unique_ptr<QTemporaryDir> tempDir;
+    if (parser.isSet(workDirOption)) {
+        options.workDir = QDir(parser.value(workDirOption)).absolutePath();
+        QDir().mkpath(options.workDir);
+    } else {
+        tempDir = std::make_unique<QTemporaryDir>();
+        if (!tempDir->isValid()) {
+            std::fprintf(stderr, "failed to create temp dir\n");
+            return 1;
+        }
+        options.workDir = tempDir->path();
+    }
+
+    // Daemon logs stay with the workload; the bench measures the default
+    // (non-trace) logging configuration.
+    qputenv("KHRONICLE_LOG_DIR", (options.workDir + QStringLiteral("/logs")).toUtf8());
+    khronicle::logging::initLogging(QStringLiteral("khronicle-bench"), false);
+
+    khronicle::bench::BenchRunner runner(options);
+    const bool ok = runner.run();
+    khronicle::logging::flushLogs();
+    runner.printTable(stdout);
+
+    if (parser.isSet(jsonOption)) {
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "failed to write %s\n", qPrintable(parser.value(jsonOption)));
+            return 1;
+        }
+        file.write(QByteArray::fromStdString(runner.toJson().dump(2)));
+    }
+    return ok ? 0 : 1;
+}
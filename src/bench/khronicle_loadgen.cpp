@@ -0,0 +1,211 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <cstdio>
+#include <memory>
+#include <optional>
+
+#include <nlohmann/json.hpp>
+
+#include "bench/load_generator.hpp"
+#include "bench/workload_generator.hpp"
+#include "common/logging.hpp"
+#include "common/process_utils.hpp"
+#include "daemon/journal_parser.hpp"
+#include "daemon/khronicle_api_server.hpp"
+#include "daemon/khronicle_store.hpp"
+#include "daemon/pacman_parser.hpp"
+
+// Concurrent load against the JSON-RPC API. By default it targets the
+// running daemon's socket; --in-process serves a synthetic store from a
+// server thread inside this process instead, so the numbers do not depend
+// on whatever history the local machine has.
+
+namespace {
+
+// Roughly what the UI, tray and report CLI send while a user browses.
+constexpr const char *kDefaultMix =
+    "get_changes_since=5,get_changes_between=3,list_snapshots=2,"
+    "summary_since=2,get_watch_signals_since=2,diff_snapshots=1";
+
+std::optional<std::vector<std::pair<std::string, double>>> parseMix(const QString &text)
+{
+    std::vector<std::pair<std::string, double>> mix;
+    for (const QString &entry : text.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        const QStringList parts = entry.split(QLatin1Char('='));
+        bool ok = parts.size() == 1;
+        const double weight = parts.size() == 2 ? parts[1].toDouble(&ok) : 1.0;
+        if (!ok || weight < 0.0 || parts[0].trimmed().isEmpty()) {
+            return std::nullopt;
+        }
+        mix.emplace_back(parts[0].trimmed().toStdString(), weight);
+    }
+    if (mix.empty()) {
+        return std::nullopt;
+    }
+    return mix;
+}
+
+// Fills the store under $HOME with a generated history.
+bool populateStore(const khronicle::bench::WorkloadConfig &config, const QString &dir)
+{
+    khronicle::bench::WorkloadGenerator generator(config);
+    const QString pacmanPath = dir + QStringLiteral("/pacman.log");
+    const QString journalPath = dir + QStringLiteral("/journal.txt");
+    if (!generator.writePacmanLog(pacmanPath) || !generator.writeJournal(journalPath)) {
+        return false;
+    }
+    qputenv("KHRONICLE_JOURNAL_PATH", journalPath.toUtf8());
+
+    khronicle::KhronicleStore store;
+    for (const auto &event :
+         khronicle::parsePacmanLog(pacmanPath.toStdString(), std::nullopt).events) {
+        store.addEvent(event);
+    }
+    for (const auto &event :
+         khronicle::parseJournalSince(generator.start() - std::chrono::hours(1)).events) {
+        store.addEvent(event);
+    }
+    const khronicle::HostIdentity host = store.getHostIdentity();
+    for (auto snapshot : generator.snapshots()) {
+        snapshot.hostIdentity = host;
+        store.addSnapshot(snapshot);
+    }
+    std::fprintf(stderr, "synthetic store: %zu upgrades, %zu snapshots\n",
+                 generator.stats().upgrades, generator.stats().snapshots);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("khronicle-loadgen"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption connectionsOption(QStringList() << "connections",
+                                         "Concurrent client connections.", "n",
+                                         QStringLiteral("4"));
+    QCommandLineOption rateOption(QStringList() << "rate",
+                                  "Requests per second across all connections; "
+                                  "0 runs closed-loop.", "n",
+                                  QStringLiteral("50"));
+    QCommandLineOption durationOption(QStringList() << "duration",
+                                      "Seconds to issue requests.", "seconds",
+                                      QStringLiteral("10"));
+    QCommandLineOption mixOption(QStringList() << "mix",
+                                 "Weighted method mix, e.g. "
+                                 "\"get_changes_since=5,list_snapshots=1\".", "mix",
+                                 QString::fromLatin1(kDefaultMix));
+    QCommandLineOption socketOption(QStringList() << "socket",
+                                    "Daemon socket (default: the daemon's own).", "name");
+    QCommandLineOption inProcessOption(QStringList() << "in-process",
+                                       "Serve a synthetic store from this process.");
+    QCommandLineOption yearsOption(QStringList() << "years",
+                                   "Years of synthetic history with --in-process.", "n",
+                                   QStringLiteral("1"));
+    QCommandLineOption seedOption(QStringList() << "seed",
+                                  "Random seed for the workload and request mix.", "n",
+                                  QStringLiteral("1"));
+    QCommandLineOption jsonOption(QStringList() << "json",
+                                  "Also write results as JSON to <path>.", "path");
+    parser.addOptions({connectionsOption, rateOption, durationOption, mixOption,
+                       socketOption, inProcessOption, yearsOption, seedOption, jsonOption});
+    parser.process(app);
+
+    khronicle::bench::LoadOptions options;
+    options.connections = parser.value(connectionsOption).toInt();
+    options.rate = parser.value(rateOption).toDouble();
+    options.duration = std::chrono::seconds(parser.value(durationOption).toInt());
+    options.seed = parser.value(seedOption).toULongLong();
+    const auto mix = parseMix(parser.value(mixOption));
+    const int years = parser.value(yearsOption).toInt();
+    if (options.connections <= 0 || options.rate < 0.0 || options.duration.count() <= 0
+        || !mix || years <= 0) {
+        std::fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+    options.mix = *mix;
+    options.socketName = parser.isSet(socketOption) ? parser.value(socketOption)
+                                                    : khronicle::daemonSocketPath();
+
+    std::unique_ptr<QTemporaryDir> tempDir;
+    std::unique_ptr<khronicle::KhronicleStore> store;
+    QThread serverThread;
+    QObject serverContext;
+    khronicle::KhronicleApiServer *server = nullptr;
+    if (parser.isSet(inProcessOption)) {
+        tempDir = std::make_unique<QTemporaryDir>();
+        if (!tempDir->isValid()) {
+            std::fprintf(stderr, "failed to create temp dir\n");
+            return 1;
+        }
+        const QString home = tempDir->path() + QStringLiteral("/home");
+        QDir().mkpath(home);
+        qputenv("HOME", home.toUtf8());
+        qputenv("KHRONICLE_LOG_DIR", (tempDir->path() + QStringLiteral("/logs")).toUtf8());
+        khronicle::logging::initLogging(QStringLiteral("khronicle-loadgen"), false);
+
+        khronicle::bench::WorkloadConfig config;
+        config.years = years;
+        config.seed = options.seed;
+        if (!populateStore(config, tempDir->path())) {
+            std::fprintf(stderr, "failed to generate workload\n");
+            return 1;
+        }
+
+        // The server gets its own thread so that its event loop, not the
+        // load generator's, decides how quickly requests are answered. The
+        // store is opened, used and closed on that thread only.
+        options.socketName = QStringLiteral("khronicle-loadgen-%1")
+                                 .arg(QCoreApplication::applicationPid());
+        qputenv("KHRONICLE_SOCKET_NAME", options.socketName.toUtf8());
+        serverContext.moveToThread(&serverThread);
+        serverThread.start();
+        bool started = false;
+        QMetaObject::invokeMethod(&serverContext, [&] {
+            store = std::make_unique<khronicle::KhronicleStore>();
+            server = new khronicle::KhronicleApiServer(*store);
+            started = server->start();
+        }, Qt::BlockingQueuedConnection);
+        if (!started) {
+            std::fprintf(stderr, "failed to listen on %s\n", qPrintable(options.socketName));
+        }
+    }
+
+    khronicle::bench::LoadGenerator generator(options);
+    const bool ok = generator.run();
+
+    if (server) {
+        QMetaObject::invokeMethod(&serverContext, [&] {
+            delete server;
+            store.reset();
+        }, Qt::BlockingQueuedConnection);
+    }
+    serverThread.quit();
+    serverThread.wait();
+    khronicle::logging::flushLogs();
+
+    if (!ok) {
+        std::fprintf(stderr, "could not connect to %s\n", qPrintable(options.socketName));
+        return 1;
+    }
+    generator.printReport(stdout);
+
+    if (parser.isSet(jsonOption)) {
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "failed to write %s\n", qPrintable(parser.value(jsonOption)));
+            return 1;
+        }
+        file.write(QByteArray::fromStdString(generator.toJson().dump(2)));
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "bench/microbench.hpp"
+#include "bench/workload_generator.hpp"
+#include "common/json_utils.hpp"
+#include "common/logging.hpp"
+#include "daemon/journal_parser.hpp"
+#include "daemon/khronicle_store.hpp"
+#include "daemon/pacman_parser.hpp"
+#include "daemon/watch_engine.hpp"
+
+// Hot-loop timings for the daemon's per-item code: log parsing, journal
+// classification, watch rule evaluation, snapshot diffs and JSON
+// conversion. Inputs come from the bench workload generator with a fixed
+// seed, so numbers are comparable across commits; --json saves a run and
+// --baseline prints the change against a saved one.
+
+namespace {
+
+using khronicle::bench::MicroBenchmarkSuite;
+
+// Opens a store in its own directory; the store path comes from HOME.
+std::shared_ptr<khronicle::KhronicleStore> openStore(const QString &home)
+{
+    QDir().mkpath(home);
+    qputenv("HOME", home.toUtf8());
+    return std::make_shared<khronicle::KhronicleStore>();
+}
+
+void addWatchEngineCase(MicroBenchmarkSuite &suite,
+                        const QString &home,
+                        int ruleCount,
+                        const std::vector<khronicle::KhronicleEvent> &events)
+{
+    auto store = openStore(home);
+    // Rules pass the cheap checks for some events but never match, so the
+    // loop measures evaluation rather than signal inserts.
+    for (int i = 0; i < ruleCount; ++i) {
+        khronicle::WatchRule rule;
+        rule.id = "bench-rule-" + std::to_string(i);
+        rule.name = rule.id;
+        rule.scope = khronicle::WatchScope::Event;
+        rule.severity = khronicle::WatchSeverity::Warning;
+        rule.categoryEquals = i % 3 == 0 ? "kernel" : "";
+        rule.riskLevelAtLeast = i % 2 == 0 ? "important" : "";
+        rule.packageNameContains = "zz-no-such-package-" + std::to_string(i);
+        rule.extra = nlohmann::json::object();
+        store->upsertWatchRule(rule);
+    }
+    auto engine = std::make_shared<khronicle::WatchEngine>(*store);
+
+    suite.add("watch/evaluate_event/" + std::to_string(ruleCount) + "_rules",
+              [store, engine, &events] {
+                  for (const auto &event : events) {
+                      engine->evaluateEvent(event);
+                  }
+                  return events.size();
+              });
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("khronicle-microbench"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption filterOption(QStringList() << "filter",
+                                    "Only run benchmarks whose name contains <text>.", "text");
+    QCommandLineOption batchOption(QStringList() << "min-batch-ms",
+                                   "Minimum duration of one timed batch.", "ms",
+                                   QStringLiteral("200"));
+    QCommandLineOption repetitionsOption(QStringList() << "repetitions",
+                                         "Timed batches per benchmark.", "n",
+                                         QStringLiteral("5"));
+    QCommandLineOption jsonOption(QStringList() << "json",
+                                  "Write results as JSON to <path>.", "path");
+    QCommandLineOption baselineOption(QStringList() << "baseline",
+                                      "Compare against a previous --json run.", "path");
+    parser.addOptions({filterOption, batchOption, repetitionsOption, jsonOption, baselineOption});
+    parser.process(app);
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        std::fprintf(stderr, "failed to create temp dir\n");
+        return 1;
+    }
+    qputenv("KHRONICLE_LOG_DIR", (tempDir.path() + QStringLiteral("/logs")).toUtf8());
+    khronicle::logging::initLogging(QStringLiteral("khronicle-microbench"), false);
+
+    khronicle::bench::WorkloadConfig config;
+    config.years = 1;
+    const QString pacmanPath = tempDir.path() + QStringLiteral("/pacman.log");
+    const QString journalPath = tempDir.path() + QStringLiteral("/journal.txt");
+    khronicle::bench::WorkloadGenerator generator(config);
+    if (!generator.writePacmanLog(pacmanPath) || !generator.writeJournal(journalPath)) {
+        std::fprintf(stderr, "failed to write workload\n");
+        return 1;
+    }
+
+    QFile journalFile(journalPath);
+    if (!journalFile.open(QIODevice::ReadOnly)) {
+        return 1;
+    }
+    const QStringList journalLines =
+        QString::fromUtf8(journalFile.readAll()).split('\n', Qt::SkipEmptyParts);
+    const auto journalSince = generator.start() - std::chrono::hours(1);
+
+    std::vector<khronicle::KhronicleEvent> events =
+        khronicle::parsePacmanLog(pacmanPath.toStdString(), std::nullopt).events;
+    events.resize(std::min<std::size_t>(events.size(), 1000));
+    std::vector<nlohmann::json> eventsJson(events.begin(), events.end());
+
+    MicroBenchmarkSuite suite;
+    const std::size_t pacmanLines = generator.stats().pacmanLines;
+
+    suite.add("pacman/parse_log", [&] {
+        const auto result = khronicle::parsePacmanLog(pacmanPath.toStdString(), std::nullopt);
+        return result.events.empty() ? std::size_t{0} : pacmanLines;
+    });
+
+    suite.add("journal/classify_lines", [&] {
+        const auto result = khronicle::parseJournalOutputLines(journalLines, journalSince);
+        return result.events.empty() ? std::size_t{0}
+                                     : static_cast<std::size_t>(journalLines.size());
+    });
+
+    for (const int rules : {10, 100, 1000}) {
+        addWatchEngineCase(suite,
+                           tempDir.path() + QStringLiteral("/rules-%1").arg(rules),
+                           rules,
+                           events);
+    }
+
+    // Two snapshots of a host with a large inventory, a tenth of it upgraded
+    // in between.
+    constexpr int kInventory = 5000;
+    auto diffStore = openStore(tempDir.path() + QStringLiteral("/diff"));
+    {
+        khronicle::SystemSnapshot before;
+        before.id = "bench-before";
+        before.timestamp = generator.start();
+        before.kernelVersion = "6.1.1-1";
+        before.gpuDriver = {{"mesa", "24.0.1-1"}};
+        before.firmwareVersions = {{"linux-firmware", "20240101-1"}};
+        before.keyPackages = nlohmann::json::object();
+        for (int i = 0; i < kInventory; ++i) {
+            before.keyPackages["bench-lib-" + std::to_string(i)] = "1.0." + std::to_string(i) + "-1";
+        }
+        before.hostIdentity = diffStore->getHostIdentity();
+
+        khronicle::SystemSnapshot after = before;
+        after.id = "bench-after";
+        after.timestamp = generator.end();
+        after.kernelVersion = "6.2.1-1";
+        for (int i = 0; i < kInventory; i += 10) {
+            after.keyPackages["bench-lib-" + std::to_string(i)] = "1.1.0-1";
+        }
+        diffStore->addSnapshot(before);
+        diffStore->addSnapshot(after);
+    }
+    suite.add("diff/snapshots_5000_packages", [diffStore] {
+        const auto diff = diffStore->diffSnapshots("bench-before", "bench-after");
+        return diff.changedFields.empty() ? std::size_t{0}
+                                          : static_cast<std::size_t>(kInventory);
+    });
+
+    suite.add("json/event_to_json", [&events] {
+        std::size_t fields = 0;
+        for (const auto &event : events) {
+            const nlohmann::json json = event;
+            fields += json.size();
+        }
+        return fields ? events.size() : std::size_t{0};
+    });
+
+    suite.add("json/event_from_json", [&eventsJson] {
+        std::size_t parsed = 0;
+        for (const auto &json : eventsJson) {
+            const auto event = json.get<khronicle::KhronicleEvent>();
+            parsed += event.id.empty() ? 0 : 1;
+        }
+        return parsed;
+    });
+
+    MicroBenchmarkSuite::Options options;
+    options.filter = parser.value(filterOption);
+    options.minBatchMs = parser.value(batchOption).toDouble();
+    options.repetitions = parser.value(repetitionsOption).toInt();
+    const auto results = suite.run(options);
+
+    nlohmann::json baseline;
+    if (parser.isSet(baselineOption)) {
+        QFile file(parser.value(baselineOption));
+        if (file.open(QIODevice::ReadOnly)) {
+            baseline = nlohmann::json::parse(file.readAll().toStdString(), nullptr, false);
+        }
+        if (!baseline.is_object()) {
+            std::fprintf(stderr, "ignoring unreadable baseline %s\n",
+                         qPrintable(parser.value(baselineOption)));
+        }
+    }
+    MicroBenchmarkSuite::printTable(stdout, results, baseline);
+
+    if (parser.isSet(jsonOption)) {
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "failed to write %s\n", qPrintable(parser.value(jsonOption)));
+            return 1;
+        }
+        file.write(QByteArray::fromStdString(MicroBenchmarkSuite::toJson(results).dump(2)));
+    }
+    khronicle::logging::flushLogs();
+    return 0;
+}
@@ -0,0 +1,351 @@
+#include "bench/load_generator.hpp"
+
+#include <QEventLoop>
+#include <QLocalSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#include "bench/bench_stats.hpp"
+#include "common/json_utils.hpp"
+
+namespace khronicle::bench {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Time allowed after the run for answers to requests already sent.
+constexpr auto kDrainTimeout = std::chrono::seconds(5);
+
+double msSince(SteadyClock::time_point from, SteadyClock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+struct LoadGenerator::Connection {
+    struct Pending {
+        std::string method;
+        SteadyClock::time_point dueAt;
+    };
+
+    std::unique_ptr<QLocalSocket> socket;
+    QByteArray buffer;
+    // By JSON-RPC id, so a reordered or stray answer cannot be charged to
+    // another request.
+    std::unordered_map<int, Pending> inFlight;
+    bool alive = true;
+};
+
+LoadGenerator::LoadGenerator(const LoadOptions &options)
+    : m_options(options)
+    , m_anchor(std::chrono::system_clock::now())
+    , m_random(options.seed)
+{
+}
+
+bool LoadGenerator::discover(Connection &connection)
+{
+    // One synchronous list_snapshots before the run gives snapshot ids for
+    // get_snapshot/diff_snapshots and anchors time windows at the newest
+    // snapshot, so synthetic stores with an old history get real results.
+    connection.socket->write(R"({"id":0,"method":"list_snapshots","params":{}})" "\n");
+    QByteArray response;
+    while (!response.contains('\n')) {
+        if (!connection.socket->waitForReadyRead(5000)) {
+            return false;
+        }
+        response += connection.socket->readAll();
+    }
+
+    const auto parsed = nlohmann::json::parse(
+        response.left(response.indexOf('\n')).toStdString(), nullptr, false);
+    if (parsed.is_discarded() || !parsed.contains("result")) {
+        return false;
+    }
+    std::chrono::system_clock::time_point newest;
+    for (const auto &snapshot : parsed["result"].value("snapshots", nlohmann::json::array())) {
+        m_snapshotIds.push_back(snapshot.value("id", ""));
+        newest = std::max(newest, fromIso8601Utc(snapshot.value("timestamp", "")));
+    }
+    if (newest != std::chrono::system_clock::time_point{}) {
+        m_anchor = newest;
+    }
+    return true;
+}
+
+nlohmann::json LoadGenerator::paramsFor(const std::string &method)
+{
+    const auto randomSnapshot = [this] {
+        return m_snapshotIds.empty() ? std::string()
+                                     : m_snapshotIds[m_random() % m_snapshotIds.size()];
+    };
+
+    if (method == "get_changes_since" || method == "summary_since"
+        || method == "get_watch_signals_since") {
+        return {{"since", toIso8601Utc(m_anchor - std::chrono::hours(24 * 7))}};
+    }
+    if (method == "get_changes_between" || method == "explain_change_between") {
+        return {{"from", toIso8601Utc(m_anchor - std::chrono::hours(24 * 30))},
+                {"to", toIso8601Utc(m_anchor)}};
+    }
+    if (method == "get_snapshot") {
+        return {{"id", randomSnapshot()}};
+    }
+    if (method == "diff_snapshots") {
+        return {{"a", randomSnapshot()}, {"b", randomSnapshot()}};
+    }
+    if (method == "what_changed_since_last_good") {
+        return {{"referenceSnapshotId", randomSnapshot()}};
+    }
+    return nlohmann::json::object();
+}
+
+bool LoadGenerator::run()
+{
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (int i = 0; i < m_options.connections; ++i) {
+        auto connection = std::make_unique<Connection>();
+        connection->socket = std::make_unique<QLocalSocket>();
+        connection->socket->connectToServer(m_options.socketName);
+        if (!connection->socket->waitForConnected(2000)) {
+            std::fprintf(stderr, "connection %d to %s failed: %s\n", i,
+                         qPrintable(m_options.socketName),
+                         qPrintable(connection->socket->errorString()));
+            continue;
+        }
+        connections.push_back(std::move(connection));
+    }
+    if (connections.empty()) {
+        return false;
+    }
+    if (!discover(*connections.front())) {
+        std::fprintf(stderr, "list_snapshots failed; snapshot methods will use empty ids\n");
+    }
+
+    std::vector<double> cumulative;
+    double totalWeight = 0.0;
+    for (const auto &[method, weight] : m_options.mix) {
+        totalWeight += weight;
+        cumulative.push_back(totalWeight);
+        m_stats[method];
+    }
+    if (totalWeight <= 0.0) {
+        return false;
+    }
+    const auto pickMethod = [&]() -> const std::string & {
+        const double x = static_cast<double>(m_random() >> 11) * 0x1.0p-53 * totalWeight;
+        const auto it = std::upper_bound(cumulative.begin(), cumulative.end(), x);
+        const auto index = std::min<std::size_t>(
+            static_cast<std::size_t>(it - cumulative.begin()), cumulative.size() - 1);
+        return m_options.mix[index].first;
+    };
+
+    const bool closedLoop = m_options.rate <= 0.0;
+    const auto start = SteadyClock::now();
+    const auto stopAt = start + m_options.duration;
+    bool issuing = true;
+    std::size_t scheduled = 0;
+    std::size_t inFlight = 0;
+    std::size_t nextConnection = 0;
+    int nextId = 1;
+
+    QEventLoop loop;
+    const auto maybeFinish = [&] {
+        if (!issuing && inFlight == 0) {
+            loop.quit();
+        }
+    };
+    const auto send = [&](Connection &connection, SteadyClock::time_point dueAt) {
+        const std::string &method = pickMethod();
+        const nlohmann::json request = {
+            {"id", nextId++}, {"method", method}, {"params", paramsFor(method)}
+        };
+        QByteArray line = QByteArray::fromStdString(request.dump());
+        line.append('\n');
+        connection.socket->write(line);
+        connection.inFlight.emplace(request["id"].get<int>(), Connection::Pending{method, dueAt});
+        ++m_stats[method].sent;
+        m_maxInFlight = std::max(m_maxInFlight, ++inFlight);
+    };
+
+    for (auto &owned : connections) {
+        Connection *connection = owned.get();
+        QObject::connect(connection->socket.get(), &QLocalSocket::readyRead, &loop, [&, connection] {
+            connection->buffer.append(connection->socket->readAll());
+            qsizetype newline = 0;
+            while ((newline = connection->buffer.indexOf('\n')) >= 0) {
+                const QByteArray line = connection->buffer.left(newline);
+                connection->buffer.remove(0, newline + 1);
+                if (line.trimmed().isEmpty()) {
+                    continue;
+                }
+                const auto now = SteadyClock::now();
+                const auto parsed = nlohmann::json::parse(line.toStdString(), nullptr, false);
+                const auto found = !parsed.is_discarded() && parsed.is_object()
+                        && parsed.contains("id") && parsed["id"].is_number_integer()
+                    ? connection->inFlight.find(parsed["id"].get<int>())
+                    : connection->inFlight.end();
+                if (found == connection->inFlight.end()) {
+                    // Unparsable, or not an answer to anything in flight.
+                    ++m_unmatchedResponses;
+                    continue;
+                }
+                const Connection::Pending pending = found->second;
+                connection->inFlight.erase(found);
+                --inFlight;
+
+                MethodLoadStats &stats = m_stats[pending.method];
+                if (parsed.contains("error")) {
+                    ++stats.errors;
+                } else {
+                    stats.latenciesMs.push_back(msSince(pending.dueAt, now));
+                }
+                if (closedLoop && issuing && now < stopAt) {
+                    send(*connection, now);
+                }
+            }
+            maybeFinish();
+        });
+        QObject::connect(connection->socket.get(), &QLocalSocket::disconnected, &loop,
+                         [&, connection] {
+                             connection->alive = false;
+                             for (const auto &[id, pending] : connection->inFlight) {
+                                 ++m_stats[pending.method].dropped;
+                             }
+                             inFlight -= connection->inFlight.size();
+                             connection->inFlight.clear();
+                             maybeFinish();
+                         });
+    }
+
+    QTimer ticker;
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(1);
+    QObject::connect(&ticker, &QTimer::timeout, &loop, [&] {
+        // Send everything that has come due, round robin over live
+        // connections; a busy connection queues on its socket like a real
+        // client would.
+        const auto now = SteadyClock::now();
+        while (issuing) {
+            const auto dueAt = start
+                + std::chrono::duration_cast<SteadyClock::duration>(
+                    std::chrono::duration<double>(static_cast<double>(scheduled) / m_options.rate));
+            if (dueAt > now || dueAt >= stopAt) {
+                break;
+            }
+            Connection *target = nullptr;
+            for (std::size_t i = 0; i < connections.size() && !target; ++i) {
+                Connection *candidate = connections[(nextConnection + i) % connections.size()].get();
+                if (candidate->alive) {
+                    target = candidate;
+                    nextConnection = (nextConnection + i + 1) % connections.size();
+                }
+            }
+            if (!target) {
+                issuing = false;
+                break;
+            }
+            send(*target, dueAt);
+            ++scheduled;
+        }
+        maybeFinish();
+    });
+
+    if (closedLoop) {
+        for (auto &connection : connections) {
+            send(*connection, start);
+        }
+    } else {
+        ticker.start();
+    }
+    QTimer::singleShot(m_options.duration, &loop, [&] {
+        issuing = false;
+        ticker.stop();
+        maybeFinish();
+    });
+    QTimer::singleShot(m_options.duration + kDrainTimeout, &loop, [&] { loop.quit(); });
+    loop.exec();
+    m_elapsedSeconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+
+    for (auto &connection : connections) {
+        connection->socket->disconnect();
+        for (const auto &[id, pending] : connection->inFlight) {
+            ++m_stats[pending.method].dropped;
+        }
+        connection->socket->abort();
+    }
+    return true;
+}
+
+void LoadGenerator::printReport(std::FILE *out) const
+{
+    std::fprintf(out, "%d connections, %s, %.1f s, max in flight %zu, unmatched responses %zu\n\n",
+                 m_options.connections,
+                 m_options.rate > 0.0
+                     ? qPrintable(QStringLiteral("%1 req/s offered").arg(m_options.rate))
+                     : "closed loop",
+                 m_elapsedSeconds, m_maxInFlight, m_unmatchedResponses);
+    std::fprintf(out, "%-30s %8s %8s %7s %7s %9s %9s %9s %9s %9s\n",
+                 "method", "sent", "ok", "errors", "dropped", "req/s",
+                 "p50 ms", "p95 ms", "p99 ms", "max ms");
+
+    std::vector<double> all;
+    std::size_t sent = 0;
+    std::size_t errors = 0;
+    std::size_t dropped = 0;
+    const auto printRow = [&](const std::string &name, std::size_t rowSent,
+                              std::vector<double> samples, std::size_t rowErrors,
+                              std::size_t rowDropped) {
+        const LatencySummary summary = summarizeLatencies(samples);
+        std::fprintf(out, "%-30s %8zu %8zu %7zu %7zu %9.1f %9.2f %9.2f %9.2f %9.2f\n",
+                     name.c_str(), rowSent, summary.count, rowErrors, rowDropped,
+                     m_elapsedSeconds > 0.0 ? static_cast<double>(summary.count) / m_elapsedSeconds
+                                            : 0.0,
+                     summary.p50, summary.p95, summary.p99, summary.max);
+    };
+    for (const auto &[method, stats] : m_stats) {
+        printRow(method, stats.sent, stats.latenciesMs, stats.errors, stats.dropped);
+        all.insert(all.end(), stats.latenciesMs.begin(), stats.latenciesMs.end());
+        sent += stats.sent;
+        errors += stats.errors;
+        dropped += stats.dropped;
+    }
+    printRow("all", sent, all, errors + m_unmatchedResponses, dropped);
+}
+
+nlohmann::json LoadGenerator::toJson() const
+{
+    nlohmann::json methods = nlohmann::json::object();
+    for (const auto &[method, stats] : m_stats) {
+        std::vector<double> samples = stats.latenciesMs;
+        const LatencySummary summary = summarizeLatencies(samples);
+        methods[method] = {
+            {"sent", stats.sent},
+            {"ok", summary.count},
+            {"errors", stats.errors},
+            {"dropped", stats.dropped},
+            {"throughput", m_elapsedSeconds > 0.0
+                               ? static_cast<double>(summary.count) / m_elapsedSeconds
+                               : 0.0},
+            {"p50Ms", summary.p50},
+            {"p95Ms", summary.p95},
+            {"p99Ms", summary.p99},
+            {"maxMs", summary.max}
+        };
+    }
+    return {
+        {"connections", m_options.connections},
+        {"rate", m_options.rate},
+        {"elapsedSeconds", m_elapsedSeconds},
+        {"maxInFlight", m_maxInFlight},
+        {"unmatchedResponses", m_unmatchedResponses},
+        {"methods", methods}
+    };
+}
+
+} // namespace khronicle::bench
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QString>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle::bench {
+
+struct LoadOptions {
+    QString socketName;
+    int connections = 4;
+    // Requests per second across all connections. 0 runs closed-loop: every
+    // connection sends its next request as soon as the previous answer
+    // arrives.
+    double rate = 50.0;
+    std::chrono::seconds duration{10};
+    // Method name -> relative weight.
+    std::vector<std::pair<std::string, double>> mix;
+    std::uint64_t seed = 1;
+};
+
+struct MethodLoadStats {
+    std::vector<double> latenciesMs;
+    std::size_t sent = 0;
+    // Error responses from the daemon.
+    std::size_t errors = 0;
+    // Requests lost to a disconnect or still unanswered at the end.
+    std::size_t dropped = 0;
+};
+
+// Drives a running API server over N QLocalSocket connections, like the UI,
+// tray and scripts do at the same time. In open-loop mode requests are due
+// at fixed intervals and latency is measured from when a request was due,
+// not when it was written, so a stalled server shows up as latency instead
+// of silently lowering the offered rate.
+class LoadGenerator
+{
+public:
+    explicit LoadGenerator(const LoadOptions &options);
+
+    // Connects, runs for the configured duration and drains outstanding
+    // requests. Returns false when no connection could be made.
+    bool run();
+
+    void printReport(std::FILE *out) const;
+    nlohmann::json toJson() const;
+
+private:
+    struct Connection;
+
+    bool discover(Connection &connection);
+    nlohmann::json paramsFor(const std::string &method);
+
+    LoadOptions m_options;
+    std::map<std::string, MethodLoadStats> m_stats;
+    std::vector<std::string> m_snapshotIds;
+    std::chrono::system_clock::time_point m_anchor;
+    std::mt19937_64 m_random;
+    double m_elapsedSeconds = 0.0;
+    std::size_t m_maxInFlight = 0;
+    // Answers whose id matched no request in flight; counted as errors of
+    // no particular method.
+    std::size_t m_unmatchedResponses = 0;
+};
+
+} // namespace khronicle::bench
@@ -0,0 +1,169 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "common/logging.hpp"
+#include "daemon/khronicle_store.hpp"
+#include "daemon/pacman_parser.hpp"
+
+// Measures what logging costs the ingestion path: a synthetic pacman.log is
+// parsed and stored once with codex trace off (DEBUG lines skipped at the
+// call site) and once with it on (every KLOG line formatted and queued),
+// plus a tight loop over a disabled KLOG_DEBUG to show the per-site cost.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool writePacmanLog(const QString &path, int events)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    for (int i = 0; i < events; ++i) {
+        const int minute = i % 60;
+        const int hour = (i / 60) % 24;
+        const QString line = QStringLiteral(
+            "[2026-02-04T%1:%2:00+0000] [ALPM] upgraded bench-pkg-%3 (1.0-1 -> 1.0-2)\n")
+                                 .arg(hour, 2, 10, QLatin1Char('0'))
+                                 .arg(minute, 2, 10, QLatin1Char('0'))
+                                 .arg(i);
+        file.write(line.toUtf8());
+    }
+    return true;
+}
+
+struct IngestResult {
+    std::size_t events = 0;
+    double parseMs = 0.0;
+    double storeMs = 0.0;
+    double flushMs = 0.0;
+};
+
+IngestResult runIngest(const QString &pacmanLog, const QString &home, bool codexTrace)
+{
+    QDir().mkpath(home);
+    qputenv("HOME", home.toUtf8());
+    khronicle::logging::initLogging(QStringLiteral("khronicle-bench-logging"), codexTrace);
+
+    IngestResult result;
+    khronicle::KhronicleStore store;
+
+    auto start = Clock::now();
+    const auto parsed = khronicle::parsePacmanLog(pacmanLog.toStdString(), std::nullopt);
+    result.parseMs = elapsedMs(start);
+    result.events = parsed.events.size();
+
+    start = Clock::now();
+    for (const auto &event : parsed.events) {
+        store.addEvent(event);
+    }
+    result.storeMs = elapsedMs(start);
+
+    start = Clock::now();
+    khronicle::logging::flushLogs();
+    result.flushMs = elapsedMs(start);
+    return result;
+}
+
+double disabledDebugNsPerCall(int iterations)
+{
+    khronicle::logging::initLogging(QStringLiteral("khronicle-bench-logging"), false);
+
+    const auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        KLOG_DEBUG(QStringLiteral("Bench"),
+                   QStringLiteral("disabledDebugNsPerCall"),
+                   QStringLiteral("disabled_debug"),
+                   QStringLiteral("benchmark"),
+                   QStringLiteral("tight_loop"),
+                   khronicle::logging::defaultWho(),
+                   QString(),
+                   (nlohmann::json{{"i", i}}));
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+    return elapsed.count() / iterations;
+}
+
+void printRow(const char *mode, const IngestResult &result)
+{
+    const double total = result.parseMs + result.storeMs + result.flushMs;
+    std::printf("%-10s %8zu %10.1f %10.1f %10.1f %10.1f %12.2f\n",
+                mode,
+                result.events,
+                result.parseMs,
+                result.storeMs,
+                result.flushMs,
+                total,
+                result.events ? (total * 1000.0) / result.events : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("khronicle-bench-logging"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption eventsOption(QStringList() << "events",
+                                    "Synthetic pacman events to ingest.",
+                                    "count",
+                                    QStringLiteral("20000"));
+    QCommandLineOption loopOption(QStringList() << "loop",
+                                  "Iterations of the disabled KLOG_DEBUG loop.",
+                                  "count",
+                                  QStringLiteral("1000000"));
+    parser.addOption(eventsOption);
+    parser.addOption(loopOption);
+    parser.process(app);
+
+    const int events = parser.value(eventsOption).toInt();
+    const int iterations = parser.value(loopOption).toInt();
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid() || events <= 0 || iterations <= 0) {
+        std::fprintf(stderr, "invalid arguments or temp dir\n");
+        return 1;
+    }
+
+    // Logs and databases stay inside the temp dir.
+    qputenv("KHRONICLE_LOG_DIR", (tempDir.path() + QStringLiteral("/logs")).toUtf8());
+
+    const QString pacmanLog = tempDir.path() + QStringLiteral("/pacman.log");
+    if (!writePacmanLog(pacmanLog, events)) {
+        std::fprintf(stderr, "failed to write %s\n", qPrintable(pacmanLog));
+        return 1;
+    }
+
+    const IngestResult off = runIngest(pacmanLog, tempDir.path() + QStringLiteral("/off"), false);
+    const IngestResult on = runIngest(pacmanLog, tempDir.path() + QStringLiteral("/on"), true);
+
+    std::printf("%-10s %8s %10s %10s %10s %10s %12s\n",
+                "trace", "events", "parse ms", "store ms", "flush ms", "total ms", "us/event");
+    printRow("off", off);
+    printRow("on", on);
+    std::printf("\ndisabled KLOG_DEBUG: %.2f ns/call (%d calls, min level %d)\n",
+                disabledDebugNsPerCall(iterations),
+                iterations,
+                KHRONICLE_LOG_MIN_LEVEL);
+    std::printf("dropped log records: %llu\n",
+                static_cast<unsigned long long>(khronicle::logging::droppedLogRecords()));
+    return 0;
+}
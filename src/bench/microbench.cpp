@@ -0,0 +1,142 @@
+#include "bench/microbench.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace khronicle::bench {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct Batch {
+    double ns = 0.0;
+    std::size_t items = 0;
+};
+
+Batch runBatch(const MicroBenchmarkSuite::Body &body, std::size_t iterations)
+{
+    Batch batch;
+    const auto start = SteadyClock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        batch.items += body();
+    }
+    batch.ns = std::chrono::duration<double, std::nano>(SteadyClock::now() - start).count();
+    return batch;
+}
+
+// Baseline entry with the same name, from a previous --json run.
+const nlohmann::json *findBaseline(const nlohmann::json &baseline, const std::string &name)
+{
+    if (!baseline.is_object() || !baseline.contains("results")) {
+        return nullptr;
+    }
+    for (const auto &entry : baseline["results"]) {
+        if (entry.value("name", "") == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void MicroBenchmarkSuite::add(std::string name, Body body)
+{
+    m_cases.push_back(Case{std::move(name), std::move(body)});
+}
+
+std::vector<MicroResult> MicroBenchmarkSuite::run(const Options &options) const
+{
+    std::vector<MicroResult> results;
+    const double minBatchNs = options.minBatchMs * 1e6;
+    const int repetitions = std::max(1, options.repetitions);
+
+    for (const Case &benchCase : m_cases) {
+        if (!options.filter.isEmpty()
+            && !QString::fromStdString(benchCase.name).contains(options.filter)) {
+            continue;
+        }
+
+        // Warm-up doubles as calibration: grow the batch until it is long
+        // enough that timer resolution and scheduling noise do not matter.
+        std::size_t iterations = 1;
+        Batch batch = runBatch(benchCase.body, iterations);
+        while (batch.ns < minBatchNs && iterations < (std::size_t{1} << 30)) {
+            const double scale = batch.ns > 0.0 ? minBatchNs / batch.ns : 10.0;
+            iterations = std::max(iterations + 1,
+                                  static_cast<std::size_t>(iterations * std::min(scale * 1.2, 10.0)));
+            batch = runBatch(benchCase.body, iterations);
+        }
+
+        std::vector<double> nsPerOp;
+        std::size_t items = 0;
+        for (int r = 0; r < repetitions; ++r) {
+            batch = runBatch(benchCase.body, iterations);
+            nsPerOp.push_back(batch.ns / static_cast<double>(iterations));
+            items = batch.items / iterations;
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+
+        MicroResult result;
+        result.name = benchCase.name;
+        result.iterations = iterations;
+        result.itemsPerOp = items;
+        result.medianNsPerOp = nsPerOp[nsPerOp.size() / 2];
+        result.minNsPerOp = nsPerOp.front();
+        result.maxNsPerOp = nsPerOp.back();
+        result.itemsPerSecond = result.medianNsPerOp > 0.0
+            ? static_cast<double>(items) * 1e9 / result.medianNsPerOp
+            : 0.0;
+        results.push_back(result);
+    }
+    return results;
+}
+
+void MicroBenchmarkSuite::printTable(std::FILE *out,
+                                     const std::vector<MicroResult> &results,
+                                     const nlohmann::json &baseline)
+{
+    std::fprintf(out, "%-36s %10s %14s %14s %14s %14s %9s\n",
+                 "benchmark", "iters", "median ns/op", "min ns/op", "ns/item",
+                 "items/s", "vs base");
+    for (const MicroResult &result : results) {
+        char delta[16] = "-";
+        if (const nlohmann::json *base = findBaseline(baseline, result.name)) {
+            const double before = base->value("medianNsPerOp", 0.0);
+            if (before > 0.0) {
+                std::snprintf(delta, sizeof(delta), "%+.1f%%",
+                              (result.medianNsPerOp - before) * 100.0 / before);
+            }
+        }
+        std::fprintf(out, "%-36s %10zu %14.0f %14.0f %14.1f %14.0f %9s\n",
+                     result.name.c_str(),
+                     result.iterations,
+                     result.medianNsPerOp,
+                     result.minNsPerOp,
+                     result.itemsPerOp
+                         ? result.medianNsPerOp / static_cast<double>(result.itemsPerOp)
+                         : 0.0,
+                     result.itemsPerSecond,
+                     delta);
+    }
+}
+
+nlohmann::json MicroBenchmarkSuite::toJson(const std::vector<MicroResult> &results)
+{
+    nlohmann::json entries = nlohmann::json::array();
+    for (const MicroResult &result : results) {
+        entries.push_back({
+            {"name", result.name},
+            {"iterations", result.iterations},
+            {"itemsPerOp", result.itemsPerOp},
+            {"medianNsPerOp", result.medianNsPerOp},
+            {"minNsPerOp", result.minNsPerOp},
+            {"maxNsPerOp", result.maxNsPerOp},
+            {"itemsPerSecond", result.itemsPerSecond}
+        });
+    }
+    return {{"results", entries}};
+}
+
+} // namespace khronicle::bench
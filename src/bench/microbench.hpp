@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QString>
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle::bench {
+
+struct MicroResult {
+    std::string name;
+    // Iterations per timed batch, after calibration.
+    std::size_t iterations = 0;
+    // Items one iteration processed (lines, events, rules x events, ...).
+    std::size_t itemsPerOp = 0;
+    double medianNsPerOp = 0.0;
+    double minNsPerOp = 0.0;
+    double maxNsPerOp = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+// A small in-tree micro-benchmark harness. Each case is a body that runs the
+// measured work once and returns how many items it processed; setup happens
+// before registration and is captured by the body. The harness calibrates an
+// iteration count so one batch takes at least minBatchMs, times several
+// batches and reports the median, which is what comparisons should use.
+class MicroBenchmarkSuite
+{
+public:
+    using Body = std::function<std::size_t()>;
+
+    struct Options {
+        double minBatchMs = 200.0;
+        int repetitions = 5;
+        // Only cases whose name contains this run.
+        QString filter;
+    };
+
+    void add(std::string name, Body body);
+    std::vector<MicroResult> run(const Options &options) const;
+
+    static void printTable(std::FILE *out,
+                           const std::vector<MicroResult> &results,
+                           const nlohmann::json &baseline = nlohmann::json());
+    static nlohmann::json toJson(const std::vector<MicroResult> &results);
+
+private:
+    struct Case {
+        std::string name;
+        Body body;
+    };
+    std::vector<Case> m_cases;
+};
+
+} // namespace khronicle::bench
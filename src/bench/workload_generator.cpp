@@ -0,0 +1,329 @@
+#include "bench/workload_generator.hpp"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <numeric>
+#include <random>
+
+namespace khronicle::bench {
+
+namespace {
+
+// Packages the daemon and reports treat specially; they come first in the
+// package list so snapshots can refer to them by index.
+constexpr const char *kKeyPackages[] = {
+    "linux", "linux-firmware", "mesa", "vulkan-radeon", "nvidia-utils",
+    "nvidia", "amd-ucode", "systemd", "glibc", "xorg-server"
+};
+constexpr std::size_t kKeyPackageCount = std::size(kKeyPackages);
+constexpr std::size_t kFlushBytes = 1 << 20;
+
+struct Version {
+    int major = 1;
+    int minor = 0;
+    int patch = 0;
+    int rel = 1;
+
+    std::string text() const
+    {
+        char buffer[48];
+        std::snprintf(buffer, sizeof(buffer), "%d.%d.%d-%d", major, minor, patch, rel);
+        return buffer;
+    }
+};
+
+// Distributions in <random> are implementation-defined; these helpers keep
+// the generated history identical across standard libraries.
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed) : m_engine(seed) {}
+
+    std::uint64_t below(std::uint64_t bound) { return m_engine() % bound; }
+    double unit() { return static_cast<double>(m_engine() >> 11) * 0x1.0p-53; }
+    double exponential(double mean) { return -std::log(1.0 - unit()) * mean; }
+
+private:
+    std::mt19937_64 m_engine;
+};
+
+void appendTimestamp(QByteArray &out, std::chrono::system_clock::time_point time)
+{
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer),
+                                     "%04d-%02d-%02dT%02d:%02d:%02d+0000",
+                                     tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                                     tm.tm_hour, tm.tm_min, tm.tm_sec);
+    out.append(buffer, length);
+}
+
+bool flushIfLarge(QFile &file, QByteArray &buffer, bool force = false)
+{
+    if (!force && buffer.size() < static_cast<qsizetype>(kFlushBytes)) {
+        return true;
+    }
+    const bool ok = file.write(buffer) == buffer.size();
+    buffer.clear();
+    return ok;
+}
+
+} // namespace
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig &config)
+    : m_config(config)
+{
+    m_config.years = std::max(1, m_config.years);
+    m_config.packages = std::max(m_config.packages, static_cast<int>(kKeyPackageCount));
+    m_start = m_config.end - std::chrono::hours(24 * 365 * m_config.years);
+    simulate();
+}
+
+void WorkloadGenerator::simulate()
+{
+    Random random(m_config.seed);
+
+    m_packageNames.assign(std::begin(kKeyPackages), std::end(kKeyPackages));
+    char name[32];
+    for (std::size_t i = kKeyPackageCount; i < static_cast<std::size_t>(m_config.packages); ++i) {
+        std::snprintf(name, sizeof(name), "bench-lib-%04zu", i);
+        m_packageNames.emplace_back(name);
+    }
+
+    std::vector<Version> versions(m_packageNames.size());
+    for (auto &version : versions) {
+        version.major = 1 + static_cast<int>(random.below(9));
+        version.minor = static_cast<int>(random.below(20));
+        version.patch = static_cast<int>(random.below(10));
+    }
+    versions[0] = Version{6, 1, 1, 1};
+
+    const double meanGapSeconds = 7.0 * 86400.0 / std::max(0.01, m_config.upgradesPerWeek);
+    const std::size_t perSession = std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::lround(m_config.upgradeShare * m_packageNames.size())));
+    std::vector<std::size_t> order(m_packageNames.size());
+
+    auto time = m_start;
+    while (true) {
+        time += std::chrono::seconds(
+            static_cast<long long>(random.exponential(meanGapSeconds)));
+        if (time >= m_config.end) {
+            break;
+        }
+
+        // Partial Fisher-Yates picks the session's packages; key packages
+        // get an extra chance since they move faster than most libraries.
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::vector<std::size_t> picked;
+        for (std::size_t i = 0; i < perSession; ++i) {
+            const std::size_t j = i + random.below(order.size() - i);
+            std::swap(order[i], order[j]);
+            picked.push_back(order[i]);
+        }
+        for (std::size_t key = 0; key < kKeyPackageCount; ++key) {
+            if (random.unit() < 0.3) {
+                picked.push_back(key);
+            }
+        }
+        std::sort(picked.begin(), picked.end(), [this](std::size_t a, std::size_t b) {
+            return m_packageNames[a] < m_packageNames[b];
+        });
+        picked.erase(std::unique(picked.begin(), picked.end()), picked.end());
+
+        Session session;
+        session.timestamp = time;
+        for (const std::size_t package : picked) {
+            Version &version = versions[package];
+            Upgrade upgrade{package, version.text(), {}};
+            const double roll = random.unit();
+            if (roll < 0.10) {
+                ++version.rel;
+            } else if (roll < 0.88) {
+                ++version.patch;
+                version.rel = 1;
+            } else if (roll < 0.98) {
+                ++version.minor;
+                version.patch = 0;
+                version.rel = 1;
+            } else {
+                ++version.major;
+                version.minor = 0;
+                version.patch = 0;
+                version.rel = 1;
+            }
+            upgrade.newVersion = version.text();
+            session.upgrades.push_back(std::move(upgrade));
+        }
+        for (std::size_t key = 0; key < kKeyPackageCount; ++key) {
+            session.keyVersions.push_back(versions[key].text());
+        }
+
+        m_stats.upgrades += session.upgrades.size();
+        m_stats.pacmanLines += session.upgrades.size() + 3;
+        m_sessions.push_back(std::move(session));
+    }
+    m_stats.sessions = m_sessions.size();
+    m_stats.snapshots = m_sessions.size();
+}
+
+bool WorkloadGenerator::writePacmanLog(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(kFlushBytes + 4096);
+    for (const Session &session : m_sessions) {
+        auto time = session.timestamp;
+        const auto line = [&](const char *tag, const std::string &text) {
+            buffer.append('[');
+            appendTimestamp(buffer, time);
+            buffer.append("] [").append(tag).append("] ");
+            buffer.append(text.data(), static_cast<qsizetype>(text.size()));
+            buffer.append('\n');
+        };
+
+        line("PACMAN", "Running 'pacman -Syu'");
+        line("ALPM", "transaction started");
+        for (const Upgrade &upgrade : session.upgrades) {
+            time += std::chrono::seconds(1);
+            line("ALPM", "upgraded " + m_packageNames[upgrade.package] + " ("
+                     + upgrade.oldVersion + " -> " + upgrade.newVersion + ")");
+        }
+        line("ALPM", "transaction completed");
+        if (!flushIfLarge(file, buffer)) {
+            return false;
+        }
+    }
+    return flushIfLarge(file, buffer, true);
+}
+
+bool WorkloadGenerator::writeJournal(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    // Separate stream from the package history so changing journal density
+    // does not reshuffle upgrades.
+    Random random(m_config.seed ^ 0x9e3779b97f4a7c15ULL);
+    // Each line template formats one random value; literal formats keep
+    // them checkable by -Wformat.
+    using LineWriter = int (*)(char *out, std::size_t size, unsigned long long value);
+    static constexpr LineWriter kNoise[] = {
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size, "systemd[1]: Started Session %llu of User bench.",
+                                 value);
+        },
+        [](char *out, std::size_t size, unsigned long long) {
+            return std::snprintf(out, size, "%s",
+                                 "NetworkManager[712]: <info>  dhcp4 (enp5s0): state changed new lease");
+        },
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size,
+                                 "kernel: usb 1-4: new high-speed USB device number %llu using xhci_hcd",
+                                 value);
+        },
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size, "systemd-logind[640]: New session %llu of user bench.",
+                                 value);
+        },
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size, "sshd[%llu]: Connection closed by authenticating user bench",
+                                 value);
+        },
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size,
+                                 "kernel: audit: type=1400 audit(%llu.120:44): apparmor=\"STATUS\"",
+                                 value);
+        }
+    };
+    static constexpr LineWriter kGpu[] = {
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size,
+                                 "kernel: amdgpu 0000:03:00.0: amdgpu: Fetched VBIOS version 113-D41%05llu-100",
+                                 value);
+        },
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size, "kernel: amdgpu: loading firmware version 0x%08llx",
+                                 value);
+        },
+        [](char *out, std::size_t size, unsigned long long value) {
+            return std::snprintf(out, size, "kernel: NVRM: loading NVIDIA driver version 550.%llu",
+                                 value);
+        }
+    };
+
+    QByteArray buffer;
+    buffer.reserve(kFlushBytes + 4096);
+    std::vector<int> offsets(static_cast<std::size_t>(std::max(0, m_config.journalLinesPerDay)));
+    char message[160];
+    m_stats.journalLines = 0;
+    m_stats.gpuJournalLines = 0;
+    for (auto day = m_start; day < m_config.end; day += std::chrono::hours(24)) {
+        for (int &offset : offsets) {
+            offset = static_cast<int>(random.below(86400));
+        }
+        std::sort(offsets.begin(), offsets.end());
+
+        for (const int offset : offsets) {
+            const unsigned long long value = random.below(100000);
+            const double roll = random.unit();
+            if (roll < 0.002) {
+                std::snprintf(message, sizeof(message),
+                              "fwupd[901]: Successfully installed firmware 'UEFI dbx' version %llu",
+                              value);
+                ++m_stats.gpuJournalLines;
+            } else if (roll < 0.15) {
+                kGpu[random.below(std::size(kGpu))](message, sizeof(message), value);
+                ++m_stats.gpuJournalLines;
+            } else {
+                kNoise[random.below(std::size(kNoise))](message, sizeof(message), value);
+            }
+            appendTimestamp(buffer, day + std::chrono::seconds(offset));
+            buffer.append(" benchhost ").append(message).append('\n');
+            ++m_stats.journalLines;
+        }
+        if (!flushIfLarge(file, buffer)) {
+            return false;
+        }
+    }
+    return flushIfLarge(file, buffer, true);
+}
+
+std::vector<SystemSnapshot> WorkloadGenerator::snapshots() const
+{
+    std::vector<SystemSnapshot> result;
+    result.reserve(m_sessions.size());
+    for (const Session &session : m_sessions) {
+        SystemSnapshot snapshot;
+        snapshot.timestamp = session.timestamp + std::chrono::minutes(10);
+        snapshot.id = "snapshot-"
+            + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 snapshot.timestamp.time_since_epoch())
+                                 .count());
+        snapshot.kernelVersion = session.keyVersions[0];
+        snapshot.keyPackages = nlohmann::json::object();
+        for (std::size_t key = 0; key < kKeyPackageCount; ++key) {
+            snapshot.keyPackages[kKeyPackages[key]] = session.keyVersions[key];
+        }
+        snapshot.gpuDriver = {{"mesa", session.keyVersions[2]},
+                              {"nvidia", session.keyVersions[5]}};
+        snapshot.firmwareVersions = {{"linux-firmware", session.keyVersions[1]},
+                                     {"amd-ucode", session.keyVersions[6]}};
+        result.push_back(std::move(snapshot));
+    }
+    return result;
+}
+
+} // namespace khronicle::bench
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QString>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/models.hpp"
+
+namespace khronicle::bench {
+
+// Shape of a synthetic host history. Defaults approximate a desktop Arch
+// install that is upgraded a few times a week.
+struct WorkloadConfig {
+    int years = 3;
+    // Installed packages; the named kernel/GPU/firmware packages are
+    // always among them.
+    int packages = 1200;
+    // Full-system upgrade sessions per week.
+    double upgradesPerWeek = 3.0;
+    // Share of installed packages touched by one session.
+    double upgradeShare = 0.05;
+    // Journal lines per day; most are unrelated noise, the rest GPU driver
+    // and firmware messages the journal parser picks up.
+    int journalLinesPerDay = 40;
+    std::uint64_t seed = 1;
+    // The history ends here, so a given config always produces the same
+    // timestamps regardless of when the bench runs.
+    std::chrono::system_clock::time_point end =
+        std::chrono::system_clock::from_time_t(1767225600); // 2026-01-01T00:00Z
+};
+
+struct WorkloadStats {
+    std::size_t sessions = 0;
+    std::size_t upgrades = 0;
+    std::size_t pacmanLines = 0;
+    std::size_t journalLines = 0;
+    std::size_t gpuJournalLines = 0;
+    std::size_t snapshots = 0;
+};
+
+// Generates pacman.log and journalctl short-iso text in the formats the
+// daemon's parsers read, plus the snapshots a daemon would have taken along
+// the way. The history is simulated once in the constructor; output is a
+// pure function of the config, so benchmark runs are comparable.
+class WorkloadGenerator
+{
+public:
+    explicit WorkloadGenerator(const WorkloadConfig &config);
+
+    std::chrono::system_clock::time_point start() const { return m_start; }
+    std::chrono::system_clock::time_point end() const { return m_config.end; }
+
+    bool writePacmanLog(const QString &path);
+    bool writeJournal(const QString &path);
+    // One snapshot after every upgrade session, with the kernel and key
+    // driver package versions at that point.
+    std::vector<SystemSnapshot> snapshots() const;
+
+    const WorkloadStats &stats() const { return m_stats; }
+
+private:
+    struct Upgrade {
+        std::size_t package;
+        std::string oldVersion;
+        std::string newVersion;
+    };
+    struct Session {
+        std::chrono::system_clock::time_point timestamp;
+        std::vector<Upgrade> upgrades;
+        // Versions of the key packages after the session.
+        std::vector<std::string> keyVersions;
+    };
+
+    void simulate();
+
+    WorkloadConfig m_config;
+    std::chrono::system_clock::time_point m_start;
+    std::vector<std::string> m_packageNames;
+    std::vector<Session> m_sessions;
+    WorkloadStats m_stats;
+};
+
+} // namespace khronicle::bench
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+
+namespace khronicle {
+
+// Source of wall-clock time for daemon logic (snapshot timestamps, watch
+// signal timestamps, rule cache reloads, journal start, latency cooldowns).
+// Durations that measure how long work took keep using steady_clock; only
+// "what time is it" goes through a Clock, so replay can substitute its own.
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+    virtual std::chrono::system_clock::time_point now() const = 0;
+};
+
+class SystemClock final : public Clock
+{
+public:
+    std::chrono::system_clock::time_point now() const override
+    {
+        return std::chrono::system_clock::now();
+    }
+};
+
+// The clock components use when none is injected.
+inline const Clock &systemClock()
+{
+    static const SystemClock clock;
+    return clock;
+}
+
+// Clock that only moves when told to. Used by replay to run recorded logs
+// on their original timeline, compressed. Not thread-safe: set and read it
+// from the thread that drives the daemon.
+class VirtualClock final : public Clock
+{
+public:
+    explicit VirtualClock(std::chrono::system_clock::time_point start =
+                              std::chrono::system_clock::now())
+        : m_now(start)
+    {
+    }
+
+    std::chrono::system_clock::time_point now() const override { return m_now; }
+
+    void setNow(std::chrono::system_clock::time_point now) { m_now = now; }
+    void advance(std::chrono::system_clock::duration step) { m_now += step; }
+
+private:
+    std::chrono::system_clock::time_point m_now;
+};
+
+} // namespace khronicle
@@ -0,0 +1,60 @@
+#include "common/config_file.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#include "common/logging.hpp"
+
+namespace khronicle {
+
+std::string userConfigPath(const char *envVar, const char *fileName)
+{
+    if (const char *overridePath = std::getenv(envVar); overridePath && *overridePath) {
+        return overridePath;
+    }
+    const char *home = std::getenv("HOME");
+    std::filesystem::path path = home ? home : ".";
+    path /= ".config/khronicle";
+    path /= fileName;
+    return path.string();
+}
+
+bool loadConfigFile(const std::string &path,
+                    const ConfigFileLog &log,
+                    const std::function<nlohmann::json(const nlohmann::json &config)> &apply)
+{
+    std::ifstream input(path);
+    if (!input) {
+        return false;
+    }
+
+    try {
+        nlohmann::json context = apply(nlohmann::json::parse(input));
+        if (!context.is_object()) {
+            context = nlohmann::json::object();
+        }
+        context["path"] = path;
+        KLOG_INFO(QString::fromUtf8(log.component),
+                  QString::fromUtf8(log.where),
+                  QString::fromUtf8(log.what) + QStringLiteral("_loaded"),
+                  QStringLiteral("startup"),
+                  QStringLiteral("config_file"),
+                  khronicle::logging::defaultWho(),
+                  QString(),
+                  context);
+        return true;
+    } catch (const std::exception &ex) {
+        KLOG_WARN(QString::fromUtf8(log.component),
+                  QString::fromUtf8(log.where),
+                  QString::fromUtf8(log.what) + QStringLiteral("_invalid"),
+                  QStringLiteral("startup"),
+                  QStringLiteral("fallback_defaults"),
+                  khronicle::logging::defaultWho(),
+                  QString(),
+                  (nlohmann::json{{"path", path}, {"error", ex.what()}}));
+        return false;
+    }
+}
+
+} // namespace khronicle
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle {
+
+// Path of an optional user config: $<envVar> when set and non-empty,
+// otherwise ~/.config/khronicle/<fileName>.
+std::string userConfigPath(const char *envVar, const char *fileName);
+
+// Names used in the log lines of one config loader: "<what>_loaded" on
+// success and "<what>_invalid" when the file is rejected.
+struct ConfigFileLog {
+    const char *component;
+    const char *where;
+    const char *what;
+};
+
+// Parses the JSON file at path and passes it to apply, which throws
+// std::exception for content it rejects and returns extra log context on
+// success. Returns false, leaving the caller on its defaults, when the file
+// is missing (silently) or unparsable or rejected (logged as a warning).
+bool loadConfigFile(const std::string &path,
+                    const ConfigFileLog &log,
+                    const std::function<nlohmann::json(const nlohmann::json &config)> &apply);
+
+} // namespace khronicle
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+namespace khronicle {
+
+// Display label for a diff_snapshots path, shared by reports and the UI:
+// "kernelVersion" -> "Kernel", "keyPackages.mesa" -> "Package: mesa",
+// "firmwareVersions.X" -> "Firmware: X"; anything else unchanged.
+inline std::string humanizeDiffPath(const std::string &path)
+{
+    if (path == "kernelVersion") {
+        return "Kernel";
+    }
+    const std::string keyPrefix = "keyPackages.";
+    if (path.rfind(keyPrefix, 0) == 0) {
+        return "Package: " + path.substr(keyPrefix.size());
+    }
+    const std::string fwPrefix = "firmwareVersions.";
+    if (path.rfind(fwPrefix, 0) == 0) {
+        return "Firmware: " + path.substr(fwPrefix.size());
+    }
+    return path;
+}
+
+} // namespace khronicle
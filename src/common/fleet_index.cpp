@@ -0,0 +1,419 @@
+#include "common/fleet_index.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "common/json_utils.hpp"
+#include "common/version_compare.hpp"
+
+namespace khronicle {
+
+namespace {
+
+constexpr std::size_t kBitsPerWord = 64;
+
+bool isVersionSeparator(char c)
+{
+    return c == '.' || c == '-' || c == '+' || c == '_' || c == '~' || c == ':';
+}
+
+bool versionHasPrefix(const std::string &version, const std::string &wanted)
+{
+    // Prefix match on component boundaries so "24.1" does not match "24.10".
+    if (wanted.empty()) {
+        return true;
+    }
+    if (version.size() < wanted.size()
+        || version.compare(0, wanted.size(), wanted) != 0) {
+        return false;
+    }
+    return version.size() == wanted.size()
+        || isVersionSeparator(version[wanted.size()])
+        || isVersionSeparator(wanted.back());
+}
+
+bool versionMatches(const std::string &version, const FleetQueryTerm &term)
+{
+    switch (term.match) {
+    case FleetQueryTerm::Match::Prefix:
+        return versionHasPrefix(version, term.version);
+    case FleetQueryTerm::Match::Less:
+        return compareVersions(version, term.version) < 0;
+    case FleetQueryTerm::Match::LessEqual:
+        return compareVersions(version, term.version) <= 0;
+    case FleetQueryTerm::Match::Greater:
+        return compareVersions(version, term.version) > 0;
+    case FleetQueryTerm::Match::GreaterEqual:
+        return compareVersions(version, term.version) >= 0;
+    }
+    return false;
+}
+
+} // namespace
+
+HostBitset HostBitset::full(std::size_t hostCount)
+{
+    HostBitset bits;
+    bits.m_words.assign((hostCount + kBitsPerWord - 1) / kBitsPerWord,
+                        ~std::uint64_t{0});
+    const std::size_t tail = hostCount % kBitsPerWord;
+    if (tail != 0) {
+        bits.m_words.back() = (std::uint64_t{1} << tail) - 1;
+    }
+    return bits;
+}
+
+void HostBitset::set(std::size_t host)
+{
+    const std::size_t word = host / kBitsPerWord;
+    if (word >= m_words.size()) {
+        m_words.resize(word + 1, 0);
+    }
+    m_words[word] |= std::uint64_t{1} << (host % kBitsPerWord);
+}
+
+bool HostBitset::test(std::size_t host) const
+{
+    const std::size_t word = host / kBitsPerWord;
+    if (word >= m_words.size()) {
+        return false;
+    }
+    return (m_words[word] >> (host % kBitsPerWord)) & 1U;
+}
+
+std::size_t HostBitset::count() const
+{
+    std::size_t total = 0;
+    for (const std::uint64_t word : m_words) {
+        total += static_cast<std::size_t>(std::popcount(word));
+    }
+    return total;
+}
+
+bool HostBitset::none() const
+{
+    return std::all_of(m_words.begin(), m_words.end(),
+                       [](std::uint64_t word) { return word == 0; });
+}
+
+HostBitset &HostBitset::operator&=(const HostBitset &other)
+{
+    // Words missing from either side are zero, so the result never grows.
+    if (m_words.size() > other.m_words.size()) {
+        m_words.resize(other.m_words.size());
+    }
+    for (std::size_t i = 0; i < m_words.size(); ++i) {
+        m_words[i] &= other.m_words[i];
+    }
+    return *this;
+}
+
+HostBitset &HostBitset::operator|=(const HostBitset &other)
+{
+    if (m_words.size() < other.m_words.size()) {
+        m_words.resize(other.m_words.size(), 0);
+    }
+    for (std::size_t i = 0; i < other.m_words.size(); ++i) {
+        m_words[i] |= other.m_words[i];
+    }
+    return *this;
+}
+
+std::vector<std::size_t> HostBitset::members() const
+{
+    std::vector<std::size_t> hosts;
+    for (std::size_t i = 0; i < m_words.size(); ++i) {
+        std::uint64_t word = m_words[i];
+        while (word != 0) {
+            const int bit = std::countr_zero(word);
+            hosts.push_back(i * kBitsPerWord + static_cast<std::size_t>(bit));
+            word &= word - 1;
+        }
+    }
+    return hosts;
+}
+
+std::optional<FleetQueryTerm> parseFleetQueryTerm(FleetQueryTerm::Kind kind,
+                                                  const std::string &text)
+{
+    FleetQueryTerm term;
+    term.kind = kind;
+    const auto op = text.find_first_of("=<>");
+    if (op == std::string::npos) {
+        term.packageName = text;
+    } else {
+        term.packageName = text.substr(0, op);
+        std::size_t valueStart = op + 1;
+        const bool orEqual = valueStart < text.size() && text[valueStart] == '=';
+        if (text[op] == '<') {
+            term.match = orEqual ? FleetQueryTerm::Match::LessEqual
+                                 : FleetQueryTerm::Match::Less;
+        } else if (text[op] == '>') {
+            term.match = orEqual ? FleetQueryTerm::Match::GreaterEqual
+                                 : FleetQueryTerm::Match::Greater;
+        }
+        if (orEqual && text[op] != '=') {
+            ++valueStart;
+        }
+        term.version = text.substr(valueStart);
+        if (term.match != FleetQueryTerm::Match::Prefix && term.version.empty()) {
+            return std::nullopt;
+        }
+    }
+    if (term.packageName.empty()) {
+        return std::nullopt;
+    }
+    return term;
+}
+
+std::size_t FleetIndex::addHost(const FleetHostState &state)
+{
+    const std::size_t host = m_hostIds.size();
+    m_hostIds.push_back(state.hostId);
+
+    // Installed state: the latest snapshot's key packages, overridden by any
+    // package change recorded after that snapshot (or for packages the
+    // snapshot does not track).
+    std::unordered_map<std::string, std::string> installed =
+        state.snapshotPackages;
+    std::unordered_map<std::string, std::chrono::system_clock::time_point>
+        latestChange;
+    for (const auto &change : state.history) {
+        if (change.packageName.empty() || change.version.empty()) {
+            continue;
+        }
+
+        ReceivedPosting &posting =
+            m_received[change.packageName][versionSortKey(change.version)];
+        posting.version = change.version;
+        posting.hosts.set(host);
+        auto it = posting.lastReceived.find(host);
+        if (it == posting.lastReceived.end() || it->second < change.timestamp) {
+            posting.lastReceived[host] = change.timestamp;
+        }
+
+        auto latest = latestChange.find(change.packageName);
+        if (latest != latestChange.end() && latest->second > change.timestamp) {
+            continue;
+        }
+        latestChange[change.packageName] = change.timestamp;
+        const bool inSnapshot =
+            state.snapshotPackages.count(change.packageName) > 0;
+        if (!inSnapshot || !state.snapshotTime.has_value()
+            || change.timestamp > *state.snapshotTime) {
+            installed[change.packageName] = change.version;
+        }
+    }
+
+    for (const auto &[name, version] : installed) {
+        InstalledPosting &posting = m_installed[name][versionSortKey(version)];
+        posting.version = version;
+        posting.hosts.set(host);
+    }
+    m_installedByHost.push_back(std::move(installed));
+    return host;
+}
+
+std::size_t FleetIndex::hostCount() const
+{
+    return m_hostIds.size();
+}
+
+const std::string &FleetIndex::hostId(std::size_t host) const
+{
+    return m_hostIds.at(host);
+}
+
+std::string FleetIndex::installedVersion(std::size_t host,
+                                         const std::string &packageName) const
+{
+    if (host >= m_installedByHost.size()) {
+        return {};
+    }
+    const auto &installed = m_installedByHost[host];
+    const auto it = installed.find(packageName);
+    return it == installed.end() ? std::string() : it->second;
+}
+
+template <typename Map>
+std::pair<typename Map::const_iterator, typename Map::const_iterator>
+FleetIndex::candidateRange(const Map &postings, const FleetQueryTerm &term)
+{
+    // Narrow by sort key; versionMatches() still confirms every candidate
+    // because the key is only order-preserving for well-formed versions.
+    // Keys extending the bound's key (a pkgrel the bound lacks) compare equal
+    // under vercmp, so the upper end stays open past them; likewise a version
+    // without the bound's pkgrel compares equal, so the lower end starts at
+    // the bound's key without it.
+    switch (term.match) {
+    case FleetQueryTerm::Match::Less:
+    case FleetQueryTerm::Match::LessEqual:
+        return {postings.begin(),
+                postings.upper_bound(versionSortKey(term.version) + '\xff')};
+    case FleetQueryTerm::Match::Greater:
+    case FleetQueryTerm::Match::GreaterEqual:
+        return {postings.lower_bound(versionSortKeyFloor(term.version)), postings.end()};
+    case FleetQueryTerm::Match::Prefix:
+        break;
+    }
+    return {postings.begin(), postings.end()};
+}
+
+HostBitset FleetIndex::matchInstalled(const FleetQueryTerm &term) const
+{
+    HostBitset hosts;
+    const auto package = m_installed.find(term.packageName);
+    if (package == m_installed.end()) {
+        return hosts;
+    }
+    const auto [begin, end] = candidateRange(package->second, term);
+    for (auto it = begin; it != end; ++it) {
+        if (versionMatches(it->second.version, term)) {
+            hosts |= it->second.hosts;
+        }
+    }
+    return hosts;
+}
+
+HostBitset FleetIndex::matchReceived(
+    const FleetQueryTerm &term,
+    const std::optional<std::chrono::system_clock::time_point> &since) const
+{
+    HostBitset hosts;
+    const auto package = m_received.find(term.packageName);
+    if (package == m_received.end()) {
+        return hosts;
+    }
+    const auto [begin, end] = candidateRange(package->second, term);
+    for (auto it = begin; it != end; ++it) {
+        const ReceivedPosting &posting = it->second;
+        if (!versionMatches(posting.version, term)) {
+            continue;
+        }
+        if (!since.has_value()) {
+            hosts |= posting.hosts;
+            continue;
+        }
+        for (const auto &[host, timestamp] : posting.lastReceived) {
+            if (timestamp >= *since) {
+                hosts.set(host);
+            }
+        }
+    }
+    return hosts;
+}
+
+HostBitset FleetIndex::query(const FleetQuery &query) const
+{
+    // Start from every host and intersect one posting set per term; stop
+    // early once nothing is left.
+    HostBitset result = HostBitset::full(m_hostIds.size());
+    for (const auto &term : query.terms) {
+        if (term.kind == FleetQueryTerm::Kind::Installed) {
+            result &= matchInstalled(term);
+        } else {
+            result &= matchReceived(term, query.since);
+        }
+        if (result.none()) {
+            break;
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> FleetIndex::queryHostIds(const FleetQuery &query) const
+{
+    std::vector<std::string> ids;
+    for (const std::size_t host : this->query(query).members()) {
+        ids.push_back(m_hostIds[host]);
+    }
+    return ids;
+}
+
+FleetHostState FleetIndex::hostStateFromJson(const nlohmann::json &host)
+{
+    FleetHostState state;
+    const nlohmann::json identity =
+        host.value("hostIdentity", nlohmann::json::object());
+    state.hostId = identity.is_object() ? identity.value("hostId", "") : "";
+
+    // ISO-8601 UTC strings order lexically, so the latest snapshot can be
+    // picked without parsing every timestamp.
+    const nlohmann::json *latest = nullptr;
+    std::string latestTimestamp;
+    const nlohmann::json snapshots = host.value("snapshots", nlohmann::json::array());
+    for (const auto &snapshot : snapshots) {
+        if (!snapshot.is_object()) {
+            continue;
+        }
+        const std::string timestamp = snapshot.value("timestamp", "");
+        if (latest == nullptr || timestamp > latestTimestamp) {
+            latest = &snapshot;
+            latestTimestamp = timestamp;
+        }
+    }
+    if (latest != nullptr) {
+        state.snapshotTime = fromIso8601Utc(latestTimestamp);
+        const nlohmann::json packages =
+            latest->value("keyPackages", nlohmann::json::object());
+        if (packages.is_object()) {
+            for (const auto &[name, version] : packages.items()) {
+                if (version.is_string()) {
+                    state.snapshotPackages[name] = version.get<std::string>();
+                }
+            }
+        }
+    }
+
+    const nlohmann::json events = host.value("events", nlohmann::json::array());
+    for (const auto &event : events) {
+        if (auto change = historyEntryFromEvent(event)) {
+            state.history.push_back(std::move(*change));
+        }
+    }
+
+    return state;
+}
+
+std::optional<FleetPackageChange> FleetIndex::historyEntryFromEvent(const nlohmann::json &event)
+{
+    if (!event.is_object()) {
+        return std::nullopt;
+    }
+    const nlohmann::json afterState =
+        event.value("afterState", nlohmann::json::object());
+    const nlohmann::json related =
+        event.value("relatedPackages", nlohmann::json::array());
+    if (!afterState.is_object() || !afterState.contains("version")
+        || !afterState["version"].is_string() || !related.is_array()
+        || related.empty() || !related.front().is_string()) {
+        return std::nullopt;
+    }
+    FleetPackageChange change;
+    change.packageName = related.front().get<std::string>();
+    change.version = afterState["version"].get<std::string>();
+    change.timestamp = fromIso8601Utc(event.value("timestamp", ""));
+    return change;
+}
+
+FleetIndex FleetIndex::fromAggregate(const nlohmann::json &aggregate)
+{
+    FleetIndex index;
+    if (!aggregate.is_object() || !aggregate.contains("hosts")
+        || !aggregate["hosts"].is_array()) {
+        return index;
+    }
+    for (const auto &host : aggregate["hosts"]) {
+        if (!host.is_object()) {
+            continue;
+        }
+        FleetHostState state = hostStateFromJson(host);
+        if (state.hostId.empty()) {
+            continue;
+        }
+        index.addHost(state);
+    }
+    return index;
+}
+
+} // namespace khronicle
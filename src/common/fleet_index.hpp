@@ -0,0 +1,152 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle {
+
+// Dense set of host ordinals. Bit i is set when host i (in FleetIndex
+// registration order) is a member; queries combine sets with AND/OR.
+class HostBitset
+{
+public:
+    HostBitset() = default;
+
+    static HostBitset full(std::size_t hostCount);
+
+    void set(std::size_t host);
+    bool test(std::size_t host) const;
+    std::size_t count() const;
+    bool none() const;
+
+    HostBitset &operator&=(const HostBitset &other);
+    HostBitset &operator|=(const HostBitset &other);
+
+    std::vector<std::size_t> members() const;
+
+private:
+    std::vector<std::uint64_t> m_words;
+};
+
+// One package change taken from a host's event history.
+struct FleetPackageChange {
+    std::string packageName;
+    std::string version;
+    std::chrono::system_clock::time_point timestamp;
+};
+
+// Everything the index needs to know about one host: the latest snapshot's
+// key packages plus the package history recorded in its events.
+struct FleetHostState {
+    std::string hostId;
+    std::optional<std::chrono::system_clock::time_point> snapshotTime;
+    std::unordered_map<std::string, std::string> snapshotPackages;
+    std::vector<FleetPackageChange> history;
+};
+
+struct FleetQueryTerm {
+    enum class Kind {
+        Installed, // host currently runs the package (at the version)
+        Received   // host installed/upgraded to the package (at the version)
+    };
+
+    enum class Match {
+        Prefix,       // name=24.1: prefix on component boundaries
+        Less,         // name<6.9
+        LessEqual,    // name<=6.9
+        Greater,      // name>6.9
+        GreaterEqual  // name>=6.9
+    };
+
+    Kind kind = Kind::Installed;
+    Match match = Match::Prefix;
+    std::string packageName;
+    // For Prefix, "24.1" matches "24.1.3-1" but not "24.10-1" and an empty
+    // version matches anything. The other matches use pacman's vercmp.
+    std::string version;
+};
+
+struct FleetQuery {
+    std::vector<FleetQueryTerm> terms;
+    // Lower bound applied to Received terms.
+    std::optional<std::chrono::system_clock::time_point> since;
+};
+
+// Parses "name", "name=version" or "name<op>version" (op one of <, <=, >,
+// >=) into a query term of the given kind.
+// Returns nullopt for an empty package name.
+std::optional<FleetQueryTerm> parseFleetQueryTerm(FleetQueryTerm::Kind kind,
+                                                  const std::string &text);
+
+// Inverted index (package, version) -> host set for fleet-wide questions
+// such as "which hosts run mesa 24.1 with linux-zen". Answers are bitset
+// intersections over the postings instead of scans over every host's events.
+class FleetIndex
+{
+public:
+    // Registers a host and returns its ordinal. Re-adding a host id replaces
+    // nothing; callers build a fresh index per aggregate.
+    std::size_t addHost(const FleetHostState &state);
+
+    std::size_t hostCount() const;
+    const std::string &hostId(std::size_t host) const;
+
+    HostBitset query(const FleetQuery &query) const;
+    std::vector<std::string> queryHostIds(const FleetQuery &query) const;
+
+    // Installed version of a package on a host, empty when unknown.
+    std::string installedVersion(std::size_t host,
+                                 const std::string &packageName) const;
+
+    // Builds the index from an aggregate document ({"hosts":[...]}) as written
+    // by `khronicle-report aggregate --format json`.
+    static FleetIndex fromAggregate(const nlohmann::json &aggregate);
+    static FleetHostState hostStateFromJson(const nlohmann::json &host);
+    // The package change an aggregate event records: its first related
+    // package at afterState.version. Empty for events that are not package
+    // changes.
+    static std::optional<FleetPackageChange> historyEntryFromEvent(const nlohmann::json &event);
+
+private:
+    struct InstalledPosting {
+        std::string version;
+        HostBitset hosts;
+    };
+
+    struct ReceivedPosting {
+        std::string version;
+        HostBitset hosts;
+        // Latest time each member host received this version.
+        std::unordered_map<std::size_t, std::chrono::system_clock::time_point>
+            lastReceived;
+    };
+
+    // Postings per package are keyed by versionSortKey(), so comparison
+    // terms only visit the matching end of the version range.
+    using VersionMap = std::map<std::string, InstalledPosting>;
+    using ReceivedMap = std::map<std::string, ReceivedPosting>;
+
+    template <typename Map>
+    static std::pair<typename Map::const_iterator, typename Map::const_iterator>
+    candidateRange(const Map &postings, const FleetQueryTerm &term);
+
+    HostBitset matchInstalled(const FleetQueryTerm &term) const;
+    HostBitset matchReceived(
+        const FleetQueryTerm &term,
+        const std::optional<std::chrono::system_clock::time_point> &since) const;
+
+    std::vector<std::string> m_hostIds;
+    std::vector<std::unordered_map<std::string, std::string>> m_installedByHost;
+    std::unordered_map<std::string, VersionMap> m_installed;
+    std::unordered_map<std::string, ReceivedMap> m_received;
+};
+
+} // namespace khronicle
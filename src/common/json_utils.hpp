@@ -122,6 +122,19 @@ inline WatchSeverity parseWatchSeverityString(const std::string &value)
     return WatchSeverity::Info;
 }
 
+// The "version" of a package event's before/after state; empty when absent.
+inline std::string stateVersion(const nlohmann::json &state)
+{
+    if (!state.is_object()) {
+        return {};
+    }
+    auto it = state.find("version");
+    if (it != state.end() && it->is_string()) {
+        return it->get<std::string>();
+    }
+    return {};
+}
+
 inline EventCategory parseCategoryString(const std::string &value)
 {
     if (value == "kernel") {
@@ -9,33 +9,75 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/bounded_queue.hpp"
 
 namespace khronicle::logging {
 
 namespace {
 
 constexpr qint64 kMaxLogSizeBytes = 5 * 1024 * 1024;
+constexpr std::size_t kQueueCapacity = 8192;
+constexpr auto kWriterIdleWait = std::chrono::milliseconds(250);
+constexpr auto kSuppressedSummaryInterval = std::chrono::seconds(10);
 
 std::mutex g_logMutex;
-bool g_codexTraceEnabled = false;
-QString g_processName;
+std::atomic<bool> g_codexTraceEnabled{false};
+std::atomic<bool> g_rateLimitingEnabled{true};
+
+// Call-site limiters register here so the writer can report what they
+// suppressed. Intentionally leaked: limiters and the writer are function
+// local statics whose destruction order at exit is not fixed.
+std::mutex g_limiterMutex;
+
+std::vector<LogSiteLimiter *> &limiterRegistry()
+{
+    static auto *registry = new std::vector<LogSiteLimiter *>();
+    return *registry;
+}
+// Published by initLogging() and read without a lock by every KLOG_* call
+// site. Names are interned and never freed, so a reader that loaded the
+// previous pointer keeps a valid string across a rename.
+std::atomic<const QString *> g_processName{nullptr};
+
+const QString *internProcessName(const QString &name)
+{
+    static auto *names = new std::vector<std::unique_ptr<const QString>>();
+    for (const auto &known : *names) {
+        if (*known == name) {
+            return known.get();
+        }
+    }
+    names->push_back(std::make_unique<const QString>(name));
+    return names->back().get();
+}
 
 thread_local QString t_corrId;
 
-QString levelToString(LogLevel level)
+const char *levelToString(LogLevel level)
 {
     switch (level) {
     case LogLevel::Debug:
-        return QStringLiteral("DEBUG");
+        return "DEBUG";
     case LogLevel::Info:
-        return QStringLiteral("INFO");
+        return "INFO";
     case LogLevel::Warn:
-        return QStringLiteral("WARN");
+        return "WARN";
     case LogLevel::Error:
-        return QStringLiteral("ERROR");
+        return "ERROR";
     }
-    return QStringLiteral("INFO");
+    return "INFO";
 }
 
 QString logsDirPath()
@@ -51,54 +93,325 @@ QString logsDirPath()
     return home + QStringLiteral("/.local/share/khronicle/logs");
 }
 
-QString logFilePath(const QString &processName, const QString &suffix)
+QString logFilePath(const QString &logsDir, const QString &processName,
+                    const QString &suffix)
 {
     const QString base = processName.isEmpty()
         ? QStringLiteral("khronicle")
         : processName;
-    return logsDirPath() + QDir::separator() + base + suffix;
+    return logsDir + QDir::separator() + base + suffix;
 }
 
-void rotateIfNeeded(const QString &path)
+// A formatted line on its way to the writer thread, or a change of log
+// directory from initLogging(). Directory changes travel through the same
+// queue so lines logged before the change still land in the old location.
+struct LogRecord {
+    enum class Kind {
+        Line,
+        SetLogsDir
+    };
+
+    Kind kind = Kind::Line;
+    QByteArray line;
+    QString process;
+    QString logsDir;
+    bool toCodex = false;
+};
+
+// Background writer. Producers format their line and push it into a
+// lock-free ring; a single thread owns every file handle, keeps them open
+// and rotates from a tracked byte count instead of stat'ing per line. When
+// the ring is full the line is dropped and counted, and the writer reports
+// the count in the main log once it catches up.
+class AsyncWriter
 {
-    QFileInfo info(path);
-    if (!info.exists() || info.size() < kMaxLogSizeBytes) {
-        return;
+public:
+    AsyncWriter()
+        : m_queue(kQueueCapacity)
+        , m_logsDir(logsDirPath())
+        , m_thread([this] { run(); })
+    {
     }
 
-    const QString rotated = path + QStringLiteral(".1");
-    QFile::remove(rotated);
-    QFile::rename(path, rotated);
-}
+    ~AsyncWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
 
-void writeLine(const QString &path, const QString &line)
-{
-    QDir().mkpath(logsDirPath());
-    rotateIfNeeded(path);
+    void enqueue(LogRecord &&record)
+    {
+        if (!m_queue.push(std::move(record))) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            m_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_enqueued.fetch_add(1, std::memory_order_release);
+        if (m_idle.load()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wake.notify_one();
+        }
+    }
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        fprintf(stderr, "%s\n", line.toUtf8().constData());
-        return;
+    // Directory changes must not be dropped, so wait for room instead.
+    void enqueueControl(LogRecord &&record)
+    {
+        while (!m_queue.push(std::move(record))) {
+            std::this_thread::yield();
+        }
+        m_enqueued.fetch_add(1, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wake.notify_one();
+    }
+
+    void flush()
+    {
+        const std::uint64_t target = m_enqueued.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_flushRequested = true;
+        m_wake.notify_one();
+        m_flushed.wait(lock, [&] { return m_flushedCount >= target || m_stop; });
+    }
+
+    std::uint64_t droppedTotal() const
+    {
+        return m_droppedTotal.load(std::memory_order_relaxed);
     }
 
-    file.write(line.toUtf8());
-    file.write("\n");
+private:
+    struct OpenLog {
+        std::unique_ptr<QFile> file;
+        qint64 size = 0;
+    };
+
+    void run()
+    {
+        std::uint64_t written = 0;
+        for (;;) {
+            bool wroteAny = false;
+            LogRecord record;
+            while (m_queue.pop(record)) {
+                handle(record);
+                ++written;
+                wroteAny = true;
+            }
+            if (reportDrops()) {
+                wroteAny = true;
+            }
+
+            bool flushRequested = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                flushRequested = m_flushRequested;
+                m_flushRequested = false;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (flushRequested || now - m_lastSummary >= kSuppressedSummaryInterval) {
+                if (reportSuppressed()) {
+                    wroteAny = true;
+                }
+                m_lastSummary = now;
+            }
+
+            if (wroteAny || flushRequested) {
+                for (auto &entry : m_files) {
+                    if (entry.second.file) {
+                        entry.second.file->flush();
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_flushedCount = written;
+                }
+                m_flushed.notify_all();
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stop && m_queue.empty()) {
+                break;
+            }
+            m_idle.store(true);
+            m_wake.wait_for(lock, kWriterIdleWait, [&] {
+                return m_stop || m_flushRequested || !m_queue.empty();
+            });
+            m_idle.store(false);
+        }
+
+        reportSuppressed();
+        m_files.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_flushedCount = written;
+        }
+        m_flushed.notify_all();
+    }
+
+    void handle(const LogRecord &record)
+    {
+        if (record.kind == LogRecord::Kind::SetLogsDir) {
+            m_logsDir = record.logsDir;
+            return;
+        }
+
+        m_lastProcess = record.process;
+        write(logFilePath(m_logsDir, record.process, QStringLiteral(".log")),
+              record.line);
+        if (record.toCodex) {
+            write(logFilePath(m_logsDir, record.process, QStringLiteral("-codex.log")),
+                  record.line);
+        }
+    }
+
+    // Lines the writer emits about itself; same shape as logEvent() output.
+    void writeInternal(LogLevel level, const char *component, const char *where,
+                       const char *what, const char *why, const char *how,
+                       const nlohmann::json &context)
+    {
+        const nlohmann::json payload = {
+            {"ts", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs).toStdString()},
+            {"level", levelToString(level)},
+            {"process", m_lastProcess.toStdString()},
+            {"thread", ""},
+            {"component", component},
+            {"where", where},
+            {"what", what},
+            {"why", why},
+            {"how", how},
+            {"who", ""},
+            {"corr", ""},
+            {"context", context}
+        };
+        write(logFilePath(m_logsDir, m_lastProcess, QStringLiteral(".log")),
+              QByteArray::fromStdString(payload.dump()));
+    }
+
+    bool reportDrops()
+    {
+        const std::uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped == 0) {
+            return false;
+        }
+
+        writeInternal(LogLevel::Warn, "Logging", "AsyncWriter", "log_records_dropped", "queue_full",
+                      "bounded_ring",
+                      {{"dropped", dropped}, {"capacity", m_queue.capacity()}});
+        return true;
+    }
+
+    bool reportSuppressed()
+    {
+        bool wrote = false;
+        std::lock_guard<std::mutex> lock(g_limiterMutex);
+        for (LogSiteLimiter *limiter : limiterRegistry()) {
+            const std::uint64_t suppressed = limiter->takeSuppressed();
+            if (suppressed == 0) {
+                continue;
+            }
+            // Reported at the site's own level: suppressing INFO noise is
+            // routine and must not read as a warning.
+            writeInternal(limiter->level(),
+                          limiter->component().toStdString().c_str(),
+                          limiter->site(),
+                          "log_records_suppressed",
+                          "rate_limit",
+                          "per_site_limiter",
+                          {{"suppressed", suppressed},
+                           {"similarTo", limiter->what().toStdString()}});
+            wrote = true;
+        }
+        return wrote;
+    }
+
+    void write(const QString &path, const QByteArray &line)
+    {
+        OpenLog &log = m_files[path];
+        if (!log.file) {
+            QDir().mkpath(QFileInfo(path).absolutePath());
+            log.file = std::make_unique<QFile>(path);
+            if (!log.file->open(QIODevice::WriteOnly | QIODevice::Append
+                                | QIODevice::Text)) {
+                log.file.reset();
+                fprintf(stderr, "%s\n", line.constData());
+                return;
+            }
+            log.size = log.file->size();
+        }
+
+        log.file->write(line);
+        log.file->write("\n", 1);
+        log.size += line.size() + 1;
+
+        if (log.size >= kMaxLogSizeBytes) {
+            log.file.reset();
+            const QString rotated = path + QStringLiteral(".1");
+            QFile::remove(rotated);
+            QFile::rename(path, rotated);
+            log.size = 0;
+        }
+    }
+
+    BoundedQueue<LogRecord> m_queue;
+
+    // Writer thread only.
+    QString m_logsDir;
+    QString m_lastProcess = QStringLiteral("khronicle");
+    std::chrono::steady_clock::time_point m_lastSummary = std::chrono::steady_clock::now();
+    std::map<QString, OpenLog> m_files;
+
+    std::atomic<std::uint64_t> m_enqueued{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<std::uint64_t> m_droppedTotal{0};
+    std::atomic<bool> m_idle{false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    bool m_stop = false;
+    bool m_flushRequested = false;
+    std::uint64_t m_flushedCount = 0;
+
+    // Last member: the thread must start after everything above exists.
+    std::thread m_thread;
+};
+
+AsyncWriter &writer()
+{
+    static AsyncWriter instance;
+    return instance;
 }
 
-QString threadIdString()
+const std::string &threadIdString()
 {
-    return QStringLiteral("0x%1")
-        .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()), 0, 16);
+    thread_local const std::string id =
+        QStringLiteral("0x%1")
+            .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()), 0, 16)
+            .toStdString();
+    return id;
 }
 
 } // namespace
 
 void initLogging(const QString &processName, bool codexTraceEnabled)
 {
-    std::lock_guard<std::mutex> lock(g_logMutex);
-    g_processName = processName;
-    g_codexTraceEnabled = codexTraceEnabled;
+    {
+        std::lock_guard<std::mutex> lock(g_logMutex);
+        // internProcessName() is only called here, under g_logMutex.
+        g_processName.store(internProcessName(processName), std::memory_order_release);
+        g_codexTraceEnabled = codexTraceEnabled;
+        g_rateLimitingEnabled = qEnvironmentVariableIntValue("KHRONICLE_LOG_UNLIMITED") != 1;
+    }
+
+    // Pick up KHRONICLE_LOG_DIR/HOME as they are now; the replay harness
+    // re-initializes with a per-scenario directory.
+    LogRecord record;
+    record.kind = LogRecord::Kind::SetLogsDir;
+    record.logsDir = logsDirPath();
+    writer().enqueueControl(std::move(record));
 }
 
 bool isCodexTraceEnabled()
@@ -106,6 +419,26 @@ bool isCodexTraceEnabled()
     return g_codexTraceEnabled;
 }
 
+bool isLevelEnabled(LogLevel level)
+{
+    return level != LogLevel::Debug || g_codexTraceEnabled;
+}
+
+bool isRateLimitingEnabled()
+{
+    return g_rateLimitingEnabled;
+}
+
+void flushLogs()
+{
+    writer().flush();
+}
+
+std::uint64_t droppedLogRecords()
+{
+    return writer().droppedTotal();
+}
+
 void setCorrelationId(const QString &corrId)
 {
     t_corrId = corrId;
@@ -129,8 +462,9 @@ CorrelationScope::~CorrelationScope()
 
 QString defaultProcessName()
 {
-    if (!g_processName.isEmpty()) {
-        return g_processName;
+    const QString *name = g_processName.load(std::memory_order_acquire);
+    if (name && !name->isEmpty()) {
+        return *name;
     }
     if (QCoreApplication::instance()) {
         const QString appName = QCoreApplication::applicationName();
@@ -143,13 +477,75 @@ QString defaultProcessName()
 
 QString defaultWho()
 {
-    char hostname[256] = {};
-    if (gethostname(hostname, sizeof(hostname)) != 0) {
-        hostname[0] = '\0';
+    static const QString who = [] {
+        char hostname[256] = {};
+        if (gethostname(hostname, sizeof(hostname)) != 0) {
+            hostname[0] = '\0';
+        }
+        return QStringLiteral("host:%1,uid:%2")
+            .arg(QString::fromUtf8(hostname))
+            .arg(static_cast<int>(getuid()));
+    }();
+    return who;
+}
+
+LogSiteLimiter::LogSiteLimiter(const char *site, LogLevel level, LogRateLimit policy,
+                               const QString &component, const QString &what)
+    : m_site(std::strrchr(site, '/') ? std::strrchr(site, '/') + 1 : site)
+    , m_level(level)
+    , m_policy(policy)
+    , m_component(component)
+    , m_what(what)
+    , m_tokens(policy.burst)
+    , m_lastRefill(std::chrono::steady_clock::now())
+{
+    if (m_policy.burst < 1.0) {
+        m_policy.burst = 1.0;
+        m_tokens = 1.0;
     }
-    return QStringLiteral("host:%1,uid:%2")
-        .arg(QString::fromUtf8(hostname))
-        .arg(static_cast<int>(getuid()));
+    std::lock_guard<std::mutex> lock(g_limiterMutex);
+    limiterRegistry().push_back(this);
+}
+
+LogSiteLimiter::~LogSiteLimiter()
+{
+    std::lock_guard<std::mutex> lock(g_limiterMutex);
+    auto &registry = limiterRegistry();
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+bool LogSiteLimiter::allow()
+{
+    if (!g_rateLimitingEnabled) {
+        return true;
+    }
+
+    if (m_policy.sampleOneIn > 1) {
+        const std::uint64_t call = m_calls.fetch_add(1, std::memory_order_relaxed);
+        if (call % m_policy.sampleOneIn != 0) {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    if (m_policy.perSecond > 0.0) {
+        std::lock_guard<std::mutex> lock(m_bucketMutex);
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+        m_tokens = std::min(m_policy.burst, m_tokens + elapsed * m_policy.perSecond);
+        m_lastRefill = now;
+        if (m_tokens < 1.0) {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_tokens -= 1.0;
+    }
+    return true;
+}
+
+std::uint64_t LogSiteLimiter::takeSuppressed()
+{
+    return m_suppressed.exchange(0, std::memory_order_relaxed);
 }
 
 void logEvent(LogLevel level,
@@ -163,12 +559,17 @@ void logEvent(LogLevel level,
               const QString &correlationId,
               const nlohmann::json &context)
 {
+    if (!isLevelEnabled(level)) {
+        return;
+    }
+    const bool codexTrace = g_codexTraceEnabled;
+
     const QString corr = correlationId.isEmpty() ? currentCorrelationId() : correlationId;
     nlohmann::json payload = {
         {"ts", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs).toStdString()},
-        {"level", levelToString(level).toStdString()},
+        {"level", levelToString(level)},
         {"process", processName.toStdString()},
-        {"thread", threadIdString().toStdString()},
+        {"thread", threadIdString()},
         {"component", component.toStdString()},
         {"where", where.toStdString()},
         {"what", what.toStdString()},
@@ -179,22 +580,11 @@ void logEvent(LogLevel level,
         {"context", context}
     };
 
-    const QString line = QString::fromStdString(payload.dump());
-
-    const QString process = processName.isEmpty() ? defaultProcessName() : processName;
-    const QString mainPath = logFilePath(process, QStringLiteral(".log"));
-    const QString codexPath = logFilePath(process, QStringLiteral("-codex.log"));
-
-    std::lock_guard<std::mutex> lock(g_logMutex);
-    if (level != LogLevel::Debug) {
-        writeLine(mainPath, line);
-    } else if (g_codexTraceEnabled) {
-        writeLine(mainPath, line);
-    }
-
-    if (g_codexTraceEnabled) {
-        writeLine(codexPath, line);
-    }
+    LogRecord record;
+    record.line = QByteArray::fromStdString(payload.dump());
+    record.process = processName.isEmpty() ? defaultProcessName() : processName;
+    record.toCodex = codexTrace;
+    writer().enqueue(std::move(record));
 }
 
 } // namespace khronicle::logging
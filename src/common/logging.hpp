@@ -2,6 +2,11 @@
 
 #include <QString>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
 #include <nlohmann/json.hpp>
 
 namespace khronicle::logging {
@@ -18,6 +23,17 @@ void initLogging(const QString &processName, bool codexTraceEnabled);
 
 bool isCodexTraceEnabled();
 
+// True when a line at this level would be written anywhere. DEBUG lines only
+// go to the logs in codex trace mode.
+bool isLevelEnabled(LogLevel level);
+
+// Log lines are written by a background thread. flushLogs() blocks until
+// everything logged before the call is on disk (tests, shutdown paths).
+void flushLogs();
+
+// Lines dropped because the writer queue was full, since process start.
+std::uint64_t droppedLogRecords();
+
 // Thread-local correlation support for linking related log events.
 void setCorrelationId(const QString &corrId);
 QString currentCorrelationId();
@@ -43,27 +59,120 @@ void logEvent(LogLevel level,
               const QString &correlationId,
               const nlohmann::json &context = nlohmann::json::object());
 
+// defaultProcessName() is the name given to initLogging() (or the
+// application name before that); defaultWho() is computed once per process.
 QString defaultProcessName();
 QString defaultWho();
 
+// Per-call-site limits for hot paths. A site keeps one record in every
+// sampleOneIn calls, then spends a token from a bucket refilled at perSecond
+// up to burst. perSecond == 0 disables the bucket. Suppressed records are
+// counted and reported as "log_records_suppressed" summaries by the writer
+// every few seconds and on flushLogs().
+struct LogRateLimit {
+    double perSecond = 0.0;
+    double burst = 0.0;
+    std::uint32_t sampleOneIn = 1;
+};
+
+// Per-event ingestion paths (store inserts, rule evaluation).
+inline constexpr LogRateLimit kIngestionLogLimit{20.0, 100.0, 1};
+// API request bookkeeping; bursts come from UI refreshes and load tests.
+inline constexpr LogRateLimit kApiRequestLogLimit{20.0, 200.0, 1};
+
+class LogSiteLimiter {
+public:
+    LogSiteLimiter(const char *site, LogLevel level, LogRateLimit policy,
+                   const QString &component, const QString &what);
+    ~LogSiteLimiter();
+
+    LogSiteLimiter(const LogSiteLimiter &) = delete;
+    LogSiteLimiter &operator=(const LogSiteLimiter &) = delete;
+
+    bool allow();
+    std::uint64_t takeSuppressed();
+
+    const char *site() const { return m_site; }
+    // Level of the site's records; its suppression summaries use it too.
+    LogLevel level() const { return m_level; }
+    const QString &component() const { return m_component; }
+    const QString &what() const { return m_what; }
+
+private:
+    const char *m_site;
+    LogLevel m_level;
+    LogRateLimit m_policy;
+    QString m_component;
+    QString m_what;
+    std::atomic<std::uint64_t> m_calls{0};
+    std::atomic<std::uint64_t> m_suppressed{0};
+    std::mutex m_bucketMutex;
+    double m_tokens = 0.0;
+    std::chrono::steady_clock::time_point m_lastRefill;
+};
+
+// Limits apply unless KHRONICLE_LOG_UNLIMITED=1 was set at initLogging().
+bool isRateLimitingEnabled();
+
 } // namespace khronicle::logging
 
+// Lowest level compiled into KLOG_* call sites: 0=Debug, 1=Info, 2=Warn,
+// 3=Error. Release builds set 1 so KLOG_DEBUG sites compile to nothing.
+#ifndef KHRONICLE_LOG_MIN_LEVEL
+#define KHRONICLE_LOG_MIN_LEVEL 0
+#endif
+
+// Level check done by the KLOG_* macros before any argument is evaluated, so
+// a disabled line costs one branch: no QStrings, no defaultWho(), no JSON.
+#define KLOG_AT_LEVEL(level, component, where, what, why, how, who, corr, ctxJson) \
+    do { \
+        if (static_cast<int>(level) >= KHRONICLE_LOG_MIN_LEVEL \
+            && ::khronicle::logging::isLevelEnabled(level)) { \
+            ::khronicle::logging::logEvent((level), \
+                                           ::khronicle::logging::defaultProcessName(), \
+                                           (component), (where), (what), (why), (how), (who), (corr), (ctxJson)); \
+        } \
+    } while (0)
+
+#define KLOG_STRINGIFY_DETAIL(x) #x
+#define KLOG_STRINGIFY(x) KLOG_STRINGIFY_DETAIL(x)
+
+// Like KLOG_AT_LEVEL, but the call site owns a LogSiteLimiter (a function
+// local static) that applies the given LogRateLimit before formatting.
+#define KLOG_LIMITED(level, policy, component, where, what, why, how, who, corr, ctxJson) \
+    do { \
+        if (static_cast<int>(level) >= KHRONICLE_LOG_MIN_LEVEL \
+            && ::khronicle::logging::isLevelEnabled(level)) { \
+            static ::khronicle::logging::LogSiteLimiter klogSiteLimiter( \
+                __FILE__ ":" KLOG_STRINGIFY(__LINE__), (level), (policy), (component), (what)); \
+            if (klogSiteLimiter.allow()) { \
+                ::khronicle::logging::logEvent((level), \
+                                               ::khronicle::logging::defaultProcessName(), \
+                                               (component), (where), (what), (why), (how), (who), (corr), (ctxJson)); \
+            } \
+        } \
+    } while (0)
+
 #define KLOG_DEBUG(component, where, what, why, how, who, corr, ctxJson) \
-    ::khronicle::logging::logEvent(::khronicle::logging::LogLevel::Debug, \
-                                   ::khronicle::logging::defaultProcessName(), \
-                                   (component), (where), (what), (why), (how), (who), (corr), (ctxJson))
+    KLOG_AT_LEVEL(::khronicle::logging::LogLevel::Debug, \
+                  component, where, what, why, how, who, corr, ctxJson)
 
 #define KLOG_INFO(component, where, what, why, how, who, corr, ctxJson) \
-    ::khronicle::logging::logEvent(::khronicle::logging::LogLevel::Info, \
-                                   ::khronicle::logging::defaultProcessName(), \
-                                   (component), (where), (what), (why), (how), (who), (corr), (ctxJson))
+    KLOG_AT_LEVEL(::khronicle::logging::LogLevel::Info, \
+                  component, where, what, why, how, who, corr, ctxJson)
 
 #define KLOG_WARN(component, where, what, why, how, who, corr, ctxJson) \
-    ::khronicle::logging::logEvent(::khronicle::logging::LogLevel::Warn, \
-                                   ::khronicle::logging::defaultProcessName(), \
-                                   (component), (where), (what), (why), (how), (who), (corr), (ctxJson))
+    KLOG_AT_LEVEL(::khronicle::logging::LogLevel::Warn, \
+                  component, where, what, why, how, who, corr, ctxJson)
 
 #define KLOG_ERROR(component, where, what, why, how, who, corr, ctxJson) \
-    ::khronicle::logging::logEvent(::khronicle::logging::LogLevel::Error, \
-                                   ::khronicle::logging::defaultProcessName(), \
-                                   (component), (where), (what), (why), (how), (who), (corr), (ctxJson))
+    KLOG_AT_LEVEL(::khronicle::logging::LogLevel::Error, \
+                  component, where, what, why, how, who, corr, ctxJson)
+
+#define KLOG_DEBUG_LIMITED(policy, component, where, what, why, how, who, corr, ctxJson) \
+    KLOG_LIMITED(::khronicle::logging::LogLevel::Debug, policy, \
+                 component, where, what, why, how, who, corr, ctxJson)
+
+#define KLOG_INFO_LIMITED(policy, component, where, what, why, how, who, corr, ctxJson) \
+    KLOG_LIMITED(::khronicle::logging::LogLevel::Info, policy, \
+                 component, where, what, why, how, who, corr, ctxJson)
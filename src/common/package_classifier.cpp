@@ -0,0 +1,212 @@
+#include "common/package_classifier.hpp"
+
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+#include "common/config_file.hpp"
+
+namespace khronicle {
+
+struct PackageClassifier::TrieNode {
+    std::map<char, std::unique_ptr<TrieNode>> children;
+    // Patterns whose literal part (everything before the first wildcard)
+    // ends at this node. "nvidia*" and "nvidia-*-utils" both hang off the
+    // node for "nvidia".
+    std::vector<Pattern> patterns;
+};
+
+namespace {
+
+struct ClassSpec {
+    const char *key;
+    PackageClass packageClass;
+};
+
+constexpr ClassSpec kClassSpecs[] = {
+    {"kernel", PackageClass::Kernel},
+    {"gpuDriver", PackageClass::GpuDriver},
+    {"firmware", PackageClass::Firmware},
+};
+
+// Default lists. Kernel order doubles as preference when several kernels
+// are installed.
+nlohmann::json defaultConfig()
+{
+    return nlohmann::json{
+        {"kernel", {"linux-cachyos", "linux", "linux-zen", "linux-lts"}},
+        {"gpuDriver",
+         {"mesa",
+          "mesa-git",
+          "nvidia",
+          "nvidia-dkms",
+          "nvidia-utils",
+          "vulkan-radeon",
+          "vulkan-intel",
+          "vulkan-nouveau",
+          "xf86-video-amdgpu",
+          "xf86-video-intel"}},
+        {"firmware", {"linux-firmware", "amd-ucode", "intel-ucode"}},
+    };
+}
+
+// Shell-style match supporting '*' (any run, including empty) and '?'.
+bool globMatches(const std::string &pattern, const std::string &text)
+{
+    std::size_t p = 0;
+    std::size_t t = 0;
+    std::size_t starPattern = std::string::npos;
+    std::size_t starText = 0;
+
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starText = t;
+        } else if (starPattern != std::string::npos) {
+            p = starPattern + 1;
+            t = ++starText;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+} // namespace
+
+PackageClassifier::PackageClassifier()
+    : m_root(std::make_unique<TrieNode>())
+{
+}
+
+PackageClassifier::~PackageClassifier() = default;
+PackageClassifier::PackageClassifier(PackageClassifier &&other) noexcept = default;
+PackageClassifier &PackageClassifier::operator=(PackageClassifier &&other) noexcept = default;
+
+PackageClassifier PackageClassifier::defaults()
+{
+    return fromJson(defaultConfig());
+}
+
+PackageClassifier PackageClassifier::fromJson(const nlohmann::json &config)
+{
+    if (!config.is_object()) {
+        throw std::runtime_error("package classes config must be an object");
+    }
+
+    const nlohmann::json fallback = defaultConfig();
+    PackageClassifier classifier;
+    for (const auto &spec : kClassSpecs) {
+        // Classes omitted from the file keep their built-in list.
+        const auto it = config.find(spec.key);
+        const nlohmann::json &list = it != config.end() ? *it : fallback.at(spec.key);
+        if (!list.is_array()) {
+            throw std::runtime_error(std::string("package class '") + spec.key
+                                     + "' must be an array of patterns");
+        }
+
+        std::size_t rank = 0;
+        for (const auto &entry : list) {
+            if (!entry.is_string() || entry.get<std::string>().empty()) {
+                throw std::runtime_error(std::string("package class '") + spec.key
+                                         + "' contains a non-string or empty pattern");
+            }
+            classifier.addPattern(entry.get<std::string>(),
+                                  PackageClassMatch{spec.packageClass, rank++});
+        }
+    }
+    return classifier;
+}
+
+std::string PackageClassifier::configPath()
+{
+    return userConfigPath("KHRONICLE_PACKAGE_CLASSES_PATH", "package-classes.json");
+}
+
+const PackageClassifier &PackageClassifier::instance()
+{
+    static const PackageClassifier classifier = [] {
+        std::optional<PackageClassifier> loaded;
+        loadConfigFile(configPath(),
+                       {"PackageClassifier", "instance", "package_classes"},
+                       [&](const nlohmann::json &config) {
+                           loaded.emplace(fromJson(config));
+                           return nlohmann::json{
+                               {"patterns", loaded->m_patternCount + loaded->m_exact.size()}};
+                       });
+        return loaded ? std::move(*loaded) : defaults();
+    }();
+    return classifier;
+}
+
+void PackageClassifier::addPattern(const std::string &pattern, PackageClassMatch match)
+{
+    const std::size_t wildcard = pattern.find_first_of("*?");
+    if (wildcard == std::string::npos) {
+        // First listing of a name wins, like the pattern order below.
+        m_exact.emplace(pattern, match);
+        return;
+    }
+
+    TrieNode *node = m_root.get();
+    for (std::size_t i = 0; i < wildcard; ++i) {
+        auto &child = node->children[pattern[i]];
+        if (!child) {
+            child = std::make_unique<TrieNode>();
+        }
+        node = child.get();
+    }
+    node->patterns.push_back(Pattern{pattern, match, m_patternCount++});
+}
+
+std::optional<PackageClassMatch> PackageClassifier::classify(
+    const std::string &packageName) const
+{
+    if (const auto it = m_exact.find(packageName); it != m_exact.end()) {
+        return it->second;
+    }
+
+    // Walk the name down the trie; deeper nodes have longer literal prefixes
+    // and so take precedence over anything found closer to the root.
+    const Pattern *best = nullptr;
+    const TrieNode *node = m_root.get();
+    std::size_t depth = 0;
+    while (node) {
+        const Pattern *bestHere = nullptr;
+        for (const auto &pattern : node->patterns) {
+            if ((!bestHere || pattern.order < bestHere->order)
+                && globMatches(pattern.glob, packageName)) {
+                bestHere = &pattern;
+            }
+        }
+        if (bestHere) {
+            best = bestHere;
+        }
+
+        if (depth >= packageName.size()) {
+            break;
+        }
+        const auto child = node->children.find(packageName[depth++]);
+        node = child != node->children.end() ? child->second.get() : nullptr;
+    }
+
+    if (!best) {
+        return std::nullopt;
+    }
+    return best->match;
+}
+
+bool PackageClassifier::isClass(const std::string &packageName,
+                                PackageClass packageClass) const
+{
+    const auto match = classify(packageName);
+    return match && match->packageClass == packageClass;
+}
+
+} // namespace khronicle
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle {
+
+enum class PackageClass {
+    Kernel,
+    GpuDriver,
+    Firmware
+};
+
+struct PackageClassMatch {
+    PackageClass packageClass = PackageClass::Kernel;
+    // Position of the matching pattern in its class list. Lower ranks are
+    // preferred, e.g. when picking the running kernel package.
+    std::size_t rank = 0;
+};
+
+// Classifies package names into kernel / GPU driver / firmware classes.
+//
+// Patterns come from a JSON config of the form
+//   {"kernel": ["linux", "linux-*-headers"], "gpuDriver": ["nvidia*"], ...}
+// and are one of: exact names, prefixes ("nvidia*") or globs using '*' and
+// '?' ("lib32-nvidia-*-utils"). At load time exact names go into a hash map
+// and prefixes/globs into a trie keyed by their literal prefix, so a lookup
+// walks the name once and only tests the globs hanging off that path.
+//
+// Precedence: an exact name wins, then the pattern with the longest literal
+// prefix, then the pattern listed first.
+class PackageClassifier
+{
+public:
+    PackageClassifier();
+    ~PackageClassifier();
+    PackageClassifier(PackageClassifier &&other) noexcept;
+    PackageClassifier &operator=(PackageClassifier &&other) noexcept;
+
+    // Built-in lists used when no config file exists.
+    static PackageClassifier defaults();
+    // Throws std::runtime_error when the document is not a valid config.
+    static PackageClassifier fromJson(const nlohmann::json &config);
+
+    // Config path: $KHRONICLE_PACKAGE_CLASSES_PATH, otherwise
+    // ~/.config/khronicle/package-classes.json.
+    static std::string configPath();
+
+    // Process-wide classifier loaded from configPath() on first use. Falls back
+    // to defaults() when the file is missing or invalid.
+    static const PackageClassifier &instance();
+
+    std::optional<PackageClassMatch> classify(const std::string &packageName) const;
+    bool isClass(const std::string &packageName, PackageClass packageClass) const;
+
+private:
+    struct TrieNode;
+
+    struct Pattern {
+        std::string glob;
+        PackageClassMatch match;
+        std::size_t order = 0;
+    };
+
+    void addPattern(const std::string &pattern, PackageClassMatch match);
+
+    std::unordered_map<std::string, PackageClassMatch> m_exact;
+    std::unique_ptr<TrieNode> m_root;
+    std::size_t m_patternCount = 0;
+};
+
+} // namespace khronicle
@@ -86,11 +86,20 @@ bool isDevBuildTree()
 
 QString daemonSocketPath()
 {
-    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
-    if (!runtimeDir.isEmpty()) {
-        return runtimeDir + QStringLiteral("/khronicle.sock");
+    const QString socketName = qEnvironmentVariable("KHRONICLE_SOCKET_NAME");
+    if (!socketName.isEmpty()) {
+        return socketName;
     }
-    return QStringLiteral("/run/user/%1/khronicle.sock").arg(getuid());
+
+    QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (runtimeDir.isEmpty()) {
+        runtimeDir =
+            QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    }
+    if (runtimeDir.isEmpty()) {
+        runtimeDir = QStringLiteral("/run/user/%1").arg(getuid());
+    }
+    return runtimeDir + QStringLiteral("/khronicle.sock");
 }
 
 bool isDaemonRunning()
@@ -13,6 +13,9 @@ bool startTray();
 bool startUi();
 
 QString appIconPath();
+// Where the daemon listens and every client connects: KHRONICLE_SOCKET_NAME
+// when set (a path or a bare socket name), else
+// $XDG_RUNTIME_DIR/khronicle.sock.
 QString daemonSocketPath();
 
 } // namespace khronicle
@@ -0,0 +1,97 @@
+#include "common/request_trace.hpp"
+
+#include <QDateTime>
+#include <QUuid>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <nlohmann/json.hpp>
+
+#include "common/logging.hpp"
+
+namespace khronicle {
+
+namespace {
+
+// KLOG_INFO_LIMITED keeps one limiter per call site, named after the
+// component of its first call. Every client logs through the one site here,
+// so each component gets its own limiter instead: a busy UI does not use up
+// the tray's budget, and suppression summaries name the right client.
+// Intentionally leaked, like the limiters the macro creates.
+logging::LogSiteLimiter &latencyLimiter(const QString &component)
+{
+    static std::mutex mutex;
+    static auto *limiters = new std::map<QString, std::unique_ptr<logging::LogSiteLimiter>>();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &limiter = (*limiters)[component];
+    if (!limiter) {
+        limiter = std::make_unique<logging::LogSiteLimiter>(
+            "request_trace.cpp:logRequestLatency", logging::LogLevel::Info,
+            logging::kApiRequestLogLimit, component, QStringLiteral("api_round_trip"));
+    }
+    return *limiter;
+}
+
+} // namespace
+
+RequestTrace startRequestTrace()
+{
+    RequestTrace trace;
+    trace.id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    trace.sentAt = std::chrono::steady_clock::now();
+    return trace;
+}
+
+QJsonObject requestTraceJson(const RequestTrace &trace)
+{
+    // The daemon only uses sentAtUs for a one-way transit estimate; both ends
+    // read the same host clock.
+    QJsonObject json;
+    json["id"] = trace.id;
+    json["sentAtUs"] = QDateTime::currentMSecsSinceEpoch() * 1000;
+    return json;
+}
+
+void logRequestLatency(const QString &component,
+                       const QString &method,
+                       const RequestTrace &trace,
+                       const QJsonObject &response)
+{
+    if (!latencyLimiter(component).allow()) {
+        return;
+    }
+
+    const auto roundTripUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - trace.sentAt).count();
+
+    nlohmann::json context = {
+        {"method", method.toStdString()},
+        {"roundTripUs", roundTripUs}
+    };
+
+    const QJsonObject serverTrace = response.value("trace").toObject();
+    if (!serverTrace.isEmpty()) {
+        const qint64 queueWaitUs = serverTrace.value("queueWaitUs").toInteger();
+        const qint64 queryUs = serverTrace.value("queryUs").toInteger();
+        const qint64 serializeUs = serverTrace.value("serializeUs").toInteger();
+        const qint64 serverUs = queueWaitUs + queryUs + serializeUs;
+        context["queueWaitUs"] = queueWaitUs;
+        context["queryUs"] = queryUs;
+        context["serializeUs"] = serializeUs;
+        context["transportUs"] = std::max<qint64>(0, roundTripUs - serverUs);
+    }
+
+    KLOG_INFO(component,
+              QStringLiteral("logRequestLatency"),
+              QStringLiteral("api_round_trip"),
+              QStringLiteral("daemon_response"),
+              QStringLiteral("json_rpc"),
+              logging::defaultWho(),
+              trace.id,
+              context);
+}
+
+} // namespace khronicle
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+#include <chrono>
+
+namespace khronicle {
+
+// Client half of API request tracing.
+//
+// Each request carries
+//   "trace": {"id": "<uuid>", "sentAtUs": <system clock, microseconds>}
+// and the daemon adopts the id as its log correlation id, so the client and
+// daemon log lines for one UI action share a `corr`. Successful responses
+// echo the id with the daemon's timing breakdown:
+//   "trace": {"id": ..., "queueWaitUs": ..., "queryUs": ..., "serializeUs": ...}
+struct RequestTrace {
+    QString id;
+    std::chrono::steady_clock::time_point sentAt;
+};
+
+// Starts a trace with a fresh id; call right before writing the request.
+RequestTrace startRequestTrace();
+
+// The "trace" member to attach to the request object.
+QJsonObject requestTraceJson(const RequestTrace &trace);
+
+// Logs end-to-end latency for a response. Time not spent in the daemon's
+// queue, query or serialization is reported as transportUs (socket, event
+// loop delivery and JSON parsing on both ends).
+void logRequestLatency(const QString &component,
+                       const QString &method,
+                       const RequestTrace &trace,
+                       const QJsonObject &response);
+
+} // namespace khronicle
@@ -0,0 +1,166 @@
+#include "common/tracing.hpp"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+#include "common/logging.hpp"
+
+namespace khronicle::tracing {
+
+namespace {
+
+long currentThreadId()
+{
+    thread_local const long tid = static_cast<long>(syscall(SYS_gettid));
+    return tid;
+}
+
+long long toMicros(std::chrono::steady_clock::time_point time)
+{
+    // CLOCK_MONOTONIC is shared by all processes on the host, so traces
+    // from the daemon and the UI line up when loaded together.
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               time.time_since_epoch())
+        .count();
+}
+
+class TraceSink
+{
+public:
+    TraceSink()
+    {
+        const char *path = std::getenv("KHRONICLE_TRACE_FILE");
+        if (!path || !*path) {
+            return;
+        }
+        m_file = std::fopen(path, "w");
+        if (!m_file) {
+            std::fprintf(stderr, "khronicle: cannot open trace file %s\n", path);
+            return;
+        }
+        std::setvbuf(m_file, nullptr, _IOFBF, 1 << 16);
+        std::fputs("[\n", m_file);
+
+        const nlohmann::json processName = {
+            {"name", "process_name"},
+            {"ph", "M"},
+            {"pid", static_cast<long>(getpid())},
+            {"args", {{"name", logging::defaultProcessName().toStdString()}}}
+        };
+        writeLocked(processName.dump());
+    }
+
+    ~TraceSink()
+    {
+        if (m_file) {
+            std::fclose(m_file);
+        }
+    }
+
+    bool enabled() const { return m_file != nullptr; }
+
+    void write(const std::string &event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writeLocked(event);
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file) {
+            std::fflush(m_file);
+        }
+    }
+
+private:
+    void writeLocked(const std::string &event)
+    {
+        std::fputs(event.c_str(), m_file);
+        std::fputs(",\n", m_file);
+    }
+
+    std::mutex m_mutex;
+    std::FILE *m_file = nullptr;
+};
+
+TraceSink &sink()
+{
+    static TraceSink instance;
+    return instance;
+}
+
+} // namespace
+
+bool isTracingEnabled()
+{
+    return sink().enabled();
+}
+
+void flushTrace()
+{
+    sink().flush();
+}
+
+TraceSpan::TraceSpan(const char *category, const char *name)
+{
+    if (!isTracingEnabled()) {
+        return;
+    }
+    m_active = true;
+    m_category = category;
+    m_name = name;
+    m_start = std::chrono::steady_clock::now();
+}
+
+TraceSpan::TraceSpan(const char *category, const char *prefix, std::string_view suffix)
+{
+    if (!isTracingEnabled()) {
+        return;
+    }
+    m_active = true;
+    m_category = category;
+    m_ownedName.reserve(std::char_traits<char>::length(prefix) + suffix.size());
+    m_ownedName.append(prefix).append(suffix);
+    m_start = std::chrono::steady_clock::now();
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (!m_active) {
+        return;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    nlohmann::json args = m_args.is_object() ? std::move(m_args) : nlohmann::json::object();
+    const QString corr = logging::currentCorrelationId();
+    if (!corr.isEmpty()) {
+        args["corr"] = corr.toStdString();
+    }
+
+    const nlohmann::json event = {
+        {"name", m_ownedName.empty() ? std::string(m_name) : m_ownedName},
+        {"cat", m_category},
+        {"ph", "X"},
+        {"ts", toMicros(m_start)},
+        {"dur", toMicros(end) - toMicros(m_start)},
+        {"pid", static_cast<long>(getpid())},
+        {"tid", currentThreadId()},
+        {"args", std::move(args)}
+    };
+    sink().write(event.dump());
+}
+
+void TraceSpan::setArg(const char *key, nlohmann::json value)
+{
+    if (!m_active) {
+        return;
+    }
+    m_args[key] = std::move(value);
+}
+
+} // namespace khronicle::tracing
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle::tracing {
+
+// Span tracing in Chrome trace-event format, for opening a daemon run in
+// Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+// Enabled when KHRONICLE_TRACE_FILE names an output path at first use. Each
+// finished span is appended as a complete ("ph":"X") event with steady_clock
+// microsecond timestamps, pid/tid and the current log correlation id. The
+// file is a JSON array left open at the end, which both viewers accept, so a
+// crashed process still leaves a readable trace.
+bool isTracingEnabled();
+
+// Writes buffered events to disk; called automatically at exit.
+void flushTrace();
+
+class TraceSpan {
+public:
+    // category and name must outlive the span (string literals at call sites).
+    TraceSpan(const char *category, const char *name);
+    // For names built at runtime, e.g. "api:" + "get_changes_since". The
+    // name is only put together when tracing is on.
+    TraceSpan(const char *category, const char *prefix, std::string_view suffix);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    // Extra key/values shown in the viewer's details pane. No-op when
+    // tracing is off.
+    void setArg(const char *key, nlohmann::json value);
+
+private:
+    bool m_active = false;
+    const char *m_category = "";
+    const char *m_name = "";
+    std::string m_ownedName;
+    nlohmann::json m_args;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace khronicle::tracing
+
+#define KTRACE_CONCAT_DETAIL(a, b) a##b
+#define KTRACE_CONCAT(a, b) KTRACE_CONCAT_DETAIL(a, b)
+
+// Traces the enclosing scope: KTRACE_SCOPE("store", "addEvent");
+#define KTRACE_SCOPE(category, name) \
+    ::khronicle::tracing::TraceSpan KTRACE_CONCAT(ktraceSpan, __LINE__)((category), (name))
@@ -0,0 +1,265 @@
+#include "common/version_compare.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace khronicle {
+
+namespace {
+
+bool isAlpha(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) != 0;
+}
+
+bool isDigit(char c)
+{
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+bool isAlnum(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) != 0;
+}
+
+struct Evr {
+    std::string epoch;
+    std::string version;
+    std::string release;
+    bool hasRelease = false;
+};
+
+// Mirrors libalpm's parseEVR(): "epoch:version-release", where the epoch is
+// only recognized when everything before ':' is digits and the release
+// starts after the last '-'.
+Evr parseEvr(const std::string &evr)
+{
+    Evr parsed;
+    std::size_t start = 0;
+    std::size_t s = 0;
+    while (s < evr.size() && isDigit(evr[s])) {
+        ++s;
+    }
+    if (s < evr.size() && evr[s] == ':') {
+        parsed.epoch = evr.substr(0, s);
+        start = s + 1;
+        if (parsed.epoch.empty()) {
+            parsed.epoch = "0";
+        }
+    } else {
+        parsed.epoch = "0";
+    }
+
+    const std::size_t dash = evr.rfind('-');
+    if (dash != std::string::npos && dash >= start) {
+        parsed.version = evr.substr(start, dash - start);
+        parsed.release = evr.substr(dash + 1);
+        parsed.hasRelease = true;
+    } else {
+        parsed.version = evr.substr(start);
+    }
+    return parsed;
+}
+
+// Mirrors libalpm's rpmvercmp(), segment by segment.
+int rpmvercmp(const std::string &a, const std::string &b)
+{
+    if (a == b) {
+        return 0;
+    }
+
+    std::size_t one = 0;
+    std::size_t two = 0;
+    std::size_t ptr1 = 0;
+    std::size_t ptr2 = 0;
+
+    while (one < a.size() && two < b.size()) {
+        while (one < a.size() && !isAlnum(a[one])) {
+            ++one;
+        }
+        while (two < b.size() && !isAlnum(b[two])) {
+            ++two;
+        }
+
+        if (one >= a.size() || two >= b.size()) {
+            break;
+        }
+
+        // Differing separator lengths decide the comparison.
+        if (one - ptr1 != two - ptr2) {
+            return (one - ptr1) < (two - ptr2) ? -1 : 1;
+        }
+
+        ptr1 = one;
+        ptr2 = two;
+
+        bool isNum = false;
+        if (isDigit(a[ptr1])) {
+            while (ptr1 < a.size() && isDigit(a[ptr1])) {
+                ++ptr1;
+            }
+            while (ptr2 < b.size() && isDigit(b[ptr2])) {
+                ++ptr2;
+            }
+            isNum = true;
+        } else {
+            while (ptr1 < a.size() && isAlpha(a[ptr1])) {
+                ++ptr1;
+            }
+            while (ptr2 < b.size() && isAlpha(b[ptr2])) {
+                ++ptr2;
+            }
+        }
+
+        // Segments of different types: numeric always beats alpha.
+        if (two == ptr2) {
+            return isNum ? 1 : -1;
+        }
+
+        std::string segA = a.substr(one, ptr1 - one);
+        std::string segB = b.substr(two, ptr2 - two);
+        if (isNum) {
+            segA.erase(0, std::min(segA.find_first_not_of('0'), segA.size()));
+            segB.erase(0, std::min(segB.find_first_not_of('0'), segB.size()));
+            if (segA.size() != segB.size()) {
+                return segA.size() < segB.size() ? -1 : 1;
+            }
+        }
+
+        const int rc = segA.compare(segB);
+        if (rc != 0) {
+            return rc < 0 ? -1 : 1;
+        }
+
+        one = ptr1;
+        two = ptr2;
+    }
+
+    if (one >= a.size() && two >= b.size()) {
+        return 0;
+    }
+
+    // A remaining alpha segment never beats an empty string ("1.0a" < "1.0"),
+    // anything else that remains is newer.
+    if ((one >= a.size() && !(two < b.size() && isAlpha(b[two])))
+        || (one < a.size() && isAlpha(a[one]))) {
+        return -1;
+    }
+    return 1;
+}
+
+// Key tokens. Per position the ordering is: alpha segment glued to the
+// previous one < end of string < numeric segment glued to the previous one
+// < segments after one separator (alpha < numeric) < after two, and so on.
+constexpr unsigned char kTokenGluedAlpha = 0x20;
+constexpr unsigned char kTokenEnd = 0x21;
+constexpr unsigned char kTokenGluedNumber = 0x22;
+constexpr std::size_t kMaxSeparatorRun = 15;
+
+void appendSegments(std::string &key, const std::string &value)
+{
+    std::size_t pos = 0;
+    while (pos < value.size()) {
+        std::size_t separators = 0;
+        while (pos < value.size() && !isAlnum(value[pos])) {
+            ++pos;
+            ++separators;
+        }
+        if (pos >= value.size()) {
+            // Trailing separators; see the caveat in the header.
+            break;
+        }
+
+        const bool numeric = isDigit(value[pos]);
+        const std::size_t run = std::min(separators, kMaxSeparatorRun);
+        unsigned char token = 0;
+        if (run == 0) {
+            token = numeric ? kTokenGluedNumber : kTokenGluedAlpha;
+        } else {
+            token = static_cast<unsigned char>(kTokenGluedNumber + run * 2
+                                               - (numeric ? 0 : 1));
+        }
+        key.push_back(static_cast<char>(token));
+
+        const std::size_t begin = pos;
+        if (numeric) {
+            while (pos < value.size() && isDigit(value[pos])) {
+                ++pos;
+            }
+            std::size_t first = begin;
+            while (first < pos && value[first] == '0') {
+                ++first;
+            }
+            // Longer numbers are larger; equal lengths compare digit-wise.
+            const std::size_t digits = std::min<std::size_t>(pos - first, 0xFF);
+            key.push_back(static_cast<char>(digits));
+            key.append(value, first, digits);
+        } else {
+            while (pos < value.size() && isAlpha(value[pos])) {
+                ++pos;
+            }
+            key.append(value, begin, pos - begin);
+            key.push_back('\0');
+        }
+    }
+    key.push_back(static_cast<char>(kTokenEnd));
+}
+
+} // namespace
+
+int compareVersions(const std::string &a, const std::string &b)
+{
+    if (a == b) {
+        return 0;
+    }
+
+    const Evr left = parseEvr(a);
+    const Evr right = parseEvr(b);
+
+    int ret = rpmvercmp(left.epoch, right.epoch);
+    if (ret == 0) {
+        ret = rpmvercmp(left.version, right.version);
+        if (ret == 0 && left.hasRelease && right.hasRelease) {
+            ret = rpmvercmp(left.release, right.release);
+        }
+    }
+    return ret;
+}
+
+std::string versionSortKey(const std::string &version)
+{
+    const Evr evr = parseEvr(version);
+    std::string key;
+    key.reserve(version.size() + 8);
+    appendSegments(key, evr.epoch);
+    appendSegments(key, evr.version);
+    if (evr.hasRelease) {
+        appendSegments(key, evr.release);
+    }
+    return key;
+}
+
+std::string versionSortKeyFloor(const std::string &version)
+{
+    const Evr evr = parseEvr(version);
+    std::string key;
+    key.reserve(version.size() + 8);
+    appendSegments(key, evr.epoch);
+    appendSegments(key, evr.version);
+    return key;
+}
+
+bool versionInRange(const std::string &version,
+                    const std::string &minVersion,
+                    const std::string &maxVersion)
+{
+    if (!minVersion.empty() && compareVersions(version, minVersion) < 0) {
+        return false;
+    }
+    if (!maxVersion.empty() && compareVersions(version, maxVersion) >= 0) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace khronicle
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+namespace khronicle {
+
+// Port of pacman's alpm_pkg_vercmp() for "[epoch:]pkgver[-pkgrel]" strings.
+// Returns a negative value when a is older than b, 0 when equal and a
+// positive value when a is newer. The release is only compared when both
+// versions carry one, exactly as pacman does.
+int compareVersions(const std::string &a, const std::string &b);
+
+// Byte string whose lexicographic (memcmp / SQLite BLOB) order follows
+// compareVersions(), so version ranges can be answered by an index scan.
+//
+// The key agrees with compareVersions() for well-formed package versions.
+// It cannot be exact in every corner: rpmvercmp is not transitive for
+// trailing separators ("1.0." vs "1.0.a"), and a missing pkgrel compares
+// equal to any pkgrel while the key sorts it first. Range queries therefore
+// scan by key and then confirm each candidate with compareVersions().
+std::string versionSortKey(const std::string &version);
+
+// Key of version without its pkgrel: no version that compares equal to it
+// sorts below this, so it is the start of a ">= version" key range.
+std::string versionSortKeyFloor(const std::string &version);
+
+// True when version lies in [minVersion, maxVersion). Empty bounds are open.
+bool versionInRange(const std::string &version,
+                    const std::string &minVersion,
+                    const std::string &maxVersion);
+
+} // namespace khronicle
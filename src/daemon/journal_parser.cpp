@@ -16,6 +16,7 @@
 
 #include "common/json_utils.hpp"
 #include "common/logging.hpp"
+#include "common/tracing.hpp"
 
 namespace khronicle {
 
@@ -136,6 +137,8 @@ JournalParseResult parseJournalSince(std::chrono::system_clock::time_point since
             return parseJournalOutputLines(lines, since);
         }
     }
+    // Span covers the journalctl run plus parsing its output.
+    KTRACE_SCOPE("process", "spawn:journalctl");
     QProcess process;
     QString sinceArg = QStringLiteral("--since=%1").arg(toIsoSince(since));
     KLOG_DEBUG(QStringLiteral("JournalParser"),
@@ -2,19 +2,20 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <optional>
+#include <stdexcept>
 
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
-#include <QStandardPaths>
 #include <QDebug>
 #include <QUuid>
 
-#include <unistd.h>
-
 #include "common/json_utils.hpp"
 #include "common/logging.hpp"
+#include "common/process_utils.hpp"
+#include "common/tracing.hpp"
 #include "debug/scenario_capture.hpp"
 #include "daemon/counterfactual.hpp"
 
@@ -22,23 +23,13 @@ namespace khronicle {
 
 namespace {
 
-QString runtimeSocketPath()
-{
-    const QString socketName = qEnvironmentVariable("KHRONICLE_SOCKET_NAME");
-    if (!socketName.isEmpty()) {
-        return socketName;
-    }
-
-    QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
-    if (runtimeDir.isEmpty()) {
-        runtimeDir =
-            QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
-    }
-    if (runtimeDir.isEmpty()) {
-        runtimeDir = QStringLiteral("/run/user/%1").arg(getuid());
-    }
-    return runtimeDir + QStringLiteral("/khronicle.sock");
-}
+// get_changes_page sizes: a screenful or two per page by default, bounded so
+// one request cannot serialize the whole history.
+constexpr int kDefaultPageSize = 100;
+constexpr int kMaxPageSize = 1000;
+// Longest request line buffered while waiting for its newline; requests are
+// a few hundred bytes, so a peer past this is not speaking the protocol.
+constexpr qsizetype kMaxRequestLineBytes = 1024 * 1024;
 
 std::optional<std::string> extractKernelVersion(const nlohmann::json &state)
 {
@@ -71,6 +62,70 @@ std::optional<SystemSnapshot> latestSnapshot(
     return *latest;
 }
 
+// Client-side mistakes (bad params, unknown method) that are answered with an
+// error response but are not daemon failures worth an ERROR line.
+class RequestError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+WatchSeverity parseSeverityParam(const nlohmann::json &value)
+{
+    // parseWatchSeverityString falls back to info; API callers get an error.
+    if (!value.is_string()
+        || toWatchSeverityString(parseWatchSeverityString(value.get<std::string>()))
+               != value.get<std::string>()) {
+        throw RequestError("Invalid severity");
+    }
+    return parseWatchSeverityString(value.get<std::string>());
+}
+
+long long microsBetween(std::chrono::steady_clock::time_point from,
+                        std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+// Adopts the caller's trace id as the correlation id so client and daemon
+// log lines for one request can be joined. Ids are client-controlled, so
+// only short printable values are accepted.
+QString adoptTraceId(const nlohmann::json &request)
+{
+    auto trace = request.find("trace");
+    if (trace != request.end() && trace->is_object()) {
+        auto id = trace->find("id");
+        if (id != trace->end() && id->is_string()) {
+            const std::string value = id->get<std::string>();
+            const bool printable = std::all_of(value.begin(), value.end(), [](char c) {
+                return c > 0x20 && c < 0x7f;
+            });
+            if (!value.empty() && value.size() <= 64 && printable) {
+                return QString::fromStdString(value);
+            }
+        }
+    }
+    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
+
+// Microseconds between the client writing the request and the daemon reading
+// it, from the client's system-clock sentAtUs. Same-host clocks, so this is
+// meaningful, but it is clamped because the wall clock can step.
+std::optional<long long> clientToServerUs(const nlohmann::json &request)
+{
+    auto trace = request.find("trace");
+    if (trace == request.end() || !trace->is_object()) {
+        return std::nullopt;
+    }
+    auto sentAt = trace->find("sentAtUs");
+    if (sentAt == trace->end() || !sentAt->is_number_integer()) {
+        return std::nullopt;
+    }
+    const long long nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return std::max(0LL, nowUs - sentAt->get<long long>());
+}
+
 } // namespace
 
 KhronicleApiServer::KhronicleApiServer(KhronicleStore &store, QObject *parent)
@@ -81,9 +136,14 @@ KhronicleApiServer::KhronicleApiServer(KhronicleStore &store, QObject *parent)
 
 KhronicleApiServer::~KhronicleApiServer() = default;
 
+void KhronicleApiServer::setRequestObserver(RequestObserver observer)
+{
+    m_requestObserver = std::move(observer);
+}
+
 bool KhronicleApiServer::start()
 {
-    const QString socketPath = runtimeSocketPath();
+    const QString socketPath = daemonSocketPath();
     if (socketPath.contains('/')) {
         const QFileInfo socketInfo(socketPath);
         if (!QDir().mkpath(socketInfo.absolutePath())) {
@@ -126,6 +186,9 @@ void KhronicleApiServer::handleNewConnection()
                 this, &KhronicleApiServer::handleClientReadyRead);
         connect(socket, &QLocalSocket::disconnected,
                 socket, &QObject::deleteLater);
+        connect(socket, &QObject::destroyed, this, [this, socket]() {
+            m_partialLines.remove(socket);
+        });
     }
 }
 
@@ -136,38 +199,108 @@ void KhronicleApiServer::handleClientReadyRead()
         return;
     }
 
+    const auto receivedAt = std::chrono::steady_clock::now();
     const QByteArray payload = socket->readAll();
     if (payload.isEmpty()) {
         return;
     }
 
-    const QList<QByteArray> lines = payload.split('\n');
+    // Only complete lines are requests; the tail waits for the rest.
+    QByteArray buffer = m_partialLines.take(socket) + payload;
+    const qsizetype end = buffer.lastIndexOf('\n');
+    if (buffer.size() - (end + 1) > kMaxRequestLineBytes) {
+        KLOG_WARN(QStringLiteral("KhronicleApiServer"),
+                  QStringLiteral("handleClientReadyRead"),
+                  QStringLiteral("request_line_too_long"),
+                  QStringLiteral("no_newline_within_limit"),
+                  QStringLiteral("disconnect"),
+                  khronicle::logging::defaultWho(),
+                  QString(),
+                  (nlohmann::json{{"bufferedBytes", buffer.size() - (end + 1)},
+                                  {"limit", kMaxRequestLineBytes}}));
+        socket->write(makeErrorResponse(QStringLiteral("Request line too long")));
+        socket->write("\n");
+        socket->flush();
+        socket->disconnectFromServer();
+        return;
+    }
+    if (end < 0) {
+        m_partialLines.insert(socket, buffer);
+        return;
+    }
+    if (end + 1 < buffer.size()) {
+        m_partialLines.insert(socket, buffer.mid(end + 1));
+    }
+    buffer.truncate(end);
+
+    const QList<QByteArray> lines = buffer.split('\n');
     for (const QByteArray &line : lines) {
         if (line.trimmed().isEmpty()) {
             continue;
         }
-        handleRequest(socket, line);
+        handleRequest(socket, line, receivedAt);
     }
 }
 
 void KhronicleApiServer::handleRequest(QLocalSocket *socket,
-                                       const QByteArray &payload)
+                                       const QByteArray &payload,
+                                       std::chrono::steady_clock::time_point receivedAt)
 {
     if (!socket) {
         return;
     }
-    const QByteArray response = handleRequestPayload(payload);
+    m_requestSocket = socket;
+    const QByteArray response = handleRequestPayload(payload, receivedAt);
+    m_requestSocket = nullptr;
     socket->write(response);
     socket->write("\n");
     socket->flush();
 }
 
-QByteArray KhronicleApiServer::handleRequestPayload(const QByteArray &payload)
+void KhronicleApiServer::publishWatchSignal(const WatchSignal &signal)
+{
+    if (m_watchSubscribers.isEmpty()) {
+        return;
+    }
+    const nlohmann::json notification = {
+        {"method", "watch_signal"},
+        {"params", {{"signal", signal}}}
+    };
+    const QByteArray line = QByteArray::fromStdString(notification.dump()) + '\n';
+    int delivered = 0;
+    for (auto it = m_watchSubscribers.cbegin(); it != m_watchSubscribers.cend(); ++it) {
+        QLocalSocket *socket = it.key();
+        if (signal.severity < it.value()
+            || socket->state() != QLocalSocket::ConnectedState) {
+            continue;
+        }
+        socket->write(line);
+        socket->flush();
+        ++delivered;
+    }
+    KLOG_DEBUG(QStringLiteral("KhronicleApiServer"),
+               QStringLiteral("publishWatchSignal"),
+               QStringLiteral("watch_signal_pushed"),
+               QStringLiteral("watch_signal_fired"),
+               QStringLiteral("json_rpc_push"),
+               khronicle::logging::defaultWho(),
+               QString(),
+               (nlohmann::json{{"signalId", signal.id}, {"subscribers", delivered}}));
+}
+
+QByteArray KhronicleApiServer::handleRequestPayload(
+    const QByteArray &payload,
+    std::chrono::steady_clock::time_point receivedAt)
 {
     // JSON-RPC-style request handler. All requests are local-only via UNIX socket.
-    const QString corrId = QUuid::createUuid().toString(QUuid::WithoutBraces);
-    khronicle::logging::CorrelationScope corrScope(corrId);
+    if (receivedAt == std::chrono::steady_clock::time_point{}) {
+        receivedAt = std::chrono::steady_clock::now();
+    }
     const auto parsed = nlohmann::json::parse(payload.toStdString(), nullptr, false);
+    const QString corrId = parsed.is_object()
+        ? adoptTraceId(parsed)
+        : QUuid::createUuid().toString(QUuid::WithoutBraces);
+    khronicle::logging::CorrelationScope corrScope(corrId);
     if (parsed.is_discarded() || !parsed.is_object()) {
         KLOG_WARN(QStringLiteral("KhronicleApiServer"),
                   QStringLiteral("handleRequest"),
@@ -198,6 +331,7 @@ QByteArray KhronicleApiServer::handleRequestPayload(const QByteArray &payload)
     }
 
     const std::string method = parsed["method"].get<std::string>();
+    khronicle::tracing::TraceSpan span("api", "api:", method);
     nlohmann::json params = nlohmann::json::object();
     if (parsed.contains("params")) {
         if (!parsed["params"].is_object()) {
@@ -212,15 +346,19 @@ QByteArray KhronicleApiServer::handleRequestPayload(const QByteArray &payload)
             paramKeys.push_back(it.key());
         }
     }
-    KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-              QStringLiteral("handleRequest"),
-              QStringLiteral("api_request_received"),
-              QStringLiteral("client_call"),
-              QStringLiteral("json_rpc"),
-              khronicle::logging::defaultWho(),
-              corrId,
-              (nlohmann::json{{"method", method},
-                             {"paramKeys", paramKeys}}));
+    nlohmann::json receivedContext = {{"method", method}, {"paramKeys", paramKeys}};
+    if (const auto transitUs = clientToServerUs(parsed)) {
+        receivedContext["clientToServerUs"] = *transitUs;
+    }
+    KLOG_INFO_LIMITED(khronicle::logging::kApiRequestLogLimit,
+                      QStringLiteral("KhronicleApiServer"),
+                      QStringLiteral("handleRequest"),
+                      QStringLiteral("api_request_received"),
+                      QStringLiteral("client_call"),
+                      QStringLiteral("json_rpc"),
+                      khronicle::logging::defaultWho(),
+                      corrId,
+                      receivedContext);
 
     if (ScenarioCapture::isEnabled()) {
         ScenarioCapture::recordStep(nlohmann::json{
@@ -229,19 +367,36 @@ QByteArray KhronicleApiServer::handleRequestPayload(const QByteArray &payload)
         });
     }
 
-    auto start = std::chrono::steady_clock::now();
+    const auto dispatchStart = std::chrono::steady_clock::now();
+    nlohmann::json result;
     try {
-        if (method == "get_changes_since") {
-            const std::string sinceValue = params.value("since", "");
-            const auto since = fromIso8601Utc(sinceValue);
-            if (since == std::chrono::system_clock::time_point{}) {
-                return makeErrorResponse("Invalid since timestamp", id);
-            }
-
-            const auto events = m_store.getEventsSince(since);
-            nlohmann::json result;
-            result["events"] = events;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
+        result = dispatch(method, params);
+    } catch (const RequestError &ex) {
+        return makeErrorResponse(QString::fromUtf8(ex.what()), id);
+    } catch (const std::exception &ex) {
+        KLOG_ERROR(QStringLiteral("KhronicleApiServer"),
+                   QStringLiteral("handleRequest"),
+                   QStringLiteral("api_request_error"),
+                   QStringLiteral("exception"),
+                   QStringLiteral("json_rpc"),
+                   khronicle::logging::defaultWho(),
+                   corrId,
+                   (nlohmann::json{{"what", ex.what()}}));
+        return makeErrorResponse(ex.what(), id);
+    }
+    const auto queryEnd = std::chrono::steady_clock::now();
+    // Serialized separately so its cost can be reported in the same response.
+    const std::string resultText = result.dump();
+    const auto serializeEnd = std::chrono::steady_clock::now();
+
+    const nlohmann::json trace = {
+        {"id", corrId.toStdString()},
+        {"queueWaitUs", microsBetween(receivedAt, dispatchStart)},
+        {"queryUs", microsBetween(dispatchStart, queryEnd)},
+        {"serializeUs", microsBetween(queryEnd, serializeEnd)}
+    };
+    KLOG_INFO_LIMITED(khronicle::logging::kApiRequestLogLimit,
+                      QStringLiteral("KhronicleApiServer"),
                       QStringLiteral("handleRequest"),
                       QStringLiteral("api_request_completed"),
                       QStringLiteral("client_call"),
@@ -249,353 +404,380 @@ QByteArray KhronicleApiServer::handleRequestPayload(const QByteArray &payload)
                       khronicle::logging::defaultWho(),
                       corrId,
                       (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
-        }
-
-        if (method == "get_changes_between") {
-            const std::string fromValue = params.value("from", "");
-            const std::string toValue = params.value("to", "");
-            const auto from = fromIso8601Utc(fromValue);
-            const auto to = fromIso8601Utc(toValue);
-            if (from == std::chrono::system_clock::time_point{}
-                || to == std::chrono::system_clock::time_point{}) {
-                return makeErrorResponse("Invalid from/to timestamp", id);
-            }
+                                     {"durationMs", microsBetween(receivedAt, serializeEnd) / 1000},
+                                     {"queueWaitUs", trace["queueWaitUs"]},
+                                     {"queryUs", trace["queryUs"]},
+                                     {"serializeUs", trace["serializeUs"]}}));
+    if (m_requestObserver) {
+        m_requestObserver(method, std::chrono::duration_cast<std::chrono::microseconds>(
+                                      serializeEnd - receivedAt));
+    }
+    return makeResultResponse(resultText, id, trace);
+}
 
-            const auto events = m_store.getEventsBetween(from, to);
-            nlohmann::json result;
-            result["events"] = events;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+nlohmann::json KhronicleApiServer::dispatch(const std::string &method,
+                                            const nlohmann::json &params)
+{
+    if (method == "get_changes_since") {
+        const std::string sinceValue = params.value("since", "");
+        const auto since = fromIso8601Utc(sinceValue);
+        if (since == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid since timestamp");
         }
 
-        if (method == "list_snapshots") {
-            const auto snapshots = m_store.listSnapshots();
-            nlohmann::json result;
-            result["snapshots"] = snapshots;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+        const auto events = m_store.getEventsSince(since);
+        nlohmann::json result;
+        result["events"] = events;
+        return result;
+    }
+
+    if (method == "get_changes_between") {
+        const std::string fromValue = params.value("from", "");
+        const std::string toValue = params.value("to", "");
+        const auto from = fromIso8601Utc(fromValue);
+        const auto to = fromIso8601Utc(toValue);
+        if (from == std::chrono::system_clock::time_point{}
+            || to == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid from/to timestamp");
         }
 
-        if (method == "get_snapshot") {
-            const std::string snapshotId = params.value("id", "");
-            if (snapshotId.empty()) {
-                return makeErrorResponse("Missing snapshot id", id);
-            }
-            const auto snapshot = m_store.getSnapshot(snapshotId);
-            if (!snapshot.has_value()) {
-                return makeErrorResponse("Snapshot not found", id);
-            }
-            nlohmann::json result;
-            result["snapshot"] = *snapshot;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+        const auto events = m_store.getEventsBetween(from, to);
+        nlohmann::json result;
+        result["events"] = events;
+        return result;
+    }
+
+    if (method == "get_changes_page") {
+        // Newest-first page of [from, to]. Pass back nextCursor to continue;
+        // it is null on the last page.
+        const auto from = fromIso8601Utc(params.value("from", ""));
+        const auto to = fromIso8601Utc(params.value("to", ""));
+        if (from == std::chrono::system_clock::time_point{}
+            || to == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid from/to timestamp");
+        }
+        const int limit = params.value("limit", kDefaultPageSize);
+        if (limit <= 0 || limit > kMaxPageSize) {
+            throw RequestError("Invalid limit");
         }
 
-        if (method == "diff_snapshots") {
-            const std::string aId = params.value("a", "");
-            const std::string bId = params.value("b", "");
-            if (aId.empty() || bId.empty()) {
-                return makeErrorResponse("Missing snapshot ids", id);
+        std::optional<EventPageCursor> cursor;
+        if (params.contains("cursor") && !params["cursor"].is_null()) {
+            const auto &value = params["cursor"];
+            if (!value.is_object()) {
+                throw RequestError("Invalid cursor");
             }
-            const auto diff = m_store.diffSnapshots(aId, bId);
-            nlohmann::json result;
-            result["diff"] = diff;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
-        }
-
-        if (method == "summary_since") {
-            // INVARIANT: Summaries are interpretations derived from stored facts.
-            const std::string sinceValue = params.value("since", "");
-            const auto since = fromIso8601Utc(sinceValue);
-            if (since == std::chrono::system_clock::time_point{}) {
-                return makeErrorResponse("Invalid since timestamp", id);
+            cursor = EventPageCursor{fromIso8601Utc(value.value("timestamp", "")),
+                                     value.value("id", "")};
+            if (cursor->timestamp == std::chrono::system_clock::time_point{}) {
+                throw RequestError("Invalid cursor");
             }
+        }
 
-            const auto events = m_store.getEventsSince(since);
-            int gpuEvents = 0;
-            int firmwareEvents = 0;
-            bool kernelChanged = false;
-            std::string kernelFrom;
-            std::string kernelTo;
-
-            for (const auto &event : events) {
-                switch (event.category) {
-                case EventCategory::Kernel: {
-                    kernelChanged = true;
-                    if (kernelFrom.empty()) {
-                        if (auto value = extractKernelVersion(event.beforeState)) {
-                            kernelFrom = *value;
-                        }
-                    }
-                    if (auto value = extractKernelVersion(event.afterState)) {
-                        kernelTo = *value;
-                    }
-                    break;
-                }
-                case EventCategory::GpuDriver:
-                    gpuEvents++;
-                    break;
-                case EventCategory::Firmware:
-                    firmwareEvents++;
-                    break;
-                default:
-                    break;
-                }
-            }
+        // Read first: every row of the page is at or below it, so a client
+        // that later asks for changes after it misses nothing.
+        const std::int64_t generation = m_store.getStoreGeneration();
+        // One extra row tells whether another page exists.
+        auto events = m_store.getEventsPage(from, to, cursor,
+                                            static_cast<std::size_t>(limit) + 1);
+        const bool hasMore = events.size() > static_cast<std::size_t>(limit);
+        if (hasMore) {
+            events.pop_back();
+        }
 
-            nlohmann::json result;
-            result["kernelChanged"] = kernelChanged;
-            result["kernelFrom"] = kernelFrom;
-            result["kernelTo"] = kernelTo;
-            result["gpuEvents"] = gpuEvents;
-            result["firmwareEvents"] = firmwareEvents;
-            result["totalEvents"] = static_cast<int>(events.size());
+        nlohmann::json result;
+        result["events"] = events;
+        result["nextCursor"] = hasMore
+            ? nlohmann::json{{"timestamp", toIso8601Utc(events.back().timestamp)},
+                             {"id", events.back().id}}
+            : nlohmann::json(nullptr);
+        result["generation"] = generation;
+        return result;
+    }
 
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+    if (method == "get_changes_after_generation") {
+        // Events in [from, to] added or replaced since a client's copy was
+        // current (the generation of a get_changes_page answer, or of a
+        // previous call). complete is false when there were more than
+        // limit or the generation is unknown; the client should then reload
+        // the range instead.
+        const auto from = fromIso8601Utc(params.value("from", ""));
+        const auto to = fromIso8601Utc(params.value("to", ""));
+        if (from == std::chrono::system_clock::time_point{}
+            || to == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid from/to timestamp");
+        }
+        if (!params.contains("generation") || !params["generation"].is_number_integer()
+            || params["generation"].get<std::int64_t>() < 0) {
+            throw RequestError("Invalid generation");
+        }
+        const int limit = params.value("limit", kMaxPageSize);
+        if (limit <= 0 || limit > kMaxPageSize) {
+            throw RequestError("Invalid limit");
         }
 
-        if (method == "list_watch_rules") {
-            const auto rules = m_store.listWatchRules();
-            nlohmann::json result;
-            result["rules"] = rules;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+        const std::int64_t since = params["generation"].get<std::int64_t>();
+        const std::int64_t generation = m_store.getStoreGeneration();
+        auto events = m_store.getEventsAfterGeneration(since, from, to,
+                                                       static_cast<std::size_t>(limit) + 1);
+        // A generation from the future means the database was replaced.
+        const bool complete = since <= generation
+            && events.size() <= static_cast<std::size_t>(limit);
+        if (!complete) {
+            events.clear();
         }
 
-        if (method == "upsert_watch_rule") {
-            if (!params.contains("rule") || !params["rule"].is_object()) {
-                return makeErrorResponse("Missing rule object", id);
-            }
-            WatchRule rule = params["rule"].get<WatchRule>();
-            if (rule.id.empty()) {
-                return makeErrorResponse("Missing rule id", id);
-            }
-            m_store.upsertWatchRule(rule);
-            nlohmann::json result;
-            result["ok"] = true;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+        nlohmann::json result;
+        result["events"] = events;
+        result["generation"] = generation;
+        result["complete"] = complete;
+        return result;
+    }
+
+    if (method == "get_changes_by_version_range") {
+        // Version bounds use pacman's vercmp ordering: [minVersion, maxVersion).
+        const std::string packageName = params.value("package", "");
+        if (packageName.empty()) {
+            throw RequestError("Missing package");
         }
+        const std::string minVersion = params.value("minVersion", "");
+        const std::string maxVersion = params.value("maxVersion", "");
+
+        const auto events =
+            m_store.getEventsByVersionRange(packageName, minVersion, maxVersion);
+        nlohmann::json result;
+        result["events"] = events;
+        return result;
+    }
 
-        if (method == "delete_watch_rule") {
-            const std::string ruleId = params.value("id", "");
-            if (ruleId.empty()) {
-                return makeErrorResponse("Missing rule id", id);
-            }
-            m_store.deleteWatchRule(ruleId);
-            nlohmann::json result;
-            result["ok"] = true;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+    if (method == "list_snapshots") {
+        const auto snapshots = m_store.listSnapshots();
+        nlohmann::json result;
+        result["snapshots"] = snapshots;
+        return result;
+    }
+
+    if (method == "get_snapshot") {
+        const std::string snapshotId = params.value("id", "");
+        if (snapshotId.empty()) {
+            throw RequestError("Missing snapshot id");
+        }
+        const auto snapshot = m_store.getSnapshot(snapshotId);
+        if (!snapshot.has_value()) {
+            throw RequestError("Snapshot not found");
         }
+        nlohmann::json result;
+        result["snapshot"] = *snapshot;
+        return result;
+    }
 
-        if (method == "get_watch_signals_since") {
-            const std::string sinceValue = params.value("since", "");
-            const auto since = fromIso8601Utc(sinceValue);
-            if (since == std::chrono::system_clock::time_point{}) {
-                return makeErrorResponse("Invalid since timestamp", id);
+    if (method == "diff_snapshots") {
+        const std::string aId = params.value("a", "");
+        const std::string bId = params.value("b", "");
+        if (aId.empty() || bId.empty()) {
+            throw RequestError("Missing snapshot ids");
+        }
+        const auto diff = m_store.diffSnapshots(aId, bId);
+        nlohmann::json result;
+        result["diff"] = diff;
+        return result;
+    }
+
+    if (method == "summary_since") {
+        // INVARIANT: Summaries are interpretations derived from stored facts.
+        const std::string sinceValue = params.value("since", "");
+        const auto since = fromIso8601Utc(sinceValue);
+        if (since == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid since timestamp");
+        }
+
+        const auto events = m_store.getEventsSince(since);
+        int gpuEvents = 0;
+        int firmwareEvents = 0;
+        bool kernelChanged = false;
+        std::string kernelFrom;
+        std::string kernelTo;
+
+        for (const auto &event : events) {
+            switch (event.category) {
+            case EventCategory::Kernel: {
+                kernelChanged = true;
+                if (kernelFrom.empty()) {
+                    if (auto value = extractKernelVersion(event.beforeState)) {
+                        kernelFrom = *value;
+                    }
+                }
+                if (auto value = extractKernelVersion(event.afterState)) {
+                    kernelTo = *value;
+                }
+                break;
             }
-            const auto watchSignals = m_store.getWatchSignalsSince(since);
-            nlohmann::json result;
-            result["signals"] = watchSignals;
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
-        }
-
-        if (method == "explain_change_between") {
-            // INVARIANT: Explanations are interpretive, not causal assertions.
-            const std::string fromValue = params.value("from", "");
-            const std::string toValue = params.value("to", "");
-            const auto from = fromIso8601Utc(fromValue);
-            const auto to = fromIso8601Utc(toValue);
-            if (from == std::chrono::system_clock::time_point{}
-                || to == std::chrono::system_clock::time_point{}) {
-                return makeErrorResponse("Invalid from/to timestamp", id);
+            case EventCategory::GpuDriver:
+                gpuEvents++;
+                break;
+            case EventCategory::Firmware:
+                firmwareEvents++;
+                break;
+            default:
+                break;
             }
+        }
 
-            const auto baseline = m_store.getSnapshotBefore(from);
-            const auto comparison = m_store.getSnapshotAfter(to);
-            if (!baseline.has_value() || !comparison.has_value()) {
-                return makeErrorResponse("Snapshots not found", id);
-            }
+        nlohmann::json result;
+        result["kernelChanged"] = kernelChanged;
+        result["kernelFrom"] = kernelFrom;
+        result["kernelTo"] = kernelTo;
+        result["gpuEvents"] = gpuEvents;
+        result["firmwareEvents"] = firmwareEvents;
+        result["totalEvents"] = static_cast<int>(events.size());
+        return result;
+    }
 
-            const auto events = m_store.getEventsBetween(from, to);
-            const auto resultData =
-                computeCounterfactual(*baseline, *comparison, events);
+    if (method == "list_watch_rules") {
+        const auto rules = m_store.listWatchRules();
+        nlohmann::json result;
+        result["rules"] = rules;
+        return result;
+    }
 
-            nlohmann::json result;
-            result["baselineSnapshot"] = resultData.baselineSnapshotId;
-            result["comparisonSnapshot"] = resultData.comparisonSnapshotId;
-            result["summary"] = resultData.explanationSummary;
-            result["diff"] = resultData.diff;
+    if (method == "upsert_watch_rule") {
+        if (!params.contains("rule") || !params["rule"].is_object()) {
+            throw RequestError("Missing rule object");
+        }
+        WatchRule rule = params["rule"].get<WatchRule>();
+        if (rule.id.empty()) {
+            throw RequestError("Missing rule id");
+        }
+        m_store.upsertWatchRule(rule);
+        nlohmann::json result;
+        result["ok"] = true;
+        return result;
+    }
 
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+    if (method == "delete_watch_rule") {
+        const std::string ruleId = params.value("id", "");
+        if (ruleId.empty()) {
+            throw RequestError("Missing rule id");
         }
+        m_store.deleteWatchRule(ruleId);
+        nlohmann::json result;
+        result["ok"] = true;
+        return result;
+    }
 
-        if (method == "what_changed_since_last_good") {
-            const std::string referenceId = params.value("referenceSnapshotId", "");
-            if (referenceId.empty()) {
-                return makeErrorResponse("Missing referenceSnapshotId", id);
-            }
+    if (method == "get_watch_signals_since") {
+        const std::string sinceValue = params.value("since", "");
+        const auto since = fromIso8601Utc(sinceValue);
+        if (since == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid since timestamp");
+        }
+        const auto watchSignals = m_store.getWatchSignalsSince(since);
+        nlohmann::json result;
+        result["signals"] = watchSignals;
+        return result;
+    }
 
-            const auto baseline = m_store.getSnapshot(referenceId);
-            const auto latest = latestSnapshot(m_store.listSnapshots());
-            if (!baseline.has_value() || !latest.has_value()) {
-                return makeErrorResponse("Snapshots not found", id);
-            }
+    if (method == "count_watch_signals_since") {
+        // Lets the tray show "N critical today" without downloading them.
+        const auto since = fromIso8601Utc(params.value("since", ""));
+        if (since == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid since timestamp");
+        }
+        std::optional<WatchSeverity> severity;
+        if (params.contains("severity")) {
+            severity = parseSeverityParam(params["severity"]);
+        }
+        nlohmann::json result;
+        result["count"] = m_store.countWatchSignalsSince(since, severity);
+        return result;
+    }
 
-            const auto events = m_store.getEventsBetween(baseline->timestamp,
-                                                        latest->timestamp);
-            const auto resultData =
-                computeCounterfactual(*baseline, *latest, events);
+    if (method == "subscribe_watch_signals") {
+        // New signals at or above minSeverity are pushed on this connection
+        // until it closes (see publishWatchSignal).
+        if (!m_requestSocket) {
+            throw RequestError("subscribe_watch_signals needs a socket connection");
+        }
+        WatchSeverity minSeverity = WatchSeverity::Info;
+        if (params.contains("minSeverity")) {
+            minSeverity = parseSeverityParam(params["minSeverity"]);
+        }
+        QLocalSocket *socket = m_requestSocket;
+        if (!m_watchSubscribers.contains(socket)) {
+            connect(socket, &QObject::destroyed, this, [this, socket]() {
+                m_watchSubscribers.remove(socket);
+            });
+        }
+        m_watchSubscribers.insert(socket, minSeverity);
+        nlohmann::json result;
+        result["subscribed"] = true;
+        result["minSeverity"] = toWatchSeverityString(minSeverity);
+        return result;
+    }
 
-            nlohmann::json result;
-            result["baselineSnapshot"] = resultData.baselineSnapshotId;
-            result["comparisonSnapshot"] = resultData.comparisonSnapshotId;
-            result["summary"] = resultData.explanationSummary;
-            result["diff"] = resultData.diff;
+    if (method == "explain_change_between") {
+        // INVARIANT: Explanations are interpretive, not causal assertions.
+        const std::string fromValue = params.value("from", "");
+        const std::string toValue = params.value("to", "");
+        const auto from = fromIso8601Utc(fromValue);
+        const auto to = fromIso8601Utc(toValue);
+        if (from == std::chrono::system_clock::time_point{}
+            || to == std::chrono::system_clock::time_point{}) {
+            throw RequestError("Invalid from/to timestamp");
+        }
 
-            KLOG_INFO(QStringLiteral("KhronicleApiServer"),
-                      QStringLiteral("handleRequest"),
-                      QStringLiteral("api_request_completed"),
-                      QStringLiteral("client_call"),
-                      QStringLiteral("json_rpc"),
-                      khronicle::logging::defaultWho(),
-                      corrId,
-                      (nlohmann::json{{"method", method},
-                                     {"durationMs",
-                                      std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          std::chrono::steady_clock::now() - start).count()}}));
-            return makeResultResponse(result, id);
+        const auto baseline = m_store.getSnapshotBefore(from);
+        const auto comparison = m_store.getSnapshotAfter(to);
+        if (!baseline.has_value() || !comparison.has_value()) {
+            throw RequestError("Snapshots not found");
         }
 
-        KLOG_WARN(QStringLiteral("KhronicleApiServer"),
-                  QStringLiteral("handleRequest"),
-                  QStringLiteral("api_request_error"),
-                  QStringLiteral("unknown_method"),
-                  QStringLiteral("json_rpc"),
-                  khronicle::logging::defaultWho(),
-                  corrId,
-                  (nlohmann::json{{"method", method}}));
-        return makeErrorResponse("Unknown method", id);
-    } catch (const std::exception &ex) {
-        KLOG_ERROR(QStringLiteral("KhronicleApiServer"),
-                   QStringLiteral("handleRequest"),
-                   QStringLiteral("api_request_error"),
-                   QStringLiteral("exception"),
-                   QStringLiteral("json_rpc"),
-                   khronicle::logging::defaultWho(),
-                   corrId,
-                   (nlohmann::json{{"what", ex.what()}}));
-        return makeErrorResponse(ex.what(), id);
+        const auto events = m_store.getEventsBetween(from, to);
+        const auto resultData =
+            computeCounterfactual(*baseline, *comparison, events);
+
+        nlohmann::json result;
+        result["baselineSnapshot"] = resultData.baselineSnapshotId;
+        result["comparisonSnapshot"] = resultData.comparisonSnapshotId;
+        result["summary"] = resultData.explanationSummary;
+        result["diff"] = resultData.diff;
+        return result;
+    }
+
+    if (method == "what_changed_since_last_good") {
+        const std::string referenceId = params.value("referenceSnapshotId", "");
+        if (referenceId.empty()) {
+            throw RequestError("Missing referenceSnapshotId");
+        }
+
+        const auto baseline = m_store.getSnapshot(referenceId);
+        const auto latest = latestSnapshot(m_store.listSnapshots());
+        if (!baseline.has_value() || !latest.has_value()) {
+            throw RequestError("Snapshots not found");
+        }
+
+        const auto events = m_store.getEventsBetween(baseline->timestamp,
+                                                    latest->timestamp);
+        const auto resultData =
+            computeCounterfactual(*baseline, *latest, events);
+
+        nlohmann::json result;
+        result["baselineSnapshot"] = resultData.baselineSnapshotId;
+        result["comparisonSnapshot"] = resultData.comparisonSnapshotId;
+        result["summary"] = resultData.explanationSummary;
+        result["diff"] = resultData.diff;
+        return result;
     }
+
+    KLOG_WARN(QStringLiteral("KhronicleApiServer"),
+              QStringLiteral("dispatch"),
+              QStringLiteral("api_request_error"),
+              QStringLiteral("unknown_method"),
+              QStringLiteral("json_rpc"),
+              khronicle::logging::defaultWho(),
+              logging::currentCorrelationId(),
+              (nlohmann::json{{"method", method}}));
+    throw RequestError("Unknown method");
 }
 
 QByteArray KhronicleApiServer::makeErrorResponse(const QString &message, int id) const
@@ -606,13 +788,21 @@ QByteArray KhronicleApiServer::makeErrorResponse(const QString &message, int id)
     return QByteArray::fromStdString(response.dump());
 }
 
-QByteArray KhronicleApiServer::makeResultResponse(const nlohmann::json &result,
-                                                  int id) const
+QByteArray KhronicleApiServer::makeResultResponse(const std::string &resultText,
+                                                  int id,
+                                                  const nlohmann::json &trace) const
 {
-    nlohmann::json response;
-    response["result"] = result;
-    response["id"] = id;
-    return QByteArray::fromStdString(response.dump());
+    // resultText is already serialized; splice it in rather than re-dumping.
+    QByteArray response;
+    response.reserve(static_cast<qsizetype>(resultText.size()) + 160);
+    response.append("{\"id\":");
+    response.append(QByteArray::number(id));
+    response.append(",\"result\":");
+    response.append(resultText.data(), static_cast<qsizetype>(resultText.size()));
+    response.append(",\"trace\":");
+    response.append(QByteArray::fromStdString(trace.dump()));
+    response.append('}');
+    return response;
 }
 
 } // namespace khronicle
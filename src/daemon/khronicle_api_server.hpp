@@ -1,9 +1,14 @@
 #pragma once
 
+#include <QHash>
 #include <QObject>
 #include <QLocalServer>
 #include <QLocalSocket>
 
+#include <chrono>
+#include <functional>
+#include <string>
+
 #include <nlohmann/json.hpp>
 
 #include "daemon/khronicle_store.hpp"
@@ -13,31 +18,66 @@ namespace khronicle {
 /**
  * KhronicleApiServer exposes KhronicleStore data over a local UNIX socket
  * using a minimal JSON-RPC-like protocol.
+ *
+ * Framing is one JSON object per line both ways: a request is dispatched
+ * once its terminating '\n' arrives, and a connection that sends more than
+ * 1 MiB without one gets an error response and is disconnected.
  */
 class KhronicleApiServer : public QObject
 {
     Q_OBJECT
 public:
+    // Called after each successful request with its daemon-side time
+    // (queue wait + query + serialization).
+    using RequestObserver =
+        std::function<void(const std::string &method, std::chrono::microseconds duration)>;
+
     explicit KhronicleApiServer(KhronicleStore &store, QObject *parent = nullptr);
     ~KhronicleApiServer() override;
 
-    // Start listening on /run/user/$UID/khronicle.sock
+    void setRequestObserver(RequestObserver observer);
+
+    // Start listening on daemonSocketPath().
     bool start();
     // Process a single JSON-RPC payload without a socket round-trip.
     // Useful for replay and test harnesses in environments without local sockets.
-    QByteArray handleRequestPayload(const QByteArray &payload);
+    // receivedAt is when the bytes were read off the socket, for the
+    // queueWaitUs figure in the response trace; defaults to now.
+    QByteArray handleRequestPayload(const QByteArray &payload,
+                                    std::chrono::steady_clock::time_point receivedAt = {});
+
+    // Pushes a new watch signal to connections that asked for it with
+    // subscribe_watch_signals, as an id-less
+    // {"method": "watch_signal", "params": {"signal": ...}} line.
+    void publishWatchSignal(const WatchSignal &signal);
 
 private slots:
     void handleNewConnection();
     void handleClientReadyRead();
 
 private:
-    void handleRequest(QLocalSocket *socket, const QByteArray &payload);
+    void handleRequest(QLocalSocket *socket,
+                       const QByteArray &payload,
+                       std::chrono::steady_clock::time_point receivedAt);
+    // Runs one method and returns its result object. Throws on bad params or
+    // unknown methods; the caller turns that into an error response.
+    nlohmann::json dispatch(const std::string &method, const nlohmann::json &params);
     QByteArray makeErrorResponse(const QString &message, int id = -1) const;
-    QByteArray makeResultResponse(const nlohmann::json &result, int id) const;
+    QByteArray makeResultResponse(const std::string &resultText,
+                                  int id,
+                                  const nlohmann::json &trace) const;
 
     KhronicleStore &m_store;
     QLocalServer m_server;
+    RequestObserver m_requestObserver;
+    // Connection of the request being dispatched; null for
+    // handleRequestPayload calls, which have no connection to push to.
+    QLocalSocket *m_requestSocket = nullptr;
+    // subscribe_watch_signals connections and their minimum severity.
+    QHash<QLocalSocket *, WatchSeverity> m_watchSubscribers;
+    // Bytes after the last newline each connection has sent: a request can
+    // arrive over several readyRead deliveries.
+    QHash<QLocalSocket *, QByteArray> m_partialLines;
 };
 
 } // namespace khronicle
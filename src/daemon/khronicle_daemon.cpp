@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
 
 #include <QTimer>
 
@@ -12,6 +13,8 @@
 #include "daemon/watch_engine.hpp"
 #include "common/json_utils.hpp"
 #include "common/logging.hpp"
+#include "common/tracing.hpp"
+#include "common/package_classifier.hpp"
 #include "debug/scenario_capture.hpp"
 
 #include <nlohmann/json.hpp>
@@ -20,11 +23,9 @@ namespace khronicle {
 
 namespace {
 
-constexpr int kIngestionIntervalMs = 300000;
-
-std::chrono::system_clock::time_point defaultJournalStart()
+std::chrono::system_clock::time_point defaultJournalStart(const Clock &clock)
 {
-    return std::chrono::system_clock::now() - std::chrono::minutes(30);
+    return clock.now() - std::chrono::minutes(30);
 }
 
 std::string timePointToIso(std::chrono::system_clock::time_point time)
@@ -32,40 +33,57 @@ std::string timePointToIso(std::chrono::system_clock::time_point time)
     return toIso8601Utc(time);
 }
 
-std::chrono::system_clock::time_point isoToTimePoint(const std::string &value)
+std::chrono::system_clock::time_point isoToTimePoint(const std::string &value,
+                                                     const Clock &clock)
 {
     auto parsed = fromIso8601Utc(value);
     if (parsed == std::chrono::system_clock::time_point{}) {
-        return defaultJournalStart();
+        return defaultJournalStart(clock);
     }
     return parsed;
 }
 
+std::chrono::microseconds elapsedSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+}
+
 std::string detectKernelPackage(const SystemSnapshot &snapshot)
 {
-    const std::vector<std::string> kernelPackages = {
-        "linux-cachyos",
-        "linux",
-        "linux-zen",
-        "linux-lts",
-    };
-
-    for (const auto &name : kernelPackages) {
-        if (snapshot.keyPackages.contains(name)) {
-            return name;
+    // Prefer the kernel listed first in the package classes config when
+    // several are installed.
+    const PackageClassifier &classifier = PackageClassifier::instance();
+    std::string best;
+    std::size_t bestRank = 0;
+    for (const auto &item : snapshot.keyPackages.items()) {
+        const auto match = classifier.classify(item.key());
+        if (!match || match->packageClass != PackageClass::Kernel) {
+            continue;
+        }
+        if (best.empty() || match->rank < bestRank) {
+            best = item.key();
+            bestRank = match->rank;
         }
     }
-    return "linux";
+    return best.empty() ? "linux" : best;
 }
 
 } // namespace
 
 KhronicleDaemon::KhronicleDaemon(QObject *parent)
+    : KhronicleDaemon(systemClock(), parent)
+{
+}
+
+KhronicleDaemon::KhronicleDaemon(const Clock &clock, QObject *parent)
     : QObject(parent)
+    , m_clock(clock)
     , m_store(std::make_unique<KhronicleStore>())
-    , m_journalLastTimestamp(defaultJournalStart())
+    , m_latencyMonitor(LatencyMonitor::load())
+    , m_journalLastTimestamp(defaultJournalStart(clock))
 {
-    m_watchEngine = std::make_unique<WatchEngine>(*m_store);
+    m_watchEngine = std::make_unique<WatchEngine>(*m_store, m_clock);
     loadStateFromMeta();
     loadLastSnapshotFromStore();
 }
@@ -76,7 +94,14 @@ void KhronicleDaemon::start()
 {
     if (!m_apiServer) {
         m_apiServer = std::make_unique<KhronicleApiServer>(*m_store);
+        m_apiServer->setRequestObserver(
+            [this](const std::string &method, std::chrono::microseconds duration) {
+                recordLatency("api:" + method, duration);
+            });
         m_apiServer->start();
+        m_watchEngine->setSignalListener([this](const WatchSignal &signal) {
+            m_apiServer->publishWatchSignal(signal);
+        });
     }
 
     KLOG_INFO(QStringLiteral("KhronicleDaemon"),
@@ -86,11 +111,12 @@ void KhronicleDaemon::start()
               QStringLiteral("timer_loop"),
               khronicle::logging::defaultWho(),
               QString(),
-              (nlohmann::json{{"intervalMs", kIngestionIntervalMs}}));
+              (nlohmann::json{{"intervalMs",
+                               std::chrono::milliseconds(kIngestionInterval).count()}}));
 
     // Timer-driven ingestion loop: keep work bounded and predictable.
     auto *timer = new QTimer(this);
-    timer->setInterval(kIngestionIntervalMs);
+    timer->setInterval(kIngestionInterval);
     connect(timer, &QTimer::timeout, this, &KhronicleDaemon::runIngestionCycle);
     timer->start();
 
@@ -108,6 +134,8 @@ void KhronicleDaemon::runIngestionCycle()
     static uint64_t cycleIndex = 0;
     const QString corrId = QStringLiteral("ingestion-%1").arg(++cycleIndex);
     khronicle::logging::CorrelationScope corrScope(corrId);
+    khronicle::tracing::TraceSpan cycleSpan("ingestion", "ingestion_cycle");
+    cycleSpan.setArg("cycleIndex", cycleIndex);
     KLOG_INFO(QStringLiteral("KhronicleDaemon"),
               QStringLiteral("runIngestionCycle"),
               QStringLiteral("start_ingestion_cycle"),
@@ -124,10 +152,22 @@ void KhronicleDaemon::runIngestionCycle()
         });
     }
 
+    auto stageStart = std::chrono::steady_clock::now();
     runPacmanIngestion();
+    recordLatency("pacman_ingestion", elapsedSince(stageStart));
+
+    stageStart = std::chrono::steady_clock::now();
     runJournalIngestion();
+    recordLatency("journal_ingestion", elapsedSince(stageStart));
+
+    stageStart = std::chrono::steady_clock::now();
     runSnapshotCheck();
-    persistStateToMeta();
+    recordLatency("snapshot_check", elapsedSince(stageStart));
+    {
+        KTRACE_SCOPE("ingestion", "persist_state");
+        persistStateToMeta();
+    }
+    recordLatency("ingestion_cycle", elapsedSince(cycleStart));
 
     const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now() - cycleStart).count();
@@ -146,8 +186,20 @@ void KhronicleDaemon::runIngestionCycleForReplay()
     runIngestionCycle();
 }
 
+void KhronicleDaemon::resetIngestionStateForReplay()
+{
+    m_pacmanCursor.reset();
+    m_journalLastTimestamp = defaultJournalStart(m_clock);
+}
+
+KhronicleStore &KhronicleDaemon::store()
+{
+    return *m_store;
+}
+
 void KhronicleDaemon::runPacmanIngestion()
 {
+    khronicle::tracing::TraceSpan span("ingestion", "pacman_ingestion");
     // Parse new pacman log entries from the last cursor.
     const char *overridePath = std::getenv("KHRONICLE_PACMAN_LOG_PATH");
     const std::string logPath = overridePath ? overridePath : "/var/log/pacman.log";
@@ -177,6 +229,7 @@ void KhronicleDaemon::runPacmanIngestion()
     if (!result.newCursor.empty()) {
         m_pacmanCursor = result.newCursor;
     }
+    span.setArg("events", ingested);
 
     KLOG_INFO(QStringLiteral("KhronicleDaemon"),
               QStringLiteral("runPacmanIngestion"),
@@ -191,6 +244,7 @@ void KhronicleDaemon::runPacmanIngestion()
 
 void KhronicleDaemon::runJournalIngestion()
 {
+    khronicle::tracing::TraceSpan span("ingestion", "journal_ingestion");
     // Parse journal entries since the last observed timestamp.
     KLOG_DEBUG(QStringLiteral("KhronicleDaemon"),
                QStringLiteral("runJournalIngestion"),
@@ -216,6 +270,7 @@ void KhronicleDaemon::runJournalIngestion()
     if (result.lastTimestamp > m_journalLastTimestamp) {
         m_journalLastTimestamp = result.lastTimestamp;
     }
+    span.setArg("events", ingested);
 
     KLOG_INFO(QStringLiteral("KhronicleDaemon"),
               QStringLiteral("runJournalIngestion"),
@@ -230,6 +285,7 @@ void KhronicleDaemon::runJournalIngestion()
 
 void KhronicleDaemon::runSnapshotCheck()
 {
+    KTRACE_SCOPE("ingestion", "snapshot_check");
     // Snapshot builder captures point-in-time system state. We only write a new
     // snapshot when kernel changes (current heuristic).
     if (qEnvironmentVariableIntValue("KHRONICLE_REPLAY_NO_SNAPSHOT") == 1) {
@@ -251,7 +307,7 @@ void KhronicleDaemon::runSnapshotCheck()
                khronicle::logging::defaultWho(),
                QString(),
                nlohmann::json::object());
-    SystemSnapshot current = buildCurrentSnapshot();
+    SystemSnapshot current = buildCurrentSnapshot(m_clock);
     current.hostIdentity = m_store->getHostIdentity();
 
     if (!m_lastSnapshot.has_value()) {
@@ -332,7 +388,7 @@ void KhronicleDaemon::loadStateFromMeta()
 
     if (const auto journalTimestamp =
             m_store->getMeta("journal_last_timestamp")) {
-        m_journalLastTimestamp = isoToTimePoint(*journalTimestamp);
+        m_journalLastTimestamp = isoToTimePoint(*journalTimestamp, m_clock);
     }
 }
 
@@ -346,6 +402,42 @@ void KhronicleDaemon::persistStateToMeta()
                      timePointToIso(m_journalLastTimestamp));
 }
 
+void KhronicleDaemon::recordLatency(const std::string &name,
+                                    std::chrono::microseconds elapsed)
+{
+    const auto breach =
+        m_latencyMonitor.record(name, elapsed, m_clock.now());
+    if (!breach || !m_watchEngine) {
+        return;
+    }
+
+    // Twice over budget is treated as a regression worth interrupting for.
+    const WatchSeverity severity = breach->p95Ms > 2.0 * breach->budgetMs
+        ? WatchSeverity::Critical
+        : WatchSeverity::Warning;
+    char message[256];
+    std::snprintf(message, sizeof(message),
+                  "p95 latency of %s is %.0f ms over the last %zu runs (budget %.0f ms)",
+                  breach->name.c_str(), breach->p95Ms, breach->samples, breach->budgetMs);
+
+    KLOG_WARN(QStringLiteral("KhronicleDaemon"),
+              QStringLiteral("recordLatency"),
+              QStringLiteral("latency_budget_exceeded"),
+              QStringLiteral("self_monitoring"),
+              QStringLiteral("rolling_p95"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"name", breach->name},
+                             {"p95Ms", breach->p95Ms},
+                             {"budgetMs", breach->budgetMs},
+                             {"samples", breach->samples}}));
+    m_watchEngine->recordDaemonSignal("daemon-latency-budget",
+                                      "Latency budget",
+                                      severity,
+                                      breach->name,
+                                      message);
+}
+
 void KhronicleDaemon::loadLastSnapshotFromStore()
 {
     const auto snapshots = m_store->listSnapshots();
@@ -7,7 +7,9 @@
 
 #include <QObject>
 
+#include "common/clock.hpp"
 #include "daemon/khronicle_store.hpp"
+#include "daemon/latency_monitor.hpp"
 #include "common/models.hpp"
 
 namespace khronicle {
@@ -31,12 +33,25 @@ class KhronicleDaemon : public QObject
 {
     Q_OBJECT
 public:
+    // Virtual time between scheduled ingestion cycles.
+    static constexpr std::chrono::minutes kIngestionInterval{5};
+
     explicit KhronicleDaemon(QObject *parent = nullptr);
+    // Reads wall-clock time from clock instead of the system clock; replay
+    // passes a VirtualClock. clock must outlive the daemon.
+    explicit KhronicleDaemon(const Clock &clock, QObject *parent = nullptr);
     ~KhronicleDaemon() override;
 
     // Call this after constructing the daemon to set up timers and start periodic work.
     void start();
     void runIngestionCycleForReplay();
+    // Forgets the pacman cursor and restarts journal ingestion from the
+    // clock's current time, so replay can stream logs from their beginning.
+    void resetIngestionStateForReplay();
+
+    // The daemon's store, for harnesses that drive it in-process (replay
+    // serves API steps from it instead of opening a second connection).
+    KhronicleStore &store();
 
 private slots:
     void runIngestionCycle();
@@ -51,9 +66,15 @@ private:
 
     void loadLastSnapshotFromStore();
 
+    // Feeds the latency monitor and raises a "daemon" watch signal when the
+    // rolling p95 for name goes over its budget.
+    void recordLatency(const std::string &name, std::chrono::microseconds elapsed);
+
+    const Clock &m_clock;
     std::unique_ptr<KhronicleStore> m_store;
     std::unique_ptr<KhronicleApiServer> m_apiServer;
     std::unique_ptr<WatchEngine> m_watchEngine;
+    LatencyMonitor m_latencyMonitor;
 
     // In-memory cached state for faster access between cycles.
     std::optional<std::string> m_pacmanCursor;
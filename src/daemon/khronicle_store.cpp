@@ -14,6 +14,8 @@
 
 #include "common/json_utils.hpp"
 #include "common/logging.hpp"
+#include "common/tracing.hpp"
+#include "common/version_compare.hpp"
 
 namespace khronicle {
 
@@ -30,7 +32,8 @@ constexpr const char *kCreateEventsTable =
     "    before_state TEXT,"
     "    after_state TEXT,"
     "    related_packages TEXT,"
-    "    host_id TEXT"
+    "    host_id TEXT,"
+    "    generation INTEGER NOT NULL DEFAULT 0"
     ");";
 
 constexpr const char *kCreateSnapshotsTable =
@@ -41,7 +44,8 @@ constexpr const char *kCreateSnapshotsTable =
     "    gpu_driver TEXT,"
     "    firmware_versions TEXT,"
     "    key_packages TEXT,"
-    "    host_id TEXT"
+    "    host_id TEXT,"
+    "    generation INTEGER NOT NULL DEFAULT 0"
     ");";
 
 constexpr const char *kCreateMetaTable =
@@ -87,6 +91,45 @@ constexpr const char *kCreateWatchSignalsTable =
     "    message TEXT"
     ");";
 
+// One row per (origin, package, role) version string, with a binary sort
+// key (see versionSortKey) so version ranges are answered by an index scan.
+// role is "before"/"after" for events and "installed" for snapshots.
+constexpr const char *kCreatePackageVersionsTable =
+    "CREATE TABLE IF NOT EXISTS package_versions ("
+    "    origin_type TEXT NOT NULL,"
+    "    origin_id TEXT NOT NULL,"
+    "    package TEXT NOT NULL,"
+    "    role TEXT NOT NULL,"
+    "    version TEXT NOT NULL,"
+    "    version_key BLOB NOT NULL,"
+    "    timestamp INTEGER NOT NULL,"
+    "    PRIMARY KEY (origin_type, origin_id, package, role)"
+    ");";
+
+constexpr const char *kCreatePackageVersionsIndex =
+    "CREATE INDEX IF NOT EXISTS idx_package_versions_key "
+    "ON package_versions (package, role, version_key);";
+
+// Incremental client refresh ("what changed after generation N"). Created
+// after the generation columns are migrated in.
+constexpr const char *kCreateEventsGenerationIndex =
+    "CREATE INDEX IF NOT EXISTS idx_events_generation "
+    "ON events (generation);";
+
+constexpr const char *kCreateSnapshotsGenerationIndex =
+    "CREATE INDEX IF NOT EXISTS idx_snapshots_generation "
+    "ON snapshots (generation);";
+
+// Tray counts of today's signals by severity.
+constexpr const char *kCreateWatchSignalsTimestampIndex =
+    "CREATE INDEX IF NOT EXISTS idx_watch_signals_timestamp "
+    "ON watch_signals (timestamp, severity);";
+
+// Timeline paging walks events by (timestamp, id) in both directions.
+constexpr const char *kCreateEventsTimestampIndex =
+    "CREATE INDEX IF NOT EXISTS idx_events_timestamp "
+    "ON events (timestamp, id);";
+
 class Statement {
 public:
     Statement(sqlite3 *db, const char *sql)
@@ -135,6 +178,21 @@ void execOrThrow(sqlite3 *db, const char *sql)
     }
 }
 
+bool tableExists(sqlite3 *db, const std::string &table)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db,
+                           "SELECT 1 FROM sqlite_master "
+                           "WHERE type = 'table' AND name = ? LIMIT 1;",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+    const bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
 bool columnExists(sqlite3 *db, const std::string &table, const std::string &column)
 {
     const std::string sql = "PRAGMA table_info(" + table + ");";
@@ -155,6 +213,19 @@ bool columnExists(sqlite3 *db, const std::string &table, const std::string &colu
     return found;
 }
 
+// Newest generation in either table, read once when the store opens. Both
+// MAX() lookups are answered from the generation indexes.
+std::int64_t storedGeneration(sqlite3 *db)
+{
+    Statement stmt(db,
+                   "SELECT MAX((SELECT COALESCE(MAX(generation), 0) FROM events), "
+                   "(SELECT COALESCE(MAX(generation), 0) FROM snapshots));");
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw std::runtime_error("failed to read store generation");
+    }
+    return sqlite3_column_int64(stmt.get(), 0);
+}
+
 std::string generateUuid()
 {
     std::random_device rd;
@@ -223,6 +294,142 @@ nlohmann::json columnJson(sqlite3_stmt *stmt, int index)
     }
 }
 
+void bindVersionKey(sqlite3_stmt *stmt, int index, const std::string &version)
+{
+    const std::string key = versionSortKey(version);
+    sqlite3_bind_blob(stmt, index, key.data(), static_cast<int>(key.size()),
+                      SQLITE_TRANSIENT);
+}
+
+// Drops an event's or snapshot's rows before it is indexed again, so a
+// replaced origin leaves no versions it no longer has.
+void deletePackageVersions(sqlite3 *db, const char *originType, const std::string &originId)
+{
+    Statement stmt(db,
+                   "DELETE FROM package_versions WHERE origin_type = ? AND origin_id = ?;");
+    sqlite3_bind_text(stmt.get(), 1, originType, -1, SQLITE_STATIC);
+    bindText(stmt.get(), 2, originId);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw std::runtime_error("failed to delete package versions");
+    }
+}
+
+void insertPackageVersion(sqlite3 *db,
+                          const char *originType,
+                          const std::string &originId,
+                          const std::string &package,
+                          const char *role,
+                          const std::string &version,
+                          int64_t timestamp)
+{
+    if (package.empty() || version.empty()) {
+        return;
+    }
+    Statement stmt(db,
+                   "INSERT OR REPLACE INTO package_versions (origin_type, "
+                   "origin_id, package, role, version, version_key, timestamp) "
+                   "VALUES (?, ?, ?, ?, ?, ?, ?);");
+    sqlite3_bind_text(stmt.get(), 1, originType, -1, SQLITE_STATIC);
+    bindText(stmt.get(), 2, originId);
+    bindText(stmt.get(), 3, package);
+    sqlite3_bind_text(stmt.get(), 4, role, -1, SQLITE_STATIC);
+    bindText(stmt.get(), 5, version);
+    bindVersionKey(stmt.get(), 6, version);
+    sqlite3_bind_int64(stmt.get(), 7, timestamp);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw std::runtime_error("failed to insert package version");
+    }
+}
+
+void indexEventVersions(sqlite3 *db,
+                        const std::string &eventId,
+                        int64_t timestamp,
+                        const nlohmann::json &beforeState,
+                        const nlohmann::json &afterState,
+                        const nlohmann::json &relatedPackages)
+{
+    deletePackageVersions(db, "event", eventId);
+    // Package events carry the package as the first related package and the
+    // versions in before/after state (see pacman_parser).
+    if (!relatedPackages.is_array() || relatedPackages.empty()
+        || !relatedPackages.front().is_string()) {
+        return;
+    }
+    const std::string package = relatedPackages.front().get<std::string>();
+    insertPackageVersion(db, "event", eventId, package, "before",
+                         stateVersion(beforeState), timestamp);
+    insertPackageVersion(db, "event", eventId, package, "after",
+                         stateVersion(afterState), timestamp);
+}
+
+void indexSnapshotVersions(sqlite3 *db,
+                           const std::string &snapshotId,
+                           int64_t timestamp,
+                           const nlohmann::json &keyPackages)
+{
+    deletePackageVersions(db, "snapshot", snapshotId);
+    if (!keyPackages.is_object()) {
+        return;
+    }
+    for (const auto &item : keyPackages.items()) {
+        if (item.value().is_string()) {
+            insertPackageVersion(db, "snapshot", snapshotId, item.key(),
+                                 "installed", item.value().get<std::string>(),
+                                 timestamp);
+        }
+    }
+}
+
+// Runs body as one unit: a row and its package_versions are replaced
+// together. A savepoint also nests inside a transaction the caller holds.
+template <typename Body>
+void inSavepoint(sqlite3 *db, Body &&body)
+{
+    execOrThrow(db, "SAVEPOINT store_write;");
+    try {
+        body();
+    } catch (...) {
+        execOrThrow(db, "ROLLBACK TO store_write;");
+        execOrThrow(db, "RELEASE store_write;");
+        throw;
+    }
+    execOrThrow(db, "RELEASE store_write;");
+}
+
+void backfillPackageVersions(sqlite3 *db)
+{
+    // One-time migration for databases created before package_versions.
+    execOrThrow(db, "BEGIN;");
+    try {
+        {
+            Statement stmt(db,
+                           "SELECT id, timestamp, before_state, after_state, "
+                           "related_packages FROM events;");
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+                indexEventVersions(db,
+                                   columnText(stmt.get(), 0),
+                                   sqlite3_column_int64(stmt.get(), 1),
+                                   columnJson(stmt.get(), 2),
+                                   columnJson(stmt.get(), 3),
+                                   columnJson(stmt.get(), 4));
+            }
+        }
+        {
+            Statement stmt(db, "SELECT id, timestamp, key_packages FROM snapshots;");
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+                indexSnapshotVersions(db,
+                                      columnText(stmt.get(), 0),
+                                      sqlite3_column_int64(stmt.get(), 1),
+                                      columnJson(stmt.get(), 2));
+            }
+        }
+    } catch (...) {
+        execOrThrow(db, "ROLLBACK;");
+        throw;
+    }
+    execOrThrow(db, "COMMIT;");
+}
+
 EventCategory categoryFromInt(int value)
 {
     switch (value) {
@@ -281,11 +488,40 @@ WatchSeverity watchSeverityFromInt(int value)
     }
 }
 
+// One events row, selected as "id, timestamp, category, source, summary,
+// details, before_state, after_state, related_packages, host_id" in that
+// order. Rows without a host id belong to defaultHostId.
+KhronicleEvent eventFromStatement(sqlite3_stmt *stmt, const std::string &defaultHostId)
+{
+    KhronicleEvent event;
+    event.id = columnText(stmt, 0);
+    event.timestamp = fromEpochSeconds(sqlite3_column_int64(stmt, 1));
+    event.category = categoryFromInt(sqlite3_column_int(stmt, 2));
+    event.source = sourceFromInt(sqlite3_column_int(stmt, 3));
+    event.summary = columnText(stmt, 4);
+    event.details = columnText(stmt, 5);
+    event.beforeState = columnJson(stmt, 6);
+    event.afterState = columnJson(stmt, 7);
+    nlohmann::json related = columnJson(stmt, 8);
+    if (related.is_array()) {
+        event.relatedPackages = related.get<std::vector<std::string>>();
+    }
+    event.hostId = columnText(stmt, 9);
+    if (event.hostId.empty()) {
+        event.hostId = defaultHostId;
+    }
+    return event;
+}
+
 } // namespace
 
 struct KhronicleStore::Impl {
     sqlite3 *db = nullptr;
     HostIdentity hostIdentity;
+    std::uint64_t rowsRead = 0;
+    // Newest generation written through this store; seeded from the tables
+    // when the store opens. The daemon is the only writer of its database.
+    std::int64_t generation = 0;
 };
 
 KhronicleStore::KhronicleStore()
@@ -321,11 +557,16 @@ KhronicleStore::KhronicleStore()
 
     // Schema setup is idempotent; new tables/columns are created on startup.
     execOrThrow(impl->db, kCreateEventsTable);
+    execOrThrow(impl->db, kCreateEventsTimestampIndex);
     execOrThrow(impl->db, kCreateSnapshotsTable);
     execOrThrow(impl->db, kCreateMetaTable);
     execOrThrow(impl->db, kCreateHostIdentityTable);
     execOrThrow(impl->db, kCreateWatchRulesTable);
     execOrThrow(impl->db, kCreateWatchSignalsTable);
+    execOrThrow(impl->db, kCreateWatchSignalsTimestampIndex);
+    const bool hadPackageVersions = tableExists(impl->db, "package_versions");
+    execOrThrow(impl->db, kCreatePackageVersionsTable);
+    execOrThrow(impl->db, kCreatePackageVersionsIndex);
 
     // Load or initialize host identity (stable per database).
     {
@@ -371,6 +612,21 @@ KhronicleStore::KhronicleStore()
     if (!columnExists(impl->db, "snapshots", "host_id")) {
         execOrThrow(impl->db, "ALTER TABLE snapshots ADD COLUMN host_id TEXT;");
     }
+    // Rows from before generations existed count as generation 0.
+    if (!columnExists(impl->db, "events", "generation")) {
+        execOrThrow(impl->db,
+                    "ALTER TABLE events ADD COLUMN generation INTEGER NOT NULL DEFAULT 0;");
+    }
+    if (!columnExists(impl->db, "snapshots", "generation")) {
+        execOrThrow(impl->db,
+                    "ALTER TABLE snapshots ADD COLUMN generation INTEGER NOT NULL DEFAULT 0;");
+    }
+    execOrThrow(impl->db, kCreateEventsGenerationIndex);
+    execOrThrow(impl->db, kCreateSnapshotsGenerationIndex);
+    impl->generation = storedGeneration(impl->db);
+    if (!hadPackageVersions) {
+        backfillPackageVersions(impl->db);
+    }
 }
 
 KhronicleStore::~KhronicleStore()
@@ -388,39 +644,52 @@ HostIdentity KhronicleStore::getHostIdentity() const
 
 void KhronicleStore::addEvent(const KhronicleEvent &event)
 {
-    KLOG_DEBUG(QStringLiteral("KhronicleStore"),
-               QStringLiteral("addEvent"),
-               QStringLiteral("insert_event"),
-               QStringLiteral("ingestion"),
-               QStringLiteral("sqlite_insert"),
-               khronicle::logging::defaultWho(),
-               QString(),
-               (nlohmann::json{{"id", event.id},
-                              {"category", toCategoryString(event.category)},
-                              {"timestamp", toIso8601Utc(event.timestamp)}}));
-    Statement stmt(impl->db,
-                   "INSERT OR REPLACE INTO events (id, timestamp, category, "
-                   "source, summary, details, before_state, after_state, "
-                   "related_packages, host_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
-    bindText(stmt.get(), 1, event.id);
-    sqlite3_bind_int64(stmt.get(), 2, toEpochSeconds(event.timestamp));
-    sqlite3_bind_int(stmt.get(), 3, static_cast<int>(event.category));
-    sqlite3_bind_int(stmt.get(), 4, static_cast<int>(event.source));
-    bindText(stmt.get(), 5, event.summary);
-    bindOptionalText(stmt.get(), 6, event.details);
-    bindJson(stmt.get(), 7, event.beforeState);
-    bindJson(stmt.get(), 8, event.afterState);
-    bindJson(stmt.get(), 9, nlohmann::json(event.relatedPackages));
-    // Default to the store's host identity if the event didn't set one.
-    bindText(stmt.get(), 10, event.hostId.empty() ? impl->hostIdentity.hostId : event.hostId);
+    KTRACE_SCOPE("store", "addEvent");
+    KLOG_DEBUG_LIMITED(khronicle::logging::kIngestionLogLimit,
+                       QStringLiteral("KhronicleStore"),
+                       QStringLiteral("addEvent"),
+                       QStringLiteral("insert_event"),
+                       QStringLiteral("ingestion"),
+                       QStringLiteral("sqlite_insert"),
+                       khronicle::logging::defaultWho(),
+                       QString(),
+                       (nlohmann::json{{"id", event.id},
+                                      {"category", toCategoryString(event.category)},
+                                      {"timestamp", toIso8601Utc(event.timestamp)}}));
+    const std::int64_t generation = impl->generation + 1;
+    inSavepoint(impl->db, [&] {
+        Statement stmt(impl->db,
+                       "INSERT OR REPLACE INTO events (id, timestamp, category, "
+                       "source, summary, details, before_state, after_state, "
+                       "related_packages, host_id, generation) "
+                       "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+        bindText(stmt.get(), 1, event.id);
+        sqlite3_bind_int64(stmt.get(), 2, toEpochSeconds(event.timestamp));
+        sqlite3_bind_int(stmt.get(), 3, static_cast<int>(event.category));
+        sqlite3_bind_int(stmt.get(), 4, static_cast<int>(event.source));
+        bindText(stmt.get(), 5, event.summary);
+        bindOptionalText(stmt.get(), 6, event.details);
+        bindJson(stmt.get(), 7, event.beforeState);
+        bindJson(stmt.get(), 8, event.afterState);
+        bindJson(stmt.get(), 9, nlohmann::json(event.relatedPackages));
+        // Default to the store's host identity if the event didn't set one.
+        bindText(stmt.get(), 10, event.hostId.empty() ? impl->hostIdentity.hostId : event.hostId);
+        sqlite3_bind_int64(stmt.get(), 11, generation);
+
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            throw std::runtime_error("failed to insert event");
+        }
 
-    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
-        throw std::runtime_error("failed to insert event");
-    }
+        indexEventVersions(impl->db, event.id, toEpochSeconds(event.timestamp),
+                           event.beforeState, event.afterState,
+                           nlohmann::json(event.relatedPackages));
+    });
+    impl->generation = generation;
 }
 
 void KhronicleStore::addSnapshot(const SystemSnapshot &snapshot)
 {
+    KTRACE_SCOPE("store", "addSnapshot");
     KLOG_DEBUG(QStringLiteral("KhronicleStore"),
                QStringLiteral("addSnapshot"),
                QStringLiteral("insert_snapshot"),
@@ -431,28 +700,39 @@ void KhronicleStore::addSnapshot(const SystemSnapshot &snapshot)
                (nlohmann::json{{"id", snapshot.id},
                               {"kernelVersion", snapshot.kernelVersion},
                               {"timestamp", toIso8601Utc(snapshot.timestamp)}}));
-    Statement stmt(impl->db,
-                   "INSERT OR REPLACE INTO snapshots (id, timestamp, "
-                   "kernel_version, gpu_driver, firmware_versions, "
-                   "key_packages, host_id) VALUES (?, ?, ?, ?, ?, ?, ?);");
-    bindText(stmt.get(), 1, snapshot.id);
-    sqlite3_bind_int64(stmt.get(), 2, toEpochSeconds(snapshot.timestamp));
-    bindText(stmt.get(), 3, snapshot.kernelVersion);
-    bindJson(stmt.get(), 4, snapshot.gpuDriver);
-    bindJson(stmt.get(), 5, snapshot.firmwareVersions);
-    bindJson(stmt.get(), 6, snapshot.keyPackages);
-    // Ensure snapshots carry a stable host identity.
-    bindText(stmt.get(), 7, snapshot.hostIdentity.hostId.empty()
-        ? impl->hostIdentity.hostId
-        : snapshot.hostIdentity.hostId);
+    const std::int64_t generation = impl->generation + 1;
+    inSavepoint(impl->db, [&] {
+        Statement stmt(impl->db,
+                       "INSERT OR REPLACE INTO snapshots (id, timestamp, "
+                       "kernel_version, gpu_driver, firmware_versions, "
+                       "key_packages, host_id, generation) "
+                       "VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+        bindText(stmt.get(), 1, snapshot.id);
+        sqlite3_bind_int64(stmt.get(), 2, toEpochSeconds(snapshot.timestamp));
+        bindText(stmt.get(), 3, snapshot.kernelVersion);
+        bindJson(stmt.get(), 4, snapshot.gpuDriver);
+        bindJson(stmt.get(), 5, snapshot.firmwareVersions);
+        bindJson(stmt.get(), 6, snapshot.keyPackages);
+        // Ensure snapshots carry a stable host identity.
+        bindText(stmt.get(), 7, snapshot.hostIdentity.hostId.empty()
+            ? impl->hostIdentity.hostId
+            : snapshot.hostIdentity.hostId);
+        sqlite3_bind_int64(stmt.get(), 8, generation);
+
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            throw std::runtime_error("failed to insert snapshot");
+        }
 
-    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
-        throw std::runtime_error("failed to insert snapshot");
-    }
+        indexSnapshotVersions(impl->db, snapshot.id,
+                              toEpochSeconds(snapshot.timestamp),
+                              snapshot.keyPackages);
+    });
+    impl->generation = generation;
 }
 
 std::vector<WatchRule> KhronicleStore::listWatchRules() const
 {
+    KTRACE_SCOPE("store", "listWatchRules");
     Statement stmt(impl->db,
                    "SELECT id, name, description, scope, severity, enabled, "
                    "category_equals, risk_level_at_least, package_name_contains, "
@@ -482,6 +762,7 @@ std::vector<WatchRule> KhronicleStore::listWatchRules() const
 
 void KhronicleStore::upsertWatchRule(const WatchRule &rule)
 {
+    KTRACE_SCOPE("store", "upsertWatchRule");
     KLOG_DEBUG(QStringLiteral("KhronicleStore"),
                QStringLiteral("upsertWatchRule"),
                QStringLiteral("upsert_watch_rule"),
@@ -517,6 +798,7 @@ void KhronicleStore::upsertWatchRule(const WatchRule &rule)
 
 void KhronicleStore::deleteWatchRule(const std::string &id)
 {
+    KTRACE_SCOPE("store", "deleteWatchRule");
     KLOG_INFO(QStringLiteral("KhronicleStore"),
               QStringLiteral("deleteWatchRule"),
               QStringLiteral("delete_watch_rule"),
@@ -535,6 +817,7 @@ void KhronicleStore::deleteWatchRule(const std::string &id)
 
 void KhronicleStore::addWatchSignal(const WatchSignal &signal)
 {
+    KTRACE_SCOPE("store", "addWatchSignal");
     KLOG_DEBUG(QStringLiteral("KhronicleStore"),
                QStringLiteral("addWatchSignal"),
                QStringLiteral("insert_watch_signal"),
@@ -567,6 +850,7 @@ void KhronicleStore::addWatchSignal(const WatchSignal &signal)
 std::vector<WatchSignal> KhronicleStore::getWatchSignalsSince(
     std::chrono::system_clock::time_point t) const
 {
+    KTRACE_SCOPE("store", "getWatchSignalsSince");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, rule_id, rule_name, severity, "
                    "origin_type, origin_id, message "
@@ -591,9 +875,33 @@ std::vector<WatchSignal> KhronicleStore::getWatchSignalsSince(
     return result;
 }
 
+std::size_t KhronicleStore::countWatchSignalsSince(
+    std::chrono::system_clock::time_point t,
+    std::optional<WatchSeverity> severity) const
+{
+    KTRACE_SCOPE("store", "countWatchSignalsSince");
+    Statement stmt(impl->db,
+                   "SELECT COUNT(*) FROM watch_signals "
+                   "WHERE timestamp >= ? AND (? IS NULL OR severity = ?);");
+    sqlite3_bind_int64(stmt.get(), 1, toEpochSeconds(t));
+    if (severity) {
+        sqlite3_bind_int(stmt.get(), 2, static_cast<int>(*severity));
+        sqlite3_bind_int(stmt.get(), 3, static_cast<int>(*severity));
+    } else {
+        sqlite3_bind_null(stmt.get(), 2);
+        sqlite3_bind_null(stmt.get(), 3);
+    }
+
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw std::runtime_error("failed to count watch signals");
+    }
+    return static_cast<std::size_t>(sqlite3_column_int64(stmt.get(), 0));
+}
+
 std::vector<KhronicleEvent> KhronicleStore::getEventsSince(
     std::chrono::system_clock::time_point since) const
 {
+    KTRACE_SCOPE("store", "getEventsSince");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, category, source, summary, details, "
                    "before_state, after_state, related_packages, host_id "
@@ -602,24 +910,7 @@ std::vector<KhronicleEvent> KhronicleStore::getEventsSince(
 
     std::vector<KhronicleEvent> events;
     while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
-        KhronicleEvent event;
-        event.id = columnText(stmt.get(), 0);
-        event.timestamp = fromEpochSeconds(sqlite3_column_int64(stmt.get(), 1));
-        event.category = categoryFromInt(sqlite3_column_int(stmt.get(), 2));
-        event.source = sourceFromInt(sqlite3_column_int(stmt.get(), 3));
-        event.summary = columnText(stmt.get(), 4);
-        event.details = columnText(stmt.get(), 5);
-        event.beforeState = columnJson(stmt.get(), 6);
-        event.afterState = columnJson(stmt.get(), 7);
-        nlohmann::json related = columnJson(stmt.get(), 8);
-        if (related.is_array()) {
-            event.relatedPackages = related.get<std::vector<std::string>>();
-        }
-        event.hostId = columnText(stmt.get(), 9);
-        if (event.hostId.empty()) {
-            event.hostId = impl->hostIdentity.hostId;
-        }
-        events.push_back(std::move(event));
+        events.push_back(eventFromStatement(stmt.get(), impl->hostIdentity.hostId));
     }
 
     return events;
@@ -629,6 +920,7 @@ std::vector<KhronicleEvent> KhronicleStore::getEventsBetween(
     std::chrono::system_clock::time_point from,
     std::chrono::system_clock::time_point to) const
 {
+    KTRACE_SCOPE("store", "getEventsBetween");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, category, source, summary, details, "
                    "before_state, after_state, related_packages, host_id "
@@ -639,24 +931,124 @@ std::vector<KhronicleEvent> KhronicleStore::getEventsBetween(
 
     std::vector<KhronicleEvent> events;
     while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
-        KhronicleEvent event;
-        event.id = columnText(stmt.get(), 0);
-        event.timestamp = fromEpochSeconds(sqlite3_column_int64(stmt.get(), 1));
-        event.category = categoryFromInt(sqlite3_column_int(stmt.get(), 2));
-        event.source = sourceFromInt(sqlite3_column_int(stmt.get(), 3));
-        event.summary = columnText(stmt.get(), 4);
-        event.details = columnText(stmt.get(), 5);
-        event.beforeState = columnJson(stmt.get(), 6);
-        event.afterState = columnJson(stmt.get(), 7);
-        nlohmann::json related = columnJson(stmt.get(), 8);
-        if (related.is_array()) {
-            event.relatedPackages = related.get<std::vector<std::string>>();
-        }
-        event.hostId = columnText(stmt.get(), 9);
-        if (event.hostId.empty()) {
-            event.hostId = impl->hostIdentity.hostId;
+        events.push_back(eventFromStatement(stmt.get(), impl->hostIdentity.hostId));
+    }
+
+    return events;
+}
+
+std::vector<KhronicleEvent> KhronicleStore::getEventsPage(
+    std::chrono::system_clock::time_point from,
+    std::chrono::system_clock::time_point to,
+    const std::optional<EventPageCursor> &after,
+    std::size_t limit) const
+{
+    KTRACE_SCOPE("store", "getEventsPage");
+    // The row-value comparison keeps the cursor condition on the index
+    // range instead of turning it into a per-row filter.
+    Statement stmt(impl->db,
+                   after.has_value()
+                       ? "SELECT id, timestamp, category, source, summary, details, "
+                         "before_state, after_state, related_packages, host_id "
+                         "FROM events WHERE timestamp >= ? AND timestamp <= ? "
+                         "AND (timestamp, id) < (?, ?) "
+                         "ORDER BY timestamp DESC, id DESC LIMIT ?;"
+                       : "SELECT id, timestamp, category, source, summary, details, "
+                         "before_state, after_state, related_packages, host_id "
+                         "FROM events WHERE timestamp >= ? AND timestamp <= ? "
+                         "ORDER BY timestamp DESC, id DESC LIMIT ?;");
+    int index = 1;
+    sqlite3_bind_int64(stmt.get(), index++, toEpochSeconds(from));
+    sqlite3_bind_int64(stmt.get(), index++, toEpochSeconds(to));
+    if (after.has_value()) {
+        sqlite3_bind_int64(stmt.get(), index++, toEpochSeconds(after->timestamp));
+        bindText(stmt.get(), index++, after->id);
+    }
+    sqlite3_bind_int64(stmt.get(), index, static_cast<sqlite3_int64>(limit));
+
+    std::vector<KhronicleEvent> events;
+    events.reserve(limit);
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        events.push_back(eventFromStatement(stmt.get(), impl->hostIdentity.hostId));
+    }
+
+    return events;
+}
+
+std::int64_t KhronicleStore::getStoreGeneration() const
+{
+    KTRACE_SCOPE("store", "getStoreGeneration");
+    return impl->generation;
+}
+
+std::vector<KhronicleEvent> KhronicleStore::getEventsAfterGeneration(
+    std::int64_t generation,
+    std::chrono::system_clock::time_point from,
+    std::chrono::system_clock::time_point to,
+    std::size_t limit) const
+{
+    KTRACE_SCOPE("store", "getEventsAfterGeneration");
+    // idx_events_generation narrows this to the rows written since; the
+    // range check and sort only see those.
+    Statement stmt(impl->db,
+                   "SELECT id, timestamp, category, source, summary, details, "
+                   "before_state, after_state, related_packages, host_id "
+                   "FROM events WHERE generation > ? "
+                   "AND timestamp >= ? AND timestamp <= ? "
+                   "ORDER BY timestamp DESC, id DESC LIMIT ?;");
+    sqlite3_bind_int64(stmt.get(), 1, generation);
+    sqlite3_bind_int64(stmt.get(), 2, toEpochSeconds(from));
+    sqlite3_bind_int64(stmt.get(), 3, toEpochSeconds(to));
+    sqlite3_bind_int64(stmt.get(), 4, static_cast<sqlite3_int64>(limit));
+
+    std::vector<KhronicleEvent> events;
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        events.push_back(eventFromStatement(stmt.get(), impl->hostIdentity.hostId));
+    }
+
+    return events;
+}
+
+std::vector<KhronicleEvent> KhronicleStore::getEventsByVersionRange(
+    const std::string &packageName,
+    const std::string &minVersion,
+    const std::string &maxVersion) const
+{
+    KTRACE_SCOPE("store", "getEventsByVersionRange");
+    // Index scan on (package, role, version_key); every candidate is then
+    // confirmed with compareVersions. The upper key is padded so versions
+    // that only add a pkgrel to maxVersion (equal under vercmp) are still
+    // visited and rejected by the exact check rather than by the key; the
+    // lower key drops minVersion's pkgrel so versions without one (also
+    // equal) are visited and accepted.
+    const std::string minKey = minVersion.empty() ? std::string()
+                                                  : versionSortKeyFloor(minVersion);
+    const std::string maxKey = maxVersion.empty()
+        ? std::string()
+        : versionSortKey(maxVersion) + '\xff';
+    Statement stmt(impl->db,
+                   "SELECT e.id, e.timestamp, e.category, e.source, e.summary, "
+                   "e.details, e.before_state, e.after_state, "
+                   "e.related_packages, e.host_id, pv.version "
+                   "FROM package_versions pv "
+                   "JOIN events e ON e.id = pv.origin_id "
+                   "WHERE pv.origin_type = 'event' AND pv.role = 'after' "
+                   "AND pv.package = ? AND pv.version_key >= ? "
+                   "AND (? = 0 OR pv.version_key <= ?) "
+                   "ORDER BY e.timestamp ASC;");
+    bindText(stmt.get(), 1, packageName);
+    sqlite3_bind_blob(stmt.get(), 2, minKey.data(),
+                      static_cast<int>(minKey.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt.get(), 3, maxVersion.empty() ? 0 : 1);
+    sqlite3_bind_blob(stmt.get(), 4, maxKey.data(),
+                      static_cast<int>(maxKey.size()), SQLITE_TRANSIENT);
+
+    std::vector<KhronicleEvent> events;
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        if (!versionInRange(columnText(stmt.get(), 10), minVersion, maxVersion)) {
+            continue;
         }
-        events.push_back(std::move(event));
+        events.push_back(eventFromStatement(stmt.get(), impl->hostIdentity.hostId));
     }
 
     return events;
@@ -664,6 +1056,7 @@ std::vector<KhronicleEvent> KhronicleStore::getEventsBetween(
 
 std::vector<SystemSnapshot> KhronicleStore::listSnapshots() const
 {
+    KTRACE_SCOPE("store", "listSnapshots");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, kernel_version, gpu_driver, "
                    "firmware_versions, key_packages, host_id "
@@ -692,6 +1085,7 @@ std::vector<SystemSnapshot> KhronicleStore::listSnapshots() const
 std::optional<SystemSnapshot> KhronicleStore::getSnapshot(
     const std::string &id) const
 {
+    KTRACE_SCOPE("store", "getSnapshot");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, kernel_version, gpu_driver, "
                    "firmware_versions, key_packages, host_id "
@@ -721,6 +1115,7 @@ std::optional<SystemSnapshot> KhronicleStore::getSnapshot(
 std::optional<SystemSnapshot> KhronicleStore::getSnapshotBefore(
     std::chrono::system_clock::time_point t) const
 {
+    KTRACE_SCOPE("store", "getSnapshotBefore");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, kernel_version, gpu_driver, "
                    "firmware_versions, key_packages, host_id "
@@ -750,6 +1145,7 @@ std::optional<SystemSnapshot> KhronicleStore::getSnapshotBefore(
 std::optional<SystemSnapshot> KhronicleStore::getSnapshotAfter(
     std::chrono::system_clock::time_point t) const
 {
+    KTRACE_SCOPE("store", "getSnapshotAfter");
     Statement stmt(impl->db,
                    "SELECT id, timestamp, kernel_version, gpu_driver, "
                    "firmware_versions, key_packages, host_id "
@@ -779,6 +1175,7 @@ std::optional<SystemSnapshot> KhronicleStore::getSnapshotAfter(
 KhronicleDiff KhronicleStore::diffSnapshots(const std::string &aId,
                                             const std::string &bId) const
 {
+    KTRACE_SCOPE("store", "diffSnapshots");
     KhronicleDiff diff;
     diff.snapshotAId = aId;
     diff.snapshotBId = bId;
@@ -849,6 +1246,7 @@ KhronicleDiff KhronicleStore::diffSnapshots(const std::string &aId,
 
 std::optional<std::string> KhronicleStore::getMeta(const std::string &key) const
 {
+    KTRACE_SCOPE("store", "getMeta");
     Statement stmt(impl->db,
                    "SELECT value FROM meta WHERE key = ? LIMIT 1;");
     bindText(stmt.get(), 1, key);
@@ -862,6 +1260,7 @@ std::optional<std::string> KhronicleStore::getMeta(const std::string &key) const
 
 void KhronicleStore::setMeta(const std::string &key, const std::string &value)
 {
+    KTRACE_SCOPE("store", "setMeta");
     KLOG_DEBUG(QStringLiteral("KhronicleStore"),
                QStringLiteral("setMeta"),
                QStringLiteral("update_meta"),
@@ -881,4 +1280,30 @@ void KhronicleStore::setMeta(const std::string &key, const std::string &value)
     }
 }
 
+void KhronicleStore::setRowCountingEnabled(bool enabled)
+{
+    if (!enabled) {
+        sqlite3_trace_v2(impl->db, 0, nullptr, nullptr);
+        return;
+    }
+    sqlite3_trace_v2(
+        impl->db,
+        SQLITE_TRACE_ROW,
+        [](unsigned, void *context, void *, void *) -> int {
+            ++static_cast<Impl *>(context)->rowsRead;
+            return 0;
+        },
+        impl.get());
+}
+
+std::uint64_t KhronicleStore::rowsRead() const
+{
+    return impl->rowsRead;
+}
+
+std::uint64_t KhronicleStore::rowsWritten() const
+{
+    return static_cast<std::uint64_t>(sqlite3_total_changes(impl->db));
+}
+
 } // namespace khronicle
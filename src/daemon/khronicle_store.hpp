@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -10,6 +12,12 @@
 
 namespace khronicle {
 
+// Position in the newest-first timeline: the last event of the previous page.
+struct EventPageCursor {
+    std::chrono::system_clock::time_point timestamp;
+    std::string id;
+};
+
 // KhronicleStore is the SQLite access layer for all persistent data:
 // events, snapshots, meta, host identity, watch rules, and watch signals.
 class KhronicleStore {
@@ -32,6 +40,10 @@ public:
     void addWatchSignal(const WatchSignal &signal);
     std::vector<WatchSignal> getWatchSignalsSince(
         std::chrono::system_clock::time_point t) const;
+    // Number of signals since t, optionally only those of one severity.
+    std::size_t countWatchSignalsSince(
+        std::chrono::system_clock::time_point t,
+        std::optional<WatchSeverity> severity = std::nullopt) const;
 
     // Query event history for API and reports.
     std::vector<KhronicleEvent> getEventsSince(
@@ -39,6 +51,33 @@ public:
     std::vector<KhronicleEvent> getEventsBetween(
         std::chrono::system_clock::time_point from,
         std::chrono::system_clock::time_point to) const;
+    // Package events whose new version lies in [minVersion, maxVersion),
+    // compared with pacman's vercmp rules. Empty bounds are open.
+    std::vector<KhronicleEvent> getEventsByVersionRange(
+        const std::string &packageName,
+        const std::string &minVersion,
+        const std::string &maxVersion) const;
+
+    // Up to `limit` events in [from, to], newest first (ties by id), starting
+    // after `after` when given. Keyset pagination over idx_events_timestamp,
+    // so every page costs the same however deep the caller has scrolled.
+    std::vector<KhronicleEvent> getEventsPage(
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        const std::optional<EventPageCursor> &after,
+        std::size_t limit) const;
+
+    // Every addEvent/addSnapshot stamps the row with a store generation one
+    // above any existing one. Clients that remember the generation their
+    // copy was current with fetch only what changed since.
+    std::int64_t getStoreGeneration() const;
+    // Up to `limit` events in [from, to] added or replaced after
+    // `generation`, newest first.
+    std::vector<KhronicleEvent> getEventsAfterGeneration(
+        std::int64_t generation,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        std::size_t limit) const;
 
     std::vector<SystemSnapshot> listSnapshots() const;
     std::optional<SystemSnapshot> getSnapshot(const std::string &id) const;
@@ -52,6 +91,14 @@ public:
     std::optional<std::string> getMeta(const std::string &key) const;
     void setMeta(const std::string &key, const std::string &value);
 
+    // Instrumentation for replay and benchmarks. rowsRead counts result rows
+    // returned by any query while row counting is on (off by default, it
+    // adds a callback per row); rowsWritten is SQLite's running count of
+    // rows inserted, updated or deleted on this connection.
+    void setRowCountingEnabled(bool enabled);
+    std::uint64_t rowsRead() const;
+    std::uint64_t rowsWritten() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl;
@@ -0,0 +1,168 @@
+#include "daemon/latency_monitor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "common/config_file.hpp"
+
+namespace khronicle {
+
+namespace {
+
+double percentile95(std::vector<double> samples)
+{
+    // Nearest-rank p95; windows are small, so a partial sort per sample is
+    // cheaper than keeping an order-statistics structure up to date.
+    const std::size_t rank = static_cast<std::size_t>(
+        std::ceil(0.95 * static_cast<double>(samples.size())));
+    const auto nth = samples.begin() + static_cast<std::ptrdiff_t>(rank - 1);
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+} // namespace
+
+LatencyMonitor LatencyMonitor::defaults()
+{
+    // Generous enough that a healthy host never trips them; the point is to
+    // catch regressions of an order of magnitude, not to tune.
+    LatencyMonitor monitor;
+    monitor.m_budgetsMs = {
+        {"ingestion_cycle", 60000.0},
+        {"pacman_ingestion", 15000.0},
+        {"journal_ingestion", 15000.0},
+        {"snapshot_check", 20000.0},
+        {"api:*", 500.0}
+    };
+    return monitor;
+}
+
+LatencyMonitor LatencyMonitor::fromJson(const nlohmann::json &config)
+{
+    if (!config.is_object()) {
+        throw std::runtime_error("latency budgets config must be a JSON object");
+    }
+
+    LatencyMonitor monitor = defaults();
+    if (config.contains("windowSize")) {
+        const auto &value = config.at("windowSize");
+        if (!value.is_number_integer() || value.get<long long>() <= 0) {
+            throw std::runtime_error("windowSize must be a positive integer");
+        }
+        monitor.m_windowSize = value.get<std::size_t>();
+    }
+    if (config.contains("minSamples")) {
+        const auto &value = config.at("minSamples");
+        if (!value.is_number_integer() || value.get<long long>() <= 0) {
+            throw std::runtime_error("minSamples must be a positive integer");
+        }
+        monitor.m_minSamples = value.get<std::size_t>();
+    }
+    monitor.m_minSamples = std::min(monitor.m_minSamples, monitor.m_windowSize);
+    if (config.contains("cooldownMinutes")) {
+        const auto &value = config.at("cooldownMinutes");
+        if (!value.is_number_integer() || value.get<long long>() < 0) {
+            throw std::runtime_error("cooldownMinutes must be a non-negative integer");
+        }
+        monitor.m_cooldown = std::chrono::minutes(value.get<int>());
+    }
+    if (config.contains("budgetsMs")) {
+        const auto &budgets = config.at("budgetsMs");
+        if (!budgets.is_object()) {
+            throw std::runtime_error("budgetsMs must be an object");
+        }
+        // Configured names override or extend the defaults; a budget of 0
+        // disables tracking for that name.
+        for (auto it = budgets.begin(); it != budgets.end(); ++it) {
+            if (!it->is_number() || it->get<double>() < 0.0) {
+                throw std::runtime_error("budget for '" + it.key()
+                                         + "' must be a non-negative number");
+            }
+            if (it->get<double>() == 0.0) {
+                monitor.m_budgetsMs.erase(it.key());
+            } else {
+                monitor.m_budgetsMs[it.key()] = it->get<double>();
+            }
+        }
+    }
+    return monitor;
+}
+
+std::string LatencyMonitor::configPath()
+{
+    return userConfigPath("KHRONICLE_LATENCY_BUDGETS_PATH", "latency-budgets.json");
+}
+
+LatencyMonitor LatencyMonitor::load()
+{
+    std::optional<LatencyMonitor> loaded;
+    loadConfigFile(configPath(), {"LatencyMonitor", "load", "latency_budgets"},
+                   [&](const nlohmann::json &config) {
+                       loaded.emplace(fromJson(config));
+                       return nlohmann::json{{"budgets", loaded->m_budgetsMs.size()}};
+                   });
+    return loaded ? std::move(*loaded) : defaults();
+}
+
+std::optional<LatencyBreach> LatencyMonitor::record(
+    const std::string &name,
+    std::chrono::microseconds duration,
+    std::chrono::system_clock::time_point now)
+{
+    const auto budget = budgetMs(name);
+    if (!budget) {
+        return std::nullopt;
+    }
+
+    Window &window = m_windows[name];
+    const double sampleMs = static_cast<double>(duration.count()) / 1000.0;
+    if (window.samplesMs.size() < m_windowSize) {
+        window.samplesMs.push_back(sampleMs);
+    } else {
+        window.samplesMs[window.next] = sampleMs;
+        window.next = (window.next + 1) % m_windowSize;
+    }
+
+    if (window.samplesMs.size() < m_minSamples) {
+        return std::nullopt;
+    }
+
+    const double p95 = percentile95(window.samplesMs);
+    if (p95 <= *budget) {
+        return std::nullopt;
+    }
+    if (window.lastBreach != std::chrono::system_clock::time_point{}
+        && now - window.lastBreach < m_cooldown) {
+        return std::nullopt;
+    }
+
+    window.lastBreach = now;
+    return LatencyBreach{name, p95, *budget, window.samplesMs.size()};
+}
+
+std::optional<double> LatencyMonitor::budgetMs(const std::string &name) const
+{
+    if (auto it = m_budgetsMs.find(name); it != m_budgetsMs.end()) {
+        return it->second;
+    }
+    const std::size_t colon = name.find(':');
+    if (colon != std::string::npos) {
+        if (auto it = m_budgetsMs.find(name.substr(0, colon + 1) + "*");
+            it != m_budgetsMs.end()) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<double> LatencyMonitor::p95Ms(const std::string &name) const
+{
+    auto it = m_windows.find(name);
+    if (it == m_windows.end() || it->second.samplesMs.empty()) {
+        return std::nullopt;
+    }
+    return percentile95(it->second.samplesMs);
+}
+
+} // namespace khronicle
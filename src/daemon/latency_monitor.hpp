@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace khronicle {
+
+struct LatencyBreach {
+    std::string name;
+    double p95Ms = 0.0;
+    double budgetMs = 0.0;
+    std::size_t samples = 0;
+};
+
+// Tracks rolling p95 latencies for named daemon operations ("ingestion_cycle",
+// "pacman_ingestion", "api:get_changes_since", ...) and reports when one goes
+// over its budget.
+//
+// Budgets come from a JSON config of the form
+//   {"windowSize": 64, "minSamples": 10, "cooldownMinutes": 60,
+//    "budgetsMs": {"ingestion_cycle": 60000, "api:*": 500}}
+// where "prefix:*" covers every name starting with "prefix:" that has no
+// budget of its own. Names without a budget are not tracked.
+//
+// Not thread-safe: the daemon records from its event loop thread only.
+class LatencyMonitor
+{
+public:
+    // Built-in budgets used when no config file exists.
+    static LatencyMonitor defaults();
+    // Throws std::runtime_error when the document is not a valid config.
+    static LatencyMonitor fromJson(const nlohmann::json &config);
+
+    // Config path: $KHRONICLE_LATENCY_BUDGETS_PATH, otherwise
+    // ~/.config/khronicle/latency-budgets.json.
+    static std::string configPath();
+    // Loads configPath(), falling back to defaults() when it is missing or
+    // invalid.
+    static LatencyMonitor load();
+
+    // Adds one sample. Returns a breach when the rolling p95 is over budget
+    // with at least minSamples in the window and the name has not breached
+    // within the cooldown.
+    std::optional<LatencyBreach> record(const std::string &name,
+                                        std::chrono::microseconds duration,
+                                        std::chrono::system_clock::time_point now);
+
+    std::optional<double> budgetMs(const std::string &name) const;
+    // Rolling p95 in milliseconds, or nullopt before any sample.
+    std::optional<double> p95Ms(const std::string &name) const;
+
+private:
+    struct Window {
+        std::vector<double> samplesMs;
+        std::size_t next = 0;
+        std::chrono::system_clock::time_point lastBreach;
+    };
+
+    std::unordered_map<std::string, double> m_budgetsMs;
+    std::unordered_map<std::string, Window> m_windows;
+    std::size_t m_windowSize = 64;
+    std::size_t m_minSamples = 10;
+    std::chrono::minutes m_cooldown{60};
+};
+
+} // namespace khronicle
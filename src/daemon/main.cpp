@@ -1,5 +1,10 @@
 #include <QCoreApplication>
 #include <QDebug>
+#include <QSocketNotifier>
+
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <nlohmann/json.hpp>
 
@@ -7,12 +12,49 @@
 #include "common/logging.hpp"
 #include "debug/scenario_capture.hpp"
 
+namespace {
+
+int g_signalFds[2] = {-1, -1};
+
+void onTerminationSignal(int)
+{
+    const char byte = 1;
+    // Only async-signal-safe work here; the event loop does the rest.
+    [[maybe_unused]] const ssize_t written = ::write(g_signalFds[0], &byte, 1);
+}
+
+// SIGTERM (systemd, stopDaemon) and SIGINT quit the event loop like a
+// normal exit, so aboutToQuit handlers still run.
+void quitOnTerminationSignals(QCoreApplication &app)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, g_signalFds) != 0) {
+        qWarning() << "Failed to create the signal socket pair";
+        return;
+    }
+    auto *notifier = new QSocketNotifier(g_signalFds[1], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, &QSocketNotifier::activated, &app, [&app] {
+        char byte = 0;
+        [[maybe_unused]] const ssize_t bytesRead = ::read(g_signalFds[1], &byte, 1);
+        app.quit();
+    });
+
+    struct sigaction action = {};
+    action.sa_handler = onTerminationSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    ::sigaction(SIGTERM, &action, nullptr);
+    ::sigaction(SIGINT, &action, nullptr);
+}
+
+} // namespace
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
 
     QCoreApplication::setApplicationName(QStringLiteral("khronicle-daemon"));
     qInfo() << "Khronicle daemon starting...";
+    quitOnTerminationSignals(app);
 
     bool codexTrace = qEnvironmentVariableIntValue("KHRONICLE_CODEX_TRACE") == 1;
     for (int i = 1; i < argc; ++i) {
@@ -38,6 +80,9 @@ int main(int argc, char *argv[])
             qputenv("KHRONICLE_SCENARIO_ENTRY", "daemon_ingestion_cycle");
         }
         khronicle::ScenarioCapture::start(scenarioId, title, desc);
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [] {
+            khronicle::ScenarioCapture::finalize();
+        });
     }
 
     // The daemon lives for the lifetime of the process.
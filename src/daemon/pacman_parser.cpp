@@ -8,7 +8,6 @@
 #include <regex>
 #include <sstream>
 #include <string>
-#include <unordered_set>
 
 #include <QDateTime>
 #include <QRegularExpression>
@@ -16,6 +15,8 @@
 #include <nlohmann/json.hpp>
 
 #include "common/logging.hpp"
+#include "common/package_classifier.hpp"
+#include "common/tracing.hpp"
 
 namespace khronicle {
 
@@ -161,42 +162,19 @@ std::pair<std::string, std::string> splitVersions(const ParsedLine &parsed)
 
 EventCategory categoryForPackage(const std::string &packageName)
 {
-    static const std::unordered_set<std::string> kernels{
-        "linux",
-        "linux-cachyos",
-        "linux-zen",
-        "linux-lts",
-    };
-
-    static const std::unordered_set<std::string> gpuDrivers{
-        "mesa",
-        "mesa-git",
-        "nvidia",
-        "nvidia-dkms",
-        "nvidia-utils",
-        "vulkan-radeon",
-        "vulkan-intel",
-        "vulkan-nouveau",
-        "xf86-video-amdgpu",
-        "xf86-video-intel",
-    };
-
-    static const std::unordered_set<std::string> firmware{
-        "linux-firmware",
-        "amd-ucode",
-        "intel-ucode",
-    };
-
-    if (kernels.contains(packageName)) {
-        return EventCategory::Kernel;
+    const auto match = PackageClassifier::instance().classify(packageName);
+    if (!match) {
+        return EventCategory::Package;
     }
-    if (gpuDrivers.contains(packageName)) {
+
+    switch (match->packageClass) {
+    case PackageClass::Kernel:
+        return EventCategory::Kernel;
+    case PackageClass::GpuDriver:
         return EventCategory::GpuDriver;
-    }
-    if (firmware.contains(packageName)) {
+    case PackageClass::Firmware:
         return EventCategory::Firmware;
     }
-
     return EventCategory::Package;
 }
 
@@ -207,6 +185,7 @@ PacmanParseResult parsePacmanLog(const std::string &path,
 {
     // Parse pacman.log from a prior cursor and emit KhronicleEvent records.
     // If the log cannot be read, keep the previous cursor so we don't skip data.
+    KTRACE_SCOPE("parser", "parsePacmanLog");
     PacmanParseResult result;
 
     KLOG_DEBUG(QStringLiteral("PacmanParser"),
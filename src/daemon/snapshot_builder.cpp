@@ -10,6 +10,9 @@
 
 #include <nlohmann/json.hpp>
 
+#include "common/package_classifier.hpp"
+#include "common/tracing.hpp"
+
 namespace khronicle {
 
 namespace {
@@ -17,6 +20,10 @@ namespace {
 QString runCommand(const QString &program, const QStringList &arguments,
                    int *exitCode)
 {
+    // The program name is only converted when it will be traced.
+    const std::string traced =
+        khronicle::tracing::isTracingEnabled() ? program.toStdString() : std::string();
+    khronicle::tracing::TraceSpan span("process", "spawn:", traced);
     QProcess process;
     process.start(program, arguments);
     if (!process.waitForStarted()) {
@@ -48,10 +55,11 @@ QString runCommand(const QString &program, const QStringList &arguments,
 
 } // namespace
 
-SystemSnapshot buildCurrentSnapshot()
+SystemSnapshot buildCurrentSnapshot(const Clock &clock)
 {
+    KTRACE_SCOPE("snapshot", "buildCurrentSnapshot");
     SystemSnapshot snapshot;
-    snapshot.timestamp = std::chrono::system_clock::now();
+    snapshot.timestamp = clock.now();
 
     const auto epochMs = std::chrono::duration_cast<std::chrono::milliseconds>(
                              snapshot.timestamp.time_since_epoch())
@@ -72,40 +80,26 @@ SystemSnapshot buildCurrentSnapshot()
         snapshot.kernelVersion.clear();
     }
 
-    const std::vector<QString> packages = {
-        QStringLiteral("linux"),
-        QStringLiteral("linux-cachyos"),
-        QStringLiteral("linux-zen"),
-        QStringLiteral("linux-lts"),
-        QStringLiteral("mesa"),
-        QStringLiteral("mesa-git"),
-        QStringLiteral("nvidia"),
-        QStringLiteral("nvidia-dkms"),
-        QStringLiteral("nvidia-utils"),
-        QStringLiteral("vulkan-radeon"),
-        QStringLiteral("vulkan-intel"),
-        QStringLiteral("vulkan-nouveau"),
-        QStringLiteral("xf86-video-amdgpu"),
-        QStringLiteral("xf86-video-intel"),
-        QStringLiteral("linux-firmware"),
-        QStringLiteral("amd-ucode"),
-        QStringLiteral("intel-ucode"),
-    };
-
-    for (const QString &pkg : packages) {
-        int exitCode = 0;
-        QString output = runCommand(QStringLiteral("pacman"),
-                                    {QStringLiteral("-Q"), pkg}, &exitCode);
-        if (exitCode != 0 || output.isEmpty()) {
-            continue;
-        }
-
-        const QStringList tokens = output.split(QChar(' '), Qt::SkipEmptyParts);
-        if (tokens.size() < 2) {
-            continue;
+    // One `pacman -Q` listing filtered through the classifier replaces a
+    // query per package and lets prefix/glob patterns select key packages.
+    int pacmanExit = 0;
+    const QString output = runCommand(QStringLiteral("pacman"),
+                                      {QStringLiteral("-Q")}, &pacmanExit);
+    if (pacmanExit == 0) {
+        const PackageClassifier &classifier = PackageClassifier::instance();
+        const QStringList lines = output.split(QChar('\n'), Qt::SkipEmptyParts);
+        for (const QString &line : lines) {
+            const QStringList tokens = line.split(QChar(' '), Qt::SkipEmptyParts);
+            if (tokens.size() < 2) {
+                continue;
+            }
+
+            const std::string name = tokens[0].toStdString();
+            if (!classifier.classify(name)) {
+                continue;
+            }
+            snapshot.keyPackages[name] = tokens[1].toStdString();
         }
-
-        snapshot.keyPackages[pkg.toStdString()] = tokens[1].toStdString();
     }
 
     return snapshot;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/clock.hpp"
 #include "models.hpp"
 
 namespace khronicle {
@@ -10,8 +11,8 @@ namespace khronicle {
  * - versions of key driver/system packages via pacman
  *
  * This function does not persist anything; it only interrogates the system
- * and returns a SystemSnapshot struct.
+ * and returns a SystemSnapshot struct stamped with clock.now().
  */
-SystemSnapshot buildCurrentSnapshot();
+SystemSnapshot buildCurrentSnapshot(const Clock &clock = systemClock());
 
 } // namespace khronicle
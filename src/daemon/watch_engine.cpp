@@ -6,9 +6,11 @@
 #include <exception>
 #include <random>
 #include <sstream>
+#include <utility>
 
 #include "common/json_utils.hpp"
 #include "common/logging.hpp"
+#include "common/version_compare.hpp"
 
 namespace khronicle {
 
@@ -125,10 +127,63 @@ bool jsonKeysContainSubstring(const nlohmann::json &obj,
     return false;
 }
 
+std::string extraString(const nlohmann::json &extra, const char *key)
+{
+    if (!extra.is_object()) {
+        return {};
+    }
+    auto it = extra.find(key);
+    if (it != extra.end() && it->is_string()) {
+        return it->get<std::string>();
+    }
+    return {};
+}
+
+bool extraFlag(const nlohmann::json &extra, const char *key)
+{
+    if (!extra.is_object()) {
+        return false;
+    }
+    auto it = extra.find(key);
+    return it != extra.end() && it->is_boolean() && it->get<bool>();
+}
+
+// Optional version criteria carried in WatchRule.extra:
+//   "versionAtLeast" / "versionBelow" bound the package version with pacman's
+//   vercmp ordering, "downgrade": true matches only version decreases.
+bool hasVersionBounds(const nlohmann::json &extra)
+{
+    return !extraString(extra, "versionAtLeast").empty()
+        || !extraString(extra, "versionBelow").empty();
+}
+
+bool versionBoundsMatch(const nlohmann::json &extra, const std::string &version)
+{
+    if (!hasVersionBounds(extra)) {
+        return true;
+    }
+    return !version.empty()
+        && versionInRange(version,
+                          extraString(extra, "versionAtLeast"),
+                          extraString(extra, "versionBelow"));
+}
+
+bool downgradeMatch(const nlohmann::json &extra,
+                    const std::string &version,
+                    const std::string &previousVersion)
+{
+    if (!extraFlag(extra, "downgrade")) {
+        return true;
+    }
+    return !version.empty() && !previousVersion.empty()
+        && compareVersions(version, previousVersion) < 0;
+}
+
 } // namespace
 
-WatchEngine::WatchEngine(KhronicleStore &store)
+WatchEngine::WatchEngine(KhronicleStore &store, const Clock &clock)
     : m_store(store)
+    , m_clock(clock)
     , m_lastRulesReload(std::chrono::system_clock::time_point{})
 {
 }
@@ -137,15 +192,16 @@ void WatchEngine::evaluateEvent(const KhronicleEvent &event)
 {
     // Evaluate all enabled event-scope rules against this event and persist
     // WatchSignal records for any matches.
-    KLOG_DEBUG(QStringLiteral("WatchEngine"),
-               QStringLiteral("evaluateEvent"),
-               QStringLiteral("evaluate_watch_rules"),
-               QStringLiteral("ingestion_event_interpretation"),
-               QStringLiteral("rule_match"),
-               khronicle::logging::defaultWho(),
-               QString(),
-               (nlohmann::json{{"eventId", event.id},
-                              {"rulesCached", m_rulesCache.size()}}));
+    KLOG_DEBUG_LIMITED(khronicle::logging::kIngestionLogLimit,
+                       QStringLiteral("WatchEngine"),
+                       QStringLiteral("evaluateEvent"),
+                       QStringLiteral("evaluate_watch_rules"),
+                       QStringLiteral("ingestion_event_interpretation"),
+                       QStringLiteral("rule_match"),
+                       khronicle::logging::defaultWho(),
+                       QString(),
+                       (nlohmann::json{{"eventId", event.id},
+                                      {"rulesCached", m_rulesCache.size()}}));
     maybeReloadRules();
 
     for (const auto &rule : m_rulesCache) {
@@ -170,17 +226,18 @@ void WatchEngine::evaluateEvent(const KhronicleEvent &event)
             signal.message += " category '" + rule.categoryEquals + "'";
         }
 
-        KLOG_INFO(QStringLiteral("WatchEngine"),
-                  QStringLiteral("evaluateEvent"),
-                  QStringLiteral("watch_signal_fired"),
-                  QStringLiteral("rule_match"),
-                  QStringLiteral("persist_signal"),
-                  khronicle::logging::defaultWho(),
-                  QString(),
-                  (nlohmann::json{{"ruleId", rule.id},
-                                 {"originId", event.id},
-                                 {"severity", toWatchSeverityString(rule.severity)}}));
-        m_store.addWatchSignal(signal);
+        KLOG_INFO_LIMITED(khronicle::logging::kIngestionLogLimit,
+                          QStringLiteral("WatchEngine"),
+                          QStringLiteral("evaluateEvent"),
+                          QStringLiteral("watch_signal_fired"),
+                          QStringLiteral("rule_match"),
+                          QStringLiteral("persist_signal"),
+                          khronicle::logging::defaultWho(),
+                          QString(),
+                          (nlohmann::json{{"ruleId", rule.id},
+                                         {"originId", event.id},
+                                         {"severity", toWatchSeverityString(rule.severity)}}));
+        persistSignal(signal);
     }
 }
 
@@ -230,14 +287,56 @@ void WatchEngine::evaluateSnapshot(const SystemSnapshot &snapshot)
                   (nlohmann::json{{"ruleId", rule.id},
                                  {"originId", snapshot.id},
                                  {"severity", toWatchSeverityString(rule.severity)}}));
-        m_store.addWatchSignal(signal);
+        persistSignal(signal);
+    }
+}
+
+void WatchEngine::recordDaemonSignal(const std::string &ruleId,
+                                     const std::string &ruleName,
+                                     WatchSeverity severity,
+                                     const std::string &originId,
+                                     const std::string &message)
+{
+    WatchSignal signal;
+    signal.id = generateUuid();
+    signal.timestamp = m_clock.now();
+    signal.ruleId = ruleId;
+    signal.ruleName = ruleName;
+    signal.severity = severity;
+    signal.originType = "daemon";
+    signal.originId = originId;
+    signal.message = message;
+
+    KLOG_INFO(QStringLiteral("WatchEngine"),
+              QStringLiteral("recordDaemonSignal"),
+              QStringLiteral("watch_signal_fired"),
+              QStringLiteral("daemon_self_check"),
+              QStringLiteral("persist_signal"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"ruleId", ruleId},
+                             {"originId", originId},
+                             {"severity", toWatchSeverityString(severity)}}));
+    persistSignal(signal);
+}
+
+void WatchEngine::setSignalListener(SignalListener listener)
+{
+    m_signalListener = std::move(listener);
+}
+
+void WatchEngine::persistSignal(const WatchSignal &signal)
+{
+    m_store.addWatchSignal(signal);
+    if (m_signalListener) {
+        m_signalListener(signal);
     }
 }
 
 void WatchEngine::maybeReloadRules()
 {
     // Cache rules to keep ingestion cycles fast. Reload periodically.
-    const auto now = std::chrono::system_clock::now();
+    const auto now = m_clock.now();
     if (!m_rulesCache.empty()
         && now - m_lastRulesReload < kRulesReloadInterval) {
         return;
@@ -284,6 +383,12 @@ bool WatchEngine::ruleMatchesEvent(const WatchRule &rule,
         }
     }
 
+    const std::string version = stateVersion(event.afterState);
+    if (!versionBoundsMatch(rule.extra, version)
+        || !downgradeMatch(rule.extra, version, stateVersion(event.beforeState))) {
+        return false;
+    }
+
     return true;
 }
 
@@ -332,6 +437,27 @@ bool WatchEngine::ruleMatchesSnapshot(const WatchRule &rule,
         }
     }
 
+    // Version bounds on snapshots hold when any key package selected by
+    // packageNameContains (or any key package at all) is inside the range.
+    // Downgrades need a previous version and only apply to events.
+    if (hasVersionBounds(rule.extra)) {
+        bool anyInRange = false;
+        if (snapshot.keyPackages.is_object()) {
+            for (const auto &item : snapshot.keyPackages.items()) {
+                if (item.value().is_string()
+                    && containsCaseInsensitive(item.key(), rule.packageNameContains)
+                    && versionBoundsMatch(rule.extra,
+                                          item.value().get<std::string>())) {
+                    anyInRange = true;
+                    break;
+                }
+            }
+        }
+        if (!anyInRange) {
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 
+#include "common/clock.hpp"
 #include "common/models.hpp"
 #include "daemon/khronicle_store.hpp"
 
@@ -13,19 +15,38 @@ namespace khronicle {
 // It records matches as WatchSignal entries in the store.
 class WatchEngine {
 public:
-    explicit WatchEngine(KhronicleStore &store);
+    // Called with each signal right after it is stored, e.g. to push it to
+    // subscribed API clients.
+    using SignalListener = std::function<void(const WatchSignal &signal)>;
+
+    explicit WatchEngine(KhronicleStore &store, const Clock &clock = systemClock());
+
+    void setSignalListener(SignalListener listener);
 
     // INVARIANT: Rules are declarative and inspectable.
     // Do not introduce executable scripting or opaque logic here.
     void evaluateEvent(const KhronicleEvent &event);
     void evaluateSnapshot(const SystemSnapshot &snapshot);
 
+    // Records a signal raised by the daemon about itself (originType
+    // "daemon"), e.g. a latency budget breach, so it shows up alongside
+    // rule matches. ruleId/ruleName identify the built-in check.
+    void recordDaemonSignal(const std::string &ruleId,
+                            const std::string &ruleName,
+                            WatchSeverity severity,
+                            const std::string &originId,
+                            const std::string &message);
+
 private:
     KhronicleStore &m_store;
+    const Clock &m_clock;
+
+    SignalListener m_signalListener;
 
     std::vector<WatchRule> m_rulesCache;
     std::chrono::system_clock::time_point m_lastRulesReload;
 
+    void persistSignal(const WatchSignal &signal);
     void maybeReloadRules();
     bool ruleMatchesEvent(const WatchRule &rule, const KhronicleEvent &event) const;
     bool ruleMatchesSnapshot(const WatchRule &rule, const SystemSnapshot &snapshot) const;
@@ -5,8 +5,12 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QCoreApplication>
+#include <QTimer>
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 
 #include "common/logging.hpp"
@@ -17,9 +21,17 @@ namespace khronicle {
 namespace {
 
 std::mutex g_mutex;
-bool g_enabled = false;
+std::atomic<bool> g_enabled{false};
 QString g_scenarioDir;
+// Scenario metadata; steps live in the NDJSON journal until finalize().
 nlohmann::json g_scenario;
+std::unique_ptr<QFile> g_stepsFile;
+// A flush is scheduled for the steps written since the last one.
+bool g_flushPending = false;
+
+// The first unflushed step arms a flush this long after it, so a killed
+// process loses at most the steps of its last half second, idle or not.
+constexpr auto kStepsFlushDelay = std::chrono::milliseconds(500);
 
 QString baseScenariosDir()
 {
@@ -39,7 +51,12 @@ QString dbPathFromHome()
     return home + QStringLiteral("/.local/share/khronicle/khronicle.db");
 }
 
-void writeScenarioJson()
+QString stepsPath()
+{
+    return g_scenarioDir + QDir::separator() + "steps.ndjson";
+}
+
+void writeScenarioJson(const nlohmann::json &scenario)
 {
     if (g_scenarioDir.isEmpty()) {
         return;
@@ -49,14 +66,41 @@ void writeScenarioJson()
     if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         return;
     }
-    file.write(QString::fromStdString(g_scenario.dump(2)).toUtf8());
+    file.write(QString::fromStdString(scenario.dump(2)).toUtf8());
+}
+
+void flushSteps()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_flushPending = false;
+    if (g_stepsFile) {
+        g_stepsFile->flush();
+    }
+}
+
+// Called with g_mutex held. Steps can come from any thread; the timer runs
+// on the application's.
+void scheduleFlush()
+{
+    if (g_flushPending) {
+        return;
+    }
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app) {
+        g_stepsFile->flush();
+        return;
+    }
+    g_flushPending = true;
+    QMetaObject::invokeMethod(app, [app] {
+        QTimer::singleShot(kStepsFlushDelay, app, flushSteps);
+    }, Qt::QueuedConnection);
 }
 
 } // namespace
 
 bool ScenarioCapture::isEnabled()
 {
-    return g_enabled;
+    return g_enabled.load(std::memory_order_acquire);
 }
 
 void ScenarioCapture::start(const QString &scenarioId,
@@ -64,7 +108,7 @@ void ScenarioCapture::start(const QString &scenarioId,
                             const QString &description)
 {
     std::lock_guard<std::mutex> lock(g_mutex);
-    if (g_enabled) {
+    if (isEnabled()) {
         return;
     }
 
@@ -72,7 +116,6 @@ void ScenarioCapture::start(const QString &scenarioId,
         return;
     }
 
-    g_enabled = true;
     g_scenarioDir = baseScenariosDir() + QDir::separator() + scenarioId;
     QDir().mkpath(g_scenarioDir);
 
@@ -95,7 +138,16 @@ void ScenarioCapture::start(const QString &scenarioId,
         QFile::copy(dbPath, targetDb);
     }
 
-    writeScenarioJson();
+    // Written now, with no steps, so the directory is a valid scenario even
+    // if the process dies before finalize().
+    writeScenarioJson(g_scenario);
+
+    g_stepsFile = std::make_unique<QFile>(stepsPath());
+    if (!g_stepsFile->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        g_stepsFile.reset();
+        return;
+    }
+    g_enabled.store(true, std::memory_order_release);
 
     KLOG_INFO(QStringLiteral("ScenarioCapture"),
               QStringLiteral("start"),
@@ -110,22 +162,65 @@ void ScenarioCapture::start(const QString &scenarioId,
 
 void ScenarioCapture::recordStep(const nlohmann::json &step)
 {
+    if (!isEnabled()) {
+        return;
+    }
+    // One compact line per step, serialized outside the lock. QFile buffers
+    // the writes and a burst of steps shares one delayed flush.
+    QByteArray line = QByteArray::fromStdString(step.dump());
+    line.append('\n');
+
     std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_enabled) {
+    if (!g_stepsFile) {
         return;
     }
-    g_scenario["steps"].push_back(step);
-    writeScenarioJson();
+    g_stepsFile->write(line);
+    scheduleFlush();
 }
 
 void ScenarioCapture::finalize()
 {
     std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_enabled) {
+    if (!g_enabled.exchange(false) || !g_stepsFile) {
         return;
     }
-    g_enabled = false;
-    writeScenarioJson();
+    g_stepsFile->close();
+    g_stepsFile.reset();
+
+    nlohmann::json scenario = g_scenario;
+    scenario["steps"] = readStepsJournal(stepsPath());
+    writeScenarioJson(scenario);
+
+    KLOG_INFO(QStringLiteral("ScenarioCapture"),
+              QStringLiteral("finalize"),
+              QStringLiteral("scenario_finalized"),
+              QStringLiteral("capture_stopped"),
+              QStringLiteral("write_scenario_json"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"dir", g_scenarioDir.toStdString()},
+                             {"steps", scenario["steps"].size()}}));
+}
+
+nlohmann::json ScenarioCapture::readStepsJournal(const QString &path)
+{
+    nlohmann::json steps = nlohmann::json::array();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return steps;
+    }
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        // A crash can leave a torn last line; skip anything unparsable.
+        auto step = nlohmann::json::parse(line.toStdString(), nullptr, false);
+        if (!step.is_discarded() && step.is_object()) {
+            steps.push_back(std::move(step));
+        }
+    }
+    return steps;
 }
 
 QString ScenarioCapture::scenarioDir()
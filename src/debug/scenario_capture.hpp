@@ -6,6 +6,13 @@
 
 namespace khronicle {
 
+// Captures a replayable scenario under ~/.local/share/khronicle/scenarios/<id>.
+//
+// Steps are appended to steps.ndjson (one JSON object per line) through a
+// buffered handle that stays open for the whole capture, so recording a step
+// costs a serialization and a buffered write; the buffer is flushed shortly
+// after the first unflushed step. finalize() flushes the journal and writes
+// the legacy scenario.json with metadata and the full steps array.
 class ScenarioCapture {
 public:
     static bool isEnabled();
@@ -13,9 +20,13 @@ public:
                       const QString &title,
                       const QString &description);
     static void recordStep(const nlohmann::json &step);
+    // Safe to call more than once and when capture never started.
     static void finalize();
 
     static QString scenarioDir();
+
+    // Steps from a steps.ndjson journal; unparsable lines are skipped.
+    static nlohmann::json readStepsJournal(const QString &path);
 };
 
 } // namespace khronicle
@@ -0,0 +1,115 @@
+#include "replay/LogStream.hpp"
+
+#include <QDateTime>
+#include <QFile>
+#include <QRegularExpression>
+
+#include <optional>
+
+namespace khronicle {
+
+namespace {
+
+std::optional<std::chrono::system_clock::time_point> lineTimestamp(const QString &line)
+{
+    QString token;
+    if (line.startsWith(QLatin1Char('['))) {
+        const int end = line.indexOf(QLatin1Char(']'));
+        if (end < 0) {
+            return std::nullopt;
+        }
+        token = line.mid(1, end - 1);
+    } else {
+        token = line.section(QLatin1Char(' '), 0, 0);
+    }
+    token.replace(QLatin1Char(' '), QLatin1Char('T'));
+
+    // Qt wants +00:00; pacman and journalctl write +0000.
+    static const QRegularExpression offsetPattern(QStringLiteral("[+-]\\d{4}$"));
+    const QRegularExpressionMatch offset = offsetPattern.match(token);
+    if (offset.hasMatch()) {
+        token.insert(offset.capturedStart() + 3, QLatin1Char(':'));
+    }
+
+    const QDateTime parsed = QDateTime::fromString(token, Qt::ISODate);
+    if (!parsed.isValid()) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::time_point{
+        std::chrono::milliseconds{parsed.toMSecsSinceEpoch()}};
+}
+
+} // namespace
+
+bool LogStream::load(const QString &path)
+{
+    m_lines.clear();
+    m_next = 0;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    std::optional<std::chrono::system_clock::time_point> previous;
+    std::size_t leadingUnstamped = 0;
+    while (!file.atEnd()) {
+        QByteArray text = file.readLine();
+        if (text.trimmed().isEmpty()) {
+            continue;
+        }
+        if (!text.endsWith('\n')) {
+            text.append('\n');
+        }
+        if (const auto stamp = lineTimestamp(QString::fromUtf8(text))) {
+            previous = stamp;
+        }
+        if (!previous) {
+            ++leadingUnstamped;
+        }
+        m_lines.push_back(Line{previous.value_or(std::chrono::system_clock::time_point{}),
+                               std::move(text)});
+    }
+
+    // Headers before the first stamped line ("-- Logs begin at ...") go out
+    // with it.
+    if (previous) {
+        const auto first = m_lines[leadingUnstamped].timestamp;
+        for (std::size_t i = 0; i < leadingUnstamped; ++i) {
+            m_lines[i].timestamp = first;
+        }
+    }
+    return true;
+}
+
+std::chrono::system_clock::time_point LogStream::firstTimestamp() const
+{
+    return m_lines.empty() ? std::chrono::system_clock::time_point{}
+                           : m_lines.front().timestamp;
+}
+
+std::chrono::system_clock::time_point LogStream::lastTimestamp() const
+{
+    return m_lines.empty() ? std::chrono::system_clock::time_point{}
+                           : m_lines.back().timestamp;
+}
+
+std::chrono::system_clock::time_point LogStream::nextTimestamp() const
+{
+    return exhausted() ? std::chrono::system_clock::time_point::max()
+                       : m_lines[m_next].timestamp;
+}
+
+std::size_t LogStream::releaseUntil(std::chrono::system_clock::time_point until,
+                                    QIODevice &out)
+{
+    std::size_t released = 0;
+    while (m_next < m_lines.size() && m_lines[m_next].timestamp <= until) {
+        out.write(m_lines[m_next].text);
+        ++m_next;
+        ++released;
+    }
+    return released;
+}
+
+} // namespace khronicle
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace khronicle {
+
+// A recorded log (pacman.log, or journalctl short-iso output) that replay
+// releases line by line as virtual time passes. Each line is stamped with its
+// leading timestamp ("[...]" for pacman, the first token for the journal);
+// lines without one inherit the timestamp of the line before them.
+class LogStream {
+public:
+    // Returns false when path cannot be read; a missing log is an empty stream.
+    bool load(const QString &path);
+
+    bool isEmpty() const { return m_lines.empty(); }
+    bool exhausted() const { return m_next >= m_lines.size(); }
+    std::chrono::system_clock::time_point firstTimestamp() const;
+    std::chrono::system_clock::time_point lastTimestamp() const;
+    // Timestamp of the next line releaseUntil would write;
+    // time_point::max() once exhausted.
+    std::chrono::system_clock::time_point nextTimestamp() const;
+
+    // Writes every line not yet released that is stamped at or before until,
+    // in file order, and returns how many were written.
+    std::size_t releaseUntil(std::chrono::system_clock::time_point until, QIODevice &out);
+
+private:
+    struct Line {
+        std::chrono::system_clock::time_point timestamp;
+        QByteArray text;
+    };
+
+    std::vector<Line> m_lines;
+    std::size_t m_next = 0;
+};
+
+} // namespace khronicle
@@ -5,17 +5,23 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
-#include <QLocalSocket>
 #include <QProcess>
 #include <QTemporaryDir>
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <filesystem>
+#include <optional>
+#include <thread>
 
 #include "common/logging.hpp"
 #include "common/json_utils.hpp"
 #include "daemon/khronicle_api_server.hpp"
 #include "daemon/khronicle_daemon.hpp"
 #include "daemon/khronicle_store.hpp"
+#include "debug/scenario_capture.hpp"
+#include "replay/LogStream.hpp"
 #include "report/ReportCli.hpp"
 
 namespace khronicle {
@@ -36,15 +42,70 @@ nlohmann::json readJsonFile(const QString &path)
     }
 }
 
+double threadCpuMs()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1000.0
+        + static_cast<double>(ts.tv_nsec) / 1e6;
+}
+
+std::optional<double> numberAt(const nlohmann::json &object, const char *key)
+{
+    if (!object.is_object()) {
+        return std::nullopt;
+    }
+    auto it = object.find(key);
+    if (it == object.end() || !it->is_number()) {
+        return std::nullopt;
+    }
+    return it->get<double>();
+}
+
+std::optional<double> stepBudgetMs(const nlohmann::json &budgets,
+                                   const nlohmann::json &step,
+                                   const std::string &action)
+{
+    if (auto own = numberAt(step, "budgetMs")) {
+        return own;
+    }
+    if (budgets.is_object() && budgets.contains("actions")) {
+        if (auto perAction = numberAt(budgets["actions"], action.c_str())) {
+            return perAction;
+        }
+    }
+    return numberAt(budgets, "stepWallMs");
+}
+
+bool writeJsonFile(const QString &path, const nlohmann::json &value)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write(QByteArray::fromStdString(value.dump(2)));
+    return true;
+}
+
 } // namespace
 
-int ReplayHarness::runScenario(const QString &scenarioDir)
+ReplayHarness::ReplayHarness() = default;
+
+ReplayHarness::~ReplayHarness() = default;
+
+int ReplayHarness::runScenario(const QString &scenarioDir, const ReplayOptions &options)
 {
     const QString scenarioPath = scenarioDir + QDir::separator() + "scenario.json";
     const nlohmann::json scenario = readJsonFile(scenarioPath);
     if (scenario.is_null() || !scenario.contains("steps")) {
         return 1;
     }
+    // A capture that was never finalized has its steps only in the journal.
+    nlohmann::json steps = scenario["steps"];
+    if (steps.is_array() && steps.empty()) {
+        steps = ScenarioCapture::readStepsJournal(
+            scenarioDir + QDir::separator() + "steps.ndjson");
+    }
 
     QTemporaryDir replayHome;
     if (!replayHome.isValid()) {
@@ -81,29 +142,148 @@ int ReplayHarness::runScenario(const QString &scenarioDir)
               QString(),
               (nlohmann::json{{"scenarioDir", scenarioDir.toStdString()}}));
 
-    return runSteps(scenario["steps"]);
+    // One session for the whole run: the daemon owns the store, and API
+    // steps go through a server on that same store, so SQLite is opened and
+    // the schema checked once rather than per step.
+    const auto setupStart = std::chrono::steady_clock::now();
+    m_scenarioDir = scenarioDir;
+    m_replayHome = replayHome.path();
+    m_clock.setNow(std::chrono::system_clock::now());
+    m_daemon = std::make_unique<KhronicleDaemon>(m_clock);
+    m_daemon->store().setRowCountingEnabled(true);
+    m_apiServer = std::make_unique<KhronicleApiServer>(m_daemon->store());
+    const double setupMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - setupStart).count();
+
+    const nlohmann::json budgets = scenario.value("budgets", nlohmann::json::object());
+    nlohmann::json timing = {
+        {"scenario", scenario.value("id", "")},
+        {"sessionSetupMs", setupMs},
+        {"steps", nlohmann::json::array()}
+    };
+    const int stepsResult = runSteps(steps, budgets, timing);
+
+    // Tear down before replayHome goes away with the database in it.
+    m_apiServer.reset();
+    m_daemon.reset();
+
+    int budgetViolations = 0;
+    double totalWallMs = 0.0;
+    double totalCpuMs = 0.0;
+    for (const auto &entry : timing["steps"]) {
+        totalWallMs += entry.value("wallMs", 0.0);
+        totalCpuMs += entry.value("cpuMs", 0.0);
+        if (entry.value("overBudget", false)) {
+            ++budgetViolations;
+        }
+    }
+    timing["totalWallMs"] = totalWallMs;
+    timing["totalCpuMs"] = totalCpuMs;
+    if (const auto totalBudget = numberAt(budgets, "totalWallMs")) {
+        timing["totalBudgetMs"] = *totalBudget;
+        if (totalWallMs > *totalBudget) {
+            timing["totalOverBudget"] = true;
+            ++budgetViolations;
+        }
+    }
+    timing["budgetViolations"] = budgetViolations;
+    timing["ok"] = stepsResult == 0;
+
+    const QString reportPath = options.timingReportPath.isEmpty()
+        ? QDir::current().filePath(QStringLiteral("replay-timing.json"))
+        : options.timingReportPath;
+    writeJsonFile(reportPath, timing);
+
+    KLOG_INFO(QStringLiteral("ReplayHarness"),
+              QStringLiteral("runScenario"),
+              QStringLiteral("replay_complete"),
+              QStringLiteral("scenario"),
+              QStringLiteral("replay"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"steps", timing["steps"].size()},
+                             {"totalWallMs", totalWallMs},
+                             {"budgetViolations", budgetViolations},
+                             {"timingReport", reportPath.toStdString()}}));
+
+    if (stepsResult != 0) {
+        return stepsResult;
+    }
+    if (options.enforceBudgets && budgetViolations > 0) {
+        return 2;
+    }
+    return 0;
 }
 
-int ReplayHarness::runSteps(const nlohmann::json &steps)
+int ReplayHarness::runSteps(const nlohmann::json &steps,
+                            const nlohmann::json &budgets,
+                            nlohmann::json &timing)
 {
     if (!steps.is_array()) {
         return 1;
     }
-    for (const auto &step : steps) {
+    KhronicleStore &store = m_daemon->store();
+    for (std::size_t index = 0; index < steps.size(); ++index) {
+        const nlohmann::json &step = steps[index];
         const std::string action = step.value("action", "");
+        if (action != "run_ingestion_cycle" && action != "api_call"
+            && action != "report_cli" && action != "replay_log_stream") {
+            continue;
+        }
+
+        const std::uint64_t rowsReadBefore = store.rowsRead();
+        const std::uint64_t rowsWrittenBefore = store.rowsWritten();
+        const double cpuStart = threadCpuMs();
+        const auto wallStart = std::chrono::steady_clock::now();
+
+        int result = 0;
         if (action == "run_ingestion_cycle") {
-            if (runIngestionCycleStep(step) != 0) {
-                return 1;
-            }
+            result = runIngestionCycleStep(step);
         } else if (action == "api_call") {
-            if (runApiStep(step) != 0) {
-                return 1;
-            }
-        } else if (action == "report_cli") {
-            if (runReportStep(step) != 0) {
-                return 1;
+            result = runApiStep(step);
+        } else if (action == "replay_log_stream") {
+            result = runLogStreamStep(step);
+        } else {
+            result = runReportStep(step);
+        }
+
+        const double wallMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - wallStart).count();
+        nlohmann::json entry = {
+            {"index", index},
+            {"action", action},
+            {"wallMs", wallMs},
+            {"cpuMs", threadCpuMs() - cpuStart},
+            {"ok", result == 0}
+        };
+        if (action == "api_call") {
+            entry["method"] = step.value("context", nlohmann::json::object())
+                                  .value("method", "");
+        }
+        // The report CLI opens its own store, so its rows are not visible here.
+        if (action != "report_cli") {
+            entry["rowsRead"] = store.rowsRead() - rowsReadBefore;
+            entry["rowsWritten"] = store.rowsWritten() - rowsWrittenBefore;
+        }
+        if (const auto budget = stepBudgetMs(budgets, step, action)) {
+            entry["budgetMs"] = *budget;
+            entry["overBudget"] = wallMs > *budget;
+            if (wallMs > *budget) {
+                KLOG_WARN(QStringLiteral("ReplayHarness"),
+                          QStringLiteral("runSteps"),
+                          QStringLiteral("replay_step_over_budget"),
+                          QStringLiteral("scenario_budget"),
+                          QStringLiteral("replay"),
+                          khronicle::logging::defaultWho(),
+                          QString(),
+                          entry);
             }
         }
+        timing["steps"].push_back(std::move(entry));
+
+        if (result != 0) {
+            return 1;
+        }
     }
     return 0;
 }
@@ -111,8 +291,7 @@ int ReplayHarness::runSteps(const nlohmann::json &steps)
 int ReplayHarness::runIngestionCycleStep(const nlohmann::json &step)
 {
     Q_UNUSED(step)
-    KhronicleDaemon daemon;
-    daemon.runIngestionCycleForReplay();
+    m_daemon->runIngestionCycleForReplay();
     return 0;
 }
 
@@ -122,16 +301,13 @@ int ReplayHarness::runApiStep(const nlohmann::json &step)
     const std::string method = context.value("method", "");
     const nlohmann::json params = context.value("params", nlohmann::json::object());
 
-    KhronicleStore store;
-    KhronicleApiServer server(store);
-
     // Use direct method invocation for reliability in test/replay scenarios
     // (socket communication in same thread requires event loop coordination)
     nlohmann::json root;
     root["id"] = 1;
     root["method"] = method;
     root["params"] = params;
-    const QByteArray response = server.handleRequestPayload(
+    const QByteArray response = m_apiServer->handleRequestPayload(
         QByteArray::fromStdString(root.dump()));
     const auto parsed = nlohmann::json::parse(response.toStdString(), nullptr, false);
     if (parsed.is_discarded() || parsed.contains("error")) {
@@ -172,38 +348,95 @@ int ReplayHarness::runReportStep(const nlohmann::json &step)
     return cli.run(rawArgs.size(), rawArgs.data());
 }
 
-int ReplayHarness::sendApiRequest(const QString &socketPath,
-                                  const QString &method,
-                                  const nlohmann::json &params)
+int ReplayHarness::runLogStreamStep(const nlohmann::json &step)
 {
-    QLocalSocket socket;
-    socket.connectToServer(socketPath);
-    if (!socket.waitForConnected(1000)) {
+    const nlohmann::json context = step.value("context", nlohmann::json::object());
+    const double speedup = context.value("speedup", 0.0);
+    const auto tick = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::duration<double, std::ratio<60>>(context.value(
+            "tickMinutes",
+            static_cast<double>(KhronicleDaemon::kIngestionInterval.count()))));
+    if (tick <= std::chrono::system_clock::duration::zero() || speedup < 0.0) {
         return 1;
     }
 
-    nlohmann::json root;
-    root["id"] = 1;
-    root["method"] = method.toStdString();
-    root["params"] = params;
-
-    const QByteArray payload = QByteArray::fromStdString(root.dump());
-    socket.write(payload);
-    if (!socket.waitForBytesWritten(1000)) {
+    LogStream pacman;
+    LogStream journal;
+    pacman.load(m_scenarioDir + QDir::separator() + "pacman.log");
+    journal.load(m_scenarioDir + QDir::separator() + "journal.txt");
+    if (pacman.isEmpty() && journal.isEmpty()) {
         return 1;
     }
-    if (!socket.waitForReadyRead(1000)) {
+
+    // The daemon reads these as if they were the live logs; they only ever
+    // contain what has "happened" by the virtual clock's time.
+    const QString pacmanPath = m_replayHome + QDir::separator() + "stream-pacman.log";
+    const QString journalPath = m_replayHome + QDir::separator() + "stream-journal.txt";
+    QFile pacmanOut(pacmanPath);
+    QFile journalOut(journalPath);
+    if (!pacmanOut.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || !journalOut.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         return 1;
     }
+    qputenv("KHRONICLE_PACMAN_LOG_PATH", pacmanPath.toUtf8());
+    qputenv("KHRONICLE_JOURNAL_PATH", journalPath.toUtf8());
 
-    const QByteArray response = socket.readAll();
-    const auto parsed = nlohmann::json::parse(response.toStdString(), nullptr, false);
-    if (parsed.is_discarded()) {
-        return 1;
+    std::chrono::system_clock::time_point start;
+    if (pacman.isEmpty()) {
+        start = journal.firstTimestamp();
+    } else if (journal.isEmpty()) {
+        start = pacman.firstTimestamp();
+    } else {
+        start = std::min(pacman.firstTimestamp(), journal.firstTimestamp());
     }
-    if (parsed.contains("error")) {
-        return 1;
+    m_clock.setNow(start);
+    m_daemon->resetIngestionStateForReplay();
+
+    const auto realStart = std::chrono::steady_clock::now();
+    std::size_t cycles = 0;
+    std::size_t lines = 0;
+    while (true) {
+        lines += pacman.releaseUntil(m_clock.now(), pacmanOut);
+        lines += journal.releaseUntil(m_clock.now(), journalOut);
+        pacmanOut.flush();
+        journalOut.flush();
+        m_daemon->runIngestionCycleForReplay();
+        ++cycles;
+        if (pacman.exhausted() && journal.exhausted()) {
+            break;
+        }
+
+        // Across an idle gap, go straight to the next line instead of
+        // running a full (and, for the journal, re-reading) ingestion cycle
+        // per tick in between.
+        const auto next = std::min(pacman.nextTimestamp(), journal.nextTimestamp());
+        if (next > m_clock.now() + tick) {
+            m_clock.setNow(next);
+        } else {
+            m_clock.advance(tick);
+        }
+        if (speedup > 0.0) {
+            const std::chrono::duration<double> virtualElapsed = m_clock.now() - start;
+            std::this_thread::sleep_until(
+                realStart
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    virtualElapsed / speedup));
+        }
     }
+
+    KLOG_INFO(QStringLiteral("ReplayHarness"),
+              QStringLiteral("runLogStreamStep"),
+              QStringLiteral("replay_log_stream_complete"),
+              QStringLiteral("scenario_step"),
+              QStringLiteral("virtual_clock"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"cycles", cycles},
+                             {"lines", lines},
+                             {"virtualHours",
+                              std::chrono::duration<double, std::ratio<3600>>(
+                                  m_clock.now() - start).count()},
+                             {"speedup", speedup}}));
     return 0;
 }
 
@@ -2,25 +2,66 @@
 
 #include <QString>
 
+#include <memory>
+
 #include <nlohmann/json.hpp>
 
+#include "common/clock.hpp"
+
 namespace khronicle {
 
+class KhronicleApiServer;
+class KhronicleDaemon;
+
+struct ReplayOptions {
+    // Where to write the per-step timing report; empty means
+    // replay-timing.json in the working directory. The scenario directory
+    // is left as captured.
+    QString timingReportPath;
+    // Fail the replay (exit code 2) when a step or the whole run goes over
+    // the budgets declared in scenario.json.
+    bool enforceBudgets = false;
+};
+
+// Replays a captured scenario against one daemon, store and API server that
+// live for the whole run, timing every step.
+//
+// scenario.json may declare budgets in milliseconds of wall time:
+//   "budgets": {"stepWallMs": 500, "totalWallMs": 5000,
+//               "actions": {"api_call": 50, "run_ingestion_cycle": 2000}}
+// and a step may carry its own "budgetMs". A step's budget is its own, then
+// its action's, then stepWallMs.
+//
+// The daemon reads time from a virtual clock. A "replay_log_stream" step
+// feeds the scenario's pacman.log and journal.txt to it on their recorded
+// timeline, running one ingestion cycle per scheduler tick of virtual time:
+//   {"action": "replay_log_stream",
+//    "context": {"speedup": 86400, "tickMinutes": 5}}
+// speedup is virtual seconds per real second (0 or absent: as fast as
+// possible); tickMinutes defaults to the daemon's ingestion interval.
 class ReplayHarness {
 public:
-    int runScenario(const QString &scenarioDir);
+    ReplayHarness();
+    ~ReplayHarness();
+
+    int runScenario(const QString &scenarioDir, const ReplayOptions &options = {});
 
 private:
-    int runSteps(const nlohmann::json &steps);
+    int runSteps(const nlohmann::json &steps,
+                 const nlohmann::json &budgets,
+                 nlohmann::json &timing);
     int runIngestionCycleStep(const nlohmann::json &step);
     int runApiStep(const nlohmann::json &step);
     int runReportStep(const nlohmann::json &step);
-
-    int sendApiRequest(const QString &socketPath,
-                       const QString &method,
-                       const nlohmann::json &params);
+    int runLogStreamStep(const nlohmann::json &step);
 
     bool prepareScenarioDb(const QString &scenarioDir, const QString &replayHome);
+
+    QString m_scenarioDir;
+    QString m_replayHome;
+    VirtualClock m_clock;
+    std::unique_ptr<KhronicleDaemon> m_daemon;
+    std::unique_ptr<KhronicleApiServer> m_apiServer;
 };
 
 } // namespace khronicle
@@ -16,6 +16,13 @@ int main(int argc, char *argv[])
     QCommandLineOption codexOption(QStringList() << "codex-trace",
                                    "Enable verbose Codex trace logging.");
     parser.addOption(codexOption);
+    QCommandLineOption timingReportOption(QStringList() << "timing-report",
+                                          "Write per-step timing to <path> (default: ./replay-timing.json).",
+                                          "path");
+    parser.addOption(timingReportOption);
+    QCommandLineOption enforceBudgetsOption(QStringList() << "enforce-budgets",
+                                            "Exit with code 2 when a step exceeds its budget.");
+    parser.addOption(enforceBudgetsOption);
     parser.addPositionalArgument("scenarioDir", "Path to scenario directory.");
     parser.process(app);
 
@@ -28,6 +35,10 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    khronicle::ReplayOptions options;
+    options.timingReportPath = parser.value(timingReportOption);
+    options.enforceBudgets = parser.isSet(enforceBudgetsOption);
+
     khronicle::ReplayHarness harness;
-    return harness.runScenario(args.first());
+    return harness.runScenario(args.first(), options);
 }
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <unordered_map>
 
 #include <QCoreApplication>
 #include <QDateTime>
@@ -10,6 +11,8 @@
 #include <QTemporaryDir>
 #include <QProcess>
 
+#include "common/diff_labels.hpp"
+#include "common/fleet_index.hpp"
 #include "common/json_utils.hpp"
 #include "common/models.hpp"
 #include "common/logging.hpp"
@@ -29,25 +32,10 @@ QString usageText()
         "  khronicle-report diff --snapshot-a ID --snapshot-b ID [--format markdown|json]\n"
         "  khronicle-report explain --from ISO --to ISO [--format markdown|json]\n"
         "  khronicle-report bundle --from ISO --to ISO --out PATH\n"
-        "  khronicle-report aggregate --input PATH --format markdown|json --out PATH\n");
-}
-
-QString humanizePath(const std::string &path)
-{
-    if (path == "kernelVersion") {
-        return QStringLiteral("Kernel");
-    }
-    const std::string keyPrefix = "keyPackages.";
-    if (path.rfind(keyPrefix, 0) == 0) {
-        return QStringLiteral("Package: ")
-            + QString::fromStdString(path.substr(keyPrefix.size()));
-    }
-    const std::string fwPrefix = "firmwareVersions.";
-    if (path.rfind(fwPrefix, 0) == 0) {
-        return QStringLiteral("Firmware: ")
-            + QString::fromStdString(path.substr(fwPrefix.size()));
-    }
-    return QString::fromStdString(path);
+        "  khronicle-report aggregate --input PATH --format markdown|json --out PATH\n"
+        "  khronicle-report fleet-query --input AGGREGATE.json [--has NAME[OP VERSION]]...\n"
+        "                               [--got NAME[OP VERSION]]... [--since ISO]\n"
+        "                               [--format markdown|json]  (OP: = < <= > >=)\n");
 }
 
 std::string formatLocalTime(std::chrono::system_clock::time_point timestamp)
@@ -127,7 +115,7 @@ void renderDiffMarkdown(const KhronicleDiff &diff,
     }
 
     for (const auto &field : diff.changedFields) {
-        std::cout << "### " << humanizePath(field.path).toStdString() << "\n\n";
+        std::cout << "### " << humanizeDiffPath(field.path) << "\n\n";
         if (field.before.is_string()) {
             std::cout << "- Before: " << field.before.get<std::string>() << "\n";
         } else {
@@ -166,6 +154,17 @@ QString getArgValue(const QStringList &args, const QString &key)
     return args.at(idx + 1);
 }
 
+QStringList getArgValues(const QStringList &args, const QString &key)
+{
+    QStringList values;
+    for (int i = 0; i + 1 < args.size(); ++i) {
+        if (args.at(i) == key) {
+            values.push_back(args.at(i + 1));
+        }
+    }
+    return values;
+}
+
 QString getFormat(const QStringList &args)
 {
     const QString value = getArgValue(args, QStringLiteral("--format"));
@@ -248,6 +247,9 @@ int ReportCli::run(int argc, char *argv[])
     if (command == QStringLiteral("aggregate")) {
         return runAggregateReport(args);
     }
+    if (command == QStringLiteral("fleet-query")) {
+        return runFleetQueryReport(args);
+    }
 
     std::cerr << usageText().toStdString();
     return 1;
@@ -704,6 +706,123 @@ int ReportCli::runAggregateReport(const QStringList &args)
     return 0;
 }
 
+int ReportCli::runFleetQueryReport(const QStringList &args)
+{
+    // Fleet queries answer "which hosts run/got X" from an aggregate file
+    // using the (package, version) -> host inverted index.
+    const QString inputPath = getArgValue(args, QStringLiteral("--input"));
+    const QString sinceValue = getArgValue(args, QStringLiteral("--since"));
+    const QString format = getFormat(args);
+
+    if (inputPath.isEmpty()) {
+        std::cerr << usageText().toStdString();
+        return 1;
+    }
+
+    if (format != QStringLiteral("markdown") && format != QStringLiteral("json")) {
+        std::cerr << "Invalid format. Use markdown or json." << std::endl;
+        return 1;
+    }
+
+    FleetQuery query;
+    const auto addTerms = [&query](const QStringList &values,
+                                   FleetQueryTerm::Kind kind) {
+        for (const QString &value : values) {
+            const auto term = parseFleetQueryTerm(kind, value.toStdString());
+            if (!term.has_value()) {
+                return false;
+            }
+            query.terms.push_back(*term);
+        }
+        return true;
+    };
+    if (!addTerms(getArgValues(args, QStringLiteral("--has")),
+                  FleetQueryTerm::Kind::Installed)
+        || !addTerms(getArgValues(args, QStringLiteral("--got")),
+                     FleetQueryTerm::Kind::Received)) {
+        std::cerr << "Invalid package term. Use NAME or NAME=VERSION." << std::endl;
+        return 1;
+    }
+
+    if (!sinceValue.isEmpty()) {
+        query.since = parseIso8601(sinceValue);
+        if (!query.since.has_value()) {
+            std::cerr << "Invalid ISO8601 timestamp." << std::endl;
+            return 1;
+        }
+    }
+
+    const nlohmann::json aggregate = readJsonFile(inputPath);
+    if (!aggregate.is_object() || !aggregate.contains("hosts")) {
+        std::cerr << "Invalid aggregate JSON." << std::endl;
+        return 1;
+    }
+
+    const FleetIndex index = FleetIndex::fromAggregate(aggregate);
+    std::unordered_map<std::string, nlohmann::json> identities;
+    for (const auto &host : aggregate["hosts"]) {
+        const auto identity = host.value("hostIdentity", nlohmann::json::object());
+        identities[identity.value("hostId", "")] = identity;
+    }
+
+    const std::vector<std::size_t> matched = index.query(query).members();
+
+    KLOG_INFO(QStringLiteral("ReportCli"),
+              QStringLiteral("runFleetQueryReport"),
+              QStringLiteral("report_fleet_query"),
+              QStringLiteral("user_invocation"),
+              QStringLiteral("fleet_index"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"terms", query.terms.size()},
+                             {"hosts", index.hostCount()},
+                             {"matched", matched.size()},
+                             {"format", format.toStdString()}}));
+
+    if (format == QStringLiteral("json")) {
+        nlohmann::json payload;
+        payload["totalHosts"] = index.hostCount();
+        payload["hosts"] = nlohmann::json::array();
+        for (const std::size_t host : matched) {
+            nlohmann::json entry = identities[index.hostId(host)];
+            nlohmann::json versions = nlohmann::json::object();
+            for (const auto &term : query.terms) {
+                versions[term.packageName] =
+                    index.installedVersion(host, term.packageName);
+            }
+            entry["installed"] = versions;
+            payload["hosts"].push_back(entry);
+        }
+        std::cout << payload.dump(2) << std::endl;
+        return 0;
+    }
+
+    std::cout << "# Khronicle Fleet Query\n\n";
+    std::cout << "Matched " << matched.size() << " of " << index.hostCount()
+              << " hosts.\n\n";
+    for (const std::size_t host : matched) {
+        const nlohmann::json &identity = identities[index.hostId(host)];
+        std::string label = identity.value("displayName", "");
+        if (label.empty()) {
+            label = identity.value("hostname", "");
+        }
+        if (label.empty()) {
+            label = index.hostId(host);
+        }
+        std::cout << "- " << label << " [hostId: " << index.hostId(host) << "]";
+        for (const auto &term : query.terms) {
+            const std::string version =
+                index.installedVersion(host, term.packageName);
+            if (!version.empty()) {
+                std::cout << " " << term.packageName << " " << version;
+            }
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}
+
 std::optional<std::chrono::system_clock::time_point> ReportCli::parseIso8601(
     const QString &value) const
 {
@@ -22,6 +22,7 @@ private:
     int runExplainReport(const QStringList &args);
     int runBundleReport(const QStringList &args);
     int runAggregateReport(const QStringList &args);
+    int runFleetQueryReport(const QStringList &args);
 
     std::optional<std::chrono::system_clock::time_point> parseIso8601(
         const QString &value) const;
@@ -51,5 +51,7 @@ int main(int argc, char *argv[])
     for (auto &arg : utf8Args) {
         rawArgs.push_back(arg.data());
     }
-    return cli.run(rawArgs.size(), rawArgs.data());
+    const int exitCode = cli.run(rawArgs.size(), rawArgs.data());
+    khronicle::ScenarioCapture::finalize();
+    return exitCode;
 }
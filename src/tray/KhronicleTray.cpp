@@ -4,32 +4,40 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
-#include <QLocalSocket>
 #include <QProcess>
 #include <QIcon>
 #include <QMessageBox>
 #include <QTime>
 #include <QStringList>
 
-#include <unistd.h>
-
 #include <nlohmann/json.hpp>
 
 #include "common/logging.hpp"
 #include "common/process_utils.hpp"
+#include "common/request_trace.hpp"
 
 namespace {
 
 constexpr int kRefreshIntervalMs = 15 * 60 * 1000;
-constexpr int kSocketTimeoutMs = 1500;
 
 QString toIso8601Utc(const QDateTime &dt)
 {
     return dt.toUTC().toString(Qt::ISODate);
 }
 
+QDateTime localMidnight()
+{
+    return QDateTime(QDateTime::currentDateTime().date(), QTime(0, 0));
+}
+
+QJsonObject sinceTodayParams()
+{
+    QJsonObject params;
+    params["since"] = toIso8601Utc(localMidnight());
+    return params;
+}
+
 } // namespace
 
 KhronicleTray::KhronicleTray(QObject *parent)
@@ -46,6 +54,26 @@ KhronicleTray::KhronicleTray(QObject *parent)
               nlohmann::json::object());
     setupTrayIcon();
     setupMenu();
+
+    connect(&m_connection, &khronicle::DaemonConnection::connectedChanged,
+            this, [this](bool connected) {
+                updateDaemonActions(connected);
+                if (connected) {
+                    // Catch up on whatever happened while disconnected.
+                    refreshSummary();
+                }
+            });
+    connect(&m_connection, &khronicle::DaemonConnection::errorOccurred, this, [this] {
+        updateDaemonActions(m_connection.isConnected());
+    });
+    connect(&m_connection, &khronicle::DaemonConnection::responseReady,
+            this, &KhronicleTray::onResponse);
+    connect(&m_connection, &khronicle::DaemonConnection::notificationReceived,
+            this, &KhronicleTray::onNotification);
+    // Critical signals are pushed as they fire instead of polled.
+    m_connection.subscribe(QStringLiteral("subscribe_watch_signals"),
+                           QJsonObject{{"minSeverity", "critical"}});
+
     scheduleRefresh();
 }
 
@@ -74,12 +102,13 @@ void KhronicleTray::setupMenu()
 
     m_startStopDaemonAction = m_menu.addAction(QStringLiteral("Start daemon"));
     connect(m_startStopDaemonAction, &QAction::triggered, this, [this]() {
-        if (khronicle::isDaemonRunning()) {
+        // Status follows the connection, which notices either change.
+        if (m_connection.isConnected()) {
             khronicle::stopDaemon();
         } else {
             khronicle::startDaemon();
+            m_connection.connectToDaemon();
         }
-        updateDaemonActions();
     });
 
     m_menu.addSeparator();
@@ -116,8 +145,8 @@ void KhronicleTray::scheduleRefresh()
     connect(&m_refreshTimer, &QTimer::timeout, this, &KhronicleTray::refreshSummary);
     m_refreshTimer.start();
 
-    refreshSummary();
-    updateDaemonActions();
+    // The first refresh runs once the connection is up.
+    m_connection.connectToDaemon();
 }
 
 void KhronicleTray::refreshSummary()
@@ -131,21 +160,29 @@ void KhronicleTray::refreshSummary()
                khronicle::logging::defaultWho(),
                QString(),
                nlohmann::json::object());
-    m_lastSummaryText = requestSummarySinceToday();
-    const int criticalSignals = requestCriticalWatchSignalsSinceToday();
-    if (criticalSignals > 0) {
-        m_lastSummaryText += QStringLiteral(" (%1 critical watchpoint hit)")
-            .arg(criticalSignals);
+    if (!m_connection.isConnected()) {
+        // Requests would wait for the daemon; say so now instead.
+        handleSummary(QJsonObject());
+        return;
     }
-    m_trayIcon.setToolTip(QStringLiteral("Khronicle - ") + m_lastSummaryText);
-    updateDaemonActions();
+    sendRequest(QStringLiteral("summary_since"), sinceTodayParams());
+    requestCriticalCount();
+}
+
+void KhronicleTray::requestCriticalCount()
+{
+    QJsonObject countParams = sinceTodayParams();
+    countParams["severity"] = QStringLiteral("critical");
+    sendRequest(QStringLiteral("count_watch_signals_since"), countParams);
 }
 
 void KhronicleTray::showSummaryPopup()
 {
-    // On-demand popup for today's summary.
+    // On-demand popup for today's summary; shown once it has loaded.
     if (m_lastSummaryText.isEmpty()) {
+        m_summaryPopupPending = true;
         refreshSummary();
+        return;
     }
 
     KLOG_INFO(QStringLiteral("KhronicleTray"),
@@ -157,13 +194,14 @@ void KhronicleTray::showSummaryPopup()
               QString(),
               nlohmann::json::object());
     m_trayIcon.showMessage(QStringLiteral("Khronicle - Today's Changes"),
-                           m_lastSummaryText,
+                           summaryText(),
                            QSystemTrayIcon::Information);
 }
 
 void KhronicleTray::showWatchSignalsPopup()
 {
-    // Simple textual list of the most recent watchpoint signals.
+    // Simple textual list of the most recent watchpoint signals, shown when
+    // the daemon answers.
     KLOG_INFO(QStringLiteral("KhronicleTray"),
               QStringLiteral("showWatchSignalsPopup"),
               QStringLiteral("show_watch_signals_popup"),
@@ -172,10 +210,11 @@ void KhronicleTray::showWatchSignalsPopup()
               khronicle::logging::defaultWho(),
               QString(),
               nlohmann::json::object());
-    const QString summary = requestWatchSignalsSinceToday();
-    m_trayIcon.showMessage(QStringLiteral("Khronicle - Watchpoint Signals"),
-                           summary,
-                           QSystemTrayIcon::Information);
+    if (!m_connection.isConnected()) {
+        handleWatchSignals(QJsonObject());
+        return;
+    }
+    sendRequest(QStringLiteral("get_watch_signals_since"), sinceTodayParams());
 }
 
 void KhronicleTray::openFullApp()
@@ -226,57 +265,96 @@ void KhronicleTray::onTrayActivated(QSystemTrayIcon::ActivationReason reason)
     }
 }
 
-QString KhronicleTray::requestSummarySinceToday()
+void KhronicleTray::sendRequest(const QString &method, const QJsonObject &params)
 {
-    // Query the daemon for summary_since starting at local midnight.
-    QLocalSocket socket;
-    socket.connectToServer(socketPath());
-    if (!socket.waitForConnected(kSocketTimeoutMs)) {
-        return QStringLiteral("No summary available (daemon not running?)");
-    }
-
-    const QDateTime now = QDateTime::currentDateTime();
-    const QDateTime midnight = QDateTime(now.date(), QTime(0, 0));
-
-    QJsonObject params;
-    params["since"] = toIso8601Utc(midnight);
-
-    QJsonObject root;
-    root["id"] = 1;
-    root["method"] = QStringLiteral("summary_since");
-    root["params"] = params;
-
-    const QByteArray payload =
-        QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
+    // The view makes a newer request of the same kind supersede an older one
+    // still in flight.
+    const khronicle::RequestTrace trace = khronicle::startRequestTrace();
+    const int id = m_connection.send(method, params, trace,
+                                     QStringLiteral("tray:") + method);
+    m_pending.insert(id, PendingRequest{method, trace});
+}
 
-    socket.write(payload);
-    if (!socket.waitForBytesWritten(kSocketTimeoutMs)) {
-        return QStringLiteral("No summary available (daemon not running?)");
+void KhronicleTray::onResponse(const khronicle::DecodedResponse &response)
+{
+    const auto it = m_pending.constFind(response.id);
+    if (it == m_pending.constEnd()) {
+        return;
     }
-
-    if (!socket.waitForReadyRead(kSocketTimeoutMs)) {
-        return QStringLiteral("No summary available (daemon not running?)");
+    const PendingRequest pending = it.value();
+    m_pending.erase(it);
+    if (response.superseded) {
+        return;
     }
 
-    const QByteArray responseLine = socket.readLine();
-    if (responseLine.isEmpty()) {
-        return QStringLiteral("No summary available (daemon not running?)");
+    QJsonObject result;
+    if (response.error.isEmpty()) {
+        khronicle::logRequestLatency(QStringLiteral("KhronicleTray"), pending.method,
+                                     pending.trace, response.response);
+        result = response.result;
+    } else {
+        KLOG_WARN(QStringLiteral("KhronicleTray"),
+                  QStringLiteral("onResponse"),
+                  QStringLiteral("api_request_error"),
+                  QStringLiteral("daemon_error"),
+                  QStringLiteral("json_rpc"),
+                  khronicle::logging::defaultWho(),
+                  pending.trace.id,
+                  (nlohmann::json{{"method", pending.method.toStdString()},
+                                 {"error", response.error.toStdString()}}));
     }
 
-    QJsonParseError parseError{};
-    const QJsonDocument doc = QJsonDocument::fromJson(responseLine, &parseError);
-    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-        return QStringLiteral("No summary available (daemon not running?)");
+    if (pending.method == QStringLiteral("summary_since")) {
+        handleSummary(result);
+    } else if (pending.method == QStringLiteral("count_watch_signals_since")) {
+        handleCriticalCount(result);
+    } else if (pending.method == QStringLiteral("get_watch_signals_since")) {
+        handleWatchSignals(result);
     }
+}
 
-    const QJsonObject obj = doc.object();
-    if (obj.contains("error")) {
-        return QStringLiteral("No summary available (daemon not running?)");
+void KhronicleTray::onNotification(const QString &method, const QJsonObject &params)
+{
+    if (method != QStringLiteral("watch_signal")) {
+        return;
+    }
+    const QJsonObject signal = params.value("signal").toObject();
+    if (signal.value("severity").toString() != QStringLiteral("critical")) {
+        return;
+    }
+    // Ask for the count again rather than adding one: a count request
+    // already in flight may or may not include this signal. The new request
+    // supersedes it and, being handled after the signal was stored, does.
+    // Backfilled journal events can fire rules with old timestamps; only
+    // today's count is shown.
+    const QDateTime when =
+        QDateTime::fromString(signal.value("timestamp").toString(), Qt::ISODate);
+    if (when.isValid() && when >= localMidnight()) {
+        requestCriticalCount();
     }
 
-    const QJsonObject result = obj.value("result").toObject();
+    KLOG_INFO(QStringLiteral("KhronicleTray"),
+              QStringLiteral("onNotification"),
+              QStringLiteral("critical_watch_signal"),
+              QStringLiteral("daemon_push"),
+              QStringLiteral("tray_popup"),
+              khronicle::logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"signalId", signal.value("id").toString().toStdString()},
+                             {"ruleId", signal.value("ruleId").toString().toStdString()}}));
+    m_trayIcon.showMessage(QStringLiteral("Khronicle - Critical Watchpoint"),
+                           QStringLiteral("%1 - %2")
+                               .arg(signal.value("ruleName").toString(),
+                                    signal.value("message").toString()),
+                           QSystemTrayIcon::Warning);
+}
+
+void KhronicleTray::handleSummary(const QJsonObject &result)
+{
     if (result.isEmpty()) {
-        return QStringLiteral("No summary available (daemon not running?)");
+        m_lastSummaryText = QStringLiteral("No summary available (daemon not running?)");
+        onSummaryUpdated();
+        return;
     }
 
     const bool kernelChanged = result.value("kernelChanged").toBool(false);
@@ -300,153 +378,70 @@ QString KhronicleTray::requestSummarySinceToday()
     summary += QStringLiteral("; Firmware: ") + QString::number(firmwareEvents);
     summary += QStringLiteral("; Total: ") + QString::number(totalEvents);
 
-    return summary;
+    m_lastSummaryText = summary;
+    onSummaryUpdated();
 }
 
-int KhronicleTray::requestCriticalWatchSignalsSinceToday()
+void KhronicleTray::handleCriticalCount(const QJsonObject &result)
 {
-    QLocalSocket socket;
-    socket.connectToServer(socketPath());
-    if (!socket.waitForConnected(kSocketTimeoutMs)) {
-        return 0;
-    }
-
-    const QDateTime now = QDateTime::currentDateTime();
-    const QDateTime midnight = QDateTime(now.date(), QTime(0, 0));
-
-    QJsonObject params;
-    params["since"] = toIso8601Utc(midnight);
-
-    QJsonObject root;
-    root["id"] = 1;
-    root["method"] = QStringLiteral("get_watch_signals_since");
-    root["params"] = params;
-
-    const QByteArray payload =
-        QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
-
-    socket.write(payload);
-    if (!socket.waitForBytesWritten(kSocketTimeoutMs)) {
-        return 0;
-    }
-
-    if (!socket.waitForReadyRead(kSocketTimeoutMs)) {
-        return 0;
-    }
-
-    const QByteArray responseLine = socket.readLine();
-    if (responseLine.isEmpty()) {
-        return 0;
-    }
-
-    QJsonParseError parseError{};
-    const QJsonDocument doc = QJsonDocument::fromJson(responseLine, &parseError);
-    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-        return 0;
-    }
-
-    const QJsonObject obj = doc.object();
-    if (obj.contains("error")) {
-        return 0;
-    }
-
-    const QJsonObject result = obj.value("result").toObject();
-    const QJsonArray watchSignals = result.value("signals").toArray();
-    int count = 0;
-    for (const auto &value : watchSignals) {
-        const QJsonObject signal = value.toObject();
-        if (signal.value("severity").toString() == QStringLiteral("critical")) {
-            count++;
-        }
-    }
-    return count;
+    // Counted by the daemon; the signals themselves are not transferred.
+    m_criticalSignals = result.value("count").toInt(0);
+    m_trayIcon.setToolTip(QStringLiteral("Khronicle - ") + summaryText());
 }
 
-QString KhronicleTray::requestWatchSignalsSinceToday()
+void KhronicleTray::handleWatchSignals(const QJsonObject &result)
 {
-    QLocalSocket socket;
-    socket.connectToServer(socketPath());
-    if (!socket.waitForConnected(kSocketTimeoutMs)) {
-        return QStringLiteral("No watchpoint signals (daemon not running?)");
-    }
-
-    const QDateTime now = QDateTime::currentDateTime();
-    const QDateTime midnight = QDateTime(now.date(), QTime(0, 0));
-
-    QJsonObject params;
-    params["since"] = toIso8601Utc(midnight);
-
-    QJsonObject root;
-    root["id"] = 1;
-    root["method"] = QStringLiteral("get_watch_signals_since");
-    root["params"] = params;
-
-    const QByteArray payload =
-        QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
-
-    socket.write(payload);
-    if (!socket.waitForBytesWritten(kSocketTimeoutMs)) {
-        return QStringLiteral("No watchpoint signals (daemon not running?)");
-    }
-
-    if (!socket.waitForReadyRead(kSocketTimeoutMs)) {
-        return QStringLiteral("No watchpoint signals (daemon not running?)");
-    }
-
-    const QByteArray responseLine = socket.readLine();
-    if (responseLine.isEmpty()) {
-        return QStringLiteral("No watchpoint signals (daemon not running?)");
-    }
-
-    QJsonParseError parseError{};
-    const QJsonDocument doc = QJsonDocument::fromJson(responseLine, &parseError);
-    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-        return QStringLiteral("No watchpoint signals (daemon not running?)");
-    }
-
-    const QJsonObject obj = doc.object();
-    if (obj.contains("error")) {
-        return QStringLiteral("No watchpoint signals (daemon not running?)");
+    QString summary;
+    if (!result.contains("signals")) {
+        summary = QStringLiteral("No watchpoint signals (daemon not running?)");
+    } else if (result.value("signals").toArray().isEmpty()) {
+        summary = QStringLiteral("No watchpoint signals today");
+    } else {
+        const QJsonArray watchSignals = result.value("signals").toArray();
+        QStringList lines;
+        const int maxSignals = 5;
+        for (int i = watchSignals.size() - 1; i >= 0 && lines.size() < maxSignals; --i) {
+            const QJsonObject signal = watchSignals.at(i).toObject();
+            const QString timestamp = signal.value("timestamp").toString();
+            const QDateTime when = QDateTime::fromString(timestamp, Qt::ISODate);
+            const QString timeLabel = when.isValid()
+                ? when.toLocalTime().toString("HH:mm")
+                : QStringLiteral("??:??");
+            const QString ruleName = signal.value("ruleName").toString();
+            const QString severity = signal.value("severity").toString();
+            const QString message = signal.value("message").toString();
+
+            lines << QStringLiteral("%1 [%2] %3 - %4")
+                .arg(timeLabel, severity, ruleName, message);
+        }
+        summary = lines.join('\n');
     }
 
-    const QJsonObject result = obj.value("result").toObject();
-    const QJsonArray watchSignals = result.value("signals").toArray();
-    if (watchSignals.isEmpty()) {
-        return QStringLiteral("No watchpoint signals today");
-    }
+    m_trayIcon.showMessage(QStringLiteral("Khronicle - Watchpoint Signals"),
+                           summary,
+                           QSystemTrayIcon::Information);
+}
 
-    QStringList lines;
-    const int maxSignals = 5;
-    for (int i = watchSignals.size() - 1; i >= 0 && lines.size() < maxSignals; --i) {
-        const QJsonObject signal = watchSignals.at(i).toObject();
-        const QString timestamp = signal.value("timestamp").toString();
-        const QDateTime when = QDateTime::fromString(timestamp, Qt::ISODate);
-        const QString timeLabel = when.isValid()
-            ? when.toLocalTime().toString("HH:mm")
-            : QStringLiteral("??:??");
-        const QString ruleName = signal.value("ruleName").toString();
-        const QString severity = signal.value("severity").toString();
-        const QString message = signal.value("message").toString();
-
-        lines << QStringLiteral("%1 [%2] %3 - %4")
-            .arg(timeLabel, severity, ruleName, message);
+QString KhronicleTray::summaryText() const
+{
+    QString text = m_lastSummaryText;
+    if (m_criticalSignals > 0) {
+        text += QStringLiteral(" (%1 critical watchpoint hit)").arg(m_criticalSignals);
     }
-
-    return lines.join('\n');
+    return text;
 }
 
-QString KhronicleTray::socketPath() const
+void KhronicleTray::onSummaryUpdated()
 {
-    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
-    if (!runtimeDir.isEmpty()) {
-        return runtimeDir + QStringLiteral("/khronicle.sock");
+    m_trayIcon.setToolTip(QStringLiteral("Khronicle - ") + summaryText());
+    if (m_summaryPopupPending) {
+        m_summaryPopupPending = false;
+        showSummaryPopup();
     }
-    return QStringLiteral("/run/user/%1/khronicle.sock").arg(getuid());
 }
 
-void KhronicleTray::updateDaemonActions()
+void KhronicleTray::updateDaemonActions(bool running)
 {
-    const bool running = khronicle::isDaemonRunning();
     if (m_daemonStatusAction) {
         m_daemonStatusAction->setText(
             running ? QStringLiteral("Daemon: Running")
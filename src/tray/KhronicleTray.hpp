@@ -1,10 +1,15 @@
 #pragma once
 
+#include <QHash>
+#include <QJsonObject>
 #include <QObject>
 #include <QSystemTrayIcon>
 #include <QMenu>
 #include <QTimer>
 
+#include "common/request_trace.hpp"
+#include "ui/backend/DaemonConnection.hpp"
+
 // KhronicleTray provides a minimal tray UI for quick, local summaries.
 class KhronicleTray : public QObject
 {
@@ -22,6 +27,15 @@ private slots:
     void onTrayActivated(QSystemTrayIcon::ActivationReason reason);
 
 private:
+    struct PendingRequest {
+        QString method;
+        khronicle::RequestTrace trace;
+    };
+
+    // One persistent connection; every request below is asynchronous.
+    khronicle::DaemonConnection m_connection;
+    QHash<int, PendingRequest> m_pending;
+
     QSystemTrayIcon m_trayIcon;
     QMenu m_menu;
     QAction *m_refreshAction = nullptr;
@@ -34,14 +48,23 @@ private:
     QTimer m_refreshTimer;
 
     QString m_lastSummaryText;
+    int m_criticalSignals = 0;
+    bool m_summaryPopupPending = false;
 
     void setupTrayIcon();
     void setupMenu();
     void scheduleRefresh();
-    void updateDaemonActions();
+    void updateDaemonActions(bool running);
+    // Summary plus today's critical signal count, for tooltip and popup.
+    QString summaryText() const;
+    void onSummaryUpdated();
+
+    void sendRequest(const QString &method, const QJsonObject &params);
+    void requestCriticalCount();
+    void onResponse(const khronicle::DecodedResponse &response);
+    void onNotification(const QString &method, const QJsonObject &params);
 
-    QString requestSummarySinceToday();
-    int requestCriticalWatchSignalsSinceToday();
-    QString requestWatchSignalsSinceToday();
-    QString socketPath() const;
+    void handleSummary(const QJsonObject &result);
+    void handleCriticalCount(const QJsonObject &result);
+    void handleWatchSignals(const QJsonObject &result);
 };
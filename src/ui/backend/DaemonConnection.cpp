@@ -0,0 +1,244 @@
+#include "ui/backend/DaemonConnection.hpp"
+
+#include <QJsonDocument>
+
+#include <algorithm>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+#include "common/logging.hpp"
+#include "common/process_utils.hpp"
+
+namespace khronicle {
+
+DaemonConnection::DaemonConnection(QObject *parent)
+    : QObject(parent)
+    , m_socket(new QLocalSocket(this))
+    , m_decoder(new ResponseDecoder(this))
+{
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, [this] {
+        if (m_socket->state() == QLocalSocket::UnconnectedState) {
+            m_socket->connectToServer(daemonSocketPath());
+        }
+    });
+    connect(m_socket, &QLocalSocket::connected, this, &DaemonConnection::onConnected);
+    connect(m_socket, &QLocalSocket::disconnected, this, &DaemonConnection::onDisconnected);
+    connect(m_socket, &QLocalSocket::errorOccurred, this, &DaemonConnection::onSocketError);
+    connect(m_socket, &QLocalSocket::readyRead, this, [this] {
+        m_decoder->feed(m_socket->readAll());
+    });
+    connect(m_decoder, &ResponseDecoder::decoded, this, &DaemonConnection::onDecoded);
+}
+
+DaemonConnection::~DaemonConnection() = default;
+
+bool DaemonConnection::isConnected() const
+{
+    return m_connected;
+}
+
+void DaemonConnection::connectToDaemon()
+{
+    m_wanted = true;
+    if (m_socket->state() != QLocalSocket::UnconnectedState) {
+        return;
+    }
+    m_reconnectTimer.stop();
+    m_socket->connectToServer(daemonSocketPath());
+}
+
+int DaemonConnection::send(const QString &method,
+                           const QJsonObject &params,
+                           const RequestTrace &trace,
+                           const QString &view,
+                           ResponseDecoder::Converter converter)
+{
+    const int id = m_nextRequestId++;
+
+    QString coalesceKey;
+    if (!view.isEmpty()) {
+        coalesceKey = method + QLatin1Char('\n') + view + QLatin1Char('\n')
+            + QString::fromUtf8(QJsonDocument(params).toJson(QJsonDocument::Compact));
+        // Only the newest request of a view may take followers; an older
+        // one is superseded and its answer will be dropped.
+        const auto existing = m_byCoalesceKey.constFind(coalesceKey);
+        if (existing != m_byCoalesceKey.constEnd()
+            && m_latestByView.value(view, -1) == *existing) {
+            m_inFlight[*existing].followers.push_back(id);
+            KLOG_DEBUG(QStringLiteral("DaemonConnection"),
+                       QStringLiteral("send"),
+                       QStringLiteral("api_request_coalesced"),
+                       QStringLiteral("duplicate_in_flight"),
+                       QStringLiteral("json_rpc"),
+                       logging::defaultWho(),
+                       trace.id,
+                       (nlohmann::json{{"method", method.toStdString()},
+                                      {"id", id},
+                                      {"wireId", *existing}}));
+            return id;
+        }
+        m_byCoalesceKey.insert(coalesceKey, id);
+        m_latestByView.insert(view, id);
+    }
+
+    QJsonObject root;
+    root["id"] = id;
+    root["method"] = method;
+    root["params"] = params;
+    root["trace"] = requestTraceJson(trace);
+
+    WireRequest request;
+    request.id = id;
+    request.method = method;
+    request.view = view;
+    request.coalesceKey = coalesceKey;
+    request.payload = QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
+
+    m_decoder->expect(id, view, std::move(converter));
+    m_inFlight.insert(id, request);
+    m_order.push_back(id);
+
+    if (m_connected) {
+        write(request);
+    } else {
+        // Written by onConnected.
+        connectToDaemon();
+    }
+    return id;
+}
+
+void DaemonConnection::subscribe(const QString &method, const QJsonObject &params)
+{
+    m_subscriptions.push_back({method, params});
+    if (m_connected) {
+        sendSubscription(method, params);
+    } else {
+        connectToDaemon();
+    }
+}
+
+void DaemonConnection::sendSubscription(const QString &method, const QJsonObject &params)
+{
+    // Not tracked in m_inFlight: a lost acknowledgement is covered by the
+    // re-send on the next connect, so it is never replayed.
+    QJsonObject root;
+    root["id"] = m_nextRequestId++;
+    root["method"] = method;
+    root["params"] = params;
+    root["trace"] = requestTraceJson(startRequestTrace());
+    m_socket->write(QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n');
+    m_socket->flush();
+}
+
+void DaemonConnection::onConnected()
+{
+    m_connected = true;
+    m_errorReported = false;
+    m_reconnectDelay = kMinReconnectDelay;
+
+    KLOG_INFO(QStringLiteral("DaemonConnection"),
+              QStringLiteral("onConnected"),
+              QStringLiteral("daemon_connected"),
+              QStringLiteral("socket_connected"),
+              QStringLiteral("local_socket"),
+              logging::defaultWho(),
+              QString(),
+              (nlohmann::json{{"socketPath", daemonSocketPath().toStdString()},
+                             {"replayed", m_order.size()}}));
+
+    // Queued requests and those lost with the previous connection, in the
+    // order they were first sent.
+    for (const int id : std::as_const(m_order)) {
+        write(m_inFlight.value(id));
+    }
+    for (const auto &subscription : std::as_const(m_subscriptions)) {
+        sendSubscription(subscription.first, subscription.second);
+    }
+    emit connectedChanged(true);
+}
+
+void DaemonConnection::onDisconnected()
+{
+    // Half a response from the old connection must not prefix the first
+    // response on the next one.
+    m_decoder->discardPartialLine();
+    if (m_connected) {
+        m_connected = false;
+        emit connectedChanged(false);
+    }
+    scheduleReconnect();
+}
+
+void DaemonConnection::onSocketError(QLocalSocket::LocalSocketError error)
+{
+    Q_UNUSED(error)
+    if (!m_errorReported) {
+        m_errorReported = true;
+        KLOG_WARN(QStringLiteral("DaemonConnection"),
+                  QStringLiteral("onSocketError"),
+                  QStringLiteral("daemon_connection_error"),
+                  QStringLiteral("socket_error"),
+                  QStringLiteral("local_socket"),
+                  logging::defaultWho(),
+                  QString(),
+                  (nlohmann::json{{"error", m_socket->errorString().toStdString()},
+                                 {"pending", m_order.size()}}));
+        emit errorOccurred(m_socket->errorString());
+    }
+    if (m_socket->state() == QLocalSocket::UnconnectedState) {
+        // A failed connect attempt emits no disconnected().
+        scheduleReconnect();
+    }
+}
+
+void DaemonConnection::onDecoded(const DecodedResponse &response)
+{
+    if (!response.notification.isEmpty()) {
+        emit notificationReceived(response.notification, response.result);
+        return;
+    }
+    if (response.id < 0) {
+        emit errorOccurred(response.error);
+        return;
+    }
+    const auto it = m_inFlight.find(response.id);
+    if (it == m_inFlight.end()) {
+        return;
+    }
+    const WireRequest request = it.value();
+    m_inFlight.erase(it);
+    m_order.removeOne(request.id);
+    if (!request.coalesceKey.isEmpty()
+        && m_byCoalesceKey.value(request.coalesceKey, -1) == request.id) {
+        m_byCoalesceKey.remove(request.coalesceKey);
+    }
+    if (!request.view.isEmpty() && m_latestByView.value(request.view, -1) == request.id) {
+        m_latestByView.remove(request.view);
+    }
+
+    emit responseReady(response);
+    for (const int follower : request.followers) {
+        DecodedResponse copy = response;
+        copy.id = follower;
+        emit responseReady(copy);
+    }
+}
+
+void DaemonConnection::scheduleReconnect()
+{
+    if (!m_wanted || m_reconnectTimer.isActive()) {
+        return;
+    }
+    m_reconnectTimer.start(m_reconnectDelay);
+    m_reconnectDelay = std::min(m_reconnectDelay * 2, kMaxReconnectDelay);
+}
+
+void DaemonConnection::write(const WireRequest &request)
+{
+    m_socket->write(request.payload);
+    m_socket->flush();
+}
+
+} // namespace khronicle
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QLocalSocket>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QTimer>
+
+#include <chrono>
+
+#include "common/request_trace.hpp"
+#include "ui/backend/ResponseDecoder.hpp"
+
+namespace khronicle {
+
+// The UI process's one connection to the daemon, shared by
+// KhronicleApiClient, WatchClient and DaemonController.
+//
+// - Requests sent before the socket is up are queued and written on
+//   connect; requests still unanswered when the connection drops are
+//   replayed after the automatic reconnect (every API method is a read or
+//   an idempotent write, so replay is safe).
+// - Reconnects back off exponentially from kMinReconnectDelay to
+//   kMaxReconnectDelay.
+// - Responses are framed by newline and decoded off the GUI thread by a
+//   ResponseDecoder.
+// - A read sent while an identical one (same method, params and view) is
+//   in flight is coalesced onto it: one request goes to the daemon and
+//   both ids get the answer.
+// - Subscriptions (subscribe_watch_signals, ...) are re-sent on every
+//   connect, and the daemon's pushes arrive as notificationReceived.
+//
+// Request ids are unique across the process, so every client can listen to
+// responseReady and pick out its own ids.
+class DaemonConnection : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr std::chrono::milliseconds kMinReconnectDelay{250};
+    static constexpr std::chrono::milliseconds kMaxReconnectDelay{10000};
+
+    explicit DaemonConnection(QObject *parent = nullptr);
+    ~DaemonConnection() override;
+
+    bool isConnected() const;
+
+    // Starts connecting (and reconnecting after drops) if not already.
+    // Also cuts short a pending backoff, e.g. right after starting the
+    // daemon.
+    void connectToDaemon();
+
+    // Sends or queues a request and returns its id. A non-empty view marks
+    // a read that feeds one view: it may be coalesced, and it supersedes
+    // the previous request for the same view (see ResponseDecoder).
+    int send(const QString &method,
+             const QJsonObject &params,
+             const RequestTrace &trace,
+             const QString &view = QString(),
+             ResponseDecoder::Converter converter = {});
+
+    // Sends a subscribe request now (if connected) and after every
+    // reconnect; the daemon forgets subscriptions with the connection.
+    void subscribe(const QString &method, const QJsonObject &params);
+
+signals:
+    void connectedChanged(bool connected);
+    // One per request id, including coalesced ones.
+    void responseReady(const khronicle::DecodedResponse &response);
+    // An id-less push from the daemon.
+    void notificationReceived(const QString &method, const QJsonObject &params);
+    // Connection failures (once per outage, not per retry) and responses
+    // that are not valid JSON.
+    void errorOccurred(const QString &message);
+
+private:
+    struct WireRequest {
+        int id = 0;
+        QString method;
+        QString view;
+        QString coalesceKey;
+        QByteArray payload;
+        // Later ids answered by this request.
+        QList<int> followers;
+    };
+
+    void onConnected();
+    void onDisconnected();
+    void onSocketError(QLocalSocket::LocalSocketError error);
+    void onDecoded(const DecodedResponse &response);
+    void scheduleReconnect();
+    void write(const WireRequest &request);
+    void sendSubscription(const QString &method, const QJsonObject &params);
+
+    QLocalSocket *m_socket;
+    ResponseDecoder *m_decoder;
+    QTimer m_reconnectTimer;
+    std::chrono::milliseconds m_reconnectDelay = kMinReconnectDelay;
+    bool m_wanted = false;
+    bool m_connected = false;
+    bool m_errorReported = false;
+    int m_nextRequestId = 1;
+    // Sent or queued, by wire id, plus the write order for replay.
+    QHash<int, WireRequest> m_inFlight;
+    QList<int> m_order;
+    QHash<QString, int> m_byCoalesceKey;
+    QHash<QString, int> m_latestByView;
+    QList<QPair<QString, QJsonObject>> m_subscriptions;
+};
+
+} // namespace khronicle
@@ -1,16 +1,22 @@
 #include "ui/backend/DaemonController.hpp"
 
+#include <QProcess>
+
 #include "common/logging.hpp"
 #include "common/process_utils.hpp"
+#include "ui/backend/DaemonConnection.hpp"
 
 #include <nlohmann/json.hpp>
 
 namespace khronicle {
 
-DaemonController::DaemonController(QObject *parent)
+DaemonController::DaemonController(DaemonConnection *connection, QObject *parent)
     : QObject(parent)
+    , m_connection(connection)
+    , m_daemonRunning(connection->isConnected())
 {
-    refreshDaemonStatus();
+    connect(m_connection, &DaemonConnection::connectedChanged,
+            this, &DaemonController::onConnectedChanged);
 }
 
 bool DaemonController::daemonRunning() const
@@ -18,19 +24,90 @@ bool DaemonController::daemonRunning() const
     return m_daemonRunning;
 }
 
-void DaemonController::refreshDaemonStatus()
+void DaemonController::connectOnStartup(bool startTray)
+{
+    m_startTrayOnConnect = startTray;
+    if (m_connection->isConnected()) {
+        onConnectedChanged(true);
+        return;
+    }
+
+    // The connection reports a failure once per outage, so the first one
+    // after startup means nothing is listening on the socket.
+    m_startupFailure = connect(m_connection, &DaemonConnection::errorOccurred, this, [this] {
+        disconnect(m_startupFailure);
+        if (m_connection->isConnected()) {
+            return;
+        }
+        KLOG_INFO(QStringLiteral("DaemonController"),
+                  QStringLiteral("connectOnStartup"),
+                  QStringLiteral("auto_start_daemon"),
+                  QStringLiteral("ui_start"),
+                  QStringLiteral("best_effort"),
+                  khronicle::logging::defaultWho(),
+                  QString(),
+                  nlohmann::json::object());
+        startDaemon();
+        // Retries back off from here until the daemon is listening.
+        m_connection->connectToDaemon();
+    });
+    m_connection->connectToDaemon();
+}
+
+void DaemonController::onConnectedChanged(bool connected)
 {
-    const bool running = isDaemonRunning();
-    if (running != m_daemonRunning) {
-        m_daemonRunning = running;
+    if (connected) {
+        disconnect(m_startupFailure);
+    }
+    if (connected != m_daemonRunning) {
+        m_daemonRunning = connected;
         emit daemonRunningChanged();
     }
+    if (connected && m_startTrayOnConnect) {
+        m_startTrayOnConnect = false;
+        startTrayIfMissing();
+    }
+}
+
+void DaemonController::startTrayIfMissing()
+{
+    // Same check as isTrayRunning(), without waiting on pgrep.
+    auto *pgrep = new QProcess(this);
+    const auto start = [pgrep] {
+        pgrep->deleteLater();
+        KLOG_INFO(QStringLiteral("DaemonController"),
+                  QStringLiteral("startTrayIfMissing"),
+                  QStringLiteral("auto_start_tray"),
+                  QStringLiteral("ui_start"),
+                  QStringLiteral("best_effort"),
+                  khronicle::logging::defaultWho(),
+                  QString(),
+                  nlohmann::json::object());
+        startTray();
+    };
+    connect(pgrep, &QProcess::finished, this,
+            [pgrep, start](int exitCode, QProcess::ExitStatus status) {
+                if (status == QProcess::NormalExit && exitCode == 0) {
+                    pgrep->deleteLater();
+                    return;
+                }
+                start();
+            });
+    connect(pgrep, &QProcess::errorOccurred, this, [start](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            start();
+        }
+    });
+    pgrep->start(QStringLiteral("pgrep"),
+                 {QStringLiteral("-x"), QStringLiteral("khronicle-tray")});
 }
 
 bool DaemonController::startDaemonFromUi()
 {
     const bool result = startDaemon();
-    refreshDaemonStatus();
+    // Skip whatever is left of the reconnect backoff; daemonRunning flips
+    // when the connection comes up.
+    m_connection->connectToDaemon();
     KLOG_INFO(QStringLiteral("DaemonController"),
               QStringLiteral("startDaemonFromUi"),
               QStringLiteral("start_daemon"),
@@ -44,8 +121,8 @@ bool DaemonController::startDaemonFromUi()
 
 bool DaemonController::stopDaemonFromUi()
 {
+    // daemonRunning flips when the daemon closes the socket.
     const bool result = stopDaemon();
-    refreshDaemonStatus();
     KLOG_INFO(QStringLiteral("DaemonController"),
               QStringLiteral("stopDaemonFromUi"),
               QStringLiteral("stop_daemon"),
@@ -1,19 +1,30 @@
 #pragma once
 
+#include <QMetaObject>
 #include <QObject>
 
 namespace khronicle {
 
+class DaemonConnection;
+
+// Start/stop controls and liveness for the daemon. daemonRunning follows
+// the shared DaemonConnection: the socket closing is the daemon's
+// "stopped" notification and the connection's own reconnect loop notices
+// when it comes back, so nothing here polls or blocks the GUI thread.
 class DaemonController : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool daemonRunning READ daemonRunning NOTIFY daemonRunningChanged)
 public:
-    explicit DaemonController(QObject *parent = nullptr);
+    explicit DaemonController(DaemonConnection *connection, QObject *parent = nullptr);
 
     bool daemonRunning() const;
 
-    Q_INVOKABLE void refreshDaemonStatus();
+    // Startup path for the UI: connects, starts the daemon if the first
+    // attempt finds nothing listening, and once connected starts the tray
+    // when startTray is set and no tray is running. Returns immediately.
+    void connectOnStartup(bool startTray);
+
     Q_INVOKABLE bool startDaemonFromUi();
     Q_INVOKABLE bool stopDaemonFromUi();
     Q_INVOKABLE bool startTrayFromUi();
@@ -22,7 +33,13 @@ signals:
     void daemonRunningChanged();
 
 private:
+    void onConnectedChanged(bool connected);
+    void startTrayIfMissing();
+
+    DaemonConnection *m_connection;
     bool m_daemonRunning = false;
+    bool m_startTrayOnConnect = false;
+    QMetaObject::Connection m_startupFailure;
 };
 
 } // namespace khronicle
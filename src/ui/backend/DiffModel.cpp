@@ -0,0 +1,77 @@
+#include "ui/backend/DiffModel.hpp"
+
+#include <QVariantMap>
+
+#include "common/diff_labels.hpp"
+
+namespace khronicle {
+
+DiffModel::DiffModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int DiffModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+QVariant DiffModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0
+        || index.row() >= static_cast<int>(m_rows.size())) {
+        return {};
+    }
+
+    const Row &row = m_rows[static_cast<std::size_t>(index.row())];
+    switch (role) {
+    case PathRole:
+        return row.path;
+    case Qt::DisplayRole:
+    case LabelRole:
+        return row.label;
+    case BeforeRole:
+        return row.before;
+    case AfterRole:
+        return row.after;
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> DiffModel::roleNames() const
+{
+    return {
+        {PathRole, "path"},
+        {LabelRole, "label"},
+        {BeforeRole, "before"},
+        {AfterRole, "after"}
+    };
+}
+
+int DiffModel::count() const
+{
+    return static_cast<int>(m_rows.size());
+}
+
+void DiffModel::setRows(const QVariantList &rows)
+{
+    std::vector<Row> converted;
+    converted.reserve(static_cast<std::size_t>(rows.size()));
+    for (const QVariant &value : rows) {
+        const QVariantMap map = value.toMap();
+        Row row;
+        row.path = map.value("path").toString();
+        row.label = QString::fromStdString(humanizeDiffPath(row.path.toStdString()));
+        row.before = map.value("before").toString();
+        row.after = map.value("after").toString();
+        converted.push_back(std::move(row));
+    }
+
+    beginResetModel();
+    m_rows = std::move(converted);
+    endResetModel();
+    emit countChanged();
+}
+
+} // namespace khronicle
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVariantList>
+
+#include <vector>
+
+namespace khronicle {
+
+// Rows of a snapshot diff for DiffView's ListView. Paths are turned into
+// display labels once when the rows are set, so a full-inventory diff with
+// thousands of rows costs only the delegates on screen.
+class DiffModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+public:
+    enum Role {
+        PathRole = Qt::UserRole + 1,
+        LabelRole,
+        BeforeRole,
+        AfterRole
+    };
+
+    explicit DiffModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+
+    // Replaces the rows with diff_snapshots maps (path, before, after).
+    Q_INVOKABLE void setRows(const QVariantList &rows);
+
+signals:
+    void countChanged();
+
+private:
+    struct Row {
+        QString path;
+        QString label;
+        QString before;
+        QString after;
+    };
+
+    std::vector<Row> m_rows;
+};
+
+} // namespace khronicle
@@ -0,0 +1,357 @@
+#include "ui/backend/FleetAggregateLoader.hpp"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+#include "common/json_utils.hpp"
+
+namespace khronicle {
+
+namespace {
+
+// Forward iterator over the mapped file that records how far the parser
+// has read, for progress reporting from the parser callback.
+class ProgressIterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char *;
+    using reference = const char &;
+
+    ProgressIterator(const char *position, const char **reached)
+        : m_position(position)
+        , m_reached(reached)
+    {
+    }
+
+    reference operator*() const { return *m_position; }
+
+    ProgressIterator &operator++()
+    {
+        *m_reached = ++m_position;
+        return *this;
+    }
+
+    ProgressIterator operator++(int)
+    {
+        ProgressIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    bool operator==(const ProgressIterator &other) const
+    {
+        return m_position == other.m_position;
+    }
+    bool operator!=(const ProgressIterator &other) const { return !(*this == other); }
+
+private:
+    const char *m_position;
+    const char **m_reached;
+};
+
+struct LoadCancelled {
+};
+
+std::string stringField(const nlohmann::json &object, const char *key)
+{
+    const auto it = object.find(key);
+    return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+}
+
+QVariant toVariant(const nlohmann::json &value)
+{
+    const QJsonDocument doc =
+        QJsonDocument::fromJson(QByteArray::fromStdString(value.dump()));
+    if (doc.isObject()) {
+        return doc.object().toVariantMap();
+    }
+    if (doc.isArray()) {
+        return doc.array().toVariantList();
+    }
+    return {};
+}
+
+QString displayNameForHost(const QVariantMap &host)
+{
+    const QString displayName = host.value("displayName").toString();
+    if (!displayName.isEmpty()) {
+        return displayName;
+    }
+    const QString hostname = host.value("hostname").toString();
+    if (!hostname.isEmpty()) {
+        return hostname;
+    }
+    return host.value("hostId").toString();
+}
+
+// A host between its opening brace and its closing one: events are moved
+// out of the JSON tree as they complete.
+struct PendingHost {
+    std::vector<FleetEvent> events;
+    std::vector<std::pair<qint64, int>> timed;
+    std::vector<FleetPackageChange> history;
+    bool kernelChanged = false;
+    QString kernelFrom;
+    QString kernelTo;
+    int gpuEvents = 0;
+    int firmwareEvents = 0;
+};
+
+void addEvent(PendingHost &host, const nlohmann::json &object)
+{
+    FleetEvent event;
+    event.id = stringField(object, "id");
+    event.timestamp = stringField(object, "timestamp");
+    event.category = parseCategoryString(stringField(object, "category"));
+    event.source = parseSourceString(stringField(object, "source"));
+    event.summary = stringField(object, "summary");
+    event.details = stringField(object, "details");
+
+    const auto before = object.find("beforeState");
+    const auto after = object.find("afterState");
+    if (before != object.end() && !before->is_null()) {
+        event.beforeState = before->dump();
+    }
+    if (after != object.end() && !after->is_null()) {
+        event.afterState = after->dump();
+    }
+    const auto related = object.find("relatedPackages");
+    if (related != object.end() && related->is_array()) {
+        for (const auto &package : *related) {
+            if (package.is_string()) {
+                event.relatedPackages.push_back(package.get<std::string>());
+            }
+        }
+    }
+
+    const QDateTime timestamp =
+        QDateTime::fromString(QString::fromStdString(event.timestamp), Qt::ISODate);
+    if (timestamp.isValid()) {
+        host.timed.emplace_back(timestamp.toMSecsSinceEpoch(),
+                                static_cast<int>(host.events.size()));
+    }
+
+    if (auto change = FleetIndex::historyEntryFromEvent(object)) {
+        host.history.push_back(std::move(*change));
+    }
+
+    // SummaryBar figures.
+    switch (event.category) {
+    case EventCategory::Kernel: {
+        host.kernelChanged = true;
+        const std::string from = before != object.end() && before->is_object()
+            ? stringField(*before, "kernelVersion")
+            : std::string();
+        const std::string to = after != object.end() && after->is_object()
+            ? stringField(*after, "kernelVersion")
+            : std::string();
+        if (host.kernelFrom.isEmpty()) {
+            host.kernelFrom = QString::fromStdString(from);
+        }
+        if (!to.empty()) {
+            host.kernelTo = QString::fromStdString(to);
+        }
+        break;
+    }
+    case EventCategory::GpuDriver:
+        ++host.gpuEvents;
+        break;
+    case EventCategory::Firmware:
+        ++host.firmwareEvents;
+        break;
+    default:
+        break;
+    }
+
+    host.events.push_back(std::move(event));
+}
+
+void finishHost(FleetAggregate &aggregate, PendingHost &pending, const nlohmann::json &object)
+{
+    const auto identityValue = object.find("hostIdentity");
+    if (identityValue == object.end() || !identityValue->is_object()) {
+        return;
+    }
+    FleetHost host;
+    host.identity = toVariant(*identityValue).toMap();
+    host.hostId = host.identity.value("hostId").toString();
+    if (host.hostId.isEmpty()) {
+        return;
+    }
+    host.identity["label"] = displayNameForHost(host.identity);
+
+    const auto snapshots = object.find("snapshots");
+    if (snapshots != object.end() && snapshots->is_array()) {
+        host.snapshots = toVariant(*snapshots).toList();
+    }
+
+    // The events were already taken out of the tree, so this only reads
+    // the latest snapshot.
+    FleetHostState state = FleetIndex::hostStateFromJson(object);
+    state.history = std::move(pending.history);
+    aggregate.index.addHost(state);
+
+    // Ties keep file order.
+    std::stable_sort(pending.timed.begin(), pending.timed.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    host.epochMs.reserve(pending.timed.size());
+    host.byTime.reserve(pending.timed.size());
+    for (const auto &[epochMs, eventIndex] : pending.timed) {
+        host.epochMs.push_back(epochMs);
+        host.byTime.push_back(eventIndex);
+    }
+
+    if (!pending.events.empty()) {
+        host.summary["kernelChanged"] = pending.kernelChanged;
+        host.summary["kernelFrom"] = pending.kernelFrom;
+        host.summary["kernelTo"] = pending.kernelTo;
+        host.summary["gpuEvents"] = pending.gpuEvents;
+        host.summary["firmwareEvents"] = pending.firmwareEvents;
+        host.summary["totalEvents"] = static_cast<int>(pending.events.size());
+    }
+    host.events = std::move(pending.events);
+    aggregate.hosts.push_back(std::move(host));
+}
+
+QVariantMap stateToVariantMap(const std::string &json)
+{
+    if (json.empty()) {
+        return {};
+    }
+    return QJsonDocument::fromJson(QByteArray::fromStdString(json)).object().toVariantMap();
+}
+
+} // namespace
+
+QVariantMap fleetEventToVariantMap(const FleetEvent &event, const QString &hostId)
+{
+    QVariantList related;
+    related.reserve(static_cast<qsizetype>(event.relatedPackages.size()));
+    for (const auto &package : event.relatedPackages) {
+        related.push_back(QString::fromStdString(package));
+    }
+
+    QVariantMap map;
+    map["id"] = QString::fromStdString(event.id);
+    map["timestamp"] = QString::fromStdString(event.timestamp);
+    map["category"] = QString::fromStdString(toCategoryString(event.category));
+    map["source"] = QString::fromStdString(toSourceString(event.source));
+    map["summary"] = QString::fromStdString(event.summary);
+    map["details"] = QString::fromStdString(event.details);
+    map["beforeState"] = stateToVariantMap(event.beforeState);
+    map["afterState"] = stateToVariantMap(event.afterState);
+    map["relatedPackages"] = related;
+    map["hostId"] = hostId;
+    return map;
+}
+
+FleetAggregate loadFleetAggregate(const QString &path,
+                                  const std::function<bool(int percent)> &progress)
+{
+    FleetAggregate aggregate;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        aggregate.error = QStringLiteral("Failed to open aggregate file");
+        return aggregate;
+    }
+    QByteArray buffer;
+    const char *begin = nullptr;
+    qint64 size = file.size();
+    if (uchar *mapped = size > 0 ? file.map(0, size) : nullptr) {
+        begin = reinterpret_cast<const char *>(mapped);
+    } else {
+        // Not mappable (a pipe, an empty file): read it instead.
+        buffer = file.readAll();
+        begin = buffer.constData();
+        size = buffer.size();
+    }
+    const char *end = begin + size;
+
+    const char *reached = begin;
+    int reportedPercent = -1;
+    bool inHosts = false;
+    std::string section;
+    PendingHost pending;
+
+    const nlohmann::json::parser_callback_t callback =
+        [&](int depth, nlohmann::json::parse_event_t event, nlohmann::json &parsed) {
+            if (progress && size > 0) {
+                const int percent = static_cast<int>((reached - begin) * 100 / size);
+                if (percent != reportedPercent) {
+                    reportedPercent = percent;
+                    if (!progress(percent)) {
+                        throw LoadCancelled{};
+                    }
+                }
+            }
+
+            // {"hosts": [ {"hostIdentity", "events": [ {...} ], "snapshots"} ]}
+            // depth:  1     2               3          4
+            switch (event) {
+            case nlohmann::json::parse_event_t::key:
+                if (depth == 1) {
+                    inHosts = parsed == "hosts";
+                } else if (depth == 3 && parsed.is_string()) {
+                    section = parsed.get<std::string>();
+                }
+                return true;
+            case nlohmann::json::parse_event_t::object_start:
+                if (inHosts && depth == 2) {
+                    pending = PendingHost();
+                    section.clear();
+                }
+                return true;
+            case nlohmann::json::parse_event_t::object_end:
+                if (inHosts && depth == 4 && section == "events") {
+                    addEvent(pending, parsed);
+                    return false;
+                }
+                if (inHosts && depth == 2) {
+                    finishHost(aggregate, pending, parsed);
+                    return false;
+                }
+                return true;
+            default:
+                return true;
+            }
+        };
+
+    const auto failed = [](const QString &error) {
+        FleetAggregate result;
+        result.error = error;
+        return result;
+    };
+    try {
+        const nlohmann::json root = nlohmann::json::parse(ProgressIterator(begin, &reached),
+                                                          ProgressIterator(end, &reached),
+                                                          callback);
+        if (!root.is_object()) {
+            return failed(QStringLiteral("Invalid aggregate JSON"));
+        }
+    } catch (const LoadCancelled &) {
+        return failed(QStringLiteral("Aggregate loading cancelled"));
+    } catch (const nlohmann::json::exception &) {
+        return failed(QStringLiteral("Invalid aggregate JSON"));
+    }
+
+    if (progress) {
+        progress(100);
+    }
+    return aggregate;
+}
+
+} // namespace khronicle
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common/enums.hpp"
+#include "common/fleet_index.hpp"
+
+namespace khronicle {
+
+// One event of a fleet host, kept compact until QML asks for it: text as
+// UTF-8, before/after state as its JSON text.
+struct FleetEvent {
+    std::string id;
+    std::string timestamp;
+    EventCategory category = EventCategory::System;
+    EventSource source = EventSource::Other;
+    std::string summary;
+    std::string details;
+    std::string beforeState;
+    std::string afterState;
+    std::vector<std::string> relatedPackages;
+};
+
+struct FleetHost {
+    QString hostId;
+    // hostIdentity plus a display "label".
+    QVariantMap identity;
+    // In file order.
+    std::vector<FleetEvent> events;
+    // events ordered by time: epochMs[i] is the timestamp of
+    // events[byTime[i]]. Events without a parseable timestamp are left out.
+    std::vector<qint64> epochMs;
+    std::vector<int> byTime;
+    QVariantList snapshots;
+    // SummaryBar's fields, computed while parsing.
+    QVariantMap summary;
+};
+
+struct FleetAggregate {
+    std::vector<FleetHost> hosts;
+    // Host ordinals follow `hosts`.
+    FleetIndex index;
+    // Set when the file could not be loaded; hosts is then empty.
+    QString error;
+};
+
+// The QML row for an event, in the shape the aggregate file uses.
+QVariantMap fleetEventToVariantMap(const FleetEvent &event, const QString &hostId);
+
+// Loads an aggregate written by `khronicle-report aggregate --format json`.
+// The file is memory-mapped and parsed one event at a time, so only the
+// current event's JSON tree is alive at once. Runs on any thread. progress
+// gets 0-100 as the parser moves through the file; returning false from it
+// stops the load.
+FleetAggregate loadFleetAggregate(const QString &path,
+                                  const std::function<bool(int percent)> &progress = {});
+
+} // namespace khronicle
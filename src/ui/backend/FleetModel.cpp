@@ -1,106 +1,132 @@
 #include "ui/backend/FleetModel.hpp"
 
-#include <QDateTime>
-#include <QFile>
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QPromise>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+#include "common/json_utils.hpp"
 
 namespace khronicle {
 
 namespace {
 
-QVariantList jsonArrayToVariantList(const QJsonValue &value)
+// Rows for the events of host at byTime positions [begin, end).
+QVariantList rowsByTime(const FleetHost &host, std::size_t begin, std::size_t end)
 {
-    QVariantList list;
-    if (!value.isArray()) {
-        return list;
+    QVariantList rows;
+    rows.reserve(static_cast<qsizetype>(end - begin));
+    for (std::size_t i = begin; i < end; ++i) {
+        rows.push_back(fleetEventToVariantMap(
+            host.events[static_cast<std::size_t>(host.byTime[i])], host.hostId));
     }
-    const QJsonArray array = value.toArray();
-    list.reserve(array.size());
-    for (const QJsonValue &item : array) {
-        list.push_back(item.toObject().toVariantMap());
-    }
-    return list;
+    return rows;
 }
 
-QString displayNameForHost(const QVariantMap &host)
+std::size_t firstAtOrAfter(const FleetHost &host, std::size_t from, qint64 epochMs)
 {
-    const QString displayName = host.value("displayName").toString();
-    if (!displayName.isEmpty()) {
-        return displayName;
-    }
-    const QString hostname = host.value("hostname").toString();
-    if (!hostname.isEmpty()) {
-        return hostname;
-    }
-    return host.value("hostId").toString();
+    return static_cast<std::size_t>(
+        std::lower_bound(host.epochMs.begin() + static_cast<std::ptrdiff_t>(from),
+                         host.epochMs.end(), epochMs)
+        - host.epochMs.begin());
 }
 
 } // namespace
 
 FleetModel::FleetModel(QObject *parent)
     : QObject(parent)
+    , m_hostEvents(new FleetTimelineModel(this))
+    , m_timeline(new FleetTimelineModel(this))
 {
 }
 
 void FleetModel::loadAggregateFile(const QString &path)
 {
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) {
-        emit errorOccurred(QStringLiteral("Failed to open aggregate file"));
-        return;
+    const bool wasLoading = loading();
+    if (m_loadWatcher) {
+        // Superseded: stop it at its next progress step and drop its result.
+        m_loadWatcher->disconnect(this);
+        m_loadWatcher->cancel();
+        m_loadWatcher->deleteLater();
     }
+    auto *watcher = new QFutureWatcher<FleetAggregate>(this);
+    m_loadWatcher = watcher;
+    connect(watcher, &QFutureWatcherBase::progressValueChanged,
+            this, &FleetModel::setLoadProgress);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        m_loadWatcher = nullptr;
+        watcher->deleteLater();
+        onLoadFinished(watcher->future().takeResult());
+    });
+
+    setLoadProgress(0);
+    if (!wasLoading) {
+        emit loadingChanged();
+    }
+    // Parsing and conversion stay off the GUI thread; the watcher hands
+    // the finished aggregate back on it.
+    watcher->setFuture(QtConcurrent::run([path](QPromise<FleetAggregate> &promise) {
+        promise.setProgressRange(0, 100);
+        promise.addResult(loadFleetAggregate(path, [&promise](int percent) {
+            promise.setProgressValue(percent);
+            return !promise.isCanceled();
+        }));
+    }));
+}
 
-    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    if (!doc.isObject()) {
-        emit errorOccurred(QStringLiteral("Invalid aggregate JSON"));
+void FleetModel::onLoadFinished(FleetAggregate aggregate)
+{
+    setLoadProgress(100);
+    emit loadingChanged();
+    if (!aggregate.error.isEmpty()) {
+        emit errorOccurred(aggregate.error);
         return;
     }
 
-    const QJsonObject root = doc.object();
-    const QJsonArray hostsArray = root.value("hosts").toArray();
-
+    // Both lists point into m_hostData: detach them before replacing it.
+    m_hostEvents->setHosts(nullptr);
+    m_timeline->setHosts(nullptr);
     m_hosts.clear();
-    m_eventsByHost.clear();
-    m_snapshotsByHost.clear();
-
-    for (const QJsonValue &hostValue : hostsArray) {
-        if (!hostValue.isObject()) {
-            continue;
-        }
-        const QJsonObject hostObj = hostValue.toObject();
-        const QJsonObject identity = hostObj.value("hostIdentity").toObject();
-
-        QVariantMap hostMap = identity.toVariantMap();
-        const QString hostId = hostMap.value("hostId").toString();
-        if (hostId.isEmpty()) {
-            continue;
-        }
-
-        hostMap["label"] = displayNameForHost(hostMap);
-        m_hosts.push_back(hostMap);
-
-        m_eventsByHost.insert(hostId, jsonArrayToVariantList(hostObj.value("events")));
-        m_snapshotsByHost.insert(hostId, jsonArrayToVariantList(hostObj.value("snapshots")));
+    m_hostRows.clear();
+    m_hostData = std::move(aggregate.hosts);
+    m_index = std::move(aggregate.index);
+    m_hosts.reserve(static_cast<qsizetype>(m_hostData.size()));
+    for (std::size_t row = 0; row < m_hostData.size(); ++row) {
+        m_hosts.push_back(m_hostData[row].identity);
+        m_hostRows.insert(m_hostData[row].hostId, static_cast<int>(row));
     }
+    m_timeline->setHosts(&m_hostData);
 
     emit hostsChanged();
 
-    if (!m_hosts.isEmpty()) {
-        setSelectedHostId(m_hosts.first().toMap().value("hostId").toString());
+    // Select again even when the id is unchanged: its data was replaced.
+    m_selectedHostId.clear();
+    if (!m_hostData.empty()) {
+        setSelectedHostId(m_hostData.front().hostId);
     } else {
-        m_selectedHostId.clear();
-        m_currentEvents.clear();
         m_currentSnapshots.clear();
         m_currentSummary.clear();
         emit selectedHostChanged();
-        emit eventsChanged();
         emit snapshotsChanged();
         emit summaryChanged();
     }
 }
 
+void FleetModel::setLoadProgress(int percent)
+{
+    if (percent == m_loadProgress) {
+        return;
+    }
+    m_loadProgress = percent;
+    emit loadProgressChanged();
+}
+
+const FleetHost *FleetModel::hostData(const QString &hostId) const
+{
+    const auto row = m_hostRows.constFind(hostId);
+    return row == m_hostRows.cend() ? nullptr : &m_hostData[static_cast<std::size_t>(*row)];
+}
+
 void FleetModel::setSelectedHostId(const QString &hostId)
 {
     if (hostId == m_selectedHostId) {
@@ -113,48 +139,113 @@ void FleetModel::setSelectedHostId(const QString &hostId)
 
 QVariantList FleetModel::compareHostsLast24h(const QString &hostIdA,
                                              const QString &hostIdB) const
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    return compareHosts(hostIdA, hostIdB, now.addSecs(-24 * 3600), now, 3600);
+}
+
+QVariantList FleetModel::compareHosts(const QString &hostIdA,
+                                      const QString &hostIdB,
+                                      const QDateTime &from,
+                                      const QDateTime &to,
+                                      int bucketSeconds) const
 {
     QVariantList buckets;
-    if (!m_eventsByHost.contains(hostIdA) || !m_eventsByHost.contains(hostIdB)) {
+    const FleetHost *hostA = hostData(hostIdA);
+    const FleetHost *hostB = hostData(hostIdB);
+    if (!hostA || !hostB || !from.isValid() || !to.isValid() || from >= to
+        || bucketSeconds <= 0) {
         return buckets;
     }
 
-    const QDateTime now = QDateTime::currentDateTimeUtc();
-    const QDateTime cutoff = now.addSecs(-24 * 3600);
-
-    for (int hour = 0; hour < 24; ++hour) {
-        const QDateTime bucketStart = cutoff.addSecs(hour * 3600);
-        const QDateTime bucketEnd = bucketStart.addSecs(3600);
+    const qint64 fromMs = from.toMSecsSinceEpoch();
+    const qint64 toMs = to.toMSecsSinceEpoch();
+    const qint64 bucketMs = static_cast<qint64>(bucketSeconds) * 1000;
+    const qint64 bucketCount = (toMs - fromMs + bucketMs - 1) / bucketMs;
+    if (bucketCount > kMaxBuckets) {
+        return buckets;
+    }
+    buckets.reserve(static_cast<qsizetype>(bucketCount));
+
+    // Each host is walked once: every bucket starts where the previous one
+    // ended and only its end is searched for.
+    std::size_t startA = firstAtOrAfter(*hostA, 0, fromMs);
+    std::size_t startB = firstAtOrAfter(*hostB, 0, fromMs);
+    for (qint64 bucket = 0; bucket < bucketCount; ++bucket) {
+        const qint64 bucketStartMs = fromMs + bucket * bucketMs;
+        const qint64 bucketEndMs = std::min(bucketStartMs + bucketMs, toMs);
+        const std::size_t endA = firstAtOrAfter(*hostA, startA, bucketEndMs);
+        const std::size_t endB = firstAtOrAfter(*hostB, startB, bucketEndMs);
+
+        QVariantMap row;
+        row["timeBucket"] =
+            QDateTime::fromMSecsSinceEpoch(bucketStartMs).toUTC().toString(Qt::ISODate);
+        row["hostAEvents"] = rowsByTime(*hostA, startA, endA);
+        row["hostBEvents"] = rowsByTime(*hostB, startB, endB);
+        buckets.push_back(row);
+        startA = endA;
+        startB = endB;
+    }
 
-        QVariantList hostAEvents;
-        QVariantList hostBEvents;
+    return buckets;
+}
 
-        const auto eventsA = m_eventsByHost.value(hostIdA);
-        const auto eventsB = m_eventsByHost.value(hostIdB);
+QVariantList FleetModel::eventsBetween(const QString &hostId,
+                                       const QDateTime &from,
+                                       const QDateTime &to) const
+{
+    const FleetHost *host = hostData(hostId);
+    if (!host || !from.isValid() || !to.isValid()) {
+        return {};
+    }
+    const std::size_t begin = firstAtOrAfter(*host, 0, from.toMSecsSinceEpoch());
+    const std::size_t end =
+        std::max(begin, firstAtOrAfter(*host, begin, to.toMSecsSinceEpoch()));
+    return rowsByTime(*host, begin, end);
+}
 
-        for (const QVariant &eventVar : eventsA) {
-            const QVariantMap event = eventVar.toMap();
-            const QDateTime ts = QDateTime::fromString(event.value("timestamp").toString(), Qt::ISODate);
-            if (ts >= bucketStart && ts < bucketEnd) {
-                hostAEvents.push_back(eventVar);
-            }
+QVariantList FleetModel::fleetQuery(const QStringList &installed,
+                                    const QStringList &received,
+                                    const QString &sinceIso) const
+{
+    FleetQuery query;
+    for (const QString &text : installed) {
+        if (const auto term = parseFleetQueryTerm(FleetQueryTerm::Kind::Installed,
+                                                  text.trimmed().toStdString())) {
+            query.terms.push_back(*term);
         }
-        for (const QVariant &eventVar : eventsB) {
-            const QVariantMap event = eventVar.toMap();
-            const QDateTime ts = QDateTime::fromString(event.value("timestamp").toString(), Qt::ISODate);
-            if (ts >= bucketStart && ts < bucketEnd) {
-                hostBEvents.push_back(eventVar);
-            }
+    }
+    for (const QString &text : received) {
+        if (const auto term = parseFleetQueryTerm(FleetQueryTerm::Kind::Received,
+                                                  text.trimmed().toStdString())) {
+            query.terms.push_back(*term);
         }
+    }
+    if (!sinceIso.isEmpty()) {
+        query.since = fromIso8601Utc(sinceIso.toStdString());
+    }
 
-        QVariantMap bucket;
-        bucket["timeBucket"] = bucketStart.toString(Qt::ISODate);
-        bucket["hostAEvents"] = hostAEvents;
-        bucket["hostBEvents"] = hostBEvents;
-        buckets.push_back(bucket);
+    QVariantList matches;
+    for (const std::size_t host : m_index.query(query).members()) {
+        QVariantMap hostMap = m_hosts.value(static_cast<int>(host)).toMap();
+        QVariantMap versions;
+        for (const auto &term : query.terms) {
+            versions.insert(QString::fromStdString(term.packageName),
+                            QString::fromStdString(
+                                m_index.installedVersion(host, term.packageName)));
+        }
+        hostMap["installed"] = versions;
+        matches.push_back(hostMap);
     }
+    return matches;
+}
 
-    return buckets;
+void FleetModel::setTimelineFilter(const QStringList &categories,
+                                   const QStringList &packages,
+                                   const QDateTime &from,
+                                   const QDateTime &to)
+{
+    m_timeline->setFilter(categories, packages, from, to);
 }
 
 QVariantList FleetModel::hosts() const
@@ -162,9 +253,9 @@ QVariantList FleetModel::hosts() const
     return m_hosts;
 }
 
-QVariantList FleetModel::events() const
+FleetTimelineModel *FleetModel::events() const
 {
-    return m_currentEvents;
+    return m_hostEvents;
 }
 
 QVariantList FleetModel::snapshots() const
@@ -182,57 +273,36 @@ QString FleetModel::selectedHostId() const
     return m_selectedHostId;
 }
 
-void FleetModel::updateSelectedHostData()
+bool FleetModel::loading() const
 {
-    m_currentEvents = m_eventsByHost.value(m_selectedHostId);
-    m_currentSnapshots = m_snapshotsByHost.value(m_selectedHostId);
-    m_currentSummary = buildSummary(m_currentEvents);
+    return m_loadWatcher != nullptr;
+}
 
-    emit eventsChanged();
-    emit snapshotsChanged();
-    emit summaryChanged();
+int FleetModel::loadProgress() const
+{
+    return m_loadProgress;
 }
 
-QVariantMap FleetModel::buildSummary(const QVariantList &events) const
-{
-    QVariantMap summary;
-    if (events.isEmpty()) {
-        return summary;
-    }
-
-    int gpuEvents = 0;
-    int firmwareEvents = 0;
-    bool kernelChanged = false;
-    QString kernelFrom;
-    QString kernelTo;
-
-    for (const QVariant &eventVar : events) {
-        const QVariantMap event = eventVar.toMap();
-        const QString category = event.value("category").toString();
-        if (category == "kernel") {
-            kernelChanged = true;
-            const QVariantMap beforeState = event.value("beforeState").toMap();
-            const QVariantMap afterState = event.value("afterState").toMap();
-            if (kernelFrom.isEmpty()) {
-                kernelFrom = beforeState.value("kernelVersion").toString();
-            }
-            if (!afterState.value("kernelVersion").toString().isEmpty()) {
-                kernelTo = afterState.value("kernelVersion").toString();
-            }
-        } else if (category == "gpu_driver") {
-            gpuEvents++;
-        } else if (category == "firmware") {
-            firmwareEvents++;
-        }
+FleetTimelineModel *FleetModel::timeline() const
+{
+    return m_timeline;
+}
+
+void FleetModel::updateSelectedHostData()
+{
+    m_currentSnapshots.clear();
+    m_currentSummary.clear();
+    // The selected host's events are merged a batch at a time like the
+    // fleet timeline; a row becomes a map only when a delegate asks.
+    const int row = m_hostRows.value(m_selectedHostId, -1);
+    m_hostEvents->setHosts(row >= 0 ? &m_hostData : nullptr, row);
+    if (const FleetHost *host = hostData(m_selectedHostId)) {
+        m_currentSnapshots = host->snapshots;
+        m_currentSummary = host->summary;
     }
 
-    summary["kernelChanged"] = kernelChanged;
-    summary["kernelFrom"] = kernelFrom;
-    summary["kernelTo"] = kernelTo;
-    summary["gpuEvents"] = gpuEvents;
-    summary["firmwareEvents"] = firmwareEvents;
-    summary["totalEvents"] = events.size();
-    return summary;
+    emit snapshotsChanged();
+    emit summaryChanged();
 }
 
 } // namespace khronicle
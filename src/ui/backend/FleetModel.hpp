@@ -1,54 +1,114 @@
 #pragma once
 
 #include <QObject>
+#include <QDateTime>
+#include <QFutureWatcher>
 #include <QVariantList>
 #include <QVariantMap>
 #include <QHash>
 
+#include <vector>
+
+#include "common/fleet_index.hpp"
+#include "ui/backend/FleetAggregateLoader.hpp"
+#include "ui/backend/FleetTimelineModel.hpp"
+
 namespace khronicle {
 
+// Fleet mode's view of an aggregate file. The file is parsed on a worker
+// thread (loading/loadProgress report it) into compact per-host events,
+// indexed by time, so range and bucket queries are binary searches. Events
+// become QVariantMaps only for query results and for the rows a view asks
+// for: `events` lists the selected host's events oldest first, and
+// `timeline` merges every host's events into one list for reviewing a
+// rollout across the fleet.
 class FleetModel : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QVariantList hosts READ hosts NOTIFY hostsChanged)
-    Q_PROPERTY(QVariantList events READ events NOTIFY eventsChanged)
+    Q_PROPERTY(khronicle::FleetTimelineModel *events READ events CONSTANT)
     Q_PROPERTY(QVariantList snapshots READ snapshots NOTIFY snapshotsChanged)
     Q_PROPERTY(QVariantMap summary READ summary NOTIFY summaryChanged)
     Q_PROPERTY(QString selectedHostId READ selectedHostId NOTIFY selectedHostChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+    Q_PROPERTY(int loadProgress READ loadProgress NOTIFY loadProgressChanged)
+    Q_PROPERTY(khronicle::FleetTimelineModel *timeline READ timeline CONSTANT)
 
 public:
+    static constexpr int kMaxBuckets = 10000;
+
     explicit FleetModel(QObject *parent = nullptr);
 
+    // Starts loading in the background and returns at once; hostsChanged
+    // (or errorOccurred) follows. A newer call replaces one still running.
     Q_INVOKABLE void loadAggregateFile(const QString &path);
     Q_INVOKABLE void setSelectedHostId(const QString &hostId);
+    // compareHosts over the last 24 hours in one-hour buckets.
     Q_INVOKABLE QVariantList compareHostsLast24h(const QString &hostIdA,
                                                  const QString &hostIdB) const;
+    // Both hosts' events in [from, to), split into consecutive buckets of
+    // bucketSeconds: [{timeBucket, hostAEvents, hostBEvents}, ...]. Empty
+    // when a host is unknown, the range is empty or it would need more than
+    // kMaxBuckets buckets.
+    Q_INVOKABLE QVariantList compareHosts(const QString &hostIdA,
+                                          const QString &hostIdB,
+                                          const QDateTime &from,
+                                          const QDateTime &to,
+                                          int bucketSeconds) const;
+    // One host's events in [from, to), oldest first.
+    Q_INVOKABLE QVariantList eventsBetween(const QString &hostId,
+                                           const QDateTime &from,
+                                           const QDateTime &to) const;
+    // Hosts matching every term: `installed` terms ("name" or "name=version")
+    // must be present now, `received` terms must appear in the package
+    // history (on or after sinceIso when given).
+    Q_INVOKABLE QVariantList fleetQuery(const QStringList &installed,
+                                        const QStringList &received,
+                                        const QString &sinceIso) const;
+    // Restarts `timeline` with events of the given categories that touch
+    // one of packages, in [from, to). Empty lists and invalid times do not
+    // filter.
+    Q_INVOKABLE void setTimelineFilter(const QStringList &categories,
+                                       const QStringList &packages,
+                                       const QDateTime &from,
+                                       const QDateTime &to);
 
     QVariantList hosts() const;
-    QVariantList events() const;
+    FleetTimelineModel *events() const;
     QVariantList snapshots() const;
     QVariantMap summary() const;
     QString selectedHostId() const;
+    bool loading() const;
+    // 0-100 through the file being loaded.
+    int loadProgress() const;
+    FleetTimelineModel *timeline() const;
 
 signals:
     void hostsChanged();
-    void eventsChanged();
     void snapshotsChanged();
     void summaryChanged();
     void selectedHostChanged();
+    void loadingChanged();
+    void loadProgressChanged();
     void errorOccurred(const QString &message);
 
 private:
+    void onLoadFinished(FleetAggregate aggregate);
+    void setLoadProgress(int percent);
+    const FleetHost *hostData(const QString &hostId) const;
     void updateSelectedHostData();
-    QVariantMap buildSummary(const QVariantList &events) const;
 
     QVariantList m_hosts;
-    QHash<QString, QVariantList> m_eventsByHost;
-    QHash<QString, QVariantList> m_snapshotsByHost;
+    std::vector<FleetHost> m_hostData;
+    QHash<QString, int> m_hostRows;
+    FleetIndex m_index;
     QString m_selectedHostId;
-    QVariantList m_currentEvents;
     QVariantList m_currentSnapshots;
     QVariantMap m_currentSummary;
+    FleetTimelineModel *m_hostEvents;
+    FleetTimelineModel *m_timeline;
+    QFutureWatcher<FleetAggregate> *m_loadWatcher = nullptr;
+    int m_loadProgress = 0;
 };
 
 } // namespace khronicle
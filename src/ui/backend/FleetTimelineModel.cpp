@@ -0,0 +1,273 @@
+#include "ui/backend/FleetTimelineModel.hpp"
+
+#include <QTimer>
+
+#include <algorithm>
+
+#include "common/json_utils.hpp"
+
+namespace khronicle {
+
+namespace {
+
+// std::push_heap and friends build a max-heap; ordering by "comes later"
+// puts the earliest cursor on top.
+struct MergesLater {
+    template <typename Cursor>
+    bool operator()(const Cursor &a, const Cursor &b) const
+    {
+        if (a.epochMs != b.epochMs) {
+            return a.epochMs > b.epochMs;
+        }
+        return a.host > b.host;
+    }
+};
+
+std::size_t firstAtOrAfter(const FleetHost &host, qint64 epochMs)
+{
+    return static_cast<std::size_t>(
+        std::lower_bound(host.epochMs.begin(), host.epochMs.end(), epochMs)
+        - host.epochMs.begin());
+}
+
+} // namespace
+
+FleetTimelineModel::FleetTimelineModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int FleetTimelineModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+QVariant FleetTimelineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0
+        || index.row() >= static_cast<int>(m_rows.size())) {
+        return {};
+    }
+
+    const Row &row = m_rows[static_cast<std::size_t>(index.row())];
+    const FleetHost &host = (*m_hosts)[static_cast<std::size_t>(row.host)];
+    const FleetEvent &event = eventAt(row);
+    switch (role) {
+    case HostIdRole:
+        return host.hostId;
+    case HostLabelRole:
+        return host.identity.value("label");
+    case IdRole:
+        return QString::fromStdString(event.id);
+    case TimestampRole:
+        return QString::fromStdString(event.timestamp);
+    case CategoryRole:
+        return QString::fromStdString(toCategoryString(event.category));
+    case SourceRole:
+        return QString::fromStdString(toSourceString(event.source));
+    case Qt::DisplayRole:
+    case SummaryRole:
+        return QString::fromStdString(event.summary);
+    case DetailsRole:
+        return QString::fromStdString(event.details);
+    case RelatedPackagesRole: {
+        QStringList packages;
+        packages.reserve(static_cast<qsizetype>(event.relatedPackages.size()));
+        for (const auto &package : event.relatedPackages) {
+            packages.push_back(QString::fromStdString(package));
+        }
+        return packages;
+    }
+    case EventDataRole:
+        return get(index.row());
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> FleetTimelineModel::roleNames() const
+{
+    return {
+        {HostIdRole, "hostId"},
+        {HostLabelRole, "hostLabel"},
+        {IdRole, "id"},
+        {TimestampRole, "timestamp"},
+        {CategoryRole, "category"},
+        {SourceRole, "source"},
+        {SummaryRole, "summary"},
+        {DetailsRole, "details"},
+        {RelatedPackagesRole, "relatedPackages"},
+        {EventDataRole, "eventData"}
+    };
+}
+
+bool FleetTimelineModel::canFetchMore(const QModelIndex &parent) const
+{
+    // While a scan is still owed rows it is already fetching.
+    return !parent.isValid() && !m_heap.empty() && m_wanted == 0;
+}
+
+void FleetTimelineModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    m_wanted = kBatchSize;
+    scanStep();
+}
+
+int FleetTimelineModel::count() const
+{
+    return static_cast<int>(m_rows.size());
+}
+
+void FleetTimelineModel::setHosts(const std::vector<FleetHost> *hosts, int onlyHost)
+{
+    m_hosts = hosts;
+    m_onlyHost = onlyHost;
+    restart();
+}
+
+void FleetTimelineModel::setFilter(const QStringList &categories,
+                                   const QStringList &packages,
+                                   const QDateTime &from,
+                                   const QDateTime &to)
+{
+    m_categories.clear();
+    for (const QString &category : categories) {
+        m_categories.push_back(parseCategoryString(category.toStdString()));
+    }
+    m_packages.clear();
+    for (const QString &package : packages) {
+        m_packages.push_back(package.toStdString());
+    }
+    m_from = from;
+    m_to = to;
+    restart();
+}
+
+QVariantMap FleetTimelineModel::get(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_rows.size())) {
+        return {};
+    }
+    const Row &entry = m_rows[static_cast<std::size_t>(row)];
+    const FleetHost &host = (*m_hosts)[static_cast<std::size_t>(entry.host)];
+    QVariantMap map = fleetEventToVariantMap(eventAt(entry), host.hostId);
+    map["hostLabel"] = host.identity.value("label");
+    return map;
+}
+
+void FleetTimelineModel::restart()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_heap.clear();
+    if (m_hosts) {
+        // One cursor per host, placed on the window with two binary searches.
+        const bool hasFrom = m_from.isValid();
+        const bool hasTo = m_to.isValid();
+        const qint64 fromMs = hasFrom ? m_from.toMSecsSinceEpoch() : 0;
+        const qint64 toMs = hasTo ? m_to.toMSecsSinceEpoch() : 0;
+        m_heap.reserve(m_hosts->size());
+        for (std::size_t i = 0; i < m_hosts->size(); ++i) {
+            if (m_onlyHost >= 0 && static_cast<int>(i) != m_onlyHost) {
+                continue;
+            }
+            const FleetHost &host = (*m_hosts)[i];
+            Cursor cursor;
+            cursor.host = static_cast<int>(i);
+            cursor.position = hasFrom ? firstAtOrAfter(host, fromMs) : 0;
+            cursor.end = hasTo ? firstAtOrAfter(host, toMs) : host.epochMs.size();
+            if (cursor.position < cursor.end) {
+                cursor.epochMs = host.epochMs[cursor.position];
+                m_heap.push_back(cursor);
+            }
+        }
+        std::make_heap(m_heap.begin(), m_heap.end(), MergesLater());
+    }
+
+    endResetModel();
+    emit countChanged();
+
+    m_wanted = kBatchSize;
+    scanStep();
+}
+
+void FleetTimelineModel::scanStep()
+{
+    if (m_wanted <= 0) {
+        return;
+    }
+    std::vector<Row> rows;
+    merge(rows, m_wanted, kScanStep);
+    m_wanted -= static_cast<int>(rows.size());
+    if (m_heap.empty()) {
+        m_wanted = 0;
+    }
+    if (!rows.empty()) {
+        const int first = static_cast<int>(m_rows.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(rows.size()) - 1);
+        m_rows.insert(m_rows.end(), rows.begin(), rows.end());
+        endInsertRows();
+        emit countChanged();
+    }
+    if (m_wanted > 0 && !m_scanScheduled) {
+        // Let the event loop run before examining the next step. A restart
+        // in between leaves this pending step to continue the new scan.
+        m_scanScheduled = true;
+        QTimer::singleShot(0, this, [this] {
+            m_scanScheduled = false;
+            scanStep();
+        });
+    }
+}
+
+void FleetTimelineModel::merge(std::vector<Row> &rows, int limit, int scanLimit)
+{
+    // Filtered-out events are skipped here and count against scanLimit
+    // only, so a batch stops short only when the merge or the step runs out.
+    const std::size_t wanted = rows.size() + static_cast<std::size_t>(limit);
+    for (int scanned = 0; scanned < scanLimit && !m_heap.empty() && rows.size() < wanted;
+         ++scanned) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), MergesLater());
+        Cursor &cursor = m_heap.back();
+        const FleetHost &host = (*m_hosts)[static_cast<std::size_t>(cursor.host)];
+        const Row row{cursor.host, host.byTime[cursor.position]};
+        if (accepts(eventAt(row))) {
+            rows.push_back(row);
+        }
+
+        if (++cursor.position < cursor.end) {
+            cursor.epochMs = host.epochMs[cursor.position];
+            std::push_heap(m_heap.begin(), m_heap.end(), MergesLater());
+        } else {
+            m_heap.pop_back();
+        }
+    }
+}
+
+bool FleetTimelineModel::accepts(const FleetEvent &event) const
+{
+    if (!m_categories.empty()
+        && std::find(m_categories.begin(), m_categories.end(), event.category)
+            == m_categories.end()) {
+        return false;
+    }
+    if (m_packages.empty()) {
+        return true;
+    }
+    return std::any_of(event.relatedPackages.begin(), event.relatedPackages.end(),
+                       [this](const std::string &package) {
+                           return std::find(m_packages.begin(), m_packages.end(), package)
+                               != m_packages.end();
+                       });
+}
+
+const FleetEvent &FleetTimelineModel::eventAt(const Row &row) const
+{
+    const FleetHost &host = (*m_hosts)[static_cast<std::size_t>(row.host)];
+    return host.events[static_cast<std::size_t>(row.event)];
+}
+
+} // namespace khronicle
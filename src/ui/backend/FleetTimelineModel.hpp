@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <string>
+#include <vector>
+
+#include "common/enums.hpp"
+#include "ui/backend/FleetAggregateLoader.hpp"
+
+namespace khronicle {
+
+// Every host's events in one list, oldest first. Each host's events are
+// already sorted (FleetHost::byTime), so the list is a k-way merge: a heap
+// holds one cursor per host and each row costs O(log hosts). Rows are
+// merged a batch at a time as the view scrolls (canFetchMore/fetchMore)
+// and only point into the hosts' events until a delegate asks for a role.
+// A selective filter may skip many events per row; the scan then goes on in
+// steps of at most kScanStep events from the event loop, so the GUI thread
+// never walks the whole fleet at once.
+class FleetTimelineModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Role {
+        HostIdRole = Qt::UserRole + 1,
+        HostLabelRole,
+        IdRole,
+        TimestampRole,
+        CategoryRole,
+        SourceRole,
+        SummaryRole,
+        DetailsRole,
+        RelatedPackagesRole,
+        // The row as a map, in the shape FleetModel::events uses.
+        EventDataRole
+    };
+
+    static constexpr int kBatchSize = 200;
+    // Events examined per step, matching or not.
+    static constexpr int kScanStep = 5000;
+
+    explicit FleetTimelineModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    int count() const;
+
+    // The hosts to merge, owned by the caller and left untouched until the
+    // next call; nullptr clears the list. onlyHost >= 0 lists that host's
+    // events alone. Keeps the current filter.
+    void setHosts(const std::vector<FleetHost> *hosts, int onlyHost = -1);
+    // Restarts the merge with only events in one of categories (category
+    // strings) that touch one of packages, in [from, to). Empty lists and
+    // invalid times do not filter.
+    void setFilter(const QStringList &categories,
+                   const QStringList &packages,
+                   const QDateTime &from,
+                   const QDateTime &to);
+
+    // EventDataRole of a row; empty when out of range.
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+signals:
+    void countChanged();
+
+private:
+    struct Row {
+        int host = 0;
+        int event = 0;
+    };
+
+    // Next unmerged event of one host: byTime[position], up to end.
+    struct Cursor {
+        qint64 epochMs = 0;
+        int host = 0;
+        std::size_t position = 0;
+        std::size_t end = 0;
+    };
+
+    void restart();
+    // Merges up to m_wanted more rows, examining at most kScanStep events,
+    // and schedules the next step if rows are still owed.
+    void scanStep();
+    void merge(std::vector<Row> &rows, int limit, int scanLimit);
+    bool accepts(const FleetEvent &event) const;
+    const FleetEvent &eventAt(const Row &row) const;
+
+    const std::vector<FleetHost> *m_hosts = nullptr;
+    int m_onlyHost = -1;
+    std::vector<Row> m_rows;
+    // Min-heap on (epochMs, host): equal timestamps keep host order.
+    std::vector<Cursor> m_heap;
+    // Rows the view asked for that the scan has not found yet.
+    int m_wanted = 0;
+    bool m_scanScheduled = false;
+    std::vector<EventCategory> m_categories;
+    std::vector<std::string> m_packages;
+    QDateTime m_from;
+    QDateTime m_to;
+};
+
+} // namespace khronicle
@@ -1,14 +1,11 @@
 #include "ui/backend/KhronicleApiClient.hpp"
 
 #include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 
 #include <nlohmann/json.hpp>
 
-#include <unistd.h>
-
 #include "common/logging.hpp"
 
 namespace khronicle {
@@ -20,42 +17,201 @@ QString toIso8601Utc(const QDateTime &dt)
     return dt.toUTC().toString(Qt::ISODate);
 }
 
+QVariantList convertEventsJsonToVariantList(const QJsonValue &eventsValue)
+{
+    QVariantList events;
+    if (!eventsValue.isArray()) {
+        return events;
+    }
+
+    const QJsonArray array = eventsValue.toArray();
+    events.reserve(array.size());
+
+    for (const QJsonValue &value : array) {
+        if (!value.isObject()) {
+            continue;
+        }
+        const QJsonObject obj = value.toObject();
+
+        QVariantMap event;
+        event["id"] = obj.value("id").toString();
+        event["timestamp"] = obj.value("timestamp").toString();
+        event["category"] = obj.value("category").toString();
+        event["source"] = obj.value("source").toString();
+        event["summary"] = obj.value("summary").toString();
+        event["details"] = obj.value("details").toString();
+
+        if (obj.contains("relatedPackages") && obj.value("relatedPackages").isArray()) {
+            QVariantList related;
+            for (const QJsonValue &pkg : obj.value("relatedPackages").toArray()) {
+                related.push_back(pkg.toString());
+            }
+            event["relatedPackages"] = related;
+        }
+
+        events.push_back(event);
+    }
+
+    return events;
+}
+
+QVariantList convertSnapshotsJsonToVariantList(const QJsonValue &snapshotsValue)
+{
+    QVariantList snapshots;
+    if (!snapshotsValue.isArray()) {
+        return snapshots;
+    }
+
+    const QJsonArray array = snapshotsValue.toArray();
+    snapshots.reserve(array.size());
+
+    for (const QJsonValue &value : array) {
+        if (!value.isObject()) {
+            continue;
+        }
+        const QJsonObject obj = value.toObject();
+
+        QVariantMap snapshot;
+        snapshot["id"] = obj.value("id").toString();
+        snapshot["timestamp"] = obj.value("timestamp").toString();
+        snapshot["kernelVersion"] = obj.value("kernelVersion").toString();
+
+        if (obj.contains("keyPackages") && obj.value("keyPackages").isObject()) {
+            snapshot["keyPackages"] = obj.value("keyPackages").toObject().toVariantMap();
+        }
+
+        snapshots.push_back(snapshot);
+    }
+
+    return snapshots;
+}
+
+QVariantMap convertSummaryJsonToVariantMap(const QJsonValue &summaryValue)
+{
+    if (!summaryValue.isObject()) {
+        return {};
+    }
+
+    return summaryValue.toObject().toVariantMap();
+}
+
+QVariantList convertDiffJsonToVariantList(const QJsonValue &diffValue)
+{
+    QVariantList rows;
+    if (!diffValue.isObject()) {
+        return rows;
+    }
+
+    const QJsonObject diff = diffValue.toObject();
+    const QJsonValue changedFieldsValue = diff.value("changedFields");
+    if (!changedFieldsValue.isArray()) {
+        return rows;
+    }
+
+    const QJsonArray array = changedFieldsValue.toArray();
+    rows.reserve(array.size());
+
+    for (const QJsonValue &value : array) {
+        if (!value.isObject()) {
+            continue;
+        }
+        const QJsonObject obj = value.toObject();
+
+        QVariantMap row;
+        row["path"] = obj.value("path").toString();
+        row["before"] = obj.value("before").toString();
+        row["after"] = obj.value("after").toString();
+        rows.push_back(row);
+    }
+
+    return rows;
+}
+
+// The view a method feeds (a newer request for the same view supersedes an
+// older one) and how its result is converted for QML. Converters run on a
+// decoder worker thread.
+QString viewForMethod(const QString &method)
+{
+    if (method == "get_changes_since" || method == "get_changes_between") {
+        return QStringLiteral("changes");
+    }
+    if (method == "get_changes_page" || method == "get_changes_after_generation") {
+        return QStringLiteral("timeline");
+    }
+    if (method == "list_snapshots" || method == "get_snapshot") {
+        return QStringLiteral("snapshots");
+    }
+    if (method == "diff_snapshots") {
+        return QStringLiteral("diff");
+    }
+    if (method == "explain_change_between") {
+        return QStringLiteral("explanation");
+    }
+    if (method == "summary_since") {
+        return QStringLiteral("summary");
+    }
+    return QString();
+}
+
+ResponseDecoder::Converter converterForMethod(const QString &method)
+{
+    if (method == "get_changes_since" || method == "get_changes_between") {
+        return [](const QJsonObject &result) {
+            return QVariant(convertEventsJsonToVariantList(result.value("events")));
+        };
+    }
+    if (method == "list_snapshots") {
+        return [](const QJsonObject &result) {
+            return QVariant(convertSnapshotsJsonToVariantList(result.value("snapshots")));
+        };
+    }
+    if (method == "get_snapshot") {
+        return [](const QJsonObject &result) {
+            QJsonArray single;
+            if (result.contains("snapshot") && result.value("snapshot").isObject()) {
+                single.append(result.value("snapshot"));
+            }
+            return QVariant(convertSnapshotsJsonToVariantList(single));
+        };
+    }
+    if (method == "diff_snapshots") {
+        return [](const QJsonObject &result) {
+            return QVariant(convertDiffJsonToVariantList(result.value("diff")));
+        };
+    }
+    if (method == "summary_since") {
+        return [](const QJsonObject &result) {
+            return QVariant(convertSummaryJsonToVariantMap(result));
+        };
+    }
+    // get_changes_page hands its result object to TimelineModel as is;
+    // explain_change_between only needs one string.
+    return {};
+}
+
 } // namespace
 
-KhronicleApiClient::KhronicleApiClient(QObject *parent)
+KhronicleApiClient::KhronicleApiClient(DaemonConnection *connection, QObject *parent)
     : QObject(parent)
-    , m_socket(new QLocalSocket(this))
-    , m_nextRequestId(1)
+    , m_connection(connection)
 {
-    connect(m_socket, &QLocalSocket::connected,
-            this, &KhronicleApiClient::onSocketConnected);
-    connect(m_socket, &QLocalSocket::errorOccurred,
-            this, &KhronicleApiClient::onSocketError);
-    connect(m_socket, &QLocalSocket::readyRead,
-            this, &KhronicleApiClient::onSocketReadyRead);
+    connect(m_connection, &DaemonConnection::connectedChanged,
+            this, &KhronicleApiClient::connectedChanged);
+    connect(m_connection, &DaemonConnection::errorOccurred,
+            this, &KhronicleApiClient::errorOccurred);
+    connect(m_connection, &DaemonConnection::responseReady,
+            this, &KhronicleApiClient::onResponseDecoded);
 }
 
 KhronicleApiClient::~KhronicleApiClient() = default;
 
 void KhronicleApiClient::connectToDaemon()
 {
-    if (m_socket->state() == QLocalSocket::ConnectedState) {
-        if (!m_connected) {
-            m_connected = true;
-            emit connectedChanged(true);
-        }
+    if (m_connection->isConnected()) {
+        emit connectedChanged(true);
         return;
     }
-
-    KLOG_INFO(QStringLiteral("KhronicleApiClient"),
-              QStringLiteral("connectToDaemon"),
-              QStringLiteral("connect_daemon"),
-              QStringLiteral("ui_start"),
-              QStringLiteral("local_socket"),
-              logging::defaultWho(),
-              QString(),
-              (nlohmann::json{{"socketPath", socketPath().toStdString()}}));
-    m_socket->connectToServer(socketPath());
+    m_connection->connectToDaemon();
 }
 
 void KhronicleApiClient::loadChangesSince(const QDateTime &since)
@@ -104,72 +260,40 @@ void KhronicleApiClient::loadExplanationBetween(const QDateTime &from,
     sendRequest(QStringLiteral("explain_change_between"), params);
 }
 
-void KhronicleApiClient::onSocketConnected()
-{
-    m_connected = true;
-    emit connectedChanged(true);
-}
-
-void KhronicleApiClient::onSocketError(QLocalSocket::LocalSocketError error)
+int KhronicleApiClient::loadChangesPage(const QDateTime &from,
+                                        const QDateTime &to,
+                                        const QJsonObject &cursor,
+                                        int limit)
 {
-    Q_UNUSED(error)
-    m_connected = false;
-    emit connectedChanged(false);
-    emit errorOccurred(m_socket->errorString());
+    QJsonObject params;
+    params["from"] = toIso8601Utc(from);
+    params["to"] = toIso8601Utc(to);
+    params["limit"] = limit;
+    if (!cursor.isEmpty()) {
+        params["cursor"] = cursor;
+    }
+    return sendRequest(QStringLiteral("get_changes_page"), params);
 }
 
-void KhronicleApiClient::onSocketReadyRead()
+int KhronicleApiClient::loadChangesAfterGeneration(qint64 generation,
+                                                   const QDateTime &from,
+                                                   const QDateTime &to)
 {
-    const QByteArray payload = m_socket->readAll();
-    const QList<QByteArray> lines = payload.split('\n');
-
-    for (const QByteArray &line : lines) {
-        if (line.trimmed().isEmpty()) {
-            continue;
-        }
-
-        QJsonParseError parseError{};
-        const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
-        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-            emit errorOccurred(QStringLiteral("Invalid JSON response"));
-            continue;
-        }
-
-        handleResponse(doc.object());
-    }
+    QJsonObject params;
+    params["generation"] = generation;
+    params["from"] = toIso8601Utc(from);
+    params["to"] = toIso8601Utc(to);
+    return sendRequest(QStringLiteral("get_changes_after_generation"), params);
 }
 
-void KhronicleApiClient::sendRequest(const QString &method,
-                                    const QJsonObject &params)
+int KhronicleApiClient::sendRequest(const QString &method,
+                                   const QJsonObject &params)
 {
-    // Requests are newline-delimited JSON messages over a persistent local socket.
-    if (m_socket->state() != QLocalSocket::ConnectedState) {
-        connectToDaemon();
-        emit errorOccurred(QStringLiteral("Not connected to Khronicle daemon"));
-        KLOG_WARN(QStringLiteral("KhronicleApiClient"),
-                  QStringLiteral("sendRequest"),
-                  QStringLiteral("request_failed"),
-                  QStringLiteral("socket_disconnected"),
-                  QStringLiteral("local_socket"),
-                  logging::defaultWho(),
-                  QString(),
-                  (nlohmann::json{{"method", method.toStdString()}}));
-        return;
-    }
-
-    const int id = m_nextRequestId++;
-    QJsonObject root;
-    root["id"] = id;
-    root["method"] = method;
-    root["params"] = params;
-
-    const QByteArray payload =
-        QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
-
-    m_socket->write(payload);
-    m_socket->flush();
-
-    m_pending.insert(id, PendingRequest{method});
+    // Queued by the connection until the daemon is reachable.
+    const RequestTrace trace = startRequestTrace();
+    const int id = m_connection->send(method, params, trace,
+                                      viewForMethod(method), converterForMethod(method));
+    m_pending.insert(id, PendingRequest{method, trace});
 
     KLOG_DEBUG(QStringLiteral("KhronicleApiClient"),
                QStringLiteral("sendRequest"),
@@ -177,209 +301,87 @@ void KhronicleApiClient::sendRequest(const QString &method,
                QStringLiteral("ui_action"),
                QStringLiteral("json_rpc"),
                logging::defaultWho(),
-               QString(),
+               trace.id,
                (nlohmann::json{{"method", method.toStdString()},
                               {"id", id}}));
+    return id;
 }
 
-void KhronicleApiClient::handleResponse(const QJsonObject &obj)
+void KhronicleApiClient::onResponseDecoded(const DecodedResponse &response)
 {
     // Match responses to requests by id and emit QML-friendly signals.
-    const int id = obj.value("id").toInt(-1);
-    if (!m_pending.contains(id)) {
+    if (!m_pending.contains(response.id)) {
         return;
     }
 
+    const int id = response.id;
     const PendingRequest pending = m_pending.take(id);
 
-    if (obj.contains("error")) {
-        emit errorOccurred(obj.value("error").toString());
+    if (response.superseded) {
+        KLOG_DEBUG(QStringLiteral("KhronicleApiClient"),
+                   QStringLiteral("onResponseDecoded"),
+                   QStringLiteral("api_response_superseded"),
+                   QStringLiteral("newer_request"),
+                   QStringLiteral("json_rpc"),
+                   logging::defaultWho(),
+                   pending.trace.id,
+                   (nlohmann::json{{"method", pending.method.toStdString()},
+                                  {"id", id}}));
+        return;
+    }
+
+    if (!response.error.isEmpty()) {
+        emit errorOccurred(response.error);
+        emit requestFailed(id, response.error);
         KLOG_WARN(QStringLiteral("KhronicleApiClient"),
-                  QStringLiteral("handleResponse"),
+                  QStringLiteral("onResponseDecoded"),
                   QStringLiteral("api_request_error"),
                   QStringLiteral("daemon_error"),
                   QStringLiteral("json_rpc"),
                   logging::defaultWho(),
-                  QString(),
+                  pending.trace.id,
                   (nlohmann::json{{"method", pending.method.toStdString()},
                                  {"id", id}}));
         return;
     }
 
-    const QJsonValue resultValue = obj.value("result");
-    if (!resultValue.isObject()) {
-        emit errorOccurred(QStringLiteral("Malformed response result"));
+    logRequestLatency(QStringLiteral("KhronicleApiClient"), pending.method, pending.trace,
+                      response.response);
+
+    if (pending.method == "get_changes_since" || pending.method == "get_changes_between") {
+        emit changesLoaded(response.value.toList());
         return;
     }
 
-    const QJsonObject result = resultValue.toObject();
-
-    KLOG_DEBUG(QStringLiteral("KhronicleApiClient"),
-               QStringLiteral("handleResponse"),
-               QStringLiteral("api_request_completed"),
-               QStringLiteral("daemon_response"),
-               QStringLiteral("json_rpc"),
-               logging::defaultWho(),
-               QString(),
-               (nlohmann::json{{"method", pending.method.toStdString()},
-                              {"id", id}}));
-
-    if (pending.method == "get_changes_since" || pending.method == "get_changes_between") {
-        emit changesLoaded(convertEventsJsonToVariantList(result.value("events")));
+    if (pending.method == "get_changes_page") {
+        emit changesPageLoaded(id, response.result);
         return;
     }
 
-    if (pending.method == "list_snapshots") {
-        emit snapshotsLoaded(convertSnapshotsJsonToVariantList(result.value("snapshots")));
+    if (pending.method == "get_changes_after_generation") {
+        emit changesAfterGenerationLoaded(id, response.result);
         return;
     }
 
-    if (pending.method == "get_snapshot") {
-        QJsonArray single;
-        if (result.contains("snapshot") && result.value("snapshot").isObject()) {
-            single.append(result.value("snapshot"));
-        }
-        emit snapshotsLoaded(convertSnapshotsJsonToVariantList(single));
+    if (pending.method == "list_snapshots" || pending.method == "get_snapshot") {
+        emit snapshotsLoaded(response.value.toList());
         return;
     }
 
     if (pending.method == "diff_snapshots") {
-        emit diffLoaded(convertDiffJsonToVariantList(result.value("diff")));
+        emit diffLoaded(response.value.toList());
         return;
     }
 
     if (pending.method == "explain_change_between") {
-        emit explanationLoaded(result.value("summary").toString());
+        emit explanationLoaded(response.result.value("summary").toString());
         return;
     }
 
     if (pending.method == "summary_since") {
-        emit summaryLoaded(convertSummaryJsonToVariantMap(result));
+        emit summaryLoaded(response.value.toMap());
         return;
     }
 }
 
-QString KhronicleApiClient::socketPath() const
-{
-    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
-    if (!runtimeDir.isEmpty()) {
-        return runtimeDir + QStringLiteral("/khronicle.sock");
-    }
-    return QStringLiteral("/run/user/%1/khronicle.sock").arg(getuid());
-}
-
-QVariantList KhronicleApiClient::convertEventsJsonToVariantList(
-    const QJsonValue &eventsValue) const
-{
-    QVariantList events;
-    if (!eventsValue.isArray()) {
-        return events;
-    }
-
-    const QJsonArray array = eventsValue.toArray();
-    events.reserve(array.size());
-
-    for (const QJsonValue &value : array) {
-        if (!value.isObject()) {
-            continue;
-        }
-        const QJsonObject obj = value.toObject();
-
-        QVariantMap event;
-        event["id"] = obj.value("id").toString();
-        event["timestamp"] = obj.value("timestamp").toString();
-        event["category"] = obj.value("category").toString();
-        event["source"] = obj.value("source").toString();
-        event["summary"] = obj.value("summary").toString();
-        event["details"] = obj.value("details").toString();
-
-        if (obj.contains("relatedPackages") && obj.value("relatedPackages").isArray()) {
-            QVariantList related;
-            for (const QJsonValue &pkg : obj.value("relatedPackages").toArray()) {
-                related.push_back(pkg.toString());
-            }
-            event["relatedPackages"] = related;
-        }
-
-        events.push_back(event);
-    }
-
-    return events;
-}
-
-QVariantList KhronicleApiClient::convertSnapshotsJsonToVariantList(
-    const QJsonValue &snapshotsValue) const
-{
-    QVariantList snapshots;
-    if (!snapshotsValue.isArray()) {
-        return snapshots;
-    }
-
-    const QJsonArray array = snapshotsValue.toArray();
-    snapshots.reserve(array.size());
-
-    for (const QJsonValue &value : array) {
-        if (!value.isObject()) {
-            continue;
-        }
-        const QJsonObject obj = value.toObject();
-
-        QVariantMap snapshot;
-        snapshot["id"] = obj.value("id").toString();
-        snapshot["timestamp"] = obj.value("timestamp").toString();
-        snapshot["kernelVersion"] = obj.value("kernelVersion").toString();
-
-        if (obj.contains("keyPackages") && obj.value("keyPackages").isObject()) {
-            snapshot["keyPackages"] = obj.value("keyPackages").toObject().toVariantMap();
-        }
-
-        snapshots.push_back(snapshot);
-    }
-
-    return snapshots;
-}
-
-QVariantMap KhronicleApiClient::convertSummaryJsonToVariantMap(
-    const QJsonValue &summaryValue) const
-{
-    if (!summaryValue.isObject()) {
-        return {};
-    }
-
-    return summaryValue.toObject().toVariantMap();
-}
-
-QVariantList KhronicleApiClient::convertDiffJsonToVariantList(
-    const QJsonValue &diffValue) const
-{
-    QVariantList rows;
-    if (!diffValue.isObject()) {
-        return rows;
-    }
-
-    const QJsonObject diff = diffValue.toObject();
-    const QJsonValue changedFieldsValue = diff.value("changedFields");
-    if (!changedFieldsValue.isArray()) {
-        return rows;
-    }
-
-    const QJsonArray array = changedFieldsValue.toArray();
-    rows.reserve(array.size());
-
-    for (const QJsonValue &value : array) {
-        if (!value.isObject()) {
-            continue;
-        }
-        const QJsonObject obj = value.toObject();
-
-        QVariantMap row;
-        row["path"] = obj.value("path").toString();
-        row["before"] = obj.value("before").toString();
-        row["after"] = obj.value("after").toString();
-        rows.push_back(row);
-    }
-
-    return rows;
-}
-
 } // namespace khronicle
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <QObject>
-#include <QLocalSocket>
 #include <QDateTime>
 #include <QVariantList>
 #include <QVariantMap>
@@ -9,6 +8,10 @@
 #include <QJsonObject>
 #include <QJsonValue>
 
+#include "common/request_trace.hpp"
+#include "ui/backend/DaemonConnection.hpp"
+#include "ui/backend/ResponseDecoder.hpp"
+
 namespace khronicle {
 
 /**
@@ -16,16 +19,20 @@ namespace khronicle {
  * to communicate with the Khronicle daemon via the local JSON-RPC API.
  *
  * It exposes high-level, QML-friendly methods and emits signals with
- * QVariant-based data structures.
+ * QVariant-based data structures. Requests go through the shared
+ * DaemonConnection; responses are parsed and converted off the GUI thread,
+ * and a request for a view (changes, summary, snapshots, ...) supersedes
+ * any earlier one still in flight.
  */
 class KhronicleApiClient : public QObject
 {
     Q_OBJECT
 public:
-    explicit KhronicleApiClient(QObject *parent = nullptr);
+    explicit KhronicleApiClient(DaemonConnection *connection, QObject *parent = nullptr);
     ~KhronicleApiClient() override;
 
-    // Connect to /run/user/$UID/khronicle.sock and keep a QLocalSocket open.
+    // Starts the shared connection; connectedChanged(true) follows, right
+    // away when it is already up.
     Q_INVOKABLE void connectToDaemon();
 
     // API calls exposed to QML (fire-and-forget, results via signals).
@@ -36,11 +43,28 @@ public:
     Q_INVOKABLE void loadDiff(const QString &snapshotAId, const QString &snapshotBId);
     Q_INVOKABLE void loadExplanationBetween(const QDateTime &from, const QDateTime &to);
 
+    // One newest-first page of get_changes_page for TimelineModel. An empty
+    // cursor asks for the first page. Returns the request id that
+    // changesPageLoaded/requestFailed will carry.
+    int loadChangesPage(const QDateTime &from,
+                        const QDateTime &to,
+                        const QJsonObject &cursor,
+                        int limit);
+    // Events of [from, to] added or replaced after generation, for
+    // TimelineModel to merge into rows it already has. Answered by
+    // changesAfterGenerationLoaded/requestFailed.
+    int loadChangesAfterGeneration(qint64 generation,
+                                   const QDateTime &from,
+                                   const QDateTime &to);
+
 signals:
     void connectedChanged(bool connected);
 
     // Emitted when corresponding results arrive from the daemon:
     void changesLoaded(const QVariantList &events);
+    // Raw result object; the model decodes it straight into its own rows.
+    void changesPageLoaded(int requestId, const QJsonObject &result);
+    void changesAfterGenerationLoaded(int requestId, const QJsonObject &result);
     void summaryLoaded(const QVariantMap &summary);
     void snapshotsLoaded(const QVariantList &snapshots);
     void diffLoaded(const QVariantList &diffRows);
@@ -48,31 +72,22 @@ signals:
 
     // For debug / error reporting in QML:
     void errorOccurred(const QString &message);
+    // Same failure, tied to the request that caused it.
+    void requestFailed(int requestId, const QString &message);
 
 private slots:
-    void onSocketConnected();
-    void onSocketError(QLocalSocket::LocalSocketError error);
-    void onSocketReadyRead();
+    void onResponseDecoded(const khronicle::DecodedResponse &response);
 
 private:
     struct PendingRequest {
         QString method;
+        RequestTrace trace;
     };
 
-    QLocalSocket *m_socket;
-    int m_nextRequestId;
+    DaemonConnection *m_connection;
     QHash<int, PendingRequest> m_pending;
-    bool m_connected = false;
-
-    void sendRequest(const QString &method, const QJsonObject &params);
-    void handleResponse(const QJsonObject &obj);
-    QString socketPath() const;
 
-    // Helpers to convert JSON payloads into QVariant structures for QML:
-    QVariantList convertEventsJsonToVariantList(const QJsonValue &eventsValue) const;
-    QVariantList convertSnapshotsJsonToVariantList(const QJsonValue &snapshotsValue) const;
-    QVariantMap convertSummaryJsonToVariantMap(const QJsonValue &summaryValue) const;
-    QVariantList convertDiffJsonToVariantList(const QJsonValue &diffValue) const;
+    int sendRequest(const QString &method, const QJsonObject &params);
 };
 
 } // namespace khronicle
@@ -0,0 +1,161 @@
+#include "ui/backend/ResponseDecoder.hpp"
+
+#include <QFutureWatcher>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace khronicle {
+
+// State shared with decode jobs; jobs hold a reference, so a decoder that
+// is destroyed mid-decode leaves nothing dangling.
+struct ResponseDecoder::Shared {
+    struct Expectation {
+        QString view;
+        Converter converter;
+        bool superseded = false;
+    };
+
+    QMutex mutex;
+    QHash<int, Expectation> expectations;
+    QHash<QString, int> latestByView;
+};
+
+ResponseDecoder::ResponseDecoder(QObject *parent)
+    : QObject(parent)
+    , m_shared(std::make_shared<Shared>())
+{
+    qRegisterMetaType<khronicle::DecodedResponse>();
+    m_pool.setMaxThreadCount(1);
+}
+
+ResponseDecoder::~ResponseDecoder()
+{
+    // Lines not started yet have no one left to deliver to.
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void ResponseDecoder::expect(int id, const QString &view, Converter converter)
+{
+    QMutexLocker locker(&m_shared->mutex);
+    if (!view.isEmpty()) {
+        const auto previous = m_shared->latestByView.constFind(view);
+        if (previous != m_shared->latestByView.constEnd()) {
+            auto it = m_shared->expectations.find(*previous);
+            if (it != m_shared->expectations.end()) {
+                it->superseded = true;
+            }
+        }
+        m_shared->latestByView.insert(view, id);
+    }
+    m_shared->expectations.insert(id, Shared::Expectation{view, std::move(converter), false});
+}
+
+void ResponseDecoder::feed(const QByteArray &data)
+{
+    // Responses are newline-delimited; a read can end mid-line.
+    m_buffer.append(data);
+    qsizetype start = 0;
+    qsizetype newline = 0;
+    while ((newline = m_buffer.indexOf('\n', start)) >= 0) {
+        const QByteArray line = m_buffer.mid(start, newline - start);
+        start = newline + 1;
+        if (!line.trimmed().isEmpty()) {
+            decodeLine(line);
+        }
+    }
+    m_buffer.remove(0, start);
+}
+
+void ResponseDecoder::discardPartialLine()
+{
+    m_buffer.clear();
+}
+
+void ResponseDecoder::decodeLine(const QByteArray &line)
+{
+    const std::shared_ptr<Shared> shared = m_shared;
+    auto *watcher = new QFutureWatcher<DecodedResponse>(this);
+    m_pending.enqueue(watcher);
+    connect(watcher, &QFutureWatcher<DecodedResponse>::finished,
+            this, &ResponseDecoder::emitFinished);
+
+    watcher->setFuture(QtConcurrent::run(&m_pool, [shared, line]() {
+        DecodedResponse response;
+        QJsonParseError parseError{};
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            response.error = QStringLiteral("Invalid JSON response");
+            return response;
+        }
+
+        response.response = doc.object();
+        response.id = response.response.value("id").toInt(-1);
+        if (!response.response.contains("id")
+            && response.response.value("method").isString()) {
+            response.notification = response.response.value("method").toString();
+            response.result = response.response.value("params").toObject();
+            return response;
+        }
+        if (response.response.contains("error")) {
+            response.error = response.response.value("error").toString();
+            return response;
+        }
+        const QJsonValue resultValue = response.response.value("result");
+        if (!resultValue.isObject()) {
+            response.error = QStringLiteral("Malformed response result");
+            return response;
+        }
+        response.result = resultValue.toObject();
+
+        Converter converter;
+        {
+            QMutexLocker locker(&shared->mutex);
+            const auto it = shared->expectations.constFind(response.id);
+            if (it == shared->expectations.constEnd()) {
+                return response;
+            }
+            if (it->superseded) {
+                response.superseded = true;
+                return response;
+            }
+            converter = it->converter;
+        }
+        if (converter) {
+            response.value = converter(response.result);
+        }
+        return response;
+    }));
+}
+
+void ResponseDecoder::emitFinished()
+{
+    while (!m_pending.isEmpty() && m_pending.head()->isFinished()) {
+        QFutureWatcher<DecodedResponse> *watcher = m_pending.dequeue();
+        DecodedResponse response = watcher->result();
+        watcher->deleteLater();
+        {
+            // A newer request for the view may have been sent while this
+            // one was decoding; the check on the GUI thread is the last word.
+            QMutexLocker locker(&m_shared->mutex);
+            const auto it = m_shared->expectations.constFind(response.id);
+            if (it != m_shared->expectations.constEnd()) {
+                if (it->superseded) {
+                    response.superseded = true;
+                    response.value = QVariant();
+                }
+                if (!it->view.isEmpty()
+                    && m_shared->latestByView.value(it->view, -1) == response.id) {
+                    m_shared->latestByView.remove(it->view);
+                }
+                m_shared->expectations.erase(it);
+            }
+        }
+        emit decoded(response);
+    }
+}
+
+} // namespace khronicle
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QJsonObject>
+#include <QMetaType>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QVariant>
+
+#include <functional>
+#include <memory>
+
+namespace khronicle {
+
+struct DecodedResponse {
+    // -1 when the line was not a JSON object with an id.
+    int id = -1;
+    // Method of an id-less daemon push such as "watch_signal"; its params
+    // are in result.
+    QString notification;
+    // A newer request for the same view was sent before this one was
+    // handed over; the result was dropped and value is empty.
+    bool superseded = false;
+    // Daemon "error" field, or a decode failure.
+    QString error;
+    // The whole response (for trace fields) and its "result" object.
+    QJsonObject response;
+    QJsonObject result;
+    // Output of the converter registered for this id, if any.
+    QVariant value;
+};
+
+// Parses daemon responses and converts them for QML on a worker thread,
+// so a multi-megabyte get_changes_between answer does not stall the GUI
+// thread. Clients feed raw socket bytes in and get one decoded() signal
+// per complete line, delivered on the decoder's thread in the order the
+// lines arrived: a push or a small answer never overtakes a large answer
+// that came before it.
+//
+// Each request is registered with the view it feeds ("changes",
+// "snapshots", ...). Registering a newer request for the same view
+// supersedes the older one: if its answer is still being decoded, the
+// conversion is skipped and it arrives with superseded set.
+class ResponseDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    // Runs on a worker thread; must not touch QObjects or client state.
+    using Converter = std::function<QVariant(const QJsonObject &result)>;
+
+    explicit ResponseDecoder(QObject *parent = nullptr);
+    ~ResponseDecoder() override;
+
+    // An empty view is never superseded (writes, one-off lookups).
+    void expect(int id, const QString &view, Converter converter = {});
+    // Appends socket bytes; a trailing partial line waits for the rest.
+    void feed(const QByteArray &data);
+    // Drops a buffered partial line, when the connection it came from is
+    // gone.
+    void discardPartialLine();
+
+signals:
+    void decoded(const khronicle::DecodedResponse &response);
+
+private:
+    struct Shared;
+
+    void decodeLine(const QByteArray &line);
+    // Emits the finished jobs at the front of m_pending.
+    void emitFinished();
+
+    std::shared_ptr<Shared> m_shared;
+    QByteArray m_buffer;
+    // One worker, so lines decode one at a time in arrival order.
+    QThreadPool m_pool;
+    // Jobs in arrival order; emitFinished() only takes from the front.
+    QQueue<QFutureWatcher<DecodedResponse> *> m_pending;
+};
+
+} // namespace khronicle
+
+Q_DECLARE_METATYPE(khronicle::DecodedResponse)
@@ -0,0 +1,132 @@
+#include "ui/backend/SnapshotListModel.hpp"
+
+#include <QDateTime>
+#include <QLocale>
+
+#include <algorithm>
+
+namespace khronicle {
+
+SnapshotListModel::SnapshotListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int SnapshotListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_entries.size());
+}
+
+QVariant SnapshotListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0
+        || index.row() >= static_cast<int>(m_entries.size())) {
+        return {};
+    }
+
+    const Entry &entry = m_entries[static_cast<std::size_t>(index.row())];
+    switch (role) {
+    case IdRole:
+        return entry.id;
+    case TimestampRole:
+        return entry.timestamp;
+    case KernelVersionRole:
+        return entry.kernelVersion;
+    case Qt::DisplayRole:
+    case LabelRole:
+        return entry.label;
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> SnapshotListModel::roleNames() const
+{
+    return {
+        {IdRole, "id"},
+        {TimestampRole, "timestamp"},
+        {KernelVersionRole, "kernelVersion"},
+        {LabelRole, "label"}
+    };
+}
+
+int SnapshotListModel::count() const
+{
+    return static_cast<int>(m_entries.size());
+}
+
+void SnapshotListModel::setSnapshots(const QVariantList &snapshots)
+{
+    const QLocale locale;
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<std::size_t>(snapshots.size()));
+    for (const QVariant &value : snapshots) {
+        const QVariantMap map = value.toMap();
+        Entry entry;
+        entry.id = map.value("id").toString();
+        entry.timestamp = map.value("timestamp").toString();
+        entry.kernelVersion = map.value("kernelVersion").toString();
+
+        const QDateTime parsed = QDateTime::fromString(entry.timestamp, Qt::ISODate);
+        QString when = entry.timestamp;
+        if (parsed.isValid()) {
+            entry.epochMs = parsed.toMSecsSinceEpoch();
+            when = locale.toString(parsed.toLocalTime(), QLocale::ShortFormat);
+        }
+        if (!when.isEmpty() && !entry.kernelVersion.isEmpty()) {
+            entry.label = when + QStringLiteral(" • ") + entry.kernelVersion;
+        } else {
+            entry.label = when.isEmpty() ? entry.kernelVersion : when;
+        }
+        entries.push_back(std::move(entry));
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.epochMs > b.epochMs;
+    });
+
+    beginResetModel();
+    m_entries = std::move(entries);
+    endResetModel();
+    emit countChanged();
+}
+
+int SnapshotListModel::nearestIndex(const QString &iso) const
+{
+    const QDateTime target = QDateTime::fromString(iso, Qt::ISODate);
+    if (m_entries.empty() || !target.isValid()) {
+        return -1;
+    }
+    const qint64 targetMs = target.toMSecsSinceEpoch();
+
+    // Newest first: the first row at or before the target, and the one
+    // just newer than it, are the only candidates.
+    const auto older = std::lower_bound(m_entries.begin(), m_entries.end(), targetMs,
+                                        [](const Entry &entry, qint64 ms) {
+                                            return entry.epochMs > ms;
+                                        });
+    if (older == m_entries.begin()) {
+        return 0;
+    }
+    if (older == m_entries.end()) {
+        return static_cast<int>(m_entries.size()) - 1;
+    }
+    const auto newer = older - 1;
+    const int row = static_cast<int>(older - m_entries.begin());
+    return newer->epochMs - targetMs <= targetMs - older->epochMs ? row - 1 : row;
+}
+
+QVariantMap SnapshotListModel::get(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_entries.size())) {
+        return {};
+    }
+    const Entry &entry = m_entries[static_cast<std::size_t>(row)];
+    return {
+        {"id", entry.id},
+        {"timestamp", entry.timestamp},
+        {"kernelVersion", entry.kernelVersion},
+        {"label", entry.label}
+    };
+}
+
+} // namespace khronicle
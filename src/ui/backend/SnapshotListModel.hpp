@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <vector>
+
+namespace khronicle {
+
+// Snapshots for the compare selector, newest first. Timestamps are parsed
+// once when the list is set, so picking the snapshot nearest an event is a
+// binary search instead of a scan through Date objects in QML.
+class SnapshotListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+public:
+    enum Role {
+        IdRole = Qt::UserRole + 1,
+        TimestampRole,
+        KernelVersionRole,
+        // "<local date/time> • <kernel>", for the combo boxes.
+        LabelRole
+    };
+
+    explicit SnapshotListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+
+    // Replaces the rows with list_snapshots maps (id, timestamp,
+    // kernelVersion), in any order.
+    Q_INVOKABLE void setSnapshots(const QVariantList &snapshots);
+    // Row of the snapshot closest in time to an ISO-8601 timestamp, the
+    // newer one on a tie; -1 when there are none or iso does not parse.
+    Q_INVOKABLE int nearestIndex(const QString &iso) const;
+    // The row as {id, timestamp, kernelVersion, label}; empty when out of
+    // range.
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+signals:
+    void countChanged();
+
+private:
+    struct Entry {
+        qint64 epochMs = 0;
+        QString id;
+        QString timestamp;
+        QString kernelVersion;
+        QString label;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+} // namespace khronicle
@@ -0,0 +1,212 @@
+#include "ui/backend/TimelineCache.hpp"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <chrono>
+
+#include "common/json_utils.hpp"
+#include "common/logging.hpp"
+#include "ui/backend/KhronicleApiClient.hpp"
+#include "ui/backend/TimelineModel.hpp"
+
+namespace khronicle {
+
+namespace {
+
+// "KHTC"; bump kFormatVersion whenever the layout below changes.
+constexpr quint32 kMagic = 0x4b485443;
+constexpr quint32 kFormatVersion = 1;
+
+} // namespace
+
+TimelineCache::TimelineCache(TimelineModel *model,
+                             KhronicleApiClient *client,
+                             const QString &path,
+                             QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_path(path)
+{
+    if (client) {
+        // Remember what the overview last showed, for the next save().
+        connect(client, &KhronicleApiClient::summaryLoaded,
+                this, [this](const QVariantMap &summary) { m_summary = summary; });
+        connect(client, &KhronicleApiClient::snapshotsLoaded,
+                this, [this](const QVariantList &snapshots) { m_snapshots = snapshots; });
+    }
+}
+
+QString TimelineCache::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QStringLiteral("/khronicle/timeline.cache");
+}
+
+bool TimelineCache::restore(const QDateTime &from, const QDateTime &to)
+{
+    if (!m_model || !from.isValid() || !to.isValid()) {
+        return false;
+    }
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+    uchar *mapped = file.map(0, file.size());
+    if (!mapped) {
+        return false;
+    }
+    // The file is read through the mapping without a separate read into a
+    // buffer; QDataStream still copies each field into owned containers.
+    const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped),
+                                                     static_cast<qsizetype>(file.size()));
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != kMagic || version != kFormatVersion) {
+        return false;
+    }
+
+    qint64 generation = -1;
+    QDateTime cachedFrom;
+    QDateTime cachedTo;
+    bool hasMore = false;
+    QByteArray cursorJson;
+    quint32 rowCount = 0;
+    in >> generation >> cachedFrom >> cachedTo >> hasMore >> cursorJson >> rowCount;
+    // Only a window that starts inside the cached one can be reconciled
+    // incrementally; anything else is a fresh load.
+    if (in.status() != QDataStream::Ok || generation < 0 || !cachedFrom.isValid()
+        || !(cachedFrom <= from && from < cachedTo)) {
+        return false;
+    }
+
+    const qint64 fromSecs = from.toSecsSinceEpoch();
+    std::vector<TimelineModel::Entry> entries;
+    entries.reserve(std::min<quint32>(rowCount, kMaxRows));
+    for (quint32 i = 0; i < rowCount && in.status() == QDataStream::Ok; ++i) {
+        TimelineModel::Entry entry;
+        QString category;
+        QString source;
+        in >> entry.timestamp >> entry.id >> category >> source >> entry.summary
+            >> entry.details >> entry.relatedPackages;
+        entry.category = parseCategoryString(category.toStdString());
+        entry.source = parseSourceString(source.toStdString());
+        entries.push_back(std::move(entry));
+    }
+    QVariantMap summary;
+    QVariantList snapshots;
+    in >> summary >> snapshots;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    // Rows are newest first: drop the ones that fell out of the window.
+    const auto tail = std::find_if(entries.begin(), entries.end(),
+                                   [fromSecs](const TimelineModel::Entry &entry) {
+                                       return entry.timestamp < fromSecs;
+                                   });
+    if (tail != entries.end()) {
+        entries.erase(tail, entries.end());
+        hasMore = false;
+        cursorJson.clear();
+    }
+
+    m_model->restore(from,
+                     cachedTo,
+                     std::move(entries),
+                     QJsonDocument::fromJson(cursorJson).object(),
+                     hasMore,
+                     generation);
+    m_summary = summary;
+    m_snapshots = snapshots;
+
+    KLOG_DEBUG(QStringLiteral("TimelineCache"),
+               QStringLiteral("restore"),
+               QStringLiteral("timeline_cache_restored"),
+               QStringLiteral("ui_start"),
+               QStringLiteral("mmap"),
+               khronicle::logging::defaultWho(),
+               QString(),
+               (nlohmann::json{{"rows", m_model->count()}, {"generation", generation}}));
+    emit restored();
+    return true;
+}
+
+bool TimelineCache::save() const
+{
+    if (!m_model || m_model->generation() < 0) {
+        return false;
+    }
+
+    const auto &entries = m_model->entries();
+    const auto rowCount = std::min<std::size_t>(entries.size(), kMaxRows);
+    bool hasMore = m_model->hasMore();
+    QJsonObject cursor = m_model->cursor();
+    if (rowCount < entries.size()) {
+        // Resume paging after the last row written, in get_changes_page's
+        // cursor format.
+        const auto &last = entries[rowCount - 1];
+        hasMore = true;
+        cursor = QJsonObject{
+            {"timestamp", QString::fromStdString(toIso8601Utc(
+                              std::chrono::system_clock::from_time_t(last.timestamp)))},
+            {"id", last.id}};
+    }
+
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kMagic << kFormatVersion;
+    out << m_model->generation() << m_model->from() << m_model->to() << hasMore
+        << (cursor.isEmpty() ? QByteArray()
+                             : QJsonDocument(cursor).toJson(QJsonDocument::Compact))
+        << static_cast<quint32>(rowCount);
+    for (std::size_t i = 0; i < rowCount; ++i) {
+        const auto &entry = entries[i];
+        out << entry.timestamp << entry.id
+            << QString::fromStdString(toCategoryString(entry.category))
+            << QString::fromStdString(toSourceString(entry.source)) << entry.summary
+            << entry.details << entry.relatedPackages;
+    }
+    out << m_summary << m_snapshots;
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()
+        || !file.commit()) {
+        KLOG_WARN(QStringLiteral("TimelineCache"),
+                  QStringLiteral("save"),
+                  QStringLiteral("timeline_cache_write_failed"),
+                  QStringLiteral("ui_exit"),
+                  QStringLiteral("qsavefile"),
+                  khronicle::logging::defaultWho(),
+                  QString(),
+                  (nlohmann::json{{"path", m_path.toStdString()},
+                                  {"error", file.errorString().toStdString()}}));
+        return false;
+    }
+    return true;
+}
+
+QVariantMap TimelineCache::summary() const
+{
+    return m_summary;
+}
+
+QVariantList TimelineCache::snapshots() const
+{
+    return m_snapshots;
+}
+
+} // namespace khronicle
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+namespace khronicle {
+
+class KhronicleApiClient;
+class TimelineModel;
+
+/**
+ * TimelineCache keeps the overview's last state on disk so the UI can show
+ * it at startup before the daemon answers.
+ *
+ * The file holds the TimelineModel rows (tagged with the store generation
+ * they are current with), the last summary and the snapshot list in a
+ * QDataStream layout. It is read through a memory mapping and rewritten
+ * atomically on save. After restore(), the model's next setRange only asks
+ * the daemon for changes after that generation.
+ */
+class TimelineCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap summary READ summary NOTIFY restored)
+    Q_PROPERTY(QVariantList snapshots READ snapshots NOTIFY restored)
+public:
+    // Rows written; the rest of the range is paged in again on demand.
+    static constexpr int kMaxRows = 1000;
+
+    TimelineCache(TimelineModel *model,
+                  KhronicleApiClient *client,
+                  const QString &path = defaultPath(),
+                  QObject *parent = nullptr);
+
+    // $XDG_CACHE_HOME/khronicle/timeline.cache
+    static QString defaultPath();
+
+    // Loads the cache into the model when it covers the start of
+    // [from, to]. Returns false (and leaves the model alone) when there is
+    // no usable cache.
+    Q_INVOKABLE bool restore(const QDateTime &from, const QDateTime &to);
+    // Writes the model's current rows. Does nothing when they did not come
+    // from the daemon.
+    bool save() const;
+
+    QVariantMap summary() const;
+    QVariantList snapshots() const;
+
+signals:
+    void restored();
+
+private:
+    TimelineModel *m_model;
+    QString m_path;
+    QVariantMap m_summary;
+    QVariantList m_snapshots;
+};
+
+} // namespace khronicle
@@ -0,0 +1,442 @@
+#include "ui/backend/TimelineModel.hpp"
+
+#include <QJsonArray>
+#include <QJsonValue>
+
+#include <algorithm>
+
+#include "common/json_utils.hpp"
+#include "ui/backend/KhronicleApiClient.hpp"
+
+namespace khronicle {
+
+namespace {
+
+qint64 parseTimestamp(const QString &iso)
+{
+    const QDateTime parsed = QDateTime::fromString(iso, Qt::ISODate);
+    return parsed.isValid() ? parsed.toSecsSinceEpoch() : 0;
+}
+
+QString formatTimestamp(qint64 epochSeconds)
+{
+    return QString::fromStdString(
+        toIso8601Utc(std::chrono::system_clock::from_time_t(epochSeconds)));
+}
+
+TimelineModel::Entry entryFromJson(const QJsonObject &obj)
+{
+    TimelineModel::Entry entry;
+    entry.id = obj.value("id").toString();
+    entry.timestamp = parseTimestamp(obj.value("timestamp").toString());
+    entry.category = parseCategoryString(obj.value("category").toString().toStdString());
+    entry.source = parseSourceString(obj.value("source").toString().toStdString());
+    entry.summary = obj.value("summary").toString();
+    entry.details = obj.value("details").toString();
+    for (const QJsonValue &pkg : obj.value("relatedPackages").toArray()) {
+        entry.relatedPackages.push_back(pkg.toString());
+    }
+    return entry;
+}
+
+// Row order: newest first, ties by id descending, matching get_changes_page.
+bool rowBefore(const TimelineModel::Entry &a, const TimelineModel::Entry &b)
+{
+    if (a.timestamp != b.timestamp) {
+        return a.timestamp > b.timestamp;
+    }
+    return a.id > b.id;
+}
+
+} // namespace
+
+TimelineModel::TimelineModel(KhronicleApiClient *client, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_client(client)
+{
+    if (m_client) {
+        connect(m_client, &KhronicleApiClient::changesPageLoaded,
+                this, &TimelineModel::onPageLoaded);
+        connect(m_client, &KhronicleApiClient::changesAfterGenerationLoaded,
+                this, &TimelineModel::onChangesLoaded);
+        connect(m_client, &KhronicleApiClient::requestFailed,
+                this, [this](int requestId, const QString &) { onRequestFailed(requestId); });
+    }
+}
+
+int TimelineModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_entries.size());
+}
+
+QVariant TimelineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0
+        || index.row() >= static_cast<int>(m_entries.size())) {
+        return {};
+    }
+
+    const Entry &entry = m_entries[static_cast<std::size_t>(index.row())];
+    switch (role) {
+    case IdRole:
+        return entry.id;
+    case TimestampRole:
+        return formatTimestamp(entry.timestamp);
+    case CategoryRole:
+        return QString::fromStdString(toCategoryString(entry.category));
+    case SourceRole:
+        return QString::fromStdString(toSourceString(entry.source));
+    case Qt::DisplayRole:
+    case SummaryRole:
+        return entry.summary;
+    case DetailsRole:
+        return entry.details;
+    case RelatedPackagesRole:
+        return entry.relatedPackages;
+    case EventDataRole:
+        return entryToMap(entry);
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> TimelineModel::roleNames() const
+{
+    return {
+        {IdRole, "id"},
+        {TimestampRole, "timestamp"},
+        {CategoryRole, "category"},
+        {SourceRole, "source"},
+        {SummaryRole, "summary"},
+        {DetailsRole, "details"},
+        {RelatedPackagesRole, "relatedPackages"},
+        {EventDataRole, "eventData"}
+    };
+}
+
+bool TimelineModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_hasMore && m_pendingRequestId < 0;
+}
+
+void TimelineModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent)) {
+        requestPage();
+    }
+}
+
+int TimelineModel::count() const
+{
+    return static_cast<int>(m_entries.size());
+}
+
+bool TimelineModel::loading() const
+{
+    return m_pendingRequestId >= 0;
+}
+
+EventCategory TimelineModel::categoryAt(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_entries.size())) {
+        return EventCategory::System;
+    }
+    return m_entries[static_cast<std::size_t>(row)].category;
+}
+
+void TimelineModel::setRange(const QDateTime &from, const QDateTime &to)
+{
+    // Rows loaded at a known generation stay valid for any range starting
+    // inside the loaded one; only what was recorded since is fetched.
+    // Extending `to` relies on events being stored no earlier than they
+    // happen, which holds for the presets (they end now or at a midnight
+    // that starts the next preset's range).
+    const bool incremental = m_client && m_generation >= 0 && m_from.isValid()
+        && m_to.isValid() && m_from <= from && from < m_to && from < to;
+    if (!incremental) {
+        m_from = from;
+        m_to = to;
+        reload();
+        return;
+    }
+
+    finishRequest();
+    m_from = from;
+    m_to = to;
+    trimToRange();
+    const int requestId = m_client->loadChangesAfterGeneration(m_generation, m_from, m_to);
+    m_pendingRequestId = requestId;
+    emit loadingChanged();
+}
+
+void TimelineModel::setEvents(const QVariantList &events)
+{
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<std::size_t>(events.size()));
+    for (const QVariant &value : events) {
+        const QVariantMap map = value.toMap();
+        Entry entry;
+        entry.id = map.value("id").toString();
+        entry.timestamp = parseTimestamp(map.value("timestamp").toString());
+        entry.category = parseCategoryString(map.value("category").toString().toStdString());
+        entry.source = parseSourceString(map.value("source").toString().toStdString());
+        entry.summary = map.value("summary").toString();
+        entry.details = map.value("details").toString();
+        entry.relatedPackages = map.value("relatedPackages").toStringList();
+        entries.push_back(std::move(entry));
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.timestamp > b.timestamp;
+    });
+
+    m_hasMore = false;
+    m_generation = -1;
+    finishRequest();
+    resetRows(std::move(entries));
+}
+
+void TimelineModel::clear()
+{
+    m_hasMore = false;
+    m_generation = -1;
+    finishRequest();
+    resetRows({});
+}
+
+void TimelineModel::restore(const QDateTime &from,
+                            const QDateTime &to,
+                            std::vector<Entry> entries,
+                            const QJsonObject &cursor,
+                            bool hasMore,
+                            qint64 generation)
+{
+    m_from = from;
+    m_to = to;
+    m_cursor = cursor;
+    m_hasMore = hasMore;
+    m_generation = generation;
+    finishRequest();
+    resetRows(std::move(entries));
+}
+
+void TimelineModel::reload()
+{
+    m_cursor = QJsonObject();
+    m_hasMore = true;
+    m_generation = -1;
+    finishRequest();
+    resetRows({});
+    requestPage();
+}
+
+void TimelineModel::requestPage()
+{
+    if (!m_client || !m_from.isValid() || !m_to.isValid()) {
+        return;
+    }
+    // Queued by the shared connection while the daemon is unreachable.
+    const int requestId = m_client->loadChangesPage(m_from, m_to, m_cursor, kPageSize);
+    const bool wasLoading = loading();
+    m_pendingRequestId = requestId;
+    if (!wasLoading) {
+        emit loadingChanged();
+    }
+}
+
+void TimelineModel::onPageLoaded(int requestId, const QJsonObject &result)
+{
+    if (requestId != m_pendingRequestId) {
+        return;
+    }
+
+    const QJsonArray array = result.value("events").toArray();
+    std::vector<Entry> page;
+    page.reserve(static_cast<std::size_t>(array.size()));
+    for (const QJsonValue &value : array) {
+        page.push_back(entryFromJson(value.toObject()));
+    }
+
+    // Later pages keep the first page's generation: anything recorded while
+    // paging is picked up by the next incremental fetch.
+    if (m_generation < 0 && result.contains("generation")) {
+        m_generation = static_cast<qint64>(result.value("generation").toDouble());
+    }
+    const QJsonValue next = result.value("nextCursor");
+    m_hasMore = next.isObject();
+    m_cursor = next.toObject();
+
+    if (!page.empty()) {
+        const int first = static_cast<int>(m_entries.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(page.size()) - 1);
+        m_entries.insert(m_entries.end(),
+                         std::make_move_iterator(page.begin()),
+                         std::make_move_iterator(page.end()));
+        endInsertRows();
+        emit countChanged();
+    }
+    finishRequest();
+}
+
+void TimelineModel::onChangesLoaded(int requestId, const QJsonObject &result)
+{
+    if (requestId != m_pendingRequestId) {
+        return;
+    }
+    finishRequest();
+    // Too much changed to merge row by row (or the store was rebuilt).
+    if (!result.value("complete").toBool()) {
+        reload();
+        return;
+    }
+
+    for (const QJsonValue &value : result.value("events").toArray()) {
+        Entry entry = entryFromJson(value.toObject());
+        const auto existing = std::find_if(m_entries.begin(), m_entries.end(),
+                                           [&entry](const Entry &row) {
+                                               return row.id == entry.id;
+                                           });
+        if (existing != m_entries.end()) {
+            const int row = static_cast<int>(existing - m_entries.begin());
+            beginRemoveRows(QModelIndex(), row, row);
+            m_entries.erase(existing);
+            endRemoveRows();
+        }
+        // Rows past the last loaded one arrive with the remaining pages.
+        if (m_hasMore && !m_entries.empty() && rowBefore(m_entries.back(), entry)) {
+            continue;
+        }
+        const auto position =
+            std::lower_bound(m_entries.begin(), m_entries.end(), entry, rowBefore);
+        const int row = static_cast<int>(position - m_entries.begin());
+        beginInsertRows(QModelIndex(), row, row);
+        m_entries.insert(position, std::move(entry));
+        endInsertRows();
+    }
+    m_generation = static_cast<qint64>(result.value("generation").toDouble());
+    emit countChanged();
+}
+
+void TimelineModel::trimToRange()
+{
+    const qint64 from = m_from.toSecsSinceEpoch();
+    const qint64 to = m_to.toSecsSinceEpoch();
+
+    const auto tail = std::find_if(m_entries.begin(), m_entries.end(),
+                                   [from](const Entry &row) { return row.timestamp < from; });
+    if (tail != m_entries.end()) {
+        // The old range's oldest rows are gone, so the new one is fully
+        // loaded from here down.
+        beginRemoveRows(QModelIndex(),
+                        static_cast<int>(tail - m_entries.begin()),
+                        static_cast<int>(m_entries.size()) - 1);
+        m_entries.erase(tail, m_entries.end());
+        endRemoveRows();
+        m_hasMore = false;
+        m_cursor = QJsonObject();
+    }
+
+    const auto head = std::find_if(m_entries.begin(), m_entries.end(),
+                                   [to](const Entry &row) { return row.timestamp <= to; });
+    if (head != m_entries.begin()) {
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(head - m_entries.begin()) - 1);
+        m_entries.erase(m_entries.begin(), head);
+        endRemoveRows();
+    }
+    emit countChanged();
+}
+
+void TimelineModel::onRequestFailed(int requestId)
+{
+    if (requestId != m_pendingRequestId) {
+        return;
+    }
+    // Leave m_hasMore set so the next fetchMore retries the same page.
+    finishRequest();
+}
+
+void TimelineModel::resetRows(std::vector<Entry> entries)
+{
+    beginResetModel();
+    m_entries = std::move(entries);
+    endResetModel();
+    emit countChanged();
+}
+
+void TimelineModel::finishRequest()
+{
+    if (m_pendingRequestId >= 0) {
+        m_pendingRequestId = -1;
+        emit loadingChanged();
+    }
+}
+
+QVariantMap TimelineModel::entryToMap(const Entry &entry) const
+{
+    QVariantMap map;
+    map["id"] = entry.id;
+    map["timestamp"] = formatTimestamp(entry.timestamp);
+    map["category"] = QString::fromStdString(toCategoryString(entry.category));
+    map["source"] = QString::fromStdString(toSourceString(entry.source));
+    map["summary"] = entry.summary;
+    map["details"] = entry.details;
+    map["relatedPackages"] = entry.relatedPackages;
+    return map;
+}
+
+TimelineFilterModel::TimelineFilterModel(TimelineModel *source, QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , m_source(source)
+{
+    setSourceModel(source);
+}
+
+void TimelineFilterModel::setShowKernel(bool show)
+{
+    setFilter(m_showKernel, show);
+}
+
+void TimelineFilterModel::setShowGpu(bool show)
+{
+    setFilter(m_showGpu, show);
+}
+
+void TimelineFilterModel::setShowFirmware(bool show)
+{
+    setFilter(m_showFirmware, show);
+}
+
+void TimelineFilterModel::setShowPackage(bool show)
+{
+    setFilter(m_showPackage, show);
+}
+
+void TimelineFilterModel::setFilter(bool &field, bool value)
+{
+    if (field == value) {
+        return;
+    }
+    field = value;
+    invalidateFilter();
+    emit filtersChanged();
+}
+
+bool TimelineFilterModel::filterAcceptsRow(int sourceRow,
+                                           const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent)
+    switch (m_source->categoryAt(sourceRow)) {
+    case EventCategory::Kernel:
+        return m_showKernel;
+    case EventCategory::GpuDriver:
+        return m_showGpu;
+    case EventCategory::Firmware:
+        return m_showFirmware;
+    case EventCategory::Package:
+        return m_showPackage;
+    case EventCategory::System:
+        return true;
+    }
+    return true;
+}
+
+} // namespace khronicle
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QSortFilterProxyModel>
+#include <QStringList>
+#include <QVariantList>
+
+#include <vector>
+
+#include "common/enums.hpp"
+
+namespace khronicle {
+
+class KhronicleApiClient;
+
+// Overview timeline rows, newest first. Rows are compact structs decoded
+// straight from the daemon's JSON; QML only sees the roles of the delegates
+// it creates. History is fetched a page at a time through get_changes_page
+// as the view scrolls (canFetchMore/fetchMore), so opening a year-long range
+// costs one page, not the whole range.
+//
+// The model remembers the store generation its rows are current with.
+// Selecting a range that starts inside the loaded one (the same preset
+// again, a reconnect, a cold start from TimelineCache) trims the rows and
+// merges get_changes_after_generation instead of reloading.
+class TimelineModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+
+public:
+    enum Role {
+        IdRole = Qt::UserRole + 1,
+        TimestampRole,
+        CategoryRole,
+        SourceRole,
+        SummaryRole,
+        DetailsRole,
+        RelatedPackagesRole,
+        // The row as a map, for handing one event on to other QML code.
+        EventDataRole
+    };
+
+    static constexpr int kPageSize = 200;
+
+    struct Entry {
+        qint64 timestamp = 0; // epoch seconds
+        QString id;
+        QString summary;
+        QString details;
+        QStringList relatedPackages;
+        EventCategory category = EventCategory::System;
+        EventSource source = EventSource::Other;
+    };
+
+    explicit TimelineModel(KhronicleApiClient *client, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    int count() const;
+    bool loading() const;
+    EventCategory categoryAt(int row) const;
+
+    // Drops the current rows and loads the first page of [from, to].
+    Q_INVOKABLE void setRange(const QDateTime &from, const QDateTime &to);
+    // Replaces the rows with locally built events (demo mode). Nothing is
+    // fetched from the daemon until the next setRange.
+    Q_INVOKABLE void setEvents(const QVariantList &events);
+    Q_INVOKABLE void clear();
+
+    // Rows and paging state for TimelineCache. generation is -1 when the
+    // rows did not come from the daemon (demo mode, nothing loaded).
+    const std::vector<Entry> &entries() const { return m_entries; }
+    QDateTime from() const { return m_from; }
+    QDateTime to() const { return m_to; }
+    QJsonObject cursor() const { return m_cursor; }
+    bool hasMore() const { return m_hasMore; }
+    qint64 generation() const { return m_generation; }
+
+    // Shows previously saved rows without asking the daemon; the next
+    // setRange reconciles them.
+    void restore(const QDateTime &from,
+                 const QDateTime &to,
+                 std::vector<Entry> entries,
+                 const QJsonObject &cursor,
+                 bool hasMore,
+                 qint64 generation);
+
+signals:
+    void countChanged();
+    void loadingChanged();
+
+private:
+    void reload();
+    void requestPage();
+    void onPageLoaded(int requestId, const QJsonObject &result);
+    void onChangesLoaded(int requestId, const QJsonObject &result);
+    void trimToRange();
+    void onRequestFailed(int requestId);
+    void resetRows(std::vector<Entry> entries);
+    void finishRequest();
+    QVariantMap entryToMap(const Entry &entry) const;
+
+    KhronicleApiClient *m_client;
+    std::vector<Entry> m_entries;
+    QDateTime m_from;
+    QDateTime m_to;
+    QJsonObject m_cursor;
+    bool m_hasMore = false;
+    qint64 m_generation = -1;
+    // Id of the page or changes request in flight; answers to any other id belong to
+    // a range that has since been replaced and are dropped.
+    int m_pendingRequestId = -1;
+};
+
+// Category checkboxes of the overview page, applied in C++ on top of
+// TimelineModel. System events are always shown.
+class TimelineFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_PROPERTY(bool showKernel READ showKernel WRITE setShowKernel NOTIFY filtersChanged)
+    Q_PROPERTY(bool showGpu READ showGpu WRITE setShowGpu NOTIFY filtersChanged)
+    Q_PROPERTY(bool showFirmware READ showFirmware WRITE setShowFirmware NOTIFY filtersChanged)
+    Q_PROPERTY(bool showPackage READ showPackage WRITE setShowPackage NOTIFY filtersChanged)
+
+public:
+    explicit TimelineFilterModel(TimelineModel *source, QObject *parent = nullptr);
+
+    bool showKernel() const { return m_showKernel; }
+    bool showGpu() const { return m_showGpu; }
+    bool showFirmware() const { return m_showFirmware; }
+    bool showPackage() const { return m_showPackage; }
+    void setShowKernel(bool show);
+    void setShowGpu(bool show);
+    void setShowFirmware(bool show);
+    void setShowPackage(bool show);
+
+signals:
+    void filtersChanged();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    void setFilter(bool &field, bool value);
+
+    TimelineModel *m_source;
+    bool m_showKernel = true;
+    bool m_showGpu = true;
+    bool m_showFirmware = true;
+    bool m_showPackage = true;
+};
+
+} // namespace khronicle
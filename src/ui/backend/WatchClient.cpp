@@ -2,12 +2,9 @@
 
 #include <QDateTime>
 #include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
 #include <QUuid>
 
-#include <unistd.h>
-
 #include <nlohmann/json.hpp>
 
 #include "common/logging.hpp"
@@ -23,42 +20,18 @@ QString toIso8601Utc(const QDateTime &dt)
 
 } // namespace
 
-WatchClient::WatchClient(QObject *parent)
+WatchClient::WatchClient(DaemonConnection *connection, QObject *parent)
     : QObject(parent)
-    , m_socket(new QLocalSocket(this))
+    , m_connection(connection)
 {
-    connect(m_socket, &QLocalSocket::errorOccurred, this,
-            [this](QLocalSocket::LocalSocketError) {
-                emit errorOccurred(m_socket->errorString());
-            });
-    connect(m_socket, &QLocalSocket::readyRead, this, [this]() {
-        const QByteArray payload = m_socket->readAll();
-        const QList<QByteArray> lines = payload.split('\n');
-        for (const QByteArray &line : lines) {
-            if (line.trimmed().isEmpty()) {
-                continue;
-            }
-            QJsonParseError parseError{};
-            const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
-            if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
-                emit errorOccurred(QStringLiteral("Invalid JSON response"));
-                continue;
-            }
-            handleResponse(doc.object());
-        }
-    });
+    connect(m_connection, &DaemonConnection::errorOccurred,
+            this, &WatchClient::errorOccurred);
+    connect(m_connection, &DaemonConnection::responseReady,
+            this, &WatchClient::handleResponse);
 }
 
 WatchClient::~WatchClient() = default;
 
-void WatchClient::connectToDaemon()
-{
-    if (m_socket->state() == QLocalSocket::ConnectedState) {
-        return;
-    }
-    m_socket->connectToServer(socketPath());
-}
-
 void WatchClient::loadRules()
 {
     sendRequest(QStringLiteral("list_watch_rules"), QJsonObject());
@@ -94,33 +67,24 @@ void WatchClient::loadSignalsSince(const QDateTime &since)
 void WatchClient::sendRequest(const QString &method, const QJsonObject &params)
 {
     // WatchClient mirrors KhronicleApiClient but only for rule/signal endpoints.
-    if (m_socket->state() != QLocalSocket::ConnectedState) {
-        connectToDaemon();
-        emit errorOccurred(QStringLiteral("Not connected to Khronicle daemon"));
-        KLOG_WARN(QStringLiteral("WatchClient"),
-                  QStringLiteral("sendRequest"),
-                  QStringLiteral("request_failed"),
-                  QStringLiteral("socket_disconnected"),
-                  QStringLiteral("local_socket"),
-                  logging::defaultWho(),
-                  QString(),
-                  (nlohmann::json{{"method", method.toStdString()}}));
-        return;
+    // Rule and signal lists are converted on the decoder's worker thread; a
+    // reload supersedes one still in flight.
+    const RequestTrace trace = startRequestTrace();
+    int id = 0;
+    if (method == "list_watch_rules") {
+        id = m_connection->send(method, params, trace, QStringLiteral("rules"),
+                                [](const QJsonObject &result) {
+                                    return QVariant(result.value("rules").toArray().toVariantList());
+                                });
+    } else if (method == "get_watch_signals_since") {
+        id = m_connection->send(method, params, trace, QStringLiteral("signals"),
+                                [](const QJsonObject &result) {
+                                    return QVariant(result.value("signals").toArray().toVariantList());
+                                });
+    } else {
+        id = m_connection->send(method, params, trace);
     }
-
-    const int id = m_nextRequestId++;
-    QJsonObject root;
-    root["id"] = id;
-    root["method"] = method;
-    root["params"] = params;
-
-    const QByteArray payload =
-        QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
-
-    m_socket->write(payload);
-    m_socket->flush();
-
-    m_pending.insert(id, PendingRequest{method});
+    m_pending.insert(id, PendingRequest{method, trace});
 
     KLOG_DEBUG(QStringLiteral("WatchClient"),
                QStringLiteral("sendRequest"),
@@ -128,68 +92,48 @@ void WatchClient::sendRequest(const QString &method, const QJsonObject &params)
                QStringLiteral("ui_action"),
                QStringLiteral("json_rpc"),
                logging::defaultWho(),
-               QString(),
+               trace.id,
                (nlohmann::json{{"method", method.toStdString()},
                               {"id", id}}));
 }
 
-void WatchClient::handleResponse(const QJsonObject &obj)
+void WatchClient::handleResponse(const DecodedResponse &response)
 {
     // Resolve request IDs and emit QML-friendly data.
-    const int id = obj.value("id").toInt(-1);
-    if (!m_pending.contains(id)) {
+    if (!m_pending.contains(response.id)) {
         return;
     }
 
+    const int id = response.id;
     const PendingRequest pending = m_pending.take(id);
-    if (obj.contains("error")) {
-        emit errorOccurred(obj.value("error").toString());
+    if (response.superseded) {
+        return;
+    }
+    if (!response.error.isEmpty()) {
+        emit errorOccurred(response.error);
         KLOG_WARN(QStringLiteral("WatchClient"),
                   QStringLiteral("handleResponse"),
                   QStringLiteral("api_request_error"),
                   QStringLiteral("daemon_error"),
                   QStringLiteral("json_rpc"),
                   logging::defaultWho(),
-                  QString(),
+                  pending.trace.id,
                   (nlohmann::json{{"method", pending.method.toStdString()},
                                  {"id", id}}));
         return;
     }
 
-    const QJsonValue resultValue = obj.value("result");
-    if (!resultValue.isObject()) {
-        emit errorOccurred(QStringLiteral("Malformed response result"));
-        return;
-    }
-
-    const QJsonObject result = resultValue.toObject();
-    KLOG_DEBUG(QStringLiteral("WatchClient"),
-               QStringLiteral("handleResponse"),
-               QStringLiteral("api_request_completed"),
-               QStringLiteral("daemon_response"),
-               QStringLiteral("json_rpc"),
-               logging::defaultWho(),
-               QString(),
-               (nlohmann::json{{"method", pending.method.toStdString()},
-                              {"id", id}}));
+    logRequestLatency(QStringLiteral("WatchClient"), pending.method, pending.trace,
+                      response.response);
     if (pending.method == "list_watch_rules") {
-        emit rulesLoaded(result.value("rules").toArray().toVariantList());
+        emit rulesLoaded(response.value.toList());
         return;
     }
 
     if (pending.method == "get_watch_signals_since") {
-        emit signalsLoaded(result.value("signals").toArray().toVariantList());
+        emit signalsLoaded(response.value.toList());
         return;
     }
 }
 
-QString WatchClient::socketPath() const
-{
-    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
-    if (!runtimeDir.isEmpty()) {
-        return runtimeDir + QStringLiteral("/khronicle.sock");
-    }
-    return QStringLiteral("/run/user/%1/khronicle.sock").arg(getuid());
-}
-
 } // namespace khronicle
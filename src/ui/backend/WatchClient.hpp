@@ -3,18 +3,21 @@
 #include <QDateTime>
 #include <QHash>
 #include <QJsonObject>
-#include <QLocalSocket>
 #include <QObject>
 #include <QVariantList>
 #include <QVariantMap>
 
+#include "common/request_trace.hpp"
+#include "ui/backend/DaemonConnection.hpp"
+#include "ui/backend/ResponseDecoder.hpp"
+
 namespace khronicle {
 
 class WatchClient : public QObject
 {
     Q_OBJECT
 public:
-    explicit WatchClient(QObject *parent = nullptr);
+    explicit WatchClient(DaemonConnection *connection, QObject *parent = nullptr);
     ~WatchClient() override;
 
     // QML-facing methods to manage watch rules/signals via local JSON-RPC.
@@ -31,16 +34,14 @@ signals:
 private:
     struct PendingRequest {
         QString method;
+        RequestTrace trace;
     };
 
-    QLocalSocket *m_socket = nullptr;
-    int m_nextRequestId = 1;
+    DaemonConnection *m_connection = nullptr;
     QHash<int, PendingRequest> m_pending;
 
-    void connectToDaemon();
     void sendRequest(const QString &method, const QJsonObject &params);
-    void handleResponse(const QJsonObject &obj);
-    QString socketPath() const;
+    void handleResponse(const DecodedResponse &response);
 };
 
 } // namespace khronicle
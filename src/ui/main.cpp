@@ -1,17 +1,20 @@
 #include <QCoreApplication>
 #include <memory>
-#include <chrono>
 #include <QGuiApplication>
 #include <QIcon>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QQuickStyle>
 #include <QCommandLineParser>
-#include <QThread>
 
 #include "ui/backend/KhronicleApiClient.hpp"
+#include "ui/backend/DaemonConnection.hpp"
 #include "ui/backend/DaemonController.hpp"
+#include "ui/backend/DiffModel.hpp"
 #include "ui/backend/FleetModel.hpp"
+#include "ui/backend/SnapshotListModel.hpp"
+#include "ui/backend/TimelineCache.hpp"
+#include "ui/backend/TimelineModel.hpp"
 #include "ui/backend/WatchClient.hpp"
 #include "common/logging.hpp"
 #include "common/process_utils.hpp"
@@ -37,7 +40,13 @@ int main(int argc, char *argv[])
 
     QUrl url;
     std::unique_ptr<khronicle::FleetModel> fleetModel;
+    std::unique_ptr<khronicle::DaemonConnection> daemonConnection;
     std::unique_ptr<khronicle::KhronicleApiClient> apiClient;
+    std::unique_ptr<khronicle::TimelineModel> timelineModel;
+    std::unique_ptr<khronicle::TimelineFilterModel> timelineFilter;
+    std::unique_ptr<khronicle::TimelineCache> timelineCache;
+    std::unique_ptr<khronicle::SnapshotListModel> snapshotList;
+    std::unique_ptr<khronicle::DiffModel> snapshotDiff;
     std::unique_ptr<khronicle::WatchClient> watchClient;
     std::unique_ptr<khronicle::DaemonController> daemonController;
 
@@ -59,46 +68,6 @@ int main(int argc, char *argv[])
               QString(),
               (nlohmann::json{{"fleetMode", parser.isSet(fleetOption)}}));
 
-    if (!parser.isSet(fleetOption)) {
-        if (!khronicle::isDaemonRunning()) {
-            KLOG_INFO(QStringLiteral("main"),
-                      QStringLiteral("main"),
-                      QStringLiteral("auto_start_daemon"),
-                      QStringLiteral("ui_start"),
-                      QStringLiteral("best_effort"),
-                      khronicle::logging::defaultWho(),
-                      QString(),
-                      nlohmann::json::object());
-            khronicle::startDaemon();
-            const auto start = std::chrono::steady_clock::now();
-            while (!khronicle::isDaemonRunning()) {
-                if (std::chrono::steady_clock::now() - start
-                    > std::chrono::seconds(5)) {
-                    break;
-                }
-                QThread::msleep(100);
-            }
-        }
-
-        const bool launchedFromTray =
-            qEnvironmentVariableIntValue("KHRONICLE_LAUNCHED_FROM_TRAY") == 1;
-        const bool trayAlreadyRunning = khronicle::isTrayRunning();
-        if (qEnvironmentVariableIntValue("KHRONICLE_NO_TRAY_ON_START") != 1
-            && !launchedFromTray
-            && !trayAlreadyRunning
-            && khronicle::isDaemonRunning()) {
-            KLOG_INFO(QStringLiteral("main"),
-                      QStringLiteral("main"),
-                      QStringLiteral("auto_start_tray"),
-                      QStringLiteral("ui_start"),
-                      QStringLiteral("best_effort"),
-                      khronicle::logging::defaultWho(),
-                      QString(),
-                      nlohmann::json::object());
-            khronicle::startTray();
-        }
-    }
-
     if (parser.isSet(fleetOption)) {
         // Fleet mode is offline and read-only: it loads aggregate JSON directly.
         fleetModel = std::make_unique<khronicle::FleetModel>();
@@ -111,15 +80,45 @@ int main(int argc, char *argv[])
             QStringLiteral(KHRONICLE_QML_DIR "/FleetMain.qml"));
     } else {
         // Normal mode connects to the daemon's local JSON-RPC API.
-        apiClient = std::make_unique<khronicle::KhronicleApiClient>();
+        // One socket to the daemon, shared by every client below.
+        daemonConnection = std::make_unique<khronicle::DaemonConnection>();
+        apiClient = std::make_unique<khronicle::KhronicleApiClient>(daemonConnection.get());
         engine.rootContext()->setContextProperty(QStringLiteral("khronicleApi"),
                                                  apiClient.get());
-        watchClient = std::make_unique<khronicle::WatchClient>();
+        timelineModel = std::make_unique<khronicle::TimelineModel>(apiClient.get());
+        timelineFilter = std::make_unique<khronicle::TimelineFilterModel>(timelineModel.get());
+        engine.rootContext()->setContextProperty(QStringLiteral("timelineModel"),
+                                                 timelineModel.get());
+        engine.rootContext()->setContextProperty(QStringLiteral("timelineFilter"),
+                                                 timelineFilter.get());
+        // Last session's overview, shown before the daemon answers; saved
+        // again on the way out.
+        timelineCache =
+            std::make_unique<khronicle::TimelineCache>(timelineModel.get(), apiClient.get());
+        engine.rootContext()->setContextProperty(QStringLiteral("timelineCache"),
+                                                 timelineCache.get());
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, timelineCache.get(),
+                         [cache = timelineCache.get()]() { cache->save(); });
+        snapshotList = std::make_unique<khronicle::SnapshotListModel>();
+        engine.rootContext()->setContextProperty(QStringLiteral("snapshotList"),
+                                                 snapshotList.get());
+        snapshotDiff = std::make_unique<khronicle::DiffModel>();
+        engine.rootContext()->setContextProperty(QStringLiteral("snapshotDiff"),
+                                                 snapshotDiff.get());
+        watchClient = std::make_unique<khronicle::WatchClient>(daemonConnection.get());
         engine.rootContext()->setContextProperty(QStringLiteral("watchClient"),
                                                  watchClient.get());
-        daemonController = std::make_unique<khronicle::DaemonController>();
+        daemonController =
+            std::make_unique<khronicle::DaemonController>(daemonConnection.get());
         engine.rootContext()->setContextProperty(QStringLiteral("daemonController"),
                                                  daemonController.get());
+        // Connect (and start the daemon and tray if needed) in the
+        // background; the window shows right away and fills in on connect.
+        const bool launchedFromTray =
+            qEnvironmentVariableIntValue("KHRONICLE_LAUNCHED_FROM_TRAY") == 1;
+        daemonController->connectOnStartup(
+            qEnvironmentVariableIntValue("KHRONICLE_NO_TRAY_ON_START") != 1
+            && !launchedFromTray);
         engine.rootContext()->setContextProperty(QStringLiteral("khronicleIconPath"),
                                                  iconPath);
         url = QUrl::fromLocalFile(
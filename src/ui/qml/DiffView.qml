@@ -5,23 +5,9 @@ import org.kde.kirigami as Kirigami
 
 Kirigami.Card {
     id: root
-    property var diffRows: []
-
-    function humanizePath(path) {
-        if (!path) {
-            return ""
-        }
-        if (path === "kernelVersion") {
-            return "Kernel"
-        }
-        if (path.indexOf("keyPackages.") === 0) {
-            return path.substring("keyPackages.".length)
-        }
-        if (path.indexOf("firmwareVersions.") === 0) {
-            return "Firmware: " + path.substring("firmwareVersions.".length)
-        }
-        return path
-    }
+    // A DiffModel; paths come already humanized as `label`.
+    property var diffRows: null
+    readonly property int rowCount: root.diffRows ? root.diffRows.count : 0
 
     contentItem: ColumnLayout {
         Layout.fillWidth: true
@@ -34,12 +20,12 @@ Kirigami.Card {
         }
 
         Kirigami.PlaceholderMessage {
-            visible: !(root.diffRows && root.diffRows.length > 0)
+            visible: root.rowCount === 0
             text: "No differences between these snapshots."
         }
 
         ColumnLayout {
-            visible: root.diffRows && root.diffRows.length > 0
+            visible: root.rowCount > 0
             spacing: Kirigami.Units.smallSpacing
 
             RowLayout {
@@ -65,11 +51,20 @@ Kirigami.Card {
                 }
             }
 
-            Repeater {
+            // Only the rows on screen get delegates; a full-inventory diff
+            // scrolls inside the card.
+            ListView {
+                id: rowsView
+                Layout.fillWidth: true
+                Layout.preferredHeight: Math.min(contentHeight, Kirigami.Units.gridUnit * 20)
                 model: root.diffRows
+                clip: true
+                reuseItems: true
+
+                ScrollBar.vertical: ScrollBar { }
 
                 delegate: ItemDelegate {
-                    width: root.width
+                    width: rowsView.width
 
                     contentItem: RowLayout {
                         spacing: Kirigami.Units.largeSpacing
@@ -77,20 +72,20 @@ Kirigami.Card {
                         Layout.fillWidth: true
 
                         Label {
-                            text: humanizePath(modelData.path)
+                            text: model.label
                             font.bold: true
                             Layout.preferredWidth: root.width * 0.3
                             wrapMode: Text.Wrap
                         }
 
                         Label {
-                            text: modelData.before || ""
+                            text: model.before
                             Layout.preferredWidth: root.width * 0.35
                             wrapMode: Text.Wrap
                         }
 
                         Label {
-                            text: modelData.after || ""
+                            text: model.after
                             Layout.preferredWidth: root.width * 0.35
                             wrapMode: Text.Wrap
                         }
@@ -13,6 +13,11 @@ Kirigami.ApplicationWindow {
     property var comparisonRows: []
     property string compareHostA: ""
     property string compareHostB: ""
+    property var fleetQueryRows: []
+
+    function splitTerms(text) {
+        return text.split(/[\s,]+/).filter(function(term) { return term.length > 0 })
+    }
 
     Connections {
         target: fleetModel
@@ -41,6 +46,14 @@ Kirigami.ApplicationWindow {
                         text: "Hosts"
                     }
 
+                    ProgressBar {
+                        Layout.fillWidth: true
+                        visible: fleetModel.loading
+                        from: 0
+                        to: 100
+                        value: fleetModel.loadProgress
+                    }
+
                     ListView {
                         id: hostList
                         Layout.fillWidth: true
@@ -141,6 +154,152 @@ Kirigami.ApplicationWindow {
                         }
                     }
                 }
+
+                Kirigami.Card {
+                    Layout.fillWidth: true
+                    contentItem: ColumnLayout {
+                        anchors.margins: Kirigami.Units.largeSpacing
+                        spacing: Kirigami.Units.smallSpacing
+
+                        Kirigami.Heading {
+                            level: 3
+                            text: "Fleet Timeline"
+                        }
+
+                        RowLayout {
+                            spacing: Kirigami.Units.smallSpacing
+                            Layout.fillWidth: true
+
+                            ComboBox {
+                                id: timelineCategory
+                                model: ["all", "kernel", "gpu_driver", "firmware", "package", "system"]
+                            }
+
+                            TextField {
+                                id: timelinePackages
+                                Layout.fillWidth: true
+                                placeholderText: "Packages (e.g. mesa linux)"
+                            }
+
+                            SpinBox {
+                                id: timelineDays
+                                from: 0
+                                to: 365
+                                value: 0
+                            }
+
+                            Button {
+                                text: "Apply"
+                                onClicked: {
+                                    var categories = timelineCategory.currentIndex > 0
+                                        ? [timelineCategory.currentText] : []
+                                    var from = timelineDays.value > 0
+                                        ? new Date(Date.now() - timelineDays.value * 24 * 3600 * 1000)
+                                        : new Date(NaN)
+                                    fleetModel.setTimelineFilter(categories,
+                                                                 splitTerms(timelinePackages.text),
+                                                                 from,
+                                                                 new Date(NaN))
+                                }
+                            }
+                        }
+
+                        ListView {
+                            id: fleetTimelineList
+                            Layout.fillWidth: true
+                            Layout.preferredHeight: 180
+                            model: fleetModel.timeline
+                            clip: true
+                            reuseItems: true
+
+                            delegate: RowLayout {
+                                spacing: Kirigami.Units.smallSpacing
+                                width: fleetTimelineList.width
+
+                                Label {
+                                    text: model.timestamp
+                                    Layout.preferredWidth: 180
+                                }
+
+                                Label {
+                                    text: model.hostLabel
+                                    Layout.preferredWidth: 140
+                                    elide: Text.ElideRight
+                                }
+
+                                Label {
+                                    text: model.summary
+                                    Layout.fillWidth: true
+                                    elide: Text.ElideRight
+                                }
+                            }
+                        }
+                    }
+                }
+
+                Kirigami.Card {
+                    Layout.fillWidth: true
+                    contentItem: ColumnLayout {
+                        anchors.margins: Kirigami.Units.largeSpacing
+                        spacing: Kirigami.Units.smallSpacing
+
+                        Kirigami.Heading {
+                            level: 3
+                            text: "Fleet Query"
+                        }
+
+                        RowLayout {
+                            spacing: Kirigami.Units.smallSpacing
+                            Layout.fillWidth: true
+
+                            TextField {
+                                id: installedTerms
+                                Layout.fillWidth: true
+                                placeholderText: "Runs (e.g. mesa>=24.1 linux-zen)"
+                            }
+
+                            TextField {
+                                id: receivedTerms
+                                Layout.fillWidth: true
+                                placeholderText: "Got (e.g. nvidia-utils=550)"
+                            }
+
+                            SpinBox {
+                                id: receivedDays
+                                from: 0
+                                to: 365
+                                value: 7
+                            }
+
+                            Button {
+                                text: "Query"
+                                onClicked: {
+                                    var since = ""
+                                    if (receivedDays.value > 0) {
+                                        var cutoff = new Date(Date.now() - receivedDays.value * 24 * 3600 * 1000)
+                                        since = cutoff.toISOString().replace(/\.\d{3}Z$/, "Z")
+                                    }
+                                    fleetQueryRows = fleetModel.fleetQuery(splitTerms(installedTerms.text),
+                                                                           splitTerms(receivedTerms.text),
+                                                                           since)
+                                }
+                            }
+                        }
+
+                        ListView {
+                            Layout.fillWidth: true
+                            Layout.preferredHeight: 120
+                            model: fleetQueryRows
+                            clip: true
+
+                            delegate: Label {
+                                width: parent ? parent.width : 0
+                                text: (modelData.label || modelData.hostId)
+                                      + "  " + JSON.stringify(modelData.installed)
+                            }
+                        }
+                    }
+                }
             }
         }
     }
@@ -10,17 +10,11 @@ Kirigami.ApplicationWindow {
     height: 700
     visible: true
 
-    property bool filterKernel: true
-    property bool filterGpu: true
-    property bool filterFirmware: true
-    property bool filterPackage: true
-
     property var currentFromDate: null
     property var currentToDate: null
     property string currentRange: "week"
 
-    property var rawEventsModel: []
-    property var eventsModel: []
+    property var demoEvents: []
     property var summaryData: ({})
     property var snapshotsModel: []
     property var diffModel: []
@@ -30,51 +24,26 @@ Kirigami.ApplicationWindow {
     property var compareFromDate: null
     property var compareToDate: null
 
-    function applyFilters() {
-        if (!root.rawEventsModel) {
-            root.eventsModel = []
-            return
-        }
-
-        var filtered = []
-        for (var i = 0; i < root.rawEventsModel.length; ++i) {
-            var ev = root.rawEventsModel[i]
-            var cat = (ev.category || "").toString().toLowerCase()
-
-            var keep = false
-            if (cat === "kernel" && root.filterKernel) {
-                keep = true
-            } else if ((cat === "gpu_driver" || cat === "gpu") && root.filterGpu) {
-                keep = true
-            } else if (cat === "firmware" && root.filterFirmware) {
-                keep = true
-            } else if (cat === "package" && root.filterPackage) {
-                keep = true
-            } else if (cat === "system") {
-                keep = true
-            }
-
-            if (keep && root.demoMode && root.currentFromDate && root.currentToDate) {
-                const evDate = new Date(ev.timestamp || "")
-                if (isNaN(evDate.getTime())
+    // The selector and diff views read C++ models fed from these.
+    onSnapshotsModelChanged: snapshotList.setSnapshots(root.snapshotsModel)
+    onDiffModelChanged: snapshotDiff.setRows(root.diffModel)
+
+    // Demo events are filtered to the selected range here; live data is
+    // paged from the daemon by timelineModel itself.
+    function applyDemoRange() {
+        var inRange = []
+        for (var i = 0; i < root.demoEvents.length; ++i) {
+            const ev = root.demoEvents[i]
+            const evDate = new Date(ev.timestamp || "")
+            if (root.currentFromDate && root.currentToDate
+                && (isNaN(evDate.getTime())
                     || evDate < root.currentFromDate
-                    || evDate > root.currentToDate) {
-                    keep = false
-                }
-            }
-
-            if (keep) {
-                filtered.push(ev)
+                    || evDate > root.currentToDate)) {
+                continue
             }
+            inRange.push(ev)
         }
-
-        filtered.sort(function(a, b) {
-            const aTime = a.timestamp || ""
-            const bTime = b.timestamp || ""
-            return bTime.localeCompare(aTime)
-        })
-
-        root.eventsModel = filtered
+        timelineModel.setEvents(inRange)
     }
 
     function selectDateRange(kind) {
@@ -107,9 +76,9 @@ Kirigami.ApplicationWindow {
         root.currentToDate = to
 
         if (root.demoMode) {
-            root.applyFilters()
+            root.applyDemoRange()
         } else if (root.apiConnected) {
-            khronicleApi.loadChangesBetween(from, to)
+            timelineModel.setRange(from, to)
             khronicleApi.loadSummarySince(from)
         }
     }
@@ -156,7 +125,7 @@ Kirigami.ApplicationWindow {
             totalEvents: 6
         }
 
-        root.rawEventsModel = [
+        root.demoEvents = [
             {
                 timestamp: isoHoursAgo(2),
                 category: "kernel",
@@ -194,7 +163,7 @@ Kirigami.ApplicationWindow {
                 details: "auto snapshot check"
             }
         ]
-        root.applyFilters()
+        root.applyDemoRange()
 
         root.snapshotsModel = [
             {
@@ -220,8 +189,8 @@ Kirigami.ApplicationWindow {
 
     function loadLiveData() {
         root.summaryData = ({})
-        root.rawEventsModel = []
-        root.eventsModel = []
+        root.demoEvents = []
+        timelineModel.clear()
         root.snapshotsModel = []
         root.diffModel = []
         root.explanationText = ""
@@ -233,6 +202,11 @@ Kirigami.ApplicationWindow {
     Component.onCompleted: {
         selectDateRange("week")
         if (!root.demoMode) {
+            // Show the last session right away; connecting reconciles it.
+            if (timelineCache.restore(root.currentFromDate, root.currentToDate)) {
+                root.summaryData = timelineCache.summary
+                root.snapshotsModel = timelineCache.snapshots
+            }
             khronicleApi.connectToDaemon()
         }
     }
@@ -249,10 +223,6 @@ Kirigami.ApplicationWindow {
         function onSummaryLoaded(summary) {
             root.summaryData = summary
         }
-        function onChangesLoaded(events) {
-            root.rawEventsModel = events
-            root.applyFilters()
-        }
         function onSnapshotsLoaded(snapshots) {
             root.snapshotsModel = snapshots
         }
@@ -269,17 +239,6 @@ Kirigami.ApplicationWindow {
         }
     }
 
-    Timer {
-        interval: 5000
-        repeat: true
-        running: true
-        onTriggered: {
-            if (daemonController) {
-                daemonController.refreshDaemonStatus()
-            }
-        }
-    }
-
     globalDrawer: Kirigami.GlobalDrawer {
         title: "Khronicle"
         actions: [
@@ -369,38 +328,26 @@ Kirigami.ApplicationWindow {
 
                     CheckBox {
                         text: "Kernel"
-                        checked: root.filterKernel
-                        onToggled: {
-                            root.filterKernel = checked
-                            root.applyFilters()
-                        }
+                        checked: timelineFilter.showKernel
+                        onToggled: timelineFilter.showKernel = checked
                     }
 
                     CheckBox {
                         text: "GPU"
-                        checked: root.filterGpu
-                        onToggled: {
-                            root.filterGpu = checked
-                            root.applyFilters()
-                        }
+                        checked: timelineFilter.showGpu
+                        onToggled: timelineFilter.showGpu = checked
                     }
 
                     CheckBox {
                         text: "Firmware"
-                        checked: root.filterFirmware
-                        onToggled: {
-                            root.filterFirmware = checked
-                            root.applyFilters()
-                        }
+                        checked: timelineFilter.showFirmware
+                        onToggled: timelineFilter.showFirmware = checked
                     }
 
                     CheckBox {
                         text: "Packages"
-                        checked: root.filterPackage
-                        onToggled: {
-                            root.filterPackage = checked
-                            root.applyFilters()
-                        }
+                        checked: timelineFilter.showPackage
+                        onToggled: timelineFilter.showPackage = checked
                     }
                 }
 
@@ -449,7 +396,7 @@ Kirigami.ApplicationWindow {
             TimelineView {
                 Layout.fillWidth: true
                 Layout.fillHeight: true
-                events: root.eventsModel
+                events: timelineFilter
                 onEventClicked: function(eventData) {
                     if (snapshotSelector) {
                         snapshotSelector.selectForTimestamp(eventData.timestamp)
@@ -460,7 +407,7 @@ Kirigami.ApplicationWindow {
             SnapshotSelector {
                 id: snapshotSelector
                 Layout.fillWidth: true
-                snapshots: root.snapshotsModel
+                snapshots: snapshotList
                 onCompareRequested: function(snapshotA, snapshotB) {
                     if (!snapshotA || !snapshotB) {
                         return
@@ -502,7 +449,7 @@ Kirigami.ApplicationWindow {
 
             DiffView {
                 Layout.fillWidth: true
-                diffRows: root.diffModel
+                diffRows: snapshotDiff
                 visible: root.diffModel && root.diffModel.length > 0
             }
         }
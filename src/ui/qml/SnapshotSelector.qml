@@ -6,96 +6,47 @@ import org.kde.kirigami as Kirigami
 Kirigami.Card {
     id: root
 
-    property var snapshots: []
-    property var sortedSnapshots: []
+    // A SnapshotListModel: sorted newest first, labels prepared in C++.
+    property var snapshots: null
+    readonly property int snapshotCount: root.snapshots ? root.snapshots.count : 0
 
     signal compareRequested(var snapshotA, var snapshotB)
 
     function selectForTimestamp(iso) {
-        if (!iso || !root.sortedSnapshots || root.sortedSnapshots.length === 0) {
+        if (!iso || !root.snapshots) {
             return
         }
-        const target = new Date(iso)
-        if (isNaN(target.getTime())) {
+        const closestIndex = root.snapshots.nearestIndex(iso)
+        if (closestIndex < 0) {
             return
         }
 
-        var closestIndex = 0
-        var closestDelta = Math.abs(new Date(root.sortedSnapshots[0].timestamp).getTime()
-            - target.getTime())
-
-        for (var i = 1; i < root.sortedSnapshots.length; ++i) {
-            const snapTime = new Date(root.sortedSnapshots[i].timestamp)
-            if (isNaN(snapTime.getTime())) {
-                continue
-            }
-            const delta = Math.abs(snapTime.getTime() - target.getTime())
-            if (delta < closestDelta) {
-                closestDelta = delta
-                closestIndex = i
-            }
-        }
-
         compareFrom.currentIndex = closestIndex
         compareTo.currentIndex = 0
         if (compareTo.currentIndex === compareFrom.currentIndex
-            && root.sortedSnapshots.length > 1) {
+            && root.snapshotCount > 1) {
             compareTo.currentIndex = 1
         }
     }
 
-    function formatTimestamp(iso) {
-        if (!iso) {
-            return ""
-        }
-        const date = new Date(iso)
-        if (isNaN(date.getTime())) {
-            return iso
-        }
-        return date.toLocaleString()
-    }
-
-    function formatSnapshot(snapshot) {
-        if (!snapshot) {
-            return ""
-        }
-        const timestamp = formatTimestamp(snapshot.timestamp)
-        const kernel = snapshot.kernelVersion || ""
-        if (timestamp && kernel) {
-            return timestamp + " • " + kernel
-        }
-        return timestamp || kernel || ""
-    }
-
-    function updateSortedSnapshots() {
-        if (!root.snapshots || root.snapshots.length === 0) {
-            root.sortedSnapshots = []
-            return
-        }
-        const sorted = root.snapshots.slice().sort(function(a, b) {
-            const aTime = a.timestamp || ""
-            const bTime = b.timestamp || ""
-            return bTime.localeCompare(aTime)
-        })
-        root.sortedSnapshots = sorted.map(function(snapshot) {
-            return {
-                id: snapshot.id,
-                timestamp: snapshot.timestamp,
-                kernelVersion: snapshot.kernelVersion,
-                label: formatSnapshot(snapshot)
-            }
-        })
-
-        if (sorted.length >= 2) {
+    function resetSelection() {
+        if (root.snapshotCount >= 2) {
             compareFrom.currentIndex = 1
             compareTo.currentIndex = 0
-        } else if (sorted.length === 1) {
+        } else if (root.snapshotCount === 1) {
             compareFrom.currentIndex = 0
             compareTo.currentIndex = 0
         }
     }
 
-    onSnapshotsChanged: updateSortedSnapshots()
+    // Emitted after every setSnapshots, once the combo boxes have the
+    // new rows.
+    Connections {
+        target: root.snapshots
+        function onCountChanged() {
+            root.resetSelection()
+        }
+    }
 
     contentItem: ColumnLayout {
         anchors.margins: Kirigami.Units.largeSpacing
@@ -121,7 +72,7 @@ Kirigami.Card {
                 ComboBox {
                     id: compareFrom
                     Layout.fillWidth: true
-                    model: root.sortedSnapshots
+                    model: root.snapshots
                     textRole: "label"
                     valueRole: "id"
 
@@ -143,7 +94,7 @@ Kirigami.Card {
                 ComboBox {
                     id: compareTo
                     Layout.fillWidth: true
-                    model: root.sortedSnapshots
+                    model: root.snapshots
                     textRole: "label"
                     valueRole: "id"
 
@@ -156,15 +107,15 @@ Kirigami.Card {
 
             Button {
                 text: "Compare"
-                enabled: root.sortedSnapshots.length > 0
+                enabled: root.snapshotCount > 0
                 Layout.alignment: Qt.AlignBottom
                 onClicked: {
                     if (compareFrom.currentIndex < 0 || compareTo.currentIndex < 0) {
                         return
                     }
-                    const fromSnapshot = root.sortedSnapshots[compareFrom.currentIndex]
-                    const toSnapshot = root.sortedSnapshots[compareTo.currentIndex]
-                    if (!fromSnapshot || !toSnapshot) {
+                    const fromSnapshot = root.snapshots.get(compareFrom.currentIndex)
+                    const toSnapshot = root.snapshots.get(compareTo.currentIndex)
+                    if (!fromSnapshot.id || !toSnapshot.id) {
                         return
                     }
                     root.compareRequested(fromSnapshot, toSnapshot)
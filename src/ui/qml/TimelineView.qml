@@ -5,12 +5,14 @@ import org.kde.kirigami as Kirigami
 
 Item {
     id: root
+    // A TimelineModel (through its filter), a FleetTimelineModel, or a plain
+    // array of event maps.
     property var events: []
     signal eventClicked(var eventData)
 
     Kirigami.PlaceholderMessage {
         anchors.centerIn: parent
-        visible: !(root.events && root.events.length > 0)
+        visible: listView.count === 0
         text: "No events matching the current filters."
         explanation: "Try changing the categories or date range."
     }
@@ -18,14 +20,15 @@ Item {
     ListView {
         id: listView
         anchors.fill: parent
-        visible: root.events && root.events.length > 0
+        visible: count > 0
         model: root.events
         spacing: Kirigami.Units.smallSpacing
         clip: true
+        reuseItems: true
 
         delegate: EventCard {
             width: listView.width
-            eventData: modelData
+            eventData: model.eventData !== undefined ? model.eventData : modelData
             onClicked: {
                 listView.currentIndex = index
                 root.eventClicked(eventData)
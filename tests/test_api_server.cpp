@@ -2,6 +2,7 @@
 
 #include <QDir>
 #include <QLocalSocket>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTemporaryDir>
@@ -23,6 +24,9 @@ private slots:
     void testBasicMethods();
     void testErrorHandling();
     void testRulesAndSignals();
+    void testTracePropagation();
+    void testSplitRequestOverSocket();
+    void testOversizedRequestLine();
 
 private:
     QTemporaryDir m_tempDir;
@@ -138,6 +142,59 @@ void ApiServerTests::testBasicMethods()
         {"b", "snap-1"}
     });
     QVERIFY(diff.contains("result"));
+
+    const QString from =
+        QString::fromStdString(khronicle::toIso8601Utc(event.timestamp - std::chrono::hours(1)));
+    const QString to =
+        QString::fromStdString(khronicle::toIso8601Utc(event.timestamp + std::chrono::hours(1)));
+    const auto page = sendRequest(server, "get_changes_page", {
+        {"from", from}, {"to", to}, {"limit", 1}
+    });
+    const QJsonObject pageResult = page["result"].toObject();
+    QCOMPARE(pageResult["events"].toArray().size(), 1);
+    QVERIFY(pageResult["nextCursor"].isNull());
+    const qint64 generation = static_cast<qint64>(pageResult["generation"].toDouble());
+    QVERIFY(generation > 0);
+
+    const auto unchanged = sendRequest(server, "get_changes_after_generation", {
+        {"generation", generation}, {"from", from}, {"to", to}
+    });
+    const QJsonObject unchangedResult = unchanged["result"].toObject();
+    QVERIFY(unchangedResult["complete"].toBool());
+    QVERIFY(unchangedResult["events"].toArray().isEmpty());
+    QCOMPARE(static_cast<qint64>(unchangedResult["generation"].toDouble()), generation);
+
+    khronicle::KhronicleEvent later = event;
+    later.id = "event-2";
+    store.addEvent(later);
+    const auto changed = sendRequest(server, "get_changes_after_generation", {
+        {"generation", generation}, {"from", from}, {"to", to}
+    });
+    const QJsonObject changedResult = changed["result"].toObject();
+    QVERIFY(changedResult["complete"].toBool());
+    QCOMPARE(changedResult["events"].toArray().size(), 1);
+    QVERIFY(changedResult["generation"].toDouble() > generation);
+
+    // More changes than the limit, or a generation this store never had,
+    // tell the client to reload.
+    const auto overflow = sendRequest(server, "get_changes_after_generation", {
+        {"generation", 0}, {"from", from}, {"to", to}, {"limit", 1}
+    });
+    QVERIFY(!overflow["result"].toObject()["complete"].toBool());
+    const auto unknown = sendRequest(server, "get_changes_after_generation", {
+        {"generation", generation + 100}, {"from", from}, {"to", to}
+    });
+    QVERIFY(!unknown["result"].toObject()["complete"].toBool());
+
+    const auto badGeneration = sendRequest(server, "get_changes_after_generation", {
+        {"generation", "latest"}, {"from", from}, {"to", to}
+    });
+    QVERIFY(badGeneration.contains("error"));
+
+    const auto badLimit = sendRequest(server, "get_changes_page", {
+        {"from", from}, {"to", to}, {"limit", 0}
+    });
+    QVERIFY(badLimit.contains("error"));
 }
 
 void ApiServerTests::testErrorHandling()
@@ -163,6 +220,116 @@ void ApiServerTests::testRulesAndSignals()
         {"since", QString::fromStdString(khronicle::toIso8601Utc(std::chrono::system_clock::now()))}
     });
     QVERIFY(watchSignals["result"].toObject().contains("signals"));
+
+    const auto count = sendRequest(server, "count_watch_signals_since", {
+        {"since", QString::fromStdString(khronicle::toIso8601Utc(std::chrono::system_clock::now()))},
+        {"severity", "critical"}
+    });
+    QCOMPARE(count["result"].toObject()["count"].toInt(-1), 0);
+
+    const auto badSeverity = sendRequest(server, "count_watch_signals_since", {
+        {"since", QString::fromStdString(khronicle::toIso8601Utc(std::chrono::system_clock::now()))},
+        {"severity", "urgent"}
+    });
+    QVERIFY(badSeverity.contains("error"));
+
+    // Pushes need a connection to go to.
+    const auto subscribe = sendRequest(server, "subscribe_watch_signals");
+    QVERIFY(subscribe.contains("error"));
+}
+
+void ApiServerTests::testTracePropagation()
+{
+    resetDb();
+    khronicle::KhronicleStore store;
+    khronicle::KhronicleApiServer server(store);
+
+    QJsonObject root;
+    root["id"] = 7;
+    root["method"] = "list_snapshots";
+    root["trace"] = QJsonObject{{"id", "trace-abc"}, {"sentAtUs", 0}};
+    const auto receivedAt = std::chrono::steady_clock::now() - std::chrono::milliseconds(5);
+    const QByteArray response = server.handleRequestPayload(
+        QJsonDocument(root).toJson(QJsonDocument::Compact), receivedAt);
+
+    const QJsonObject obj = QJsonDocument::fromJson(response).object();
+    QCOMPARE(obj.value("id").toInt(), 7);
+    QVERIFY(obj.value("result").toObject().contains("snapshots"));
+
+    const QJsonObject trace = obj.value("trace").toObject();
+    QCOMPARE(trace.value("id").toString(), QStringLiteral("trace-abc"));
+    QVERIFY(trace.value("queueWaitUs").toInteger() >= 5000);
+    QVERIFY(trace.contains("queryUs"));
+    QVERIFY(trace.contains("serializeUs"));
+
+    // Unusable ids are replaced rather than echoed into the logs.
+    root["trace"] = QJsonObject{{"id", QString(200, QLatin1Char('x'))}};
+    const QJsonObject replaced = QJsonDocument::fromJson(server.handleRequestPayload(
+        QJsonDocument(root).toJson(QJsonDocument::Compact))).object();
+    QVERIFY(!replaced.value("trace").toObject().value("id").toString().isEmpty());
+    QVERIFY(replaced.value("trace").toObject().value("id").toString().size() < 200);
+}
+
+void ApiServerTests::testSplitRequestOverSocket()
+{
+    resetDb();
+    khronicle::KhronicleStore store;
+    khronicle::KhronicleApiServer server(store);
+    QVERIFY(server.start());
+
+    QLocalSocket socket;
+    socket.connectToServer(m_tempDir.path() + "/khronicle.sock");
+    QVERIFY(socket.waitForConnected(1000));
+
+    // One request in two writes, the second also carrying the start of the
+    // next request.
+    const QByteArray first = R"({"id":7,"method":"list_watch_rules","params":{}})";
+    const QByteArray second = R"({"id":8,"method":"list_watch_rules"})";
+    const QByteArray stream = first + '\n' + second + '\n';
+    const qsizetype split = first.size() / 2;
+    const qsizetype secondSplit = first.size() + 1 + second.size() / 2;
+    socket.write(stream.left(split));
+    socket.flush();
+    QTest::qWait(50);
+    socket.write(stream.mid(split, secondSplit - split));
+    socket.flush();
+    QTest::qWait(50);
+    socket.write(stream.mid(secondSplit));
+    socket.flush();
+
+    QByteArray received;
+    QTRY_COMPARE((received += socket.readAll()).count('\n'), 2);
+    const QList<QByteArray> lines = received.trimmed().split('\n');
+    QCOMPARE(lines.size(), 2);
+    const QJsonObject response7 = QJsonDocument::fromJson(lines[0]).object();
+    const QJsonObject response8 = QJsonDocument::fromJson(lines[1]).object();
+    QCOMPARE(response7["id"].toInt(), 7);
+    QVERIFY(response7["result"].toObject().contains("rules"));
+    QCOMPARE(response8["id"].toInt(), 8);
+    QVERIFY(!response8.contains("error"));
+}
+
+void ApiServerTests::testOversizedRequestLine()
+{
+    resetDb();
+    khronicle::KhronicleStore store;
+    khronicle::KhronicleApiServer server(store);
+    QVERIFY(server.start());
+
+    QLocalSocket socket;
+    socket.connectToServer(m_tempDir.path() + "/khronicle.sock");
+    QVERIFY(socket.waitForConnected(1000));
+
+    // A peer that never sends a newline is answered and dropped instead of
+    // being buffered without bound.
+    socket.write(QByteArray(1024 * 1024 + 1, 'x'));
+    socket.flush();
+
+    QByteArray received;
+    QTRY_VERIFY((received += socket.readAll()).contains('\n'));
+    const QJsonObject response = QJsonDocument::fromJson(received.trimmed()).object();
+    QCOMPARE(response["error"].toString(), QStringLiteral("Request line too long"));
+    QTRY_COMPARE(socket.state(), QLocalSocket::UnconnectedState);
 }
 
 QTEST_MAIN(ApiServerTests)
@@ -0,0 +1,188 @@
+#include <QtTest/QtTest>
+
+#include <QSet>
+#include <QTemporaryDir>
+
+#include <chrono>
+#include <memory>
+
+#include "common/request_trace.hpp"
+#include "daemon/khronicle_api_server.hpp"
+#include "daemon/khronicle_store.hpp"
+#include "ui/backend/DaemonConnection.hpp"
+#include "ui/backend/DaemonController.hpp"
+
+class DaemonConnectionTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testQueuedUntilDaemonStarts();
+    void testCoalescesIdenticalReads();
+    void testControllerFollowsConnection();
+    void testWatchSignalPush();
+
+private:
+    QTemporaryDir m_tempDir;
+    QByteArray m_prevHome;
+    QByteArray m_prevRuntime;
+};
+
+void DaemonConnectionTests::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    m_prevHome = qgetenv("HOME");
+    m_prevRuntime = qgetenv("XDG_RUNTIME_DIR");
+    qputenv("HOME", m_tempDir.path().toUtf8());
+    qputenv("XDG_RUNTIME_DIR", m_tempDir.path().toUtf8());
+}
+
+void DaemonConnectionTests::cleanupTestCase()
+{
+    if (m_prevHome.isEmpty()) {
+        qunsetenv("HOME");
+    } else {
+        qputenv("HOME", m_prevHome);
+    }
+    if (m_prevRuntime.isEmpty()) {
+        qunsetenv("XDG_RUNTIME_DIR");
+    } else {
+        qputenv("XDG_RUNTIME_DIR", m_prevRuntime);
+    }
+}
+
+void DaemonConnectionTests::testQueuedUntilDaemonStarts()
+{
+    khronicle::DaemonConnection connection;
+    QSignalSpy responses(&connection, &khronicle::DaemonConnection::responseReady);
+    QSignalSpy errors(&connection, &khronicle::DaemonConnection::errorOccurred);
+
+    // No daemon yet: the request waits and the connection keeps retrying.
+    const int id = connection.send(QStringLiteral("list_snapshots"),
+                                   QJsonObject(),
+                                   khronicle::startRequestTrace());
+    QTRY_COMPARE(errors.count(), 1);
+    QVERIFY(!connection.isConnected());
+    QVERIFY(responses.isEmpty());
+
+    khronicle::KhronicleStore store;
+    auto server = std::make_unique<khronicle::KhronicleApiServer>(store);
+    QVERIFY(server->start());
+
+    QTRY_COMPARE(responses.count(), 1);
+    QVERIFY(connection.isConnected());
+    const auto response = responses.first().first().value<khronicle::DecodedResponse>();
+    QCOMPARE(response.id, id);
+    QVERIFY(response.error.isEmpty());
+    QVERIFY(response.result.value(QStringLiteral("snapshots")).isArray());
+    // Retries while the daemon was down are not reported one by one.
+    QCOMPARE(errors.count(), 1);
+}
+
+void DaemonConnectionTests::testCoalescesIdenticalReads()
+{
+    khronicle::KhronicleStore store;
+    khronicle::KhronicleApiServer server(store);
+    QVERIFY(server.start());
+
+    khronicle::DaemonConnection connection;
+    connection.connectToDaemon();
+    QTRY_VERIFY(connection.isConnected());
+
+    QSignalSpy responses(&connection, &khronicle::DaemonConnection::responseReady);
+    const QString view = QStringLiteral("snapshots");
+    const int first = connection.send(QStringLiteral("list_snapshots"),
+                                      QJsonObject(),
+                                      khronicle::startRequestTrace(),
+                                      view);
+    const int second = connection.send(QStringLiteral("list_snapshots"),
+                                       QJsonObject(),
+                                       khronicle::startRequestTrace(),
+                                       view);
+    QVERIFY(first != second);
+
+    QTRY_COMPARE(responses.count(), 2);
+    QSet<int> ids;
+    for (const auto &arguments : responses) {
+        const auto response = arguments.first().value<khronicle::DecodedResponse>();
+        QVERIFY(!response.superseded);
+        QCOMPARE(response.result, responses.first().first()
+                                      .value<khronicle::DecodedResponse>().result);
+        ids.insert(response.id);
+    }
+    QCOMPARE(ids, (QSet<int>{first, second}));
+
+    // Once answered, the same read goes to the daemon again.
+    const int third = connection.send(QStringLiteral("list_snapshots"),
+                                      QJsonObject(),
+                                      khronicle::startRequestTrace(),
+                                      view);
+    QTRY_COMPARE(responses.count(), 3);
+    QCOMPARE(responses.last().first().value<khronicle::DecodedResponse>().id, third);
+}
+
+void DaemonConnectionTests::testControllerFollowsConnection()
+{
+    khronicle::KhronicleStore store;
+    auto server = std::make_unique<khronicle::KhronicleApiServer>(store);
+    QVERIFY(server->start());
+
+    khronicle::DaemonConnection connection;
+    khronicle::DaemonController controller(&connection);
+    QVERIFY(!controller.daemonRunning());
+
+    connection.connectToDaemon();
+    QTRY_VERIFY(controller.daemonRunning());
+
+    // The daemon going away closes the socket; no polling involved.
+    server.reset();
+    QTRY_VERIFY(!controller.daemonRunning());
+
+    server = std::make_unique<khronicle::KhronicleApiServer>(store);
+    QVERIFY(server->start());
+    QTRY_VERIFY(controller.daemonRunning());
+}
+
+void DaemonConnectionTests::testWatchSignalPush()
+{
+    khronicle::KhronicleStore store;
+    khronicle::KhronicleApiServer server(store);
+    QVERIFY(server.start());
+
+    khronicle::DaemonConnection connection;
+    QSignalSpy notifications(&connection, &khronicle::DaemonConnection::notificationReceived);
+    QSignalSpy responses(&connection, &khronicle::DaemonConnection::responseReady);
+    connection.subscribe(QStringLiteral("subscribe_watch_signals"),
+                         QJsonObject{{"minSeverity", "critical"}});
+    // Requests on one connection are handled in order, so once this is
+    // answered the subscription is in place.
+    connection.send(QStringLiteral("list_snapshots"), QJsonObject(),
+                    khronicle::startRequestTrace());
+    QTRY_COMPARE(responses.count(), 1);
+
+    khronicle::WatchSignal signal;
+    signal.id = "sig-push";
+    signal.timestamp = std::chrono::system_clock::now();
+    signal.ruleId = "rule-1";
+    signal.ruleName = "Kernel";
+    signal.severity = khronicle::WatchSeverity::Warning;
+    signal.originType = "event";
+    signal.originId = "event-1";
+    server.publishWatchSignal(signal);
+    signal.severity = khronicle::WatchSeverity::Critical;
+    server.publishWatchSignal(signal);
+
+    QTRY_COMPARE(notifications.count(), 1);
+    QCOMPARE(notifications.first().at(0).toString(), QStringLiteral("watch_signal"));
+    const QJsonObject pushed =
+        notifications.first().at(1).toJsonObject().value("signal").toObject();
+    QCOMPARE(pushed.value("id").toString(), QStringLiteral("sig-push"));
+    QCOMPARE(pushed.value("severity").toString(), QStringLiteral("critical"));
+    // Pushes are not responses.
+    QCOMPARE(responses.count(), 1);
+}
+
+QTEST_MAIN(DaemonConnectionTests)
+#include "test_daemon_connection.moc"
@@ -0,0 +1,185 @@
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+#include "common/fleet_index.hpp"
+#include "common/json_utils.hpp"
+
+namespace {
+
+nlohmann::json pacmanEvent(const std::string &timestamp,
+                           const std::string &package,
+                           const std::string &version)
+{
+    return nlohmann::json{
+        {"id", "pacman-" + timestamp + "-" + package},
+        {"timestamp", timestamp},
+        {"category", "package"},
+        {"source", "pacman"},
+        {"summary", package + " upgraded"},
+        {"afterState", {{"version", version}}},
+        {"relatedPackages", {package}}
+    };
+}
+
+nlohmann::json host(const std::string &hostId,
+                    const nlohmann::json &keyPackages,
+                    const nlohmann::json &events)
+{
+    return nlohmann::json{
+        {"hostIdentity", {{"hostId", hostId}, {"hostname", hostId}}},
+        {"snapshots", nlohmann::json::array({
+            {{"id", hostId + "-snap"},
+             {"timestamp", "2024-05-01T00:00:00Z"},
+             {"keyPackages", keyPackages}}
+        })},
+        {"events", events}
+    };
+}
+
+std::vector<std::string> sorted(std::vector<std::string> values)
+{
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+} // namespace
+
+class FleetIndexTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testBitsetOperations();
+    void testInstalledIntersection();
+    void testReceivedSince();
+    void testHistoryOverridesSnapshot();
+    void testLowerBoundWithPkgrel();
+};
+
+void FleetIndexTests::testBitsetOperations()
+{
+    khronicle::HostBitset a;
+    a.set(1);
+    a.set(70);
+    khronicle::HostBitset b;
+    b.set(70);
+    b.set(130);
+
+    khronicle::HostBitset both = a;
+    both &= b;
+    QCOMPARE(both.count(), static_cast<std::size_t>(1));
+    QVERIFY(both.test(70));
+
+    khronicle::HostBitset either = a;
+    either |= b;
+    QCOMPARE(either.members(), (std::vector<std::size_t>{1, 70, 130}));
+
+    const khronicle::HostBitset all = khronicle::HostBitset::full(65);
+    QCOMPARE(all.count(), static_cast<std::size_t>(65));
+    QVERIFY(!all.test(65));
+}
+
+void FleetIndexTests::testInstalledIntersection()
+{
+    const nlohmann::json aggregate{
+        {"hosts", nlohmann::json::array({
+            host("host-a", {{"mesa", "24.1.3-1"}, {"linux-zen", "6.9.1.zen1-1"}},
+                 nlohmann::json::array()),
+            host("host-b", {{"mesa", "24.1.3-1"}, {"linux", "6.9.1.arch1-1"}},
+                 nlohmann::json::array()),
+            host("host-c", {{"mesa", "24.10.1-1"}, {"linux-zen", "6.9.1.zen1-1"}},
+                 nlohmann::json::array())
+        })}
+    };
+
+    const auto index = khronicle::FleetIndex::fromAggregate(aggregate);
+    QCOMPARE(index.hostCount(), static_cast<std::size_t>(3));
+
+    khronicle::FleetQuery query;
+    query.terms.push_back(*khronicle::parseFleetQueryTerm(
+        khronicle::FleetQueryTerm::Kind::Installed, "mesa=24.1"));
+    QCOMPARE(sorted(index.queryHostIds(query)),
+             (std::vector<std::string>{"host-a", "host-b"}));
+
+    query.terms.push_back(*khronicle::parseFleetQueryTerm(
+        khronicle::FleetQueryTerm::Kind::Installed, "linux-zen"));
+    QCOMPARE(index.queryHostIds(query), (std::vector<std::string>{"host-a"}));
+
+    QVERIFY(!khronicle::parseFleetQueryTerm(
+                 khronicle::FleetQueryTerm::Kind::Installed, "=1.0")
+                 .has_value());
+}
+
+void FleetIndexTests::testReceivedSince()
+{
+    const nlohmann::json aggregate{
+        {"hosts", nlohmann::json::array({
+            host("host-a", nlohmann::json::object(),
+                 nlohmann::json::array({pacmanEvent("2024-05-20T10:00:00Z",
+                                                    "nvidia-utils", "550.78-1")})),
+            host("host-b", nlohmann::json::object(),
+                 nlohmann::json::array({pacmanEvent("2024-04-01T10:00:00Z",
+                                                    "nvidia-utils", "550.67-1")}))
+        })}
+    };
+
+    const auto index = khronicle::FleetIndex::fromAggregate(aggregate);
+
+    khronicle::FleetQuery query;
+    query.terms.push_back(*khronicle::parseFleetQueryTerm(
+        khronicle::FleetQueryTerm::Kind::Received, "nvidia-utils=550"));
+    QCOMPARE(index.queryHostIds(query).size(), static_cast<std::size_t>(2));
+
+    query.since = khronicle::fromIso8601Utc("2024-05-15T00:00:00Z");
+    QCOMPARE(index.queryHostIds(query), (std::vector<std::string>{"host-a"}));
+}
+
+void FleetIndexTests::testHistoryOverridesSnapshot()
+{
+    // The snapshot was taken on 2024-05-01; a later upgrade wins.
+    const nlohmann::json aggregate{
+        {"hosts", nlohmann::json::array({
+            host("host-a", {{"mesa", "24.0.5-1"}},
+                 nlohmann::json::array({pacmanEvent("2024-05-02T08:00:00Z",
+                                                    "mesa", "24.1.0-1"),
+                                        pacmanEvent("2024-04-02T08:00:00Z",
+                                                    "mesa", "23.3.0-1")}))
+        })}
+    };
+
+    const auto index = khronicle::FleetIndex::fromAggregate(aggregate);
+    QCOMPARE(index.installedVersion(0, "mesa"), std::string("24.1.0-1"));
+
+    khronicle::FleetQuery query;
+    query.terms.push_back(*khronicle::parseFleetQueryTerm(
+        khronicle::FleetQueryTerm::Kind::Installed, "mesa=24.0"));
+    QVERIFY(index.queryHostIds(query).empty());
+}
+
+void FleetIndexTests::testLowerBoundWithPkgrel()
+{
+    // "1.0" has no pkgrel and so equals "1.0-1" under vercmp, though its
+    // sort key comes first.
+    const nlohmann::json aggregate{
+        {"hosts", nlohmann::json::array({
+            host("host-a", {{"libfoo", "1.0"}}, nlohmann::json::array()),
+            host("host-b", {{"libfoo", "0.9-1"}}, nlohmann::json::array()),
+            host("host-c", {{"libfoo", "1.1-1"}}, nlohmann::json::array())
+        })}
+    };
+    const auto index = khronicle::FleetIndex::fromAggregate(aggregate);
+
+    khronicle::FleetQuery atLeast;
+    atLeast.terms.push_back(*khronicle::parseFleetQueryTerm(
+        khronicle::FleetQueryTerm::Kind::Installed, "libfoo>=1.0-1"));
+    QCOMPARE(sorted(index.queryHostIds(atLeast)),
+             (std::vector<std::string>{"host-a", "host-c"}));
+
+    khronicle::FleetQuery above;
+    above.terms.push_back(*khronicle::parseFleetQueryTerm(
+        khronicle::FleetQueryTerm::Kind::Installed, "libfoo>1.0-1"));
+    QCOMPARE(index.queryHostIds(above), (std::vector<std::string>{"host-c"}));
+}
+
+QTEST_MAIN(FleetIndexTests)
+#include "test_fleet_index.moc"
@@ -10,6 +10,10 @@ class FleetModelTests : public QObject
     Q_OBJECT
 private slots:
     void testLoadAggregate();
+    void testTimeIndexedQueries();
+    void testRowsOnDemand();
+    void testLoadErrors();
+    void testFleetTimeline();
 };
 
 void FleetModelTests::testLoadAggregate()
@@ -24,7 +28,12 @@ void FleetModelTests::testLoadAggregate()
     file.close();
 
     khronicle::FleetModel model;
+    QSignalSpy hostsChanged(&model, &khronicle::FleetModel::hostsChanged);
     model.loadAggregateFile(path);
+    QVERIFY(model.loading());
+    QTRY_COMPARE(hostsChanged.count(), 1);
+    QVERIFY(!model.loading());
+    QCOMPARE(model.loadProgress(), 100);
 
     const QVariantList hosts = model.hosts();
     QCOMPARE(hosts.size(), 1);
@@ -32,5 +41,256 @@ void FleetModelTests::testLoadAggregate()
     QCOMPARE(host.value("hostId").toString(), QStringLiteral("host-a"));
 }
 
+void FleetModelTests::testTimeIndexedQueries()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    // Events out of order in the file, one without a usable timestamp.
+    const QString path = tempDir.path() + "/aggregate.json";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(R"({"hosts":[
+        {"hostIdentity":{"hostId":"host-a"},"snapshots":[],"events":[
+            {"id":"a-3","timestamp":"2026-01-01T02:30:00Z"},
+            {"id":"a-1","timestamp":"2026-01-01T00:10:00Z"},
+            {"id":"a-bad","timestamp":"yesterday"},
+            {"id":"a-2","timestamp":"2026-01-01T00:59:59Z"}]},
+        {"hostIdentity":{"hostId":"host-b"},"snapshots":[],"events":[
+            {"id":"b-1","timestamp":"2026-01-01T01:00:00Z"}]}
+    ]})");
+    file.close();
+
+    khronicle::FleetModel model;
+    model.loadAggregateFile(path);
+    QTRY_VERIFY(!model.loading());
+
+    const QDateTime from = QDateTime::fromString("2026-01-01T00:00:00Z", Qt::ISODate);
+    const auto ids = [](const QVariantList &events) {
+        QStringList result;
+        for (const QVariant &event : events) {
+            result.push_back(event.toMap().value("id").toString());
+        }
+        return result;
+    };
+
+    QCOMPARE(ids(model.eventsBetween("host-a", from, from.addSecs(3 * 3600))),
+             (QStringList{"a-1", "a-2", "a-3"}));
+    // The end of the range is exclusive.
+    QCOMPARE(ids(model.eventsBetween("host-a", from, from.addSecs(9000))),
+             (QStringList{"a-1", "a-2"}));
+    QVERIFY(model.eventsBetween("missing", from, from.addSecs(3600)).isEmpty());
+
+    const QVariantList hourly =
+        model.compareHosts("host-a", "host-b", from, from.addSecs(3 * 3600), 3600);
+    QCOMPARE(hourly.size(), 3);
+    QCOMPARE(hourly.at(0).toMap().value("timeBucket").toString(),
+             QStringLiteral("2026-01-01T00:00:00Z"));
+    QCOMPARE(ids(hourly.at(0).toMap().value("hostAEvents").toList()),
+             (QStringList{"a-1", "a-2"}));
+    QCOMPARE(ids(hourly.at(1).toMap().value("hostBEvents").toList()), QStringList{"b-1"});
+    QVERIFY(hourly.at(1).toMap().value("hostAEvents").toList().isEmpty());
+    QCOMPARE(ids(hourly.at(2).toMap().value("hostAEvents").toList()), QStringList{"a-3"});
+
+    // Any bucket size; the last bucket is cut at the end of the range.
+    const QVariantList wide =
+        model.compareHosts("host-a", "host-b", from, from.addSecs(9000), 7200);
+    QCOMPARE(wide.size(), 2);
+    QCOMPARE(ids(wide.at(0).toMap().value("hostAEvents").toList()),
+             (QStringList{"a-1", "a-2"}));
+    QVERIFY(wide.at(1).toMap().value("hostAEvents").toList().isEmpty());
+
+    QVERIFY(model.compareHosts("host-a", "host-b", from, from.addSecs(3600), 0).isEmpty());
+    QVERIFY(model.compareHosts("host-a", "host-b", from, from.addYears(10), 1).isEmpty());
+}
+
+void FleetModelTests::testRowsOnDemand()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    const QString path = tempDir.path() + "/aggregate.json";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(R"({"generatedAt":"2026-01-02T00:00:00Z","hosts":[
+        {"hostIdentity":{"hostId":"host-a","hostname":"alpha"},
+         "snapshots":[{"id":"snap-1","timestamp":"2026-01-01T00:00:00Z",
+                       "keyPackages":{"mesa":"24.1"}}],
+         "events":[
+            {"id":"k-1","timestamp":"2026-01-01T01:00:00Z","category":"kernel",
+             "source":"pacman","summary":"kernel upgraded",
+             "beforeState":{"kernelVersion":"6.1"},"afterState":{"kernelVersion":"6.2"},
+             "relatedPackages":["linux"]},
+            {"id":"m-1","timestamp":"2026-01-01T02:00:00Z","category":"gpu_driver",
+             "source":"pacman","summary":"mesa upgraded",
+             "beforeState":{"version":"24.1"},"afterState":{"version":"24.2"},
+             "relatedPackages":["mesa"]}]}
+    ]})");
+    file.close();
+
+    khronicle::FleetModel model;
+    model.loadAggregateFile(path);
+    QTRY_VERIFY(!model.loading());
+
+    QCOMPARE(model.selectedHostId(), QStringLiteral("host-a"));
+    QCOMPARE(model.hosts().first().toMap().value("label").toString(), QStringLiteral("alpha"));
+    QCOMPARE(model.snapshots().size(), 1);
+
+    khronicle::FleetTimelineModel *events = model.events();
+    QCOMPARE(events->rowCount(), 2);
+    const QVariantMap kernel = events->get(0);
+    QCOMPARE(kernel.value("category").toString(), QStringLiteral("kernel"));
+    QCOMPARE(kernel.value("hostId").toString(), QStringLiteral("host-a"));
+    QCOMPARE(kernel.value("afterState").toMap().value("kernelVersion").toString(),
+             QStringLiteral("6.2"));
+    QCOMPARE(kernel.value("relatedPackages").toList().first().toString(),
+             QStringLiteral("linux"));
+
+    const QVariantMap summary = model.summary();
+    QVERIFY(summary.value("kernelChanged").toBool());
+    QCOMPARE(summary.value("kernelFrom").toString(), QStringLiteral("6.1"));
+    QCOMPARE(summary.value("kernelTo").toString(), QStringLiteral("6.2"));
+    QCOMPARE(summary.value("gpuEvents").toInt(), 1);
+    QCOMPARE(summary.value("totalEvents").toInt(), 2);
+
+    // The package history reaches the fleet index too.
+    const QVariantList received = model.fleetQuery({}, {"mesa=24.2"}, QString());
+    QCOMPARE(received.size(), 1);
+    // The upgrade is newer than the snapshot, so it is what is installed.
+    QCOMPARE(model.fleetQuery({"mesa=24.2"}, {}, QString()).size(), 1);
+    QVERIFY(model.fleetQuery({"mesa=24.1"}, {}, QString()).isEmpty());
+}
+
+void FleetModelTests::testLoadErrors()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    khronicle::FleetModel model;
+    QSignalSpy errors(&model, &khronicle::FleetModel::errorOccurred);
+    model.loadAggregateFile(tempDir.path() + "/missing.json");
+    QTRY_COMPARE(errors.count(), 1);
+    QVERIFY(!model.loading());
+
+    const QString path = tempDir.path() + "/broken.json";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(R"({"hosts":[{"hostIdentity":{"hostId":"host-a"},"events":[{"id":)");
+    file.close();
+    model.loadAggregateFile(path);
+    QTRY_COMPARE(errors.count(), 2);
+    QCOMPARE(errors.last().first().toString(), QStringLiteral("Invalid aggregate JSON"));
+    QVERIFY(model.hosts().isEmpty());
+}
+
+void FleetModelTests::testFleetTimeline()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    // host-c has more events than one scan step; only its last one touches
+    // "libdrm".
+    QByteArray hostC;
+    const QDateTime base = QDateTime::fromString("2026-02-01T00:00:00Z", Qt::ISODate);
+    const int manyEvents = khronicle::FleetTimelineModel::kScanStep + 50;
+    for (int i = 0; i < manyEvents; ++i) {
+        if (i > 0) {
+            hostC += ",";
+        }
+        hostC += QStringLiteral(R"({"id":"c-%1","timestamp":"%2","category":"package",)"
+                                R"("summary":"mesa rebuilt","relatedPackages":["mesa"%3]})")
+                     .arg(i)
+                     .arg(base.addSecs(i * 60).toString(Qt::ISODate))
+                     .arg(i == manyEvents - 1 ? QStringLiteral(R"(,"libdrm")") : QString())
+                     .toUtf8();
+    }
+
+    const QString path = tempDir.path() + "/aggregate.json";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(R"({"hosts":[
+        {"hostIdentity":{"hostId":"host-a","hostname":"alpha"},"events":[
+            {"id":"a-3","timestamp":"2026-01-01T03:00:00Z","category":"kernel",
+             "relatedPackages":["linux"]},
+            {"id":"a-1","timestamp":"2026-01-01T01:00:00Z","category":"package",
+             "relatedPackages":["mesa"]}]},
+        {"hostIdentity":{"hostId":"host-b","hostname":"beta"},"events":[
+            {"id":"b-2","timestamp":"2026-01-01T02:00:00Z","category":"package",
+             "relatedPackages":["mesa"]},
+            {"id":"b-3","timestamp":"2026-01-01T03:00:00Z","category":"package",
+             "relatedPackages":["vulkan-radeon","mesa"]}]},
+        {"hostIdentity":{"hostId":"host-c"},"events":[)");
+    file.write(hostC);
+    file.write("]}]}");
+    file.close();
+
+    khronicle::FleetModel model;
+    model.loadAggregateFile(path);
+    QTRY_VERIFY(!model.loading());
+
+    khronicle::FleetTimelineModel *timeline = model.timeline();
+    const auto ids = [timeline](int count) {
+        QStringList result;
+        for (int row = 0; row < count; ++row) {
+            result << timeline->index(row).data(khronicle::FleetTimelineModel::IdRole).toString();
+        }
+        return result;
+    };
+
+    // Merged oldest first; equal timestamps keep host order.
+    QCOMPARE(timeline->rowCount(), khronicle::FleetTimelineModel::kBatchSize);
+    QCOMPARE(ids(5), QStringList({"a-1", "b-2", "a-3", "b-3", "c-0"}));
+    QCOMPARE(timeline->index(1).data(khronicle::FleetTimelineModel::HostLabelRole).toString(),
+             QStringLiteral("beta"));
+    QCOMPARE(timeline->get(2).value("hostId").toString(), QStringLiteral("host-a"));
+
+    // The selected host's events are the same lazy list, limited to it.
+    khronicle::FleetTimelineModel *hostEvents = model.events();
+    QCOMPARE(hostEvents->rowCount(), 2);
+    QCOMPARE(hostEvents->get(0).value("id").toString(), QStringLiteral("a-1"));
+    QCOMPARE(hostEvents->get(1).value("id").toString(), QStringLiteral("a-3"));
+    model.setSelectedHostId(QStringLiteral("host-c"));
+    QCOMPARE(hostEvents->rowCount(), khronicle::FleetTimelineModel::kBatchSize);
+    QCOMPARE(hostEvents->get(0).value("hostId").toString(), QStringLiteral("host-c"));
+
+    QVERIFY(timeline->canFetchMore(QModelIndex()));
+    timeline->fetchMore(QModelIndex());
+    QCOMPARE(timeline->rowCount(), 2 * khronicle::FleetTimelineModel::kBatchSize);
+    while (timeline->canFetchMore(QModelIndex())) {
+        timeline->fetchMore(QModelIndex());
+    }
+    QCOMPARE(timeline->rowCount(), manyEvents + 4);
+
+    // A filter that matches late in the fleet is scanned a step at a time
+    // from the event loop, not in one call.
+    model.setTimelineFilter({}, {"libdrm"}, QDateTime(), QDateTime());
+    QCOMPARE(timeline->rowCount(), 0);
+    QVERIFY(!timeline->canFetchMore(QModelIndex()));
+    QTRY_COMPARE(timeline->rowCount(), 1);
+    QCOMPARE(timeline->get(0).value("id").toString(),
+             QStringLiteral("c-%1").arg(manyEvents - 1));
+    QVERIFY(!timeline->canFetchMore(QModelIndex()));
+
+    // Category and package filters, and a window ending before host-c.
+    model.setTimelineFilter({"package"}, {"mesa"}, QDateTime(),
+                            QDateTime::fromString("2026-01-02T00:00:00Z", Qt::ISODate));
+    QCOMPARE(ids(timeline->rowCount()), QStringList({"a-1", "b-2", "b-3"}));
+    QVERIFY(!timeline->canFetchMore(QModelIndex()));
+
+    model.setTimelineFilter({}, {"vulkan-radeon", "linux"}, QDateTime(), QDateTime());
+    QTRY_COMPARE(ids(timeline->rowCount()), QStringList({"a-3", "b-3"}));
+
+    // The window is [from, to).
+    model.setTimelineFilter({}, {},
+                            QDateTime::fromString("2026-01-01T02:00:00Z", Qt::ISODate),
+                            QDateTime::fromString("2026-01-01T03:00:00Z", Qt::ISODate));
+    QCOMPARE(ids(timeline->rowCount()), QStringList({"b-2"}));
+
+    // The filter survives a reload.
+    model.loadAggregateFile(path);
+    QTRY_VERIFY(!model.loading());
+    QCOMPARE(ids(timeline->rowCount()), QStringList({"b-2"}));
+}
+
 QTEST_MAIN(FleetModelTests)
 #include "test_fleet_model.moc"
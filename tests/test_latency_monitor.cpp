@@ -0,0 +1,93 @@
+#include <QtTest/QtTest>
+
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "daemon/latency_monitor.hpp"
+
+using namespace std::chrono_literals;
+
+class LatencyMonitorTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testBudgetLookup();
+    void testRollingP95Breach();
+    void testCooldown();
+    void testInvalidConfig();
+};
+
+void LatencyMonitorTests::testBudgetLookup()
+{
+    const auto monitor = khronicle::LatencyMonitor::fromJson(nlohmann::json{
+        {"budgetsMs", {{"api:list_snapshots", 50}, {"snapshot_check", 0}}}
+    });
+
+    QCOMPARE(*monitor.budgetMs("api:list_snapshots"), 50.0);
+    QCOMPARE(*monitor.budgetMs("api:get_changes_since"), 500.0);
+    QCOMPARE(*monitor.budgetMs("ingestion_cycle"), 60000.0);
+    QVERIFY(!monitor.budgetMs("snapshot_check").has_value());
+    QVERIFY(!monitor.budgetMs("unknown_stage").has_value());
+}
+
+void LatencyMonitorTests::testRollingP95Breach()
+{
+    auto monitor = khronicle::LatencyMonitor::fromJson(nlohmann::json{
+        {"windowSize", 20}, {"minSamples", 20}, {"budgetsMs", {{"stage", 100}}}
+    });
+    const auto now = std::chrono::system_clock::now();
+
+    // Nearest-rank p95 of 20 samples is the 19th smallest, so a single
+    // outlier does not count.
+    for (int i = 0; i < 19; ++i) {
+        QVERIFY(!monitor.record("stage", 10ms, now).has_value());
+    }
+    QVERIFY(!monitor.record("stage", 500ms, now).has_value());
+    QCOMPARE(*monitor.p95Ms("stage"), 10.0);
+
+    // A second slow run pushes p95 over the budget.
+    const auto breach = monitor.record("stage", 500ms, now);
+    QVERIFY(breach.has_value());
+    QCOMPARE(QString::fromStdString(breach->name), QStringLiteral("stage"));
+    QCOMPARE(breach->p95Ms, 500.0);
+    QCOMPARE(breach->budgetMs, 100.0);
+    QCOMPARE(breach->samples, std::size_t(20));
+
+    // Untracked names never breach.
+    for (int i = 0; i < 30; ++i) {
+        QVERIFY(!monitor.record("other", 10s, now).has_value());
+    }
+}
+
+void LatencyMonitorTests::testCooldown()
+{
+    auto monitor = khronicle::LatencyMonitor::fromJson(nlohmann::json{
+        {"minSamples", 1}, {"cooldownMinutes", 30}, {"budgetsMs", {{"stage", 100}}}
+    });
+    const auto now = std::chrono::system_clock::now();
+
+    QVERIFY(monitor.record("stage", 200ms, now).has_value());
+    QVERIFY(!monitor.record("stage", 200ms, now + 10min).has_value());
+    QVERIFY(monitor.record("stage", 200ms, now + 31min).has_value());
+}
+
+void LatencyMonitorTests::testInvalidConfig()
+{
+    const auto rejects = [](const nlohmann::json &config) {
+        try {
+            khronicle::LatencyMonitor::fromJson(config);
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+
+    QVERIFY(rejects(nlohmann::json::array()));
+    QVERIFY(rejects(nlohmann::json{{"windowSize", 0}}));
+    QVERIFY(rejects(nlohmann::json{{"cooldownMinutes", -1}}));
+    QVERIFY(rejects(nlohmann::json{{"budgetsMs", {{"stage", "fast"}}}}));
+}
+
+QTEST_MAIN(LatencyMonitorTests)
+#include "test_latency_monitor.moc"
@@ -3,6 +3,9 @@
 #include <QTemporaryDir>
 #include <QFile>
 
+#include <thread>
+#include <vector>
+
 #include <nlohmann/json.hpp>
 
 #include "common/logging.hpp"
@@ -15,6 +18,8 @@ private slots:
     void cleanupTestCase();
     void testLogEventWrites();
     void testCodexTraceWrites();
+    void testConcurrentProducers();
+    void testRateLimitedSite();
 
 private:
     QTemporaryDir m_tempDir;
@@ -52,6 +57,7 @@ void LoggingTests::testLogEventWrites()
                                  khronicle::logging::defaultWho(),
                                  QStringLiteral("corr-1"),
                                  nlohmann::json{{"key", "value"}});
+    khronicle::logging::flushLogs();
 
     QFile file(logPath);
     QVERIFY(file.exists());
@@ -79,6 +85,7 @@ void LoggingTests::testCodexTraceWrites()
                                  khronicle::logging::defaultWho(),
                                  QStringLiteral("corr-2"),
                                  nlohmann::json::object());
+    khronicle::logging::flushLogs();
 
     QFile file(codexPath);
     QVERIFY(file.exists());
@@ -87,5 +94,110 @@ void LoggingTests::testCodexTraceWrites()
     QVERIFY(!line.trimmed().isEmpty());
 }
 
+void LoggingTests::testConcurrentProducers()
+{
+    khronicle::logging::initLogging(QStringLiteral("khronicle-concurrent"), false);
+    const QString logPath = m_tempDir.path() + "/.local/share/khronicle/logs/khronicle-concurrent.log";
+
+    constexpr int kThreads = 4;
+    constexpr int kLinesPerThread = 500;
+    const std::uint64_t droppedBefore = khronicle::logging::droppedLogRecords();
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([t] {
+            for (int i = 0; i < kLinesPerThread; ++i) {
+                khronicle::logging::logEvent(khronicle::logging::LogLevel::Info,
+                                             QStringLiteral("khronicle-concurrent"),
+                                             QStringLiteral("Test"),
+                                             QStringLiteral("testConcurrentProducers"),
+                                             QStringLiteral("test_line"),
+                                             QStringLiteral("unit_test"),
+                                             QStringLiteral("thread_fanout"),
+                                             QString(),
+                                             QString(),
+                                             nlohmann::json{{"thread", t}, {"i", i}});
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    khronicle::logging::flushLogs();
+
+    QFile file(logPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    int lines = 0;
+    while (!file.atEnd()) {
+        const auto parsed = nlohmann::json::parse(file.readLine().toStdString());
+        if (parsed.value("what", "") == "test_line") {
+            ++lines;
+        }
+    }
+
+    const auto dropped = khronicle::logging::droppedLogRecords() - droppedBefore;
+    QCOMPARE(static_cast<std::uint64_t>(lines) + dropped,
+             static_cast<std::uint64_t>(kThreads * kLinesPerThread));
+}
+
+void LoggingTests::testRateLimitedSite()
+{
+    khronicle::logging::initLogging(QStringLiteral("khronicle-limited"), false);
+    const QString logPath = m_tempDir.path() + "/.local/share/khronicle/logs/khronicle-limited.log";
+
+    constexpr int kCalls = 100;
+    for (int i = 0; i < kCalls; ++i) {
+        KLOG_INFO_LIMITED((khronicle::logging::LogRateLimit{0.0, 0.0, 10}),
+                          QStringLiteral("Test"),
+                          QStringLiteral("testRateLimitedSite"),
+                          QStringLiteral("test_sampled"),
+                          QStringLiteral("unit_test"),
+                          QStringLiteral("sampling"),
+                          QString(),
+                          QString(),
+                          (nlohmann::json{{"i", i}}));
+        KLOG_INFO_LIMITED((khronicle::logging::LogRateLimit{0.001, 5.0, 1}),
+                          QStringLiteral("Test"),
+                          QStringLiteral("testRateLimitedSite"),
+                          QStringLiteral("test_bucket"),
+                          QStringLiteral("unit_test"),
+                          QStringLiteral("token_bucket"),
+                          QString(),
+                          QString(),
+                          (nlohmann::json{{"i", i}}));
+    }
+    khronicle::logging::flushLogs();
+
+    QFile file(logPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    int sampled = 0;
+    int bucket = 0;
+    std::uint64_t suppressedSampled = 0;
+    std::uint64_t suppressedBucket = 0;
+    while (!file.atEnd()) {
+        const auto parsed = nlohmann::json::parse(file.readLine().toStdString());
+        const std::string what = parsed.value("what", "");
+        if (what == "test_sampled") {
+            ++sampled;
+        } else if (what == "test_bucket") {
+            ++bucket;
+        } else if (what == "log_records_suppressed") {
+            QCOMPARE(parsed.value("level", ""), std::string("INFO"));
+            const auto &context = parsed["context"];
+            const auto suppressed = context.value("suppressed", std::uint64_t{0});
+            if (context.value("similarTo", "") == "test_sampled") {
+                suppressedSampled += suppressed;
+            } else if (context.value("similarTo", "") == "test_bucket") {
+                suppressedBucket += suppressed;
+            }
+        }
+    }
+
+    QCOMPARE(sampled, kCalls / 10);
+    QCOMPARE(bucket, 5);
+    QCOMPARE(suppressedSampled, static_cast<std::uint64_t>(kCalls - kCalls / 10));
+    QCOMPARE(suppressedBucket, static_cast<std::uint64_t>(kCalls - 5));
+}
+
 QTEST_MAIN(LoggingTests)
 #include "test_logging.moc"
@@ -0,0 +1,103 @@
+#include <QtTest/QtTest>
+
+#include <nlohmann/json.hpp>
+
+#include "common/package_classifier.hpp"
+
+class PackageClassifierTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testDefaults();
+    void testPrefixAndGlob();
+    void testPrecedence();
+    void testInvalidConfig();
+    void testConfigPathOverride();
+};
+
+void PackageClassifierTests::testDefaults()
+{
+    const auto classifier = khronicle::PackageClassifier::defaults();
+
+    QVERIFY(classifier.isClass("linux-zen", khronicle::PackageClass::Kernel));
+    QVERIFY(classifier.isClass("nvidia-utils", khronicle::PackageClass::GpuDriver));
+    QVERIFY(classifier.isClass("linux-firmware", khronicle::PackageClass::Firmware));
+    QVERIFY(!classifier.classify("firefox").has_value());
+    QVERIFY(!classifier.classify("linux-zen-headers").has_value());
+
+    const auto cachyos = classifier.classify("linux-cachyos");
+    const auto lts = classifier.classify("linux-lts");
+    QVERIFY(cachyos && lts);
+    QVERIFY(cachyos->rank < lts->rank);
+}
+
+void PackageClassifierTests::testPrefixAndGlob()
+{
+    const auto classifier = khronicle::PackageClassifier::fromJson(nlohmann::json{
+        {"kernel", {"linux", "linux-*-headers"}},
+        {"gpuDriver", {"nvidia*", "lib32-nvidia-*", "vulkan-?ntel"}},
+        {"firmware", nlohmann::json::array()},
+    });
+
+    QVERIFY(classifier.isClass("linux-zen-headers", khronicle::PackageClass::Kernel));
+    QVERIFY(!classifier.classify("linux-zen").has_value());
+    QVERIFY(classifier.isClass("nvidia", khronicle::PackageClass::GpuDriver));
+    QVERIFY(classifier.isClass("nvidia-open-dkms", khronicle::PackageClass::GpuDriver));
+    QVERIFY(classifier.isClass("lib32-nvidia-utils", khronicle::PackageClass::GpuDriver));
+    QVERIFY(!classifier.classify("lib32-nvidia").has_value());
+    QVERIFY(classifier.isClass("vulkan-intel", khronicle::PackageClass::GpuDriver));
+    QVERIFY(!classifier.classify("vulkan-radeon").has_value());
+    // An empty list disables the class instead of falling back to defaults.
+    QVERIFY(!classifier.classify("linux-firmware").has_value());
+}
+
+void PackageClassifierTests::testPrecedence()
+{
+    const auto classifier = khronicle::PackageClassifier::fromJson(nlohmann::json{
+        {"kernel", {"linux*"}},
+        {"firmware", {"linux-firmware*", "linux-firmware-nvidia"}},
+    });
+
+    // Exact beats any pattern, the longer literal prefix beats a shorter one.
+    QVERIFY(classifier.isClass("linux-firmware-nvidia", khronicle::PackageClass::Firmware));
+    QVERIFY(classifier.isClass("linux-firmware-intel", khronicle::PackageClass::Firmware));
+    QVERIFY(classifier.isClass("linux-zen", khronicle::PackageClass::Kernel));
+    // Omitted classes keep the built-in list.
+    QVERIFY(classifier.isClass("mesa", khronicle::PackageClass::GpuDriver));
+}
+
+void PackageClassifierTests::testInvalidConfig()
+{
+    const auto rejects = [](const nlohmann::json &config) {
+        try {
+            khronicle::PackageClassifier::fromJson(config);
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+
+    QVERIFY(rejects(nlohmann::json::array()));
+    QVERIFY(rejects(nlohmann::json{{"kernel", "linux"}}));
+    QVERIFY(rejects(nlohmann::json{{"kernel", {1}}}));
+    QVERIFY(rejects(nlohmann::json{{"kernel", {""}}}));
+}
+
+void PackageClassifierTests::testConfigPathOverride()
+{
+    const QByteArray previous = qgetenv("KHRONICLE_PACKAGE_CLASSES_PATH");
+    qputenv("KHRONICLE_PACKAGE_CLASSES_PATH", "/tmp/khronicle-classes.json");
+    QCOMPARE(QString::fromStdString(khronicle::PackageClassifier::configPath()),
+             QStringLiteral("/tmp/khronicle-classes.json"));
+
+    qunsetenv("KHRONICLE_PACKAGE_CLASSES_PATH");
+    QVERIFY(QString::fromStdString(khronicle::PackageClassifier::configPath())
+                .endsWith(QStringLiteral(".config/khronicle/package-classes.json")));
+
+    if (!previous.isEmpty()) {
+        qputenv("KHRONICLE_PACKAGE_CLASSES_PATH", previous);
+    }
+}
+
+QTEST_MAIN(PackageClassifierTests)
+#include "test_package_classifier.moc"
@@ -1,13 +1,18 @@
 #include <QtTest/QtTest>
 
+#include <QBuffer>
+#include <QDir>
 #include <QTemporaryDir>
 #include <QFile>
 #include <QUuid>
 
+#include <ctime>
 #include <filesystem>
 
+#include "replay/LogStream.hpp"
 #include "replay/ReplayHarness.hpp"
 #include "daemon/khronicle_store.hpp"
+#include "debug/scenario_capture.hpp"
 #include "common/json_utils.hpp"
 
 class ReplayHarnessTests : public QObject
@@ -15,6 +20,11 @@ class ReplayHarnessTests : public QObject
     Q_OBJECT
 private slots:
     void testRunScenario();
+    void testCaptureWritesJournal();
+    void testReplayFromJournal();
+    void testStepTimingAndBudgets();
+    void testLogStreamRelease();
+    void testReplayLogStream();
 };
 
 void ReplayHarnessTests::testRunScenario()
@@ -86,5 +96,256 @@ void ReplayHarnessTests::testRunScenario()
     }
 }
 
+void ReplayHarnessTests::testCaptureWritesJournal()
+{
+    QTemporaryDir homeDir;
+    QVERIFY(homeDir.isValid());
+    const QByteArray prevHome = qgetenv("HOME");
+    qputenv("HOME", homeDir.path().toUtf8());
+
+    khronicle::ScenarioCapture::start(QStringLiteral("capture-test"),
+                                      QStringLiteral("Capture"),
+                                      QStringLiteral("Journal test"));
+    QVERIFY(khronicle::ScenarioCapture::isEnabled());
+    const QString scenarioDir = khronicle::ScenarioCapture::scenarioDir();
+
+    for (int i = 0; i < 3; ++i) {
+        khronicle::ScenarioCapture::recordStep(nlohmann::json{
+            {"action", "api_call"},
+            {"context", {{"method", "list_snapshots"}, {"params", {{"i", i}}}}}
+        });
+    }
+    // The burst reaches the disk without a later step or finalize().
+    QTRY_COMPARE(static_cast<int>(khronicle::ScenarioCapture::readStepsJournal(
+                     scenarioDir + "/steps.ndjson").size()),
+                 3);
+    khronicle::ScenarioCapture::finalize();
+    QVERIFY(!khronicle::ScenarioCapture::isEnabled());
+    // A second finalize must not rewrite or clear anything.
+    khronicle::ScenarioCapture::finalize();
+
+    const nlohmann::json journal = khronicle::ScenarioCapture::readStepsJournal(
+        scenarioDir + "/steps.ndjson");
+    QCOMPARE(static_cast<int>(journal.size()), 3);
+
+    QFile scenarioFile(scenarioDir + "/scenario.json");
+    QVERIFY(scenarioFile.open(QIODevice::ReadOnly));
+    const auto scenario = nlohmann::json::parse(scenarioFile.readAll().toStdString());
+    QCOMPARE(QString::fromStdString(scenario.value("title", "")), QStringLiteral("Capture"));
+    QVERIFY(scenario["steps"] == journal);
+    QCOMPARE(scenario["steps"][2]["context"]["params"]["i"].get<int>(), 2);
+
+    if (prevHome.isEmpty()) {
+        qunsetenv("HOME");
+    } else {
+        qputenv("HOME", prevHome);
+    }
+}
+
+void ReplayHarnessTests::testReplayFromJournal()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString scenarioDir = tempDir.path();
+    const QByteArray prevHome = qgetenv("HOME");
+
+    {
+        QTemporaryDir homeDir;
+        QVERIFY(homeDir.isValid());
+        qputenv("HOME", homeDir.path().toUtf8());
+        { khronicle::KhronicleStore store; }
+        QVERIFY(QFile::copy(homeDir.path() + "/.local/share/khronicle/khronicle.db",
+                            scenarioDir + "/db.sqlite"));
+    }
+
+    // An unfinalized capture: no steps in scenario.json, a torn last line in
+    // the journal. The unknown method makes the replay fail, which shows the
+    // journal was read.
+    QFile scenarioFile(scenarioDir + "/scenario.json");
+    QVERIFY(scenarioFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    scenarioFile.write(nlohmann::json{{"id", "journal"}, {"steps", nlohmann::json::array()}}
+                           .dump().c_str());
+    scenarioFile.close();
+
+    QFile journalFile(scenarioDir + "/steps.ndjson");
+    QVERIFY(journalFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    journalFile.write(R"({"action":"api_call","context":{"method":"no_such_method"}})" "\n");
+    journalFile.write(R"({"action":"api_call","conte)");
+    journalFile.close();
+
+    QCOMPARE(static_cast<int>(khronicle::ScenarioCapture::readStepsJournal(
+                 scenarioDir + "/steps.ndjson").size()),
+             1);
+
+    khronicle::ReplayHarness harness;
+    QCOMPARE(harness.runScenario(scenarioDir), 1);
+
+    if (prevHome.isEmpty()) {
+        qunsetenv("HOME");
+    } else {
+        qputenv("HOME", prevHome);
+    }
+}
+
+void ReplayHarnessTests::testStepTimingAndBudgets()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString scenarioDir = tempDir.path();
+    const QByteArray prevHome = qgetenv("HOME");
+
+    {
+        QTemporaryDir homeDir;
+        QVERIFY(homeDir.isValid());
+        qputenv("HOME", homeDir.path().toUtf8());
+        { khronicle::KhronicleStore store; }
+        QVERIFY(QFile::copy(homeDir.path() + "/.local/share/khronicle/khronicle.db",
+                            scenarioDir + "/db.sqlite"));
+    }
+
+    const nlohmann::json apiCall = {
+        {"action", "api_call"},
+        {"context", {{"method", "list_snapshots"}, {"params", nlohmann::json::object()}}}
+    };
+    nlohmann::json tightCall = apiCall;
+    tightCall["budgetMs"] = 0.000001;
+    const nlohmann::json scenario = {
+        {"id", "budgets"},
+        {"budgets", {{"stepWallMs", 60000}}},
+        {"steps", nlohmann::json::array({apiCall, tightCall})}
+    };
+    QFile scenarioFile(scenarioDir + "/scenario.json");
+    QVERIFY(scenarioFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    scenarioFile.write(scenario.dump().c_str());
+    scenarioFile.close();
+
+    // Budgets are reported by default and only fail the run when enforced.
+    // The default report goes to the working directory, not the scenario.
+    QTemporaryDir workDir;
+    QVERIFY(workDir.isValid());
+    const QString prevCwd = QDir::currentPath();
+    QVERIFY(QDir::setCurrent(workDir.path()));
+    khronicle::ReplayHarness harness;
+    const int defaultResult = harness.runScenario(scenarioDir);
+    QVERIFY(QDir::setCurrent(prevCwd));
+    QCOMPARE(defaultResult, 0);
+    QVERIFY(QFile::exists(workDir.path() + "/replay-timing.json"));
+    QVERIFY(!QFile::exists(scenarioDir + "/replay-timing.json"));
+
+    const QString reportPath = tempDir.path() + "/timing.json";
+    khronicle::ReplayOptions options;
+    options.timingReportPath = reportPath;
+    options.enforceBudgets = true;
+    QCOMPARE(harness.runScenario(scenarioDir, options), 2);
+
+    QFile reportFile(reportPath);
+    QVERIFY(reportFile.open(QIODevice::ReadOnly));
+    const auto report = nlohmann::json::parse(reportFile.readAll().toStdString());
+    QCOMPARE(report.value("budgetViolations", -1), 1);
+    QCOMPARE(static_cast<int>(report["steps"].size()), 2);
+    const auto &first = report["steps"][0];
+    QCOMPARE(QString::fromStdString(first.value("method", "")),
+             QStringLiteral("list_snapshots"));
+    QVERIFY(first.contains("wallMs"));
+    QVERIFY(first.contains("rowsRead"));
+    QVERIFY(!first.value("overBudget", true));
+    QVERIFY(report["steps"][1].value("overBudget", false));
+
+    if (prevHome.isEmpty()) {
+        qunsetenv("HOME");
+    } else {
+        qputenv("HOME", prevHome);
+    }
+}
+
+void ReplayHarnessTests::testLogStreamRelease()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.path() + "/journal.txt";
+    QFile input(path);
+    QVERIFY(input.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    input.write("-- Logs begin --\n"
+                "2026-02-01T10:00:00+0000 host kernel: amdgpu: firmware loaded\n"
+                "    continuation line\n"
+                "2026-02-03T10:00:00+0000 host kernel: amdgpu: firmware loaded\n");
+    input.close();
+
+    khronicle::LogStream stream;
+    QVERIFY(stream.load(path));
+    const auto first = stream.firstTimestamp();
+    QCOMPARE(std::chrono::system_clock::to_time_t(first), std::time_t(1769940000));
+    QCOMPARE(std::chrono::system_clock::to_time_t(stream.lastTimestamp()),
+             std::time_t(1769940000 + 2 * 86400));
+
+    QBuffer out;
+    out.open(QIODevice::WriteOnly);
+    // The header and continuation travel with the first stamped line.
+    QCOMPARE(static_cast<int>(stream.releaseUntil(first + std::chrono::hours(24), out)), 3);
+    QVERIFY(out.data().startsWith("-- Logs begin --\n"));
+    QVERIFY(!stream.exhausted());
+    QCOMPARE(static_cast<int>(stream.releaseUntil(first + std::chrono::hours(24), out)), 0);
+    QVERIFY(stream.nextTimestamp() == stream.lastTimestamp());
+    QCOMPARE(static_cast<int>(stream.releaseUntil(first + std::chrono::hours(48), out)), 1);
+    QVERIFY(stream.exhausted());
+    QVERIFY(stream.nextTimestamp() == std::chrono::system_clock::time_point::max());
+}
+
+void ReplayHarnessTests::testReplayLogStream()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString scenarioDir = tempDir.path();
+    const QByteArray prevHome = qgetenv("HOME");
+
+    {
+        QTemporaryDir homeDir;
+        QVERIFY(homeDir.isValid());
+        qputenv("HOME", homeDir.path().toUtf8());
+        { khronicle::KhronicleStore store; }
+        QVERIFY(QFile::copy(homeDir.path() + "/.local/share/khronicle/khronicle.db",
+                            scenarioDir + "/db.sqlite"));
+    }
+
+    // A month of pacman history, streamed a day per tick.
+    QFile pacmanLog(scenarioDir + "/pacman.log");
+    QVERIFY(pacmanLog.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    pacmanLog.write("[2026-01-01T12:00:00+0000] [ALPM] upgraded mesa (1.0-1 -> 1.0-2)\n"
+                    "[2026-01-31T12:00:00+0000] [ALPM] upgraded linux (6.1-1 -> 6.2-1)\n");
+    pacmanLog.close();
+
+    const nlohmann::json scenario = {
+        {"id", "stream"},
+        {"steps", nlohmann::json::array({
+            nlohmann::json{{"action", "replay_log_stream"},
+                           {"context", {{"tickMinutes", 1440}}}}
+        })}
+    };
+    QFile scenarioFile(scenarioDir + "/scenario.json");
+    QVERIFY(scenarioFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    scenarioFile.write(scenario.dump().c_str());
+    scenarioFile.close();
+
+    QTemporaryDir reportDir;
+    QVERIFY(reportDir.isValid());
+    khronicle::ReplayOptions options;
+    options.timingReportPath = reportDir.path() + "/timing.json";
+    khronicle::ReplayHarness harness;
+    QCOMPARE(harness.runScenario(scenarioDir, options), 0);
+
+    QFile reportFile(options.timingReportPath);
+    QVERIFY(reportFile.open(QIODevice::ReadOnly));
+    const auto report = nlohmann::json::parse(reportFile.readAll().toStdString());
+    QCOMPARE(static_cast<int>(report["steps"].size()), 1);
+    QVERIFY(report["steps"][0].value("ok", false));
+    QVERIFY(report["steps"][0].value("rowsWritten", 0) >= 2);
+
+    if (prevHome.isEmpty()) {
+        qunsetenv("HOME");
+    } else {
+        qputenv("HOME", prevHome);
+    }
+}
+
 QTEST_MAIN(ReplayHarnessTests)
 #include "test_replay.moc"
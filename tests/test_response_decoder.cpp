@@ -0,0 +1,125 @@
+#include <QtTest/QtTest>
+
+#include <QJsonArray>
+#include <QThread>
+
+#include "ui/backend/ResponseDecoder.hpp"
+
+class ResponseDecoderTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testPartialLinesAndConversion();
+    void testSupersededRequest();
+    void testErrors();
+    void testArrivalOrder();
+
+private:
+    static khronicle::DecodedResponse takeById(QSignalSpy &spy, int id);
+};
+
+khronicle::DecodedResponse ResponseDecoderTests::takeById(QSignalSpy &spy, int id)
+{
+    for (const QList<QVariant> &arguments : spy) {
+        const auto response = arguments.at(0).value<khronicle::DecodedResponse>();
+        if (response.id == id) {
+            return response;
+        }
+    }
+    return {};
+}
+
+void ResponseDecoderTests::testPartialLinesAndConversion()
+{
+    khronicle::ResponseDecoder decoder;
+    QSignalSpy spy(&decoder, &khronicle::ResponseDecoder::decoded);
+    decoder.expect(1, QStringLiteral("rules"), [](const QJsonObject &result) {
+        return QVariant(result.value("rules").toArray().size());
+    });
+
+    // A response split across two reads is decoded once, when complete.
+    decoder.feed(R"({"id":1,"result":{"rules":[{"id":"a"},)");
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 0);
+    decoder.feed("{\"id\":\"b\"}]}}\n");
+    QTRY_COMPARE(spy.count(), 1);
+
+    const auto response = takeById(spy, 1);
+    QVERIFY(!response.superseded);
+    QVERIFY(response.error.isEmpty());
+    QCOMPARE(response.value.toInt(), 2);
+    QVERIFY(response.result.contains("rules"));
+}
+
+void ResponseDecoderTests::testSupersededRequest()
+{
+    khronicle::ResponseDecoder decoder;
+    QSignalSpy spy(&decoder, &khronicle::ResponseDecoder::decoded);
+    const auto converter = [](const QJsonObject &result) {
+        return QVariant(result.value("n").toInt());
+    };
+    decoder.expect(1, QStringLiteral("changes"), converter);
+    decoder.expect(2, QStringLiteral("changes"), converter);
+    decoder.expect(3, QString(), converter);
+
+    decoder.feed("{\"id\":1,\"result\":{\"n\":1}}\n"
+                 "{\"id\":2,\"result\":{\"n\":2}}\n"
+                 "{\"id\":3,\"result\":{\"n\":3}}\n");
+    QTRY_COMPARE(spy.count(), 3);
+
+    const auto stale = takeById(spy, 1);
+    QVERIFY(stale.superseded);
+    QVERIFY(!stale.value.isValid());
+    const auto current = takeById(spy, 2);
+    QVERIFY(!current.superseded);
+    QCOMPARE(current.value.toInt(), 2);
+    // Requests without a view never supersede or get superseded.
+    QCOMPARE(takeById(spy, 3).value.toInt(), 3);
+}
+
+void ResponseDecoderTests::testErrors()
+{
+    khronicle::ResponseDecoder decoder;
+    QSignalSpy spy(&decoder, &khronicle::ResponseDecoder::decoded);
+    decoder.expect(7, QStringLiteral("diff"));
+
+    decoder.feed("not json\n{\"id\":7,\"error\":\"Snapshots not found\"}\n");
+    QTRY_COMPARE(spy.count(), 2);
+
+    QCOMPARE(takeById(spy, -1).error, QStringLiteral("Invalid JSON response"));
+    QCOMPARE(takeById(spy, 7).error, QStringLiteral("Snapshots not found"));
+}
+
+void ResponseDecoderTests::testArrivalOrder()
+{
+    khronicle::ResponseDecoder decoder;
+    QSignalSpy spy(&decoder, &khronicle::ResponseDecoder::decoded);
+    // A large answer whose conversion is slow, then a small answer and a
+    // push that would finish first if decoded side by side.
+    decoder.expect(1, QStringLiteral("changes"), [](const QJsonObject &result) {
+        QThread::msleep(100);
+        return QVariant(result.value("changes").toArray().size());
+    });
+    decoder.expect(2, QStringLiteral("rules"));
+
+    QByteArray large = R"({"id":1,"result":{"changes":[)";
+    for (int i = 0; i < 5000; ++i) {
+        large += (i == 0 ? "" : ",");
+        large += R"({"package":"mesa","from":"1.0","to":"1.1"})";
+    }
+    large += "]}}\n";
+    decoder.feed(large
+                 + "{\"id\":2,\"result\":{\"rules\":[]}}\n"
+                 + "{\"method\":\"watch_signal\",\"params\":{\"severity\":\"critical\"}}\n");
+    QTRY_COMPARE(spy.count(), 3);
+
+    const auto first = spy.at(0).at(0).value<khronicle::DecodedResponse>();
+    QCOMPARE(first.id, 1);
+    QCOMPARE(first.value.toInt(), 5000);
+    QCOMPARE(spy.at(1).at(0).value<khronicle::DecodedResponse>().id, 2);
+    const auto push = spy.at(2).at(0).value<khronicle::DecodedResponse>();
+    QCOMPARE(push.notification, QStringLiteral("watch_signal"));
+}
+
+QTEST_MAIN(ResponseDecoderTests)
+#include "test_response_decoder.moc"
@@ -0,0 +1,79 @@
+#include <QtTest/QtTest>
+
+#include "ui/backend/DiffModel.hpp"
+#include "ui/backend/SnapshotListModel.hpp"
+
+class SnapshotModelsTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testSortedAndNearest();
+    void testDiffLabels();
+};
+
+void SnapshotModelsTests::testSortedAndNearest()
+{
+    khronicle::SnapshotListModel model;
+    QCOMPARE(model.nearestIndex(QStringLiteral("2026-01-02T00:00:00Z")), -1);
+
+    QVariantList snapshots;
+    snapshots.push_back(QVariantMap{{"id", "mid"},
+                                    {"timestamp", "2026-01-02T00:00:00Z"},
+                                    {"kernelVersion", "6.2"}});
+    snapshots.push_back(QVariantMap{{"id", "old"},
+                                    {"timestamp", "2026-01-01T00:00:00Z"},
+                                    {"kernelVersion", "6.1"}});
+    snapshots.push_back(QVariantMap{{"id", "new"},
+                                    {"timestamp", "2026-01-03T00:00:00Z"},
+                                    {"kernelVersion", ""}});
+    model.setSnapshots(snapshots);
+
+    QCOMPARE(model.count(), 3);
+    // Newest first.
+    QCOMPARE(model.get(0).value("id").toString(), QStringLiteral("new"));
+    QCOMPARE(model.get(2).value("id").toString(), QStringLiteral("old"));
+    QVERIFY(model.index(1).data(khronicle::SnapshotListModel::LabelRole)
+                .toString().endsWith(QStringLiteral(" • 6.2")));
+    QVERIFY(!model.index(0).data(khronicle::SnapshotListModel::LabelRole)
+                 .toString().isEmpty());
+    QVERIFY(model.get(3).isEmpty());
+
+    QCOMPARE(model.nearestIndex(QStringLiteral("2026-01-02T10:00:00Z")), 1);
+    QCOMPARE(model.nearestIndex(QStringLiteral("2026-01-02T14:00:00Z")), 0);
+    // Halfway between two snapshots picks the newer one.
+    QCOMPARE(model.nearestIndex(QStringLiteral("2026-01-01T12:00:00Z")), 1);
+    QCOMPARE(model.nearestIndex(QStringLiteral("2025-12-01T00:00:00Z")), 2);
+    QCOMPARE(model.nearestIndex(QStringLiteral("2027-01-01T00:00:00Z")), 0);
+    QCOMPARE(model.nearestIndex(QStringLiteral("not a date")), -1);
+}
+
+void SnapshotModelsTests::testDiffLabels()
+{
+    khronicle::DiffModel model;
+    QVariantList rows;
+    rows.push_back(QVariantMap{{"path", "kernelVersion"}, {"before", "6.1"}, {"after", "6.2"}});
+    rows.push_back(QVariantMap{{"path", "keyPackages.mesa"}, {"before", "24.1"}, {"after", "24.2"}});
+    rows.push_back(QVariantMap{{"path", "firmwareVersions.Dock"}, {"after", "1.2"}});
+    rows.push_back(QVariantMap{{"path", "gpuDriver"}});
+    model.setRows(rows);
+
+    QCOMPARE(model.count(), 4);
+    const auto label = [&model](int row) {
+        return model.index(row).data(khronicle::DiffModel::LabelRole).toString();
+    };
+    QCOMPARE(label(0), QStringLiteral("Kernel"));
+    QCOMPARE(label(1), QStringLiteral("Package: mesa"));
+    QCOMPARE(label(2), QStringLiteral("Firmware: Dock"));
+    QCOMPARE(label(3), QStringLiteral("gpuDriver"));
+    QCOMPARE(model.index(1).data(khronicle::DiffModel::PathRole).toString(),
+             QStringLiteral("keyPackages.mesa"));
+    QCOMPARE(model.index(2).data(khronicle::DiffModel::BeforeRole).toString(), QString());
+    QCOMPARE(model.index(2).data(khronicle::DiffModel::AfterRole).toString(),
+             QStringLiteral("1.2"));
+
+    model.setRows({});
+    QCOMPARE(model.rowCount(), 0);
+}
+
+QTEST_MAIN(SnapshotModelsTests)
+#include "test_snapshot_models.moc"
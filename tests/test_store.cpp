@@ -2,7 +2,11 @@
 
 #include <QTemporaryDir>
 
+#include <cstdint>
 #include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
@@ -19,6 +23,9 @@ private slots:
     void testSnapshots();
     void testMetaState();
     void testWatchRulesAndSignals();
+    void testEventsByVersionRange();
+    void testEventsPage();
+    void testGenerations();
 
 private:
     QTemporaryDir m_tempDir;
@@ -86,6 +93,50 @@ void StoreTests::testEventInsertAndQuery()
     QCOMPARE(QString::fromStdString(events.back().id), QStringLiteral("event-b"));
 }
 
+void StoreTests::testEventsPage()
+{
+    resetDb();
+
+    khronicle::KhronicleStore store;
+    const auto base = std::chrono::system_clock::now() - std::chrono::hours(1);
+
+    // Five events, two of them sharing a second so the id tiebreak matters.
+    for (int i = 0; i < 5; ++i) {
+        khronicle::KhronicleEvent event;
+        event.id = "event-" + std::to_string(i);
+        event.timestamp = base + std::chrono::minutes(i == 4 ? 3 : i);
+        event.category = khronicle::EventCategory::Package;
+        event.source = khronicle::EventSource::Pacman;
+        event.summary = "package";
+        store.addEvent(event);
+    }
+
+    const auto from = base - std::chrono::minutes(1);
+    const auto to = base + std::chrono::minutes(10);
+    std::vector<std::string> ids;
+    std::optional<khronicle::EventPageCursor> cursor;
+    for (int page = 0; page < 10; ++page) {
+        const auto events = store.getEventsPage(from, to, cursor, 2);
+        QVERIFY(events.size() <= 2);
+        for (const auto &event : events) {
+            ids.push_back(event.id);
+        }
+        if (events.size() < 2) {
+            break;
+        }
+        cursor = khronicle::EventPageCursor{events.back().timestamp, events.back().id};
+    }
+
+    const std::vector<std::string> expected = {
+        "event-4", "event-3", "event-2", "event-1", "event-0"
+    };
+    QCOMPARE(ids, expected);
+
+    // The range bounds still apply.
+    const auto recent = store.getEventsPage(base + std::chrono::minutes(2), to, std::nullopt, 10);
+    QCOMPARE(recent.size(), static_cast<size_t>(3));
+}
+
 void StoreTests::testSnapshots()
 {
     resetDb();
@@ -170,6 +221,119 @@ void StoreTests::testWatchRulesAndSignals()
         std::chrono::system_clock::time_point{});
     QCOMPARE(watchSignals.size(), static_cast<size_t>(1));
     QCOMPARE(QString::fromStdString(watchSignals.front().ruleId), QStringLiteral("rule-1"));
+
+    signal.id = "sig-2";
+    signal.severity = khronicle::WatchSeverity::Info;
+    store.addWatchSignal(signal);
+    QCOMPARE(store.countWatchSignalsSince(std::chrono::system_clock::time_point{}),
+             std::size_t(2));
+    QCOMPARE(store.countWatchSignalsSince(std::chrono::system_clock::time_point{},
+                                          khronicle::WatchSeverity::Critical),
+             std::size_t(1));
+    QCOMPARE(store.countWatchSignalsSince(signal.timestamp + std::chrono::hours(1)),
+             std::size_t(0));
+}
+
+void StoreTests::testGenerations()
+{
+    resetDb();
+
+    khronicle::KhronicleStore store;
+    QCOMPARE(store.getStoreGeneration(), std::int64_t(0));
+
+    const auto now = std::chrono::system_clock::now();
+    khronicle::KhronicleEvent event;
+    event.id = "event-1";
+    event.timestamp = now - std::chrono::minutes(5);
+    event.category = khronicle::EventCategory::Kernel;
+    event.source = khronicle::EventSource::Pacman;
+    event.summary = "kernel upgraded";
+    store.addEvent(event);
+
+    khronicle::SystemSnapshot snapshot;
+    snapshot.id = "snap-1";
+    snapshot.timestamp = now;
+    snapshot.kernelVersion = "6.1";
+    store.addSnapshot(snapshot);
+
+    // Every write, to either table, moves the generation forward.
+    const std::int64_t seen = store.getStoreGeneration();
+    QCOMPARE(seen, std::int64_t(2));
+
+    const auto from = now - std::chrono::hours(1);
+    const auto to = now + std::chrono::hours(1);
+    QCOMPARE(store.getEventsAfterGeneration(0, from, to, 10).size(), std::size_t(1));
+    QVERIFY(store.getEventsAfterGeneration(seen, from, to, 10).empty());
+
+    event.id = "event-2";
+    store.addEvent(event);
+    // Replacing a row counts as a change too.
+    event.id = "event-1";
+    event.summary = "kernel upgraded again";
+    store.addEvent(event);
+
+    const auto changed = store.getEventsAfterGeneration(seen, from, to, 10);
+    QCOMPARE(changed.size(), std::size_t(2));
+    QCOMPARE(QString::fromStdString(changed.front().id), QStringLiteral("event-2"));
+    QCOMPARE(QString::fromStdString(changed.back().summary),
+             QStringLiteral("kernel upgraded again"));
+    QCOMPARE(store.getStoreGeneration(), seen + 2);
+    QVERIFY(store.getEventsAfterGeneration(seen, now, to, 10).empty());
+}
+
+void StoreTests::testEventsByVersionRange()
+{
+    resetDb();
+
+    khronicle::KhronicleStore store;
+    const auto now = std::chrono::system_clock::now();
+    const std::vector<std::pair<std::string, std::string>> upgrades = {
+        {"mesa-1", "24.1.3-1"},
+        {"mesa-2", "24.10.1-1"},
+        {"mesa-3", "24.2.0-1"},
+        {"mesa-4", "1:23.0-1"},
+    };
+
+    int minutes = 10;
+    for (const auto &[id, version] : upgrades) {
+        khronicle::KhronicleEvent event;
+        event.id = id;
+        event.timestamp = now - std::chrono::minutes(minutes--);
+        event.category = khronicle::EventCategory::GpuDriver;
+        event.source = khronicle::EventSource::Pacman;
+        event.summary = "mesa upgraded";
+        event.beforeState = nlohmann::json::object();
+        event.afterState = {{"version", version}};
+        event.relatedPackages = {"mesa"};
+        store.addEvent(event);
+    }
+
+    const auto inRange = store.getEventsByVersionRange("mesa", "24.1", "24.3");
+    QCOMPARE(inRange.size(), static_cast<size_t>(2));
+    QCOMPARE(QString::fromStdString(inRange.front().id), QStringLiteral("mesa-1"));
+    QCOMPARE(QString::fromStdString(inRange.back().id), QStringLiteral("mesa-3"));
+
+    const auto withEpoch = store.getEventsByVersionRange("mesa", "24.10", "");
+    QCOMPARE(withEpoch.size(), static_cast<size_t>(2));
+
+    QVERIFY(store.getEventsByVersionRange("linux", "", "").empty());
+
+    // Re-ingesting an event replaces its indexed versions.
+    khronicle::KhronicleEvent replaced;
+    replaced.id = "mesa-3";
+    replaced.timestamp = now;
+    replaced.category = khronicle::EventCategory::Package;
+    replaced.source = khronicle::EventSource::Pacman;
+    replaced.summary = "vulkan-radeon upgraded";
+    replaced.beforeState = nlohmann::json::object();
+    replaced.afterState = {{"version", "24.2.0-1"}};
+    replaced.relatedPackages = {"vulkan-radeon"};
+    store.addEvent(replaced);
+    const auto afterReplace = store.getEventsByVersionRange("mesa", "24.1", "24.3");
+    QCOMPARE(afterReplace.size(), static_cast<size_t>(1));
+    QCOMPARE(QString::fromStdString(afterReplace.front().id), QStringLiteral("mesa-1"));
+    QCOMPARE(store.getEventsByVersionRange("vulkan-radeon", "", "").size(),
+             static_cast<size_t>(1));
 }
 
 QTEST_MAIN(StoreTests)
@@ -0,0 +1,229 @@
+#include <QtTest/QtTest>
+
+#include <QDir>
+#include <QTemporaryDir>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+#include "daemon/khronicle_api_server.hpp"
+#include "daemon/khronicle_store.hpp"
+#include "ui/backend/DaemonConnection.hpp"
+#include "ui/backend/KhronicleApiClient.hpp"
+#include "ui/backend/TimelineCache.hpp"
+#include "ui/backend/TimelineModel.hpp"
+
+class TimelineModelTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testLocalEventsAndFilters();
+    void testPagedFetch();
+    void testIncrementalRangeAndCache();
+
+private:
+    QTemporaryDir m_tempDir;
+    QByteArray m_prevHome;
+    QByteArray m_prevRuntime;
+};
+
+void TimelineModelTests::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    m_prevHome = qgetenv("HOME");
+    m_prevRuntime = qgetenv("XDG_RUNTIME_DIR");
+    qputenv("HOME", m_tempDir.path().toUtf8());
+    qputenv("XDG_RUNTIME_DIR", m_tempDir.path().toUtf8());
+}
+
+void TimelineModelTests::cleanupTestCase()
+{
+    if (m_prevHome.isEmpty()) {
+        qunsetenv("HOME");
+    } else {
+        qputenv("HOME", m_prevHome);
+    }
+    if (m_prevRuntime.isEmpty()) {
+        qunsetenv("XDG_RUNTIME_DIR");
+    } else {
+        qputenv("XDG_RUNTIME_DIR", m_prevRuntime);
+    }
+}
+
+void TimelineModelTests::testLocalEventsAndFilters()
+{
+    khronicle::TimelineModel model(nullptr);
+    khronicle::TimelineFilterModel filter(&model);
+
+    QVariantList events;
+    events.push_back(QVariantMap{{"id", "old"},
+                                 {"timestamp", "2026-01-01T10:00:00Z"},
+                                 {"category", "kernel"},
+                                 {"summary", "kernel upgraded"}});
+    events.push_back(QVariantMap{{"id", "new"},
+                                 {"timestamp", "2026-01-02T10:00:00.500Z"},
+                                 {"category", "package"},
+                                 {"summary", "mesa upgraded"}});
+    events.push_back(QVariantMap{{"id", "sys"},
+                                 {"timestamp", "2026-01-01T12:00:00Z"},
+                                 {"category", "system"},
+                                 {"summary", "snapshot"}});
+    model.setEvents(events);
+
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    // Newest first.
+    QCOMPARE(model.index(0).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("new"));
+    QCOMPARE(model.index(0).data(khronicle::TimelineModel::TimestampRole).toString(),
+             QStringLiteral("2026-01-02T10:00:00Z"));
+    QCOMPARE(model.index(2).data(khronicle::TimelineModel::CategoryRole).toString(),
+             QStringLiteral("kernel"));
+    QCOMPARE(model.index(0).data(khronicle::TimelineModel::EventDataRole).toMap()
+                 .value("summary").toString(),
+             QStringLiteral("mesa upgraded"));
+
+    filter.setShowPackage(false);
+    QCOMPARE(filter.rowCount(), 2);
+    filter.setShowKernel(false);
+    // System events are never filtered out.
+    QCOMPARE(filter.rowCount(), 1);
+    QCOMPARE(filter.index(0, 0).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("sys"));
+    filter.setShowPackage(true);
+    QCOMPARE(filter.rowCount(), 2);
+
+    model.clear();
+    QCOMPARE(filter.rowCount(), 0);
+}
+
+void TimelineModelTests::testPagedFetch()
+{
+    khronicle::KhronicleStore store;
+    const auto base = std::chrono::system_clock::now() - std::chrono::hours(24);
+    const int total = khronicle::TimelineModel::kPageSize * 2 + 50;
+    for (int i = 0; i < total; ++i) {
+        khronicle::KhronicleEvent event;
+        event.id = "event-" + std::to_string(i);
+        event.timestamp = base + std::chrono::seconds(i);
+        event.category = khronicle::EventCategory::Package;
+        event.source = khronicle::EventSource::Pacman;
+        event.summary = "package";
+        store.addEvent(event);
+    }
+
+    khronicle::KhronicleApiServer server(store);
+    QVERIFY(server.start());
+
+    khronicle::DaemonConnection connection;
+    khronicle::KhronicleApiClient client(&connection);
+    QSignalSpy connected(&client, &khronicle::KhronicleApiClient::connectedChanged);
+    client.connectToDaemon();
+    QTRY_VERIFY(!connected.isEmpty());
+
+    khronicle::TimelineModel model(&client);
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    model.setRange(now.addDays(-2), now);
+    QVERIFY(model.loading());
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    QTRY_COMPARE(model.rowCount(), khronicle::TimelineModel::kPageSize);
+    QVERIFY(!model.loading());
+    QCOMPARE(model.index(0).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("event-%1").arg(total - 1));
+
+    QVERIFY(model.canFetchMore(QModelIndex()));
+    model.fetchMore(QModelIndex());
+    QTRY_COMPARE(model.rowCount(), khronicle::TimelineModel::kPageSize * 2);
+    model.fetchMore(QModelIndex());
+    QTRY_COMPARE(model.rowCount(), total);
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    QCOMPARE(model.index(total - 1).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("event-0"));
+
+    // A narrower range drops the rows outside it and any answer still owed
+    // to the old one.
+    model.setRange(now.addDays(-2), now);
+    model.setRange(now.addSecs(-60), now);
+    QTRY_VERIFY(!model.loading());
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void TimelineModelTests::testIncrementalRangeAndCache()
+{
+    khronicle::KhronicleStore store;
+    const auto base = std::chrono::system_clock::now() - std::chrono::hours(2);
+    auto addEvent = [&store](const std::string &id, std::chrono::system_clock::time_point at) {
+        khronicle::KhronicleEvent event;
+        event.id = id;
+        event.timestamp = at;
+        event.category = khronicle::EventCategory::Kernel;
+        event.source = khronicle::EventSource::Pacman;
+        event.summary = "kernel";
+        store.addEvent(event);
+    };
+    addEvent("old", base);
+    addEvent("mid", base + std::chrono::minutes(30));
+
+    khronicle::KhronicleApiServer server(store);
+    QVERIFY(server.start());
+
+    khronicle::DaemonConnection connection;
+    khronicle::KhronicleApiClient client(&connection);
+    client.connectToDaemon();
+
+    khronicle::TimelineModel model(&client);
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    model.setRange(now.addDays(-1), now);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QTRY_VERIFY(!model.loading());
+    QVERIFY(model.generation() > 0);
+
+    // Only what was recorded since is fetched and merged in order.
+    QSignalSpy resets(&model, &QAbstractItemModel::modelReset);
+    addEvent("new", base + std::chrono::minutes(60));
+    model.setRange(now.addDays(-1), now.addSecs(60));
+    QTRY_COMPARE(model.rowCount(), 3);
+    QTRY_VERIFY(!model.loading());
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(model.index(0).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("new"));
+    QCOMPARE(model.index(2).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("old"));
+
+    const QString cachePath = m_tempDir.filePath(QStringLiteral("timeline.cache"));
+    khronicle::TimelineCache cache(&model, &client, cachePath);
+    QVERIFY(cache.save());
+
+    // Next start: the rows come from the file, and the first range
+    // selection only asks for what changed while the UI was closed.
+    khronicle::TimelineModel restored(&client);
+    khronicle::TimelineCache restoredCache(&restored, &client, cachePath);
+    // Between "old" and "mid".
+    const QDateTime from = now.addSecs(-110 * 60);
+    QVERIFY(restoredCache.restore(from, now.addSecs(60)));
+    QCOMPARE(restored.rowCount(), 2);
+    QCOMPARE(restored.generation(), model.generation());
+    QVERIFY(!restored.loading());
+
+    addEvent("newest", base + std::chrono::minutes(90));
+    QSignalSpy restoredResets(&restored, &QAbstractItemModel::modelReset);
+    restored.setRange(from, now.addSecs(120));
+    QTRY_COMPARE(restored.rowCount(), 3);
+    QTRY_VERIFY(!restored.loading());
+    QCOMPARE(restoredResets.count(), 0);
+    QCOMPARE(restored.index(0).data(khronicle::TimelineModel::IdRole).toString(),
+             QStringLiteral("newest"));
+
+    // A window the cache does not cover is not restored.
+    khronicle::TimelineModel untouched(&client);
+    khronicle::TimelineCache otherCache(&untouched, &client, cachePath);
+    QVERIFY(!otherCache.restore(now.addDays(-3), now));
+    QCOMPARE(untouched.rowCount(), 0);
+}
+
+QTEST_MAIN(TimelineModelTests)
+#include "test_timeline_model.moc"
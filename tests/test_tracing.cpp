@@ -0,0 +1,101 @@
+#include <QtTest/QtTest>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "common/logging.hpp"
+#include "common/tracing.hpp"
+
+class TracingTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testSpansWriteChromeTraceEvents();
+
+private:
+    nlohmann::json readTrace() const;
+
+    QTemporaryDir m_tempDir;
+    QString m_tracePath;
+};
+
+void TracingTests::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    // Tracing is decided once, on first use, from the environment.
+    m_tracePath = m_tempDir.path() + QStringLiteral("/trace.json");
+    qputenv("KHRONICLE_TRACE_FILE", m_tracePath.toUtf8());
+    QVERIFY(khronicle::tracing::isTracingEnabled());
+}
+
+nlohmann::json TracingTests::readTrace() const
+{
+    QFile file(m_tracePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nlohmann::json();
+    }
+    // The array is left open; close it the way the trace viewers do.
+    std::string text = file.readAll().trimmed().toStdString();
+    if (!text.empty() && text.back() == ',') {
+        text.pop_back();
+    }
+    return nlohmann::json::parse(text + "]", nullptr, false);
+}
+
+void TracingTests::testSpansWriteChromeTraceEvents()
+{
+    {
+        khronicle::logging::CorrelationScope corrScope(QStringLiteral("ingestion-7"));
+        khronicle::tracing::TraceSpan outer("ingestion", "ingestion_cycle");
+        outer.setArg("cycleIndex", 7);
+        {
+            KTRACE_SCOPE("store", "addEvent");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    {
+        const std::string method = "get_changes_since";
+        khronicle::tracing::TraceSpan named("api", "api:", method);
+    }
+    khronicle::tracing::flushTrace();
+
+    const nlohmann::json trace = readTrace();
+    QVERIFY(trace.is_array());
+
+    nlohmann::json outerEvent;
+    nlohmann::json innerEvent;
+    nlohmann::json namedEvent;
+    for (const auto &event : trace) {
+        if (event.value("ph", "") != "X") {
+            continue;
+        }
+        if (event.value("name", "") == "ingestion_cycle") {
+            outerEvent = event;
+        } else if (event.value("name", "") == "addEvent") {
+            innerEvent = event;
+        } else if (event.value("name", "") == "api:get_changes_since") {
+            namedEvent = event;
+        }
+    }
+
+    QVERIFY(outerEvent.is_object());
+    QVERIFY(innerEvent.is_object());
+    QVERIFY(namedEvent.is_object());
+    QCOMPARE(QString::fromStdString(namedEvent.value("cat", "")), QStringLiteral("api"));
+    QCOMPARE(QString::fromStdString(innerEvent.value("cat", "")), QStringLiteral("store"));
+    QVERIFY(innerEvent.value("dur", 0LL) >= 2000);
+    QVERIFY(outerEvent.value("ts", 0LL) <= innerEvent.value("ts", 0LL));
+    QVERIFY(outerEvent.value("dur", 0LL) >= innerEvent.value("dur", 0LL));
+    QCOMPARE(outerEvent.value("tid", 0L), innerEvent.value("tid", 0L));
+    QCOMPARE(QString::fromStdString(outerEvent["args"].value("corr", "")),
+             QStringLiteral("ingestion-7"));
+    QCOMPARE(outerEvent["args"].value("cycleIndex", 0), 7);
+}
+
+QTEST_MAIN(TracingTests)
+#include "test_tracing.moc"
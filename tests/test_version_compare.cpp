@@ -0,0 +1,90 @@
+#include <QtTest/QtTest>
+
+#include "common/version_compare.hpp"
+
+class VersionCompareTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testCompareVersions_data();
+    void testCompareVersions();
+    void testSortKeyOrder();
+    void testVersionInRange();
+};
+
+void VersionCompareTests::testCompareVersions_data()
+{
+    QTest::addColumn<QString>("a");
+    QTest::addColumn<QString>("b");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("equal") << "1.0-1" << "1.0-1" << 0;
+    QTest::newRow("numeric") << "1.0" << "1.1" << -1;
+    QTest::newRow("multi-digit") << "24.1.3-1" << "24.10.1-1" << -1;
+    QTest::newRow("leading-zeros") << "1.01" << "1.1" << 0;
+    QTest::newRow("alpha-suffix") << "1.0a" << "1.0" << -1;
+    QTest::newRow("rc") << "1.0rc1" << "1.0" << -1;
+    QTest::newRow("alpha-vs-number") << "1.0.a" << "1.0.1" << -1;
+    QTest::newRow("epoch") << "1:1.0" << "2.0" << 1;
+    QTest::newRow("pkgrel") << "6.9.1-1" << "6.9.1-2" << -1;
+    QTest::newRow("missing-pkgrel") << "1.5" << "1.5-1" << 0;
+    QTest::newRow("separators") << "1.0" << "1_0" << 0;
+    QTest::newRow("git") << "1.2.r3.gabc-1" << "1.2-1" << 1;
+}
+
+void VersionCompareTests::testCompareVersions()
+{
+    QFETCH(QString, a);
+    QFETCH(QString, b);
+    QFETCH(int, expected);
+
+    const int forward = khronicle::compareVersions(a.toStdString(), b.toStdString());
+    const int backward = khronicle::compareVersions(b.toStdString(), a.toStdString());
+    QCOMPARE(forward < 0 ? -1 : (forward > 0 ? 1 : 0), expected);
+    QCOMPARE(backward < 0 ? -1 : (backward > 0 ? 1 : 0), -expected);
+}
+
+void VersionCompareTests::testSortKeyOrder()
+{
+    const std::vector<std::string> ordered = {
+        "1.0rc1-1",
+        "1.0-1",
+        "1.0.1-1",
+        "1.2-1",
+        "1.2.r3.gabc-1",
+        "24.1.3-1",
+        "24.1.3-2",
+        "24.10.1-1",
+        "1:0.9-1",
+    };
+
+    for (std::size_t i = 0; i + 1 < ordered.size(); ++i) {
+        QVERIFY2(khronicle::compareVersions(ordered[i], ordered[i + 1]) < 0,
+                 ordered[i].c_str());
+        QVERIFY2(khronicle::versionSortKey(ordered[i])
+                     < khronicle::versionSortKey(ordered[i + 1]),
+                 ordered[i].c_str());
+    }
+
+    QCOMPARE(khronicle::versionSortKey("1.01-1"), khronicle::versionSortKey("1.1-1"));
+
+    // A missing pkgrel equals any pkgrel; the floor key of "1.0-1" must not
+    // sort above "1.0".
+    QCOMPARE(khronicle::compareVersions("1.0", "1.0-1"), 0);
+    QVERIFY(khronicle::versionSortKey("1.0") < khronicle::versionSortKey("1.0-1"));
+    QCOMPARE(khronicle::versionSortKeyFloor("1.0-1"), khronicle::versionSortKey("1.0"));
+    QCOMPARE(khronicle::versionSortKeyFloor("2:1.0"), khronicle::versionSortKey("2:1.0"));
+}
+
+void VersionCompareTests::testVersionInRange()
+{
+    QVERIFY(khronicle::versionInRange("24.1.3-1", "24.1", "24.2"));
+    QVERIFY(!khronicle::versionInRange("24.2.0-1", "24.1", "24.2"));
+    QVERIFY(!khronicle::versionInRange("23.3.5-1", "24.1", "24.2"));
+    QVERIFY(khronicle::versionInRange("6.9.1-1", "", ""));
+    QVERIFY(khronicle::versionInRange("6.9.1-1", "6.9", ""));
+    QVERIFY(!khronicle::versionInRange("6.9.1-1", "", "6.9"));
+}
+
+QTEST_MAIN(VersionCompareTests)
+#include "test_version_compare.moc"
@@ -4,9 +4,11 @@
 
 #include <ctime>
 #include <filesystem>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include "common/clock.hpp"
 #include "daemon/khronicle_store.hpp"
 #include "daemon/watch_engine.hpp"
 
@@ -21,6 +23,9 @@ private slots:
     void testActiveWindow();
     void testDisabledRule();
     void testPackageNameContains();
+    void testVersionBoundsAndDowngrade();
+    void testDaemonSignal();
+    void testVirtualClock();
 
 private:
     QTemporaryDir m_tempDir;
@@ -85,6 +90,10 @@ void WatchEngineTests::testEventRuleMatch()
     event.afterState["riskLevel"] = "critical";
     event.hostId = store.getHostIdentity().hostId;
 
+    std::vector<khronicle::WatchSignal> heard;
+    engine.setSignalListener([&heard](const khronicle::WatchSignal &signal) {
+        heard.push_back(signal);
+    });
     engine.evaluateEvent(event);
 
     const auto watchSignals = store.getWatchSignalsSince(
@@ -92,6 +101,8 @@ void WatchEngineTests::testEventRuleMatch()
     QCOMPARE(static_cast<int>(watchSignals.size()), 1);
     QCOMPARE(QString::fromStdString(watchSignals[0].ruleId), QString("kernel-critical"));
     QCOMPARE(QString::fromStdString(watchSignals[0].originType), QString("event"));
+    QCOMPARE(static_cast<int>(heard.size()), 1);
+    QCOMPARE(QString::fromStdString(heard[0].id), QString::fromStdString(watchSignals[0].id));
 }
 
 void WatchEngineTests::testActiveWindow()
@@ -219,5 +230,110 @@ void WatchEngineTests::testPackageNameContains()
     QCOMPARE(static_cast<int>(watchSignals.size()), 1);
 }
 
+void WatchEngineTests::testVersionBoundsAndDowngrade()
+{
+    resetDb();
+
+    khronicle::KhronicleStore store;
+    khronicle::WatchRule bounded;
+    bounded.id = "rule-bounded";
+    bounded.name = "Mesa 24.1";
+    bounded.scope = khronicle::WatchScope::Event;
+    bounded.severity = khronicle::WatchSeverity::Warning;
+    bounded.packageNameContains = "mesa";
+    bounded.extra = {{"versionAtLeast", "24.1"}, {"versionBelow", "24.2"}};
+    store.upsertWatchRule(bounded);
+
+    khronicle::WatchRule downgrade;
+    downgrade.id = "rule-downgrade";
+    downgrade.name = "Mesa downgrade";
+    downgrade.scope = khronicle::WatchScope::Event;
+    downgrade.severity = khronicle::WatchSeverity::Critical;
+    downgrade.packageNameContains = "mesa";
+    downgrade.extra = {{"downgrade", true}};
+    store.upsertWatchRule(downgrade);
+
+    khronicle::WatchEngine engine(store);
+    khronicle::KhronicleEvent event;
+    event.id = "event-upgrade";
+    event.timestamp = std::chrono::system_clock::now();
+    event.category = khronicle::EventCategory::GpuDriver;
+    event.source = khronicle::EventSource::Pacman;
+    event.summary = "mesa upgraded";
+    event.relatedPackages = {"mesa"};
+    event.beforeState = {{"version", "24.0.9-1"}};
+    event.afterState = {{"version", "24.1.3-1"}};
+    event.hostId = store.getHostIdentity().hostId;
+    engine.evaluateEvent(event);
+
+    // 24.10 sorts above 24.2, so neither rule fires for this upgrade.
+    event.id = "event-minor";
+    event.beforeState = {{"version", "24.1.3-1"}};
+    event.afterState = {{"version", "24.10.1-1"}};
+    engine.evaluateEvent(event);
+
+    event.id = "event-downgrade";
+    event.beforeState = {{"version", "24.10.1-1"}};
+    event.afterState = {{"version", "24.2.0-1"}};
+    engine.evaluateEvent(event);
+
+    const auto watchSignals = store.getWatchSignalsSince(
+        std::chrono::system_clock::time_point{});
+    QCOMPARE(static_cast<int>(watchSignals.size()), 2);
+
+    QStringList matched;
+    for (const auto &signal : watchSignals) {
+        matched.append(QString::fromStdString(signal.ruleId + "/" + signal.originId));
+    }
+    matched.sort();
+    QCOMPARE(matched, QStringList({QStringLiteral("rule-bounded/event-upgrade"),
+                                   QStringLiteral("rule-downgrade/event-downgrade")}));
+}
+
+void WatchEngineTests::testDaemonSignal()
+{
+    resetDb();
+
+    khronicle::KhronicleStore store;
+    khronicle::WatchEngine engine(store);
+    engine.recordDaemonSignal("daemon-latency-budget",
+                              "Latency budget",
+                              khronicle::WatchSeverity::Warning,
+                              "api:list_snapshots",
+                              "p95 latency of api:list_snapshots is 900 ms");
+
+    const auto watchSignals = store.getWatchSignalsSince(
+        std::chrono::system_clock::time_point{});
+    QCOMPARE(static_cast<int>(watchSignals.size()), 1);
+    QCOMPARE(QString::fromStdString(watchSignals[0].originType), QString("daemon"));
+    QCOMPARE(QString::fromStdString(watchSignals[0].originId),
+             QString("api:list_snapshots"));
+    QCOMPARE(watchSignals[0].severity, khronicle::WatchSeverity::Warning);
+}
+
+void WatchEngineTests::testVirtualClock()
+{
+    resetDb();
+
+    // Signals raised by the daemon are stamped with the injected clock, not
+    // the host's.
+    const auto replayTime = std::chrono::system_clock::from_time_t(1577836800);
+    khronicle::VirtualClock clock(replayTime);
+    khronicle::KhronicleStore store;
+    khronicle::WatchEngine engine(store, clock);
+    clock.advance(std::chrono::hours(24));
+    engine.recordDaemonSignal("daemon-latency-budget",
+                              "Latency budget",
+                              khronicle::WatchSeverity::Warning,
+                              "ingestion_cycle",
+                              "p95 latency of ingestion_cycle is 90000 ms");
+
+    const auto watchSignals = store.getWatchSignalsSince(
+        std::chrono::system_clock::time_point{});
+    QCOMPARE(static_cast<int>(watchSignals.size()), 1);
+    QCOMPARE(std::chrono::system_clock::to_time_t(watchSignals[0].timestamp),
+             std::chrono::system_clock::to_time_t(replayTime + std::chrono::hours(24)));
+}
+
 QTEST_MAIN(WatchEngineTests)
 #include "test_watch_engine.moc"
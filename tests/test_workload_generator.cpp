@@ -0,0 +1,92 @@
+#include <QtTest/QtTest>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "bench/workload_generator.hpp"
+#include "daemon/journal_parser.hpp"
+#include "daemon/pacman_parser.hpp"
+
+class WorkloadGeneratorTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testDeterministic();
+    void testParsersReadWorkload();
+};
+
+namespace {
+
+QByteArray readAll(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+khronicle::bench::WorkloadConfig smallConfig()
+{
+    khronicle::bench::WorkloadConfig config;
+    config.years = 1;
+    config.packages = 200;
+    config.journalLinesPerDay = 10;
+    config.seed = 7;
+    return config;
+}
+
+} // namespace
+
+void WorkloadGeneratorTests::testDeterministic()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    khronicle::bench::WorkloadGenerator first(smallConfig());
+    khronicle::bench::WorkloadGenerator second(smallConfig());
+    QVERIFY(first.writePacmanLog(tempDir.path() + "/a.log"));
+    QVERIFY(second.writePacmanLog(tempDir.path() + "/b.log"));
+    QVERIFY(first.writeJournal(tempDir.path() + "/a.txt"));
+    QVERIFY(second.writeJournal(tempDir.path() + "/b.txt"));
+
+    QVERIFY(!readAll(tempDir.path() + "/a.log").isEmpty());
+    QCOMPARE(readAll(tempDir.path() + "/a.log"), readAll(tempDir.path() + "/b.log"));
+    QCOMPARE(readAll(tempDir.path() + "/a.txt"), readAll(tempDir.path() + "/b.txt"));
+
+    auto otherSeed = smallConfig();
+    otherSeed.seed = 8;
+    khronicle::bench::WorkloadGenerator third(otherSeed);
+    QVERIFY(third.writePacmanLog(tempDir.path() + "/c.log"));
+    QVERIFY(readAll(tempDir.path() + "/a.log") != readAll(tempDir.path() + "/c.log"));
+}
+
+void WorkloadGeneratorTests::testParsersReadWorkload()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    khronicle::bench::WorkloadGenerator generator(smallConfig());
+    const QString pacmanPath = tempDir.path() + "/pacman.log";
+    const QString journalPath = tempDir.path() + "/journal.txt";
+    QVERIFY(generator.writePacmanLog(pacmanPath));
+    QVERIFY(generator.writeJournal(journalPath));
+
+    const auto &stats = generator.stats();
+    QVERIFY(stats.sessions > 0);
+    QCOMPARE(static_cast<int>(stats.journalLines), 365 * 10);
+
+    // Every generated upgrade line is one the real parser understands.
+    const auto pacman = khronicle::parsePacmanLog(pacmanPath.toStdString(), std::nullopt);
+    QCOMPARE(pacman.events.size(), stats.upgrades);
+
+    const QStringList lines = QString::fromUtf8(readAll(journalPath)).split('\n', Qt::SkipEmptyParts);
+    const auto journal = khronicle::parseJournalOutputLines(
+        lines, generator.start() - std::chrono::hours(1));
+    QCOMPARE(journal.events.size(), stats.gpuJournalLines);
+
+    const auto snapshots = generator.snapshots();
+    QCOMPARE(snapshots.size(), stats.snapshots);
+    QVERIFY(snapshots.front().timestamp < snapshots.back().timestamp);
+    QVERIFY(snapshots.back().keyPackages.contains("mesa"));
+}
+
+QTEST_MAIN(WorkloadGeneratorTests)
+#include "test_workload_generator.moc"